@@ -68,4 +68,34 @@ extern "C" {
 /* Track-related functions. */
 #include <cdio/track.h>
 
+/* I/O statistics and tracing. Uses driver_return_code_t too. */
+#include <cdio/stats.h>
+
+/* Track and disc checksums. */
+#include <cdio/checksum.h>
+
+/* Checking and correcting raw data sectors. */
+#include <cdio/ecc.h>
+
+/* Converting between image formats. */
+#include <cdio/convert.h>
+
+/* Running jobs on many drives at once. */
+#include <cdio/farm.h>
+
+/* Extracting audio with jitter correction. */
+#include <cdio/rip.h>
+
+/* Bulk reads which adapt speed and transfer size to the disc. */
+#include <cdio/read_ctl.h>
+
+/* Keeping what was learned about a disc on disk. */
+#include <cdio/disc_cache.h>
+
+/* Decoding Q sub-channel, and scanning a disc for what it holds. */
+#include <cdio/subchannel.h>
+
+/* Dumping a whole disc to a raw image. */
+#include <cdio/dump.h>
+
 #endif /* __CDIO_H__ */
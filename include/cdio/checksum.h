@@ -0,0 +1,184 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file checksum.h
+ *
+ *  \brief Checksums of tracks and whole discs.
+ *
+ *  cdio_checksum_disc() and cdio_checksum_track() read tracks through
+ *  the driver in large batches and compute any of CRC-32, MD5, SHA-256
+ *  and the AccurateRip v1 and v2 checksums of them, each on its own
+ *  thread where threads are available.
+ *
+ *  Audio tracks are hashed as the 2352-byte sectors that
+ *  cdio_read_audio_sectors() returns; data tracks as the 2048-byte
+ *  blocks that cdio_read_data_sectors() returns.
+ *
+ *  The digests can also be computed incrementally over any buffer
+ *  with the cdio_crc32(), cdio_md5_*(), cdio_sha256_*() and
+ *  cdio_accuraterip_*() routines.
+ */
+
+#ifndef CDIO_CHECKSUM_H_
+#define CDIO_CHECKSUM_H_
+
+#include <cdio/types.h>
+#include <cdio/sector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** The checksums cdio_checksum_disc() can compute; or them
+      together. */
+  typedef enum {
+    CDIO_CHECKSUM_CRC32       = 0x01, /**< CRC-32 as in zlib and zip */
+    CDIO_CHECKSUM_MD5         = 0x02,
+    CDIO_CHECKSUM_SHA256      = 0x04,
+    CDIO_CHECKSUM_ACCURATERIP = 0x08, /**< AccurateRip v1 and v2; audio
+                                           tracks only */
+    CDIO_CHECKSUM_ALL         = 0x0f
+  } cdio_checksum_kind_t;
+
+#define CDIO_MD5_DIGEST_SIZE    16
+#define CDIO_SHA256_DIGEST_SIZE 32
+
+  /** Checksums of a track, or of a whole disc. */
+  typedef struct cdio_checksum_report_s {
+    track_t      i_track;     /**< Track number, or 0 for the whole disc */
+    lsn_t        i_lsn;       /**< First sector */
+    uint32_t     i_sectors;   /**< Number of sectors */
+    bool         b_audio;     /**< Read as audio rather than data */
+    driver_return_code_t i_status; /**< DRIVER_OP_SUCCESS, or why some
+                                        sector couldn't be read; the
+                                        checksums are then those of
+                                        the sectors before it. */
+    unsigned int i_kinds;     /**< cdio_checksum_kind_t values computed */
+    uint32_t     crc32;
+    uint8_t      md5[CDIO_MD5_DIGEST_SIZE];
+    uint8_t      sha256[CDIO_SHA256_DIGEST_SIZE];
+    uint32_t     accuraterip_v1;
+    uint32_t     accuraterip_v2;
+  } cdio_checksum_report_t;
+
+  /** Checksums of every track of a disc. */
+  typedef struct cdio_disc_checksum_s {
+    track_t                i_tracks;  /**< Entries used in track[] */
+    cdio_checksum_report_t disc;      /**< All the tracks, in order;
+                                           no AccurateRip */
+    cdio_checksum_report_t track[CDIO_CD_MAX_TRACKS];
+  } cdio_disc_checksum_t;
+
+  /**
+    Compute the i_kinds checksums of every track of the disc in p_cdio,
+    and of all of them together.
+
+    A track whose sectors can't all be read has its i_status set, and
+    so does the disc; the other tracks are still read.
+
+    @return DRIVER_OP_SUCCESS if every sector was read, else the first
+    error; DRIVER_OP_ERROR if the threads to compute the checksums
+    can't be started.
+  */
+  driver_return_code_t cdio_checksum_disc(CdIo_t *p_cdio,
+                                          unsigned int i_kinds,
+                                          /*out*/ cdio_disc_checksum_t *p_sums);
+
+  /**
+    Compute the i_kinds checksums of track i_track.
+
+    @return DRIVER_OP_SUCCESS if every sector was read, else the first
+    error; DRIVER_OP_ERROR if the threads to compute the checksums
+    can't be started.
+  */
+  driver_return_code_t cdio_checksum_track(CdIo_t *p_cdio, track_t i_track,
+                                           unsigned int i_kinds,
+                                           /*out*/ cdio_checksum_report_t *p_sum);
+
+  /**
+    Return a short name for one cdio_checksum_kind_t value, like "md5".
+  */
+  const char *cdio_checksum_kind2str(cdio_checksum_kind_t e_kind);
+
+  /**
+    Return the CRC-32 of p_buf continuing from i_crc, which is 0 to
+    start with.
+  */
+  uint32_t cdio_crc32(uint32_t i_crc, const void *p_buf, size_t i_len);
+
+  /** MD5 state; the fields are private. */
+  typedef struct {
+    uint32_t state[4];
+    uint64_t i_bytes;
+    uint8_t  block[64];
+  } cdio_md5_t;
+
+  void cdio_md5_init(cdio_md5_t *p_md5);
+  void cdio_md5_update(cdio_md5_t *p_md5, const void *p_buf, size_t i_len);
+  void cdio_md5_final(cdio_md5_t *p_md5,
+                      /*out*/ uint8_t digest[CDIO_MD5_DIGEST_SIZE]);
+
+  /** SHA-256 state; the fields are private. */
+  typedef struct {
+    uint32_t state[8];
+    uint64_t i_bytes;
+    uint8_t  block[64];
+  } cdio_sha256_t;
+
+  void cdio_sha256_init(cdio_sha256_t *p_sha);
+  void cdio_sha256_update(cdio_sha256_t *p_sha, const void *p_buf,
+                          size_t i_len);
+  void cdio_sha256_final(cdio_sha256_t *p_sha,
+                         /*out*/ uint8_t digest[CDIO_SHA256_DIGEST_SIZE]);
+
+  /** AccurateRip state; the fields are private. */
+  typedef struct {
+    uint32_t v1;
+    uint32_t v2;
+    uint32_t i_multiplier;  /**< 1-based number of the next sample */
+    uint32_t i_from;        /**< First sample counted */
+    uint32_t i_to;          /**< Last sample counted */
+    uint8_t  partial[4];    /**< Bytes of a sample split across updates */
+    unsigned int i_partial;
+  } cdio_accuraterip_t;
+
+  /**
+    Start the AccurateRip checksums of a track of i_sectors audio
+    sectors. The first five sectors of the first track on the disc,
+    bar one sample, and the last five of the last are left out, as
+    drive offsets make them unreliable.
+  */
+  void cdio_accuraterip_init(cdio_accuraterip_t *p_ar, uint32_t i_sectors,
+                             bool b_first_track, bool b_last_track);
+  void cdio_accuraterip_update(cdio_accuraterip_t *p_ar, const void *p_buf,
+                               size_t i_len);
+  void cdio_accuraterip_final(const cdio_accuraterip_t *p_ar,
+                              /*out*/ uint32_t *p_v1, /*out*/ uint32_t *p_v2);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_CHECKSUM_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,65 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file convert.h
+ *
+ *  \brief Converting between disc image formats.
+ */
+
+#ifndef CDIO_CONVERT_H_
+#define CDIO_CONVERT_H_
+
+#include <cdio/types.h>
+#include <cdio/ecc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /**
+    Convert the ISO 9660 image psz_iso, a sequence of 2048-byte
+    blocks, into the raw image psz_bin of 2352-byte e_mode sectors,
+    and write a CUE sheet for it to psz_cue unless that is NULL.
+
+    The image is read, encoded and written in batches, with the
+    sectors split among i_threads threads; 0 picks a number from the
+    processors available.
+
+    @param e_mode CDIO_RAW_MODE1 or CDIO_RAW_MODE2_FORM1.
+    @return DRIVER_OP_SUCCESS, DRIVER_OP_BAD_PARAMETER for a bad mode
+    or an image too big for a CD, or DRIVER_OP_ERROR if a file can't
+    be read or written.
+  */
+  driver_return_code_t cdio_convert_iso_to_bin(const char *psz_iso,
+                                               const char *psz_bin,
+                                               const char *psz_cue,
+                                               cdio_raw_mode_t e_mode,
+                                               unsigned int i_threads);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_CONVERT_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
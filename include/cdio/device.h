@@ -504,6 +504,12 @@ LIBCDIO_DEPRECATED(static const driver_id_t CDIO_MAX_DEVICE_DRIVER, "please use
      been done previously.
      
      If NULL is given as the source, we'll use the default driver device.
+
+     The disc-image drivers (BIN/CUE, cdrdao and NRG) take the access
+     modes "image", the default, and "direct". "direct" reads the
+     image files around the operating system's file cache, in large
+     aligned chunks, so that scanning a whole image doesn't push
+     everything else out of the cache.
      
      @return the cdio object or NULL on error or no device.
   */
@@ -588,6 +594,21 @@ LIBCDIO_DEPRECATED(static const driver_id_t CDIO_MAX_DEVICE_DRIVER, "please use
    */
   CdIo_t * cdio_open_cue (const char *cue_name);
 
+  /**
+     Set the most image files which the BIN/CUE and cdrdao drivers
+     keep open at once, across all CdIo_t objects; 0 means no limit.
+     When another file is needed the one read least recently is
+     closed, and it is reopened when next read. The default is 64.
+
+     @return DRIVER_OP_SUCCESS
+   */
+  driver_return_code_t cdio_set_max_open_image_files(unsigned int i_max);
+
+  /**
+     @return the limit set by cdio_set_max_open_image_files().
+   */
+  unsigned int cdio_get_max_open_image_files(void);
+
   /**
      Set up CD-ROM for reading using the AIX driver. The device_name is
      the some sort of device name.
@@ -755,6 +776,29 @@ LIBCDIO_DEPRECATED(static const driver_id_t CDIO_MAX_DEVICE_DRIVER, "please use
      driver can find.
    */
   char **cdio_get_devices_linux(void);
+
+  /**
+     Have the GNU/Linux driver look for CD drives under psz_sys_block
+     rather than /sys/block, and watch psz_dev rather than /dev for
+     drives coming and going. A NULL puts back the default. Drives
+     found before are forgotten.
+
+     This is for a system whose sysfs and device nodes are mounted
+     elsewhere, say in a chroot, and for testing. It does nothing
+     if there is no GNU/Linux driver.
+   */
+  void cdio_linux_registry_set_roots(const char *psz_sys_block,
+                                     const char *psz_dev);
+
+  /**
+     Return the names of the CD drives the GNU/Linux driver has found
+     in sysfs, brought up to date.
+
+     @return a NULL-terminated list to free with
+     cdio_free_device_list(), or NULL if sysfs can't be read or there
+     is no GNU/Linux driver.
+   */
+  char **cdio_linux_registry_get_names(void);
   
   /**
      Set up CD-ROM for reading using the Sun Solaris driver. The
@@ -1031,6 +1075,19 @@ Return a list of all of the CD-ROM devices that the OS/2 driver
      @param p_cdio the CD object to set
      @param key the key to set
      @param value the value to assocaiate with key
+
+     Disc images accept the key "buffering" with the value "auto"
+     (the default: adapt to how the image is read), "none" (for large
+     sequential transfers), "sequential" (a large read-ahead window,
+     for ripping audio) or "random" (a small buffer, for browsing a
+     filesystem). An image opened with the "direct" access mode has
+     no buffer, and setting "buffering" on it gives
+     DRIVER_OP_UNSUPPORTED.
+
+     They also accept "ecc" with "off" (the default), "verify" (fail
+     reads of data sectors whose EDC doesn't match) or "correct"
+     (repair such sectors from their ECC where possible); see
+     <cdio/ecc.h>.
   */
   driver_return_code_t cdio_set_arg (CdIo_t *p_cdio, const char key[], 
                                      const char value[]);
@@ -0,0 +1,169 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file disc_cache.h
+ *
+ *  \brief Keeping what was learned about a disc on disk.
+ *
+ *  Getting the CD-Text, the MCN, the ISRC of every track and the
+ *  filesystem of every data track from a physical drive can take
+ *  seconds. A disc cache keeps them in a directory, one file per
+ *  disc, so that they are read from the drive only the first time a
+ *  disc is seen.
+ *
+ *  A disc is known by a key made from its table of contents: the
+ *  CDDB disc id, the leadout, and a CRC-32 of every track's start
+ *  and format. The TOC is all that is read from the drive to find a
+ *  disc in the cache. Looking up the same disc again through the same
+ *  handle reads nothing at all unless cdio_get_media_changed() says
+ *  the disc has been changed.
+ *
+ *  Cache files are mapped into memory where mmap() is available.
+ *  They are in the byte order of the host which wrote them; a file
+ *  from a host of the other order, or from another version of the
+ *  format, is treated as missing and rewritten.
+ */
+
+#ifndef CDIO_DISC_CACHE_H_
+#define CDIO_DISC_CACHE_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+#include <cdio/cdtext.h>
+#include <cdio/cd_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** What a disc is known by in a disc cache. */
+  typedef struct cdio_disc_key_s {
+    uint32_t i_discid;   /**< CDDB disc id */
+    lsn_t    i_leadout;  /**< Start of the leadout */
+    uint32_t i_toc_crc;  /**< CRC-32 of every track's start and format */
+  } cdio_disc_key_t;
+
+  /** An opaque disc cache. */
+  typedef struct cdio_disc_cache_s cdio_disc_cache_t;
+
+  /** An opaque entry of a disc cache: what is known about one disc. */
+  typedef struct cdio_disc_info_s cdio_disc_info_t;
+
+  /**
+    Make the key of the disc in p_cdio from its TOC.
+
+    @return false if there is no disc or its TOC can't be read.
+  */
+  bool cdio_disc_cache_key(CdIo_t *p_cdio, /*out*/ cdio_disc_key_t *p_key);
+
+  /**
+    Open the disc cache in directory psz_dir, creating the directory if
+    need be. A NULL psz_dir means "libcdio" under $XDG_CACHE_HOME, or
+    under $HOME/.cache.
+
+    @return the cache, or NULL if the directory can't be made. Close it
+    with cdio_disc_cache_close().
+  */
+  cdio_disc_cache_t *cdio_disc_cache_open(const char *psz_dir);
+
+  /** Close p_cache, freeing the entry it returned last. */
+  void cdio_disc_cache_close(cdio_disc_cache_t *p_cache);
+
+  /**
+    Return what is known about the disc in p_cdio: from the cache if
+    the disc is in it, or else by asking the drive, after which the
+    disc is added to the cache. If pb_cached isn't NULL, it is set to
+    whether the drive was spared.
+
+    The entry belongs to p_cache, and stays valid until the next
+    cdio_disc_cache_get() on it or until it is closed.
+
+    @return the entry, or NULL if the disc has no readable TOC.
+  */
+  cdio_disc_info_t *cdio_disc_cache_get(cdio_disc_cache_t *p_cache,
+                                        CdIo_t *p_cdio,
+                                        /*out*/ bool *pb_cached);
+
+  /**
+    Remove the disc known by p_key from p_cache, so that the next
+    lookup asks the drive again.
+
+    @return true if there was an entry for it.
+  */
+  bool cdio_disc_cache_remove(cdio_disc_cache_t *p_cache,
+                              const cdio_disc_key_t *p_key);
+
+  /** Put the key of p_info into p_key. */
+  void cdio_disc_info_get_key(const cdio_disc_info_t *p_info,
+                              /*out*/ cdio_disc_key_t *p_key);
+
+  /** Return the number of the first track of p_info. */
+  track_t cdio_disc_info_get_first_track_num(const cdio_disc_info_t *p_info);
+
+  /** Return the number of tracks of p_info. */
+  track_t cdio_disc_info_get_num_tracks(const cdio_disc_info_t *p_info);
+
+  /** Return the start of track i_track of p_info, or CDIO_INVALID_LSN
+      if there is no such track. CDIO_CDROM_LEADOUT_TRACK gives the
+      leadout. */
+  lsn_t cdio_disc_info_get_track_lsn(const cdio_disc_info_t *p_info,
+                                     track_t i_track);
+
+  /** Return the format of track i_track of p_info, or TRACK_FORMAT_ERROR
+      if there is no such track. */
+  track_format_t cdio_disc_info_get_track_format(const cdio_disc_info_t *p_info,
+                                                 track_t i_track);
+
+  /** Return the MCN of p_info, or NULL if the disc has none. */
+  const char *cdio_disc_info_get_mcn(const cdio_disc_info_t *p_info);
+
+  /** Return the ISRC of audio track i_track of p_info, or NULL if it
+      has none. */
+  const char *cdio_disc_info_get_isrc(const cdio_disc_info_t *p_info,
+                                      track_t i_track);
+
+  /**
+    Return what cdio_guess_cd_type() made of data track i_track of
+    p_info, from the track's start, with the analysis in
+    p_iso_analysis if that isn't NULL. An audio track gives
+    CDIO_FS_AUDIO.
+  */
+  cdio_fs_anal_t cdio_disc_info_get_fs(const cdio_disc_info_t *p_info,
+                                       track_t i_track,
+                                       /*out*/ cdio_iso_analysis_t *p_iso_analysis);
+
+  /**
+    Return the CD-Text of p_info, or NULL if the disc has none. Only
+    CD-Text the driver could give raw, as drives do, is cached; for
+    the CD-Text of an image, use cdio_get_cdtext(). The CD-Text belongs
+    to p_info.
+  */
+  cdtext_t *cdio_disc_info_get_cdtext(cdio_disc_info_t *p_info);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_DISC_CACHE_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
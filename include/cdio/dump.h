@@ -0,0 +1,117 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file dump.h
+ *
+ *  \brief Dumping a whole disc to a raw image.
+ *
+ *  cdio_dump_disc() copies every sector of a disc, from the start of
+ *  the first session to the leadout, as 2352-byte raw sectors into a
+ *  single .bin file, and describes it in a CUE sheet or a cdrdao TOC
+ *  file. Either can be opened again with the bincue or the cdrdao
+ *  driver.
+ *
+ *  Each track is read with MMC READ CD for its own kind of sector:
+ *  CD-DA for audio, mode 1 for data, and any type for mode 2 tracks,
+ *  whose sectors can be of either form. Sectors are read many at a
+ *  time, and written out on another thread while the next ones are
+ *  being read. A driver without MMC, like the image drivers, is read
+ *  with cdio_read_audio_sectors() instead, which gives raw sectors of
+ *  every kind.
+ *
+ *  The pregap and indices of each track, the MCN and the ISRCs in the
+ *  sheet come from cdio_subq_find_indices().
+ */
+
+#ifndef CDIO_DUMP_H_
+#define CDIO_DUMP_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** The kind of sheet cdio_dump_disc() writes. */
+  typedef enum {
+    CDIO_DUMP_CUE = 0,  /**< A CUE sheet, for the bincue driver */
+    CDIO_DUMP_TOC = 1   /**< A cdrdao TOC file, for the cdrdao driver */
+  } cdio_dump_format_t;
+
+  /** Defaults for cdio_dump_options_t. */
+#define CDIO_DUMP_BATCH 27  /**< Sectors per read: the most that fit in
+                                 64 KiB, as much as some systems pass in
+                                 a single command */
+#define CDIO_DUMP_TRIES  4  /**< Reads of a sector before giving up */
+
+  /** How to dump; 0 in any field picks the default. */
+  typedef struct cdio_dump_options_s {
+    cdio_dump_format_t e_format;   /**< Sheet to write */
+    uint32_t           i_batch;    /**< Sectors per read */
+    unsigned int       i_tries;    /**< Reads of a sector before it is
+                                        given up on */
+    bool               b_skip_bad; /**< Fill a sector given up on with
+                                        zeros and go on, rather than
+                                        fail */
+  } cdio_dump_options_t;
+
+  /** What cdio_dump_disc() did. */
+  typedef struct cdio_dump_stats_s {
+    uint32_t i_sectors;      /**< Sectors written */
+    uint32_t i_reads;        /**< Reads issued, rereads included */
+    uint32_t i_rereads;      /**< Reads repeated after an error */
+    uint32_t i_bad_sectors;  /**< Sectors filled with zeros */
+    uint32_t i_waits;        /**< Times the reader waited for the
+                                  writer to catch up */
+  } cdio_dump_stats_t;
+
+  /**
+    Dump the disc in p_cdio to the raw image psz_bin, and write a
+    sheet for it to psz_sheet. p_options may be NULL for the defaults;
+    p_stats may be NULL.
+
+    A batch which fails is read again sector by sector, each up to
+    i_tries times, the last time asking the drive for any type of
+    sector.
+
+    The sheet names the image by its file name alone, so the two
+    should be kept in the same directory.
+
+    @return DRIVER_OP_SUCCESS, DRIVER_OP_BAD_PARAMETER if p_options
+    asks for an unknown sheet or for batches too big to hold,
+    DRIVER_OP_ERROR if the disc has no readable TOC or a file can't
+    be written, or the error of a read that kept failing.
+  */
+  driver_return_code_t cdio_dump_disc(CdIo_t *p_cdio, const char *psz_bin,
+                                      const char *psz_sheet,
+                                      const cdio_dump_options_t *p_options,
+                                      /*out*/ cdio_dump_stats_t *p_stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_DUMP_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
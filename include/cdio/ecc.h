@@ -0,0 +1,142 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file ecc.h
+ *
+ *  \brief Checking and correcting raw data sectors with their EDC and
+ *  ECC.
+ *
+ *  A raw Mode 1 or Mode 2 Form 1 sector ends in a 4-byte EDC, a CRC
+ *  over the sector's contents, and 276 bytes of Reed-Solomon "P" and
+ *  "Q" parity (ECMA-130 Annex A). A Mode 2 Form 2 sector has only the
+ *  EDC, which may be 0 for "not computed".
+ *
+ *  cdio_sector_verify() only computes the EDC, which is cheap.
+ *  cdio_sector_repair() uses the parity as well to correct damaged
+ *  bytes.
+ *
+ *  cdio_sector_encode() goes the other way, building a raw sector
+ *  with its sync pattern, header, subheader, EDC and ECC around user
+ *  data.
+ *
+ *  The image drivers check the raw sectors they read when asked to
+ *  with cdio_set_arg(p_cdio, "ecc", ...): "off" (the default),
+ *  "verify" to fail reads of damaged sectors, or "correct" to repair
+ *  what can be repaired and fail the rest.
+ */
+
+#ifndef CDIO_ECC_H_
+#define CDIO_ECC_H_
+
+#include <cdio/types.h>
+#include <cdio/sector.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** What checking a raw sector found. */
+  typedef enum {
+    CDIO_SECTOR_OK = 0,      /**< The EDC matches */
+    CDIO_SECTOR_UNCHECKED,   /**< Nothing to check against: no sync
+                                  pattern, Mode 0, or Mode 2 Form 2
+                                  without an EDC */
+    CDIO_SECTOR_CORRECTED,   /**< Damaged, and repaired */
+    CDIO_SECTOR_BAD          /**< Damaged; not repaired */
+  } cdio_sector_status_t;
+
+  /** The kinds of raw data sector cdio_sector_encode() builds. */
+  typedef enum {
+    CDIO_RAW_MODE1 = 1,    /**< 2048 bytes of data, EDC, P and Q */
+    CDIO_RAW_MODE2_FORM1,  /**< subheader, 2048 bytes, EDC, P and Q */
+    CDIO_RAW_MODE2_FORM2   /**< subheader, 2324 bytes and EDC */
+  } cdio_raw_mode_t;
+
+  /** User data bytes in a Mode 2 Form 2 sector. */
+#define CDIO_CD_M2F2_DATA_SIZE 2324
+
+  /** How the image drivers check the raw data sectors they read. */
+  typedef enum {
+    CDIO_ECC_OFF = 0,
+    CDIO_ECC_VERIFY,
+    CDIO_ECC_CORRECT
+  } cdio_ecc_mode_t;
+
+  /**
+    Return the EDC of i_len bytes at p_buf: the CRC with polynomial
+    x^32 + x^31 + x^16 + x^15 + x^4 + x^3 + x + 1 stored little-endian
+    after the data it covers.
+  */
+  uint32_t cdio_edc(const void *p_buf, size_t i_len);
+
+  /**
+    Check the EDC of the CDIO_CD_FRAMESIZE_RAW-byte sector p_sector.
+    @return CDIO_SECTOR_OK, CDIO_SECTOR_UNCHECKED or CDIO_SECTOR_BAD.
+  */
+  cdio_sector_status_t cdio_sector_verify(const uint8_t *p_sector);
+
+  /**
+    Check i_sectors consecutive raw sectors at p_sectors, storing what
+    was found for each in p_status unless that is NULL.
+    @return the number of CDIO_SECTOR_BAD sectors.
+  */
+  unsigned int cdio_sectors_verify(const uint8_t *p_sectors,
+                                   unsigned int i_sectors,
+                                   /*out*/ cdio_sector_status_t *p_status);
+
+  /**
+    Check the raw sector p_sector and if it is damaged, correct it with
+    its P and Q parity. A Mode 2 Form 2 sector has no parity and can
+    only be checked. p_sector is left alone unless it is corrected.
+    @return any cdio_sector_status_t.
+  */
+  cdio_sector_status_t cdio_sector_repair(uint8_t *p_sector);
+
+  /**
+    Build the raw sector at LSN i_lsn holding p_data, which is
+    CDIO_CD_FRAMESIZE bytes, or CDIO_CD_M2F2_DATA_SIZE for Mode 2
+    Form 2, into p_sector.
+
+    p_subheader gives the file number, channel, submode and coding
+    bytes of a Mode 2 sector; NULL means file and channel 0 with the
+    submode saying "data" (Form 1) or "Form 2". The submode's Form 2
+    bit is set from e_mode either way.
+
+    @return DRIVER_OP_SUCCESS, or DRIVER_OP_BAD_PARAMETER if e_mode
+    or i_lsn is out of range.
+  */
+  driver_return_code_t cdio_sector_encode(/*out*/ uint8_t *p_sector,
+                                          lsn_t i_lsn, cdio_raw_mode_t e_mode,
+                                          const uint8_t *p_subheader,
+                                          const void *p_data);
+
+  /** Return a short name for e_status, like "corrected". */
+  const char *cdio_sector_status2str(cdio_sector_status_t e_status);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_ECC_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
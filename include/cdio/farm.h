@@ -0,0 +1,155 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file farm.h
+ *
+ *  \brief Running jobs on many drives at once.
+ *
+ *  A drive farm opens a set of drives and gives each one a thread of
+ *  its own. The thread watches its drive for a disc being loaded,
+ *  with GET EVENT STATUS NOTIFICATION where the drive has it, and
+ *  runs one job from a queue shared by all the drives on each disc
+ *  that is loaded. A job is whatever is to be done with a disc:
+ *  imaging it, ripping it, checksumming it...
+ *
+ *  Bytes read by jobs are counted, so that the farm's throughput can
+ *  be reported as a whole and drive by drive.
+ *
+ *  Drive farms need POSIX threads; without them cdio_farm_new()
+ *  always fails.
+ */
+
+#ifndef CDIO_FARM_H_
+#define CDIO_FARM_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** An opaque drive farm. */
+  typedef struct cdio_farm_s cdio_farm_t;
+
+  /**
+    A job run on the disc in p_cdio, the drive psz_drive. It runs in
+    the drive's own thread and may take as long as it likes; the
+    drive takes no other job until the disc is changed. The farm
+    counts the bytes read through p_cdio with a trace callback, so
+    the job shouldn't set one of its own.
+
+    @return DRIVER_OP_SUCCESS for a job done, anything else for one
+    that failed.
+  */
+  typedef driver_return_code_t (*cdio_farm_job_t) (CdIo_t *p_cdio,
+                                                   const char *psz_drive,
+                                                   void *p_user_data);
+
+  /** What a farm, or one drive of it, has done so far. */
+  typedef struct cdio_farm_stats_s {
+    unsigned int i_drives;      /**< Drives counted */
+    unsigned int i_loaded;      /**< Drives with a disc in them */
+    unsigned int i_busy;        /**< Drives running a job */
+    unsigned int i_queued;      /**< Jobs waiting for a disc; the
+                                     whole queue even for one drive */
+    uint64_t     i_jobs_done;   /**< Jobs which succeeded */
+    uint64_t     i_jobs_failed; /**< Jobs which failed */
+    uint64_t     i_bytes;       /**< Bytes read by jobs */
+    uint64_t     i_nsec;        /**< Time since the farm was created */
+    uint64_t     i_busy_nsec;   /**< Time spent running jobs, summed
+                                     over the drives */
+    uint64_t     i_bytes_per_sec; /**< i_bytes over i_nsec */
+  } cdio_farm_stats_t;
+
+  /** How often, in milliseconds, drives are polled for a disc by
+      default. */
+#define CDIO_FARM_POLL_MS 500
+
+  /**
+    Open the drives in the NULL-terminated list ppsz_drives with
+    driver_id and start a thread for each of them. A NULL list means
+    every drive cdio_get_devices_with_cap() finds. Drives which can't
+    be opened are left out with a warning.
+
+    @param i_poll_ms how often to look for a disc being loaded; 0 for
+    CDIO_FARM_POLL_MS.
+
+    @param b_eject eject each disc once its job is done.
+
+    @return the farm, or NULL if no drive could be opened. Free it
+    with cdio_farm_destroy().
+  */
+  cdio_farm_t *cdio_farm_new(char *ppsz_drives[], driver_id_t driver_id,
+                             unsigned int i_poll_ms, bool b_eject);
+
+  /**
+    Queue job to be run with p_user_data on the next disc loaded into
+    psz_drive, which is a name as given by cdio_farm_get_drive(), or
+    into any drive if psz_drive is NULL. Jobs are taken in the order
+    they were queued. A disc that is already in when the job is
+    queued counts as loaded if no job has run on it yet.
+
+    @return false if the job couldn't be queued.
+  */
+  bool cdio_farm_submit(cdio_farm_t *p_farm, cdio_farm_job_t job,
+                        void *p_user_data, const char *psz_drive);
+
+  /**
+    Wait until no job is queued or running, for at most i_timeout_ms
+    milliseconds, or for as long as it takes if that is 0.
+
+    @return true if the farm is idle, false on timeout.
+  */
+  bool cdio_farm_wait(cdio_farm_t *p_farm, unsigned int i_timeout_ms);
+
+  /** Return the number of drives in p_farm. */
+  unsigned int cdio_farm_num_drives(const cdio_farm_t *p_farm);
+
+  /** Return the name of drive i_drive of p_farm, counting from 0, or
+      NULL if there is no such drive. */
+  const char *cdio_farm_get_drive(const cdio_farm_t *p_farm,
+                                  unsigned int i_drive);
+
+  /** Put what all the drives of p_farm have done into p_stats. */
+  driver_return_code_t cdio_farm_get_stats(cdio_farm_t *p_farm,
+                                           /*out*/ cdio_farm_stats_t *p_stats);
+
+  /** Put what drive i_drive of p_farm has done into p_stats. */
+  driver_return_code_t
+  cdio_farm_get_drive_stats(cdio_farm_t *p_farm, unsigned int i_drive,
+                            /*out*/ cdio_farm_stats_t *p_stats);
+
+  /**
+    Stop p_farm: let running jobs finish, drop the ones still queued,
+    and close the drives.
+  */
+  void cdio_farm_destroy(cdio_farm_t *p_farm);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_FARM_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -156,6 +156,12 @@ extern enum iso_vd_enum_s {
 /*! \brief Maximum number of characters in a volume-set id. */
 #define ISO_MAX_VOLUMESET_ID 128
 
+/*! \brief Maximum number of extents of one file that we keep track
+    of. Files bigger than 4 GiB are recorded as several extents, which
+    mkisofs makes just under 4 GiB each, so this is enough for files
+    of about 128 GiB. A file with more extents can't be stat'ed. */
+#define ISO_MAX_MULTIEXTENT 32
+
 /*! String inside frame which identifies an ISO 9660 filesystem. This
     string is the "id" field of an iso9660_pvd_t or an iso9660_svd_t.
 */
@@ -521,12 +527,22 @@ struct iso9660_stat_s { /* big endian!! */
 
   struct tm          tm;              /**< time on entry - FIXME merge with
                                          one of entries above, like ctime? */
-  lsn_t              lsn;             /**< start logical sector number */
-  uint32_t           size;            /**< total size in bytes */
-  uint32_t           secsize;         /**< number of sectors allocated */
+  lsn_t              lsn;             /**< start logical sector number of
+                                         the first extent */
+  uint32_t           size;            /**< size in bytes of the first
+                                         extent; see total_size */
+  uint32_t           secsize;         /**< number of sectors allocated to
+                                         the first extent */
   iso9660_xa_t       xa;              /**< XA attributes */
   enum { _STAT_FILE = 1, _STAT_DIR = 2 } type;
   bool               b_xa;
+  uint64_t           total_size;      /**< size in bytes over all extents */
+  unsigned int       extents;         /**< number of extents: 1 unless the
+                                         file is multi-extent */
+  lsn_t              extent_lsn[ISO_MAX_MULTIEXTENT];  /**< where each
+                                                          extent starts */
+  uint32_t           extent_size[ISO_MAX_MULTIEXTENT]; /**< size in bytes
+                                                          of each extent */
   char         filename[EMPTY_ARRAY_SIZE]; /**< filename */
 };
 
@@ -644,6 +660,45 @@ typedef struct _iso9660_s iso9660_t;
   */
   long int iso9660_iso_seek_read (const iso9660_t *p_iso, /*out*/ void *ptr, 
                                   lsn_t start, long int i_size);
+
+  /*!
+    Read i_blocks blocks of the file p_stat, starting i_block blocks
+    into it, into ptr. Unlike reading from p_stat->lsn with
+    iso9660_iso_seek_read, this follows all the extents of a
+    multi-extent file, with one seek and read for each extent the
+    blocks span. Nothing past the file's last block is read.
+
+    @return number of bytes (not blocks) read
+  */
+  long int iso9660_iso_seek_read_file (const iso9660_t *p_iso,
+                                       const iso9660_stat_t *p_stat,
+                                       /*out*/ void *ptr, uint64_t i_block,
+                                       long int i_blocks);
+
+  /*!
+    Copy the I/O statistics of the reads p_iso has done on its image
+    file into p_stats. See <cdio/stats.h>.
+
+    @return DRIVER_OP_SUCCESS, or DRIVER_OP_UNINIT if p_iso is NULL,
+    or DRIVER_OP_BAD_POINTER if p_stats is NULL.
+  */
+  driver_return_code_t iso9660_get_stats (const iso9660_t *p_iso,
+                                          /*out*/ cdio_stats_t *p_stats);
+
+  /*!
+    Set all of the I/O statistics of p_iso back to zero.
+  */
+  driver_return_code_t iso9660_reset_stats (iso9660_t *p_iso);
+
+  /*!
+    Install callback to be called after every read p_iso does on its
+    image file, or remove it if callback is NULL. Reads done through a
+    CdIo_t by the iso9660_fs_ routines are traced by the CdIo_t; see
+    cdio_set_trace_callback().
+  */
+  driver_return_code_t iso9660_set_trace_callback (iso9660_t *p_iso,
+                                                   cdio_trace_callback_t callback,
+                                                   void *p_user_data);
   
   /*!
     Read the Primary Volume Descriptor for a CD.
@@ -1114,6 +1169,85 @@ lsn_t iso9660_get_dir_extent(const iso9660_dir_t *p_idr);
 
   void iso9660_set_evd (void *pd);
 
+  /**=====================================================================
+     Image Building
+     ======================================================================*/
+
+  /** An ISO 9660 image being built. This is an opaque structure. */
+  typedef struct iso9660_writer_s iso9660_writer_t;
+
+  /*!
+    Start building an image with volume ID psz_volume_id.
+
+    u_extensions picks the extensions to write: with any of
+    ISO_EXTENSION_JOLIET the image gets a second, Joliet, directory
+    tree with UCS-2 names of up to 64 characters, and with
+    ISO_EXTENSION_ROCK_RIDGE the ISO 9660 tree carries Rock Ridge
+    names, permissions, owners and times. The ISO 9660 names
+    themselves are level 2: up to 31 upper case d-characters.
+
+    Adding files only records their names and where their contents
+    are; nothing is read until iso9660_writer_write().
+
+    @return the writer, or NULL if we ran out of memory. Free it with
+    iso9660_writer_free().
+  */
+  iso9660_writer_t *iso9660_writer_new (const char psz_volume_id[],
+                                        iso_extension_mask_t u_extensions);
+
+  /*!
+    Set the publisher, data preparer and application IDs of the image
+    being built. NULL leaves an ID as it was.
+  */
+  void iso9660_writer_set_ids (iso9660_writer_t *p_writer,
+                               const char psz_publisher_id[],
+                               const char psz_preparer_id[],
+                               const char psz_application_id[]);
+
+  /*!
+    Add the directory psz_path, like "a/b/c", to the image. Missing
+    directories on the way are added too.
+  */
+  bool iso9660_writer_add_dir (iso9660_writer_t *p_writer,
+                               const char psz_path[]);
+
+  /*!
+    Add the file psz_path to the image, with the contents and
+    attributes of psz_source. Adding the same path again replaces the
+    file. Files must be smaller than 4 GiB.
+  */
+  bool iso9660_writer_add_file (iso9660_writer_t *p_writer,
+                                const char psz_path[],
+                                const char psz_source[]);
+
+  /*!
+    Add the directory psz_source_dir and all the files and
+    directories under it to the image as psz_path. Anything that is
+    not a regular file or a directory, symbolic links included, is
+    skipped.
+  */
+  bool iso9660_writer_add_tree (iso9660_writer_t *p_writer,
+                                const char psz_path[],
+                                const char psz_source_dir[]);
+
+  /*!
+    Write the image to psz_image.
+
+    The directories and path tables are laid out in memory, and
+    the image is written sequentially in a single pass, each file's
+    contents being copied straight into it. Names that come out the
+    same in ISO 9660 or Joliet form get a numeric suffix.
+
+    @return true on success; false if there are more than 65535
+    directories, the image would be too big, or a file can't be read
+    or the image written.
+  */
+  bool iso9660_writer_write (iso9660_writer_t *p_writer,
+                             const char psz_image[]);
+
+  /*! Free p_writer and everything added to it. */
+  void iso9660_writer_free (iso9660_writer_t *p_writer);
+
   /*!
     Return true if ISO 9660 image has extended attrributes (XA).
   */
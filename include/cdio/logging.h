@@ -118,10 +118,74 @@ void cdio_warn (const char format[], ...) GNUC_PRINTF(1,2);
  */
 void cdio_error (const char format[], ...) GNUC_PRINTF(1,2);
 
+/**
+ * Send log messages through a ring buffer that a background thread
+ * drains into handler. Messages are still formatted by the thread
+ * which logs them, but writing them out no longer holds it up, so
+ * threads reading a disc are not serialized on the output.
+ *
+ * If the buffer is full the message is dropped and counted; see
+ * cdio_log_async_dropped(). Error and assert messages are not
+ * buffered: the buffer is drained first and then they go straight to
+ * handler, since handling them usually ends the program.
+ *
+ * While the sink is running, cdio_log_set_handler() changes the
+ * handler the background thread delivers to.
+ *
+ * @param handler  where the messages go. If NULL, the handler
+ *                 currently set is used.
+ * @param i_slots  number of messages the buffer holds, rounded up to
+ *                 a power of two. 0 gives a default of 256.
+ * @return true if the sink was started. false is returned if it is
+ *         already running or is not available on this platform.
+ */
+bool cdio_log_async_start (cdio_log_handler_t handler, unsigned int i_slots);
+
+/**
+ * Deliver any messages still buffered, stop the background thread
+ * and put back the handler that was in use before
+ * cdio_log_async_start(), or the one set since then with
+ * cdio_log_set_handler().
+ */
+void cdio_log_async_stop (void);
+
+/**
+ * Return the number of messages dropped because the ring buffer was
+ * full, since the sink was last started.
+ */
+unsigned long cdio_log_async_dropped (void);
+
 #ifdef __cplusplus
 }
 #endif
 
+/*
+ * Messages below CDIO_LOG_MIN_LEVEL can be compiled out altogether.
+ * Define it to the numeric value of the lowest level to keep, e.g.
+ * -DCDIO_LOG_MIN_LEVEL=3 keeps only warnings and more serious
+ * messages; 1 (debug), the default, keeps everything. Error and assert
+ * messages are always kept. The arguments of dropped calls are not
+ * evaluated.
+ */
+#ifndef CDIO_LOG_MIN_LEVEL
+#define CDIO_LOG_MIN_LEVEL 1
+#endif
+
+#if CDIO_LOG_MIN_LEVEL > 1 \
+  && (defined(__GNUC__) \
+      || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L))
+# define cdio_debug(...) ((void) 0)
+# if CDIO_LOG_MIN_LEVEL > 2
+#  define cdio_info(...) ((void) 0)
+# endif
+# if CDIO_LOG_MIN_LEVEL > 3
+#  define cdio_warn(...) ((void) 0)
+# endif
+# define cdio_log(level, ...)                                           \
+  ((int) (level) >= CDIO_LOG_MIN_LEVEL || (level) >= CDIO_LOG_ERROR      \
+   ? cdio_log((level), __VA_ARGS__) : (void) 0)
+#endif
+
 #endif /* CDIO_LOGGING_H_ */
 
 
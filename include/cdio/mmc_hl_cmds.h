@@ -117,6 +117,88 @@ extern "C" {
                                             int i_drive_speed );
 
 
+  /** What mmc_read_cd_batch() can return for each sector; or them
+      together. */
+  typedef enum {
+    MMC_READ_PLANE_DATA  = 0x01, /**< The CDIO_CD_FRAMESIZE_RAW bytes
+                                      of the main channel */
+    MMC_READ_PLANE_C2    = 0x02, /**< MMC_C2_SIZE bytes, one bit per
+                                      main channel byte, set where the
+                                      drive found a C2 error */
+    MMC_READ_PLANE_SUBQ  = 0x04, /**< MMC_SUBQ_SIZE bytes of Q
+                                      sub-channel: 10 of data and the
+                                      CRC */
+    MMC_READ_PLANE_SUBPW = 0x08  /**< CDIO_CD_FRAMESIZE_SUB bytes of raw
+                                      P-W sub-channel, one bit of each
+                                      channel per byte */
+  } mmc_read_plane_t;
+
+#define MMC_C2_SIZE   294
+#define MMC_SUBQ_SIZE  12
+
+  /**
+    A batch of sectors read with mmc_read_cd_batch(). Each kind of
+    data is kept in a plane of its own, sector after sector, rather
+    than interleaved as the drive sends it. Create it with
+    mmc_read_batch_new().
+  */
+  typedef struct mmc_read_batch_s {
+    lsn_t        i_lsn;        /**< First sector read */
+    uint32_t     i_blocks;     /**< Sectors read */
+    uint32_t     i_max_blocks; /**< Sectors the planes hold */
+    unsigned int i_planes;     /**< mmc_read_plane_t bits asked for */
+    unsigned int i_filled;     /**< Those of them which the last read
+                                    filled in. An image has no C2 or
+                                    sub-channel, for example. */
+    uint8_t     *p_data;       /**< MMC_READ_PLANE_DATA */
+    uint8_t     *p_c2;         /**< MMC_READ_PLANE_C2 */
+    uint8_t     *p_subq;       /**< MMC_READ_PLANE_SUBQ */
+    uint8_t     *p_subpw;      /**< MMC_READ_PLANE_SUBPW */
+    uint16_t    *p_c2_errors;  /**< With MMC_READ_PLANE_C2: the number of
+                                    bytes flagged in each sector */
+    uint32_t     i_bad;        /**< Sectors with any byte flagged */
+    uint8_t     *p_raw;        /**< Private: the drive's transfer */
+  } mmc_read_batch_t;
+
+  /**
+    Allocate a batch for up to i_max_blocks sectors of the
+    mmc_read_plane_t kinds in i_planes.
+
+    @return the batch, or NULL if there is no memory. Free it with
+    mmc_read_batch_free().
+  */
+  mmc_read_batch_t *mmc_read_batch_new(unsigned int i_planes,
+                                       uint32_t i_max_blocks);
+
+  void mmc_read_batch_free(mmc_read_batch_t *p_batch);
+
+  /**
+    Read i_blocks raw sectors from i_lsn into p_batch with MMC READ CD
+    commands, asking the drive for the C2 error pointers and the
+    sub-channel as well if p_batch wants them.
+
+    Drivers without MMC, like the image drivers, fill in only the
+    main channel plane, with cdio_read_audio_sectors().
+
+    @return DRIVER_OP_SUCCESS, DRIVER_OP_BAD_PARAMETER if i_blocks is
+    more than p_batch holds, or the error of the read.
+  */
+  driver_return_code_t mmc_read_cd_batch(const CdIo_t *p_cdio, lsn_t i_lsn,
+                                         uint32_t i_blocks,
+                                         mmc_read_batch_t *p_batch);
+
+  /**
+    Read again, up to i_tries times, just the sectors of p_batch that
+    have C2 errors, runs of them at a time. A sector is replaced
+    whenever it comes back with fewer bytes flagged.
+
+    @return DRIVER_OP_SUCCESS, whether or not every sector came back
+    clean (see p_batch->i_bad), or the error of a read.
+  */
+  driver_return_code_t mmc_read_cd_batch_retry(const CdIo_t *p_cdio,
+                                               mmc_read_batch_t *p_batch,
+                                               unsigned int i_tries);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,143 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file read_ctl.h
+ *
+ *  \brief Bulk reads which adapt speed and transfer size to the disc.
+ *
+ *  A read controller reads through cdio_read_sectors() and keeps
+ *  track, region by region, of how often reads fail and how long they
+ *  take. When a read fails, the controller halves the transfer until
+ *  the bad sector is found, slows the drive down, and retries that
+ *  sector a bounded number of times. Reads which are much slower than
+ *  usual also slow the drive. After a run of good reads, it lets the
+ *  transfers grow and the speed come back up. A region where reads
+ *  have failed before is always read in small transfers.
+ *
+ *  Speed is set with cdio_set_speed(). Drivers which can't set the
+ *  speed, like the image drivers, just get the transfer size and
+ *  retry handling.
+ */
+
+#ifndef CDIO_READ_CTL_H_
+#define CDIO_READ_CTL_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+#include <cdio/read.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** An opaque read controller. */
+  typedef struct cdio_read_ctl_s cdio_read_ctl_t;
+
+  /** Defaults for cdio_read_ctl_options_t. */
+#define CDIO_READ_CTL_MAX_SPEED  48 /**< In CD-ROM speed units */
+#define CDIO_READ_CTL_MIN_SPEED   4
+#define CDIO_READ_CTL_MAX_BLOCKS 32 /**< Sectors per transfer */
+#define CDIO_READ_CTL_TRIES       4 /**< Reads of a failing sector */
+
+  /** Sectors in each region whose errors and latency are tracked. */
+#define CDIO_READ_CTL_REGION   1024
+
+  /** How to read; 0 in any field picks the default. */
+  typedef struct cdio_read_ctl_options_s {
+    int          i_max_speed;  /**< Fastest speed used */
+    int          i_min_speed;  /**< Slowest speed stepped down to */
+    uint32_t     i_max_blocks; /**< Largest transfer */
+    unsigned int i_tries;      /**< Reads of a sector before it is given
+                                    up on */
+    bool         b_skip_bad;   /**< Fill a sector given up on with zeros
+                                    and go on, rather than fail */
+  } cdio_read_ctl_options_t;
+
+  /** What a read controller has done. */
+  typedef struct cdio_read_ctl_stats_s {
+    uint64_t i_sectors;       /**< Sectors read, bad ones included */
+    uint64_t i_reads;         /**< Transfers issued */
+    uint64_t i_errors;        /**< Transfers which failed */
+    uint64_t i_slow;          /**< Transfers much slower than usual */
+    uint64_t i_bad_sectors;   /**< Sectors given up on */
+    uint32_t i_speed_changes; /**< Times the speed was set */
+    int      i_speed;         /**< Speed now; 0 if it can't be set */
+    uint32_t i_blocks;        /**< Transfer size now */
+  } cdio_read_ctl_stats_t;
+
+  /** Reads and errors in one region. */
+  typedef struct cdio_read_region_s {
+    lsn_t    i_lsn;           /**< First sector of the region */
+    uint32_t i_reads;         /**< Transfers begun in it */
+    uint32_t i_errors;        /**< Those which failed */
+    uint64_t i_sectors;       /**< Sectors read from it */
+    uint64_t i_nsec;          /**< Time its transfers took */
+  } cdio_read_region_t;
+
+  /**
+    Create a controller for reads from p_cdio, which must stay open as
+    long as the controller is used. p_options may be NULL.
+
+    @return the controller, or NULL if there is no memory. Free it
+    with cdio_read_ctl_free().
+  */
+  cdio_read_ctl_t *cdio_read_ctl_new(CdIo_t *p_cdio,
+                                     const cdio_read_ctl_options_t *p_options);
+
+  /**
+    Free p_ctl. The drive is left at the speed the controller last
+    set.
+  */
+  void cdio_read_ctl_free(cdio_read_ctl_t *p_ctl);
+
+  /**
+    Read i_blocks read_mode sectors from i_lsn into p_buf, as
+    cdio_read_sectors() does: form 2 sectors take M2RAW_SECTOR_SIZE
+    bytes each.
+
+    @return DRIVER_OP_SUCCESS, or the error of a sector that couldn't
+    be read in the tries allowed when b_skip_bad is not set.
+  */
+  driver_return_code_t cdio_read_ctl_read(cdio_read_ctl_t *p_ctl,
+                                          void *p_buf, lsn_t i_lsn,
+                                          cdio_read_mode_t read_mode,
+                                          uint32_t i_blocks);
+
+  /** Put what p_ctl has done into p_stats. */
+  driver_return_code_t
+  cdio_read_ctl_get_stats(const cdio_read_ctl_t *p_ctl,
+                          /*out*/ cdio_read_ctl_stats_t *p_stats);
+
+  /** Put what p_ctl knows about the region i_lsn is in into
+      p_region. */
+  driver_return_code_t
+  cdio_read_ctl_get_region(const cdio_read_ctl_t *p_ctl, lsn_t i_lsn,
+                           /*out*/ cdio_read_region_t *p_region);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_READ_CTL_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
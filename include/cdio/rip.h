@@ -0,0 +1,133 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file rip.h
+ *
+ *  \brief Extracting audio with jitter correction.
+ *
+ *  Drives reading audio don't always start a read at exactly the
+ *  sample asked for: the data can come back shifted by a few samples
+ *  ("jitter"), and reading sector by sector then drops or repeats
+ *  samples wherever two reads meet.
+ *
+ *  cdio_rip_audio() reads in large batches with
+ *  cdio_read_audio_sectors(). Each read also covers the last few
+ *  sectors of the one before it, and the shared samples are matched
+ *  up to find how far the new read is shifted. A read whose overlap
+ *  can't be matched at all is read again. The PCM which results is
+ *  handed over in order to a callback, on the calling thread, while
+ *  the next batches are being read on another.
+ */
+
+#ifndef CDIO_RIP_H_
+#define CDIO_RIP_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** Samples, each two 16-bit channels, in an audio sector. */
+#define CDIO_CD_SAMPLES_PER_SECTOR (CDIO_CD_FRAMESIZE_RAW / 4)
+
+  /** Defaults for cdio_rip_options_t. */
+#define CDIO_RIP_BATCH   24   /**< Sectors per read */
+#define CDIO_RIP_OVERLAP  3   /**< Sectors shared by consecutive reads */
+#define CDIO_RIP_JITTER 588   /**< Samples of shift looked for each way */
+#define CDIO_RIP_TRIES    5   /**< Reads of a batch before giving up */
+
+  /** How to read; 0 in any field picks the default. */
+  typedef struct cdio_rip_options_s {
+    uint32_t     i_batch;    /**< Sectors per read, overlap included */
+    uint32_t     i_overlap;  /**< Sectors each read shares with the one
+                                  before; at most half of i_batch */
+    uint32_t     i_jitter;   /**< Largest shift corrected, in samples;
+                                  at most a third of the overlap */
+    unsigned int i_tries;    /**< Reads of a batch before its data is
+                                  used unverified, or before a read
+                                  error is given up on */
+  } cdio_rip_options_t;
+
+  /** What cdio_rip_audio() did. */
+  typedef struct cdio_rip_stats_s {
+    uint32_t i_sectors;     /**< Sectors' worth of PCM delivered */
+    uint32_t i_reads;       /**< Reads issued, rereads included */
+    uint32_t i_rereads;     /**< Reads repeated because the overlap
+                                 didn't match or the read failed */
+    uint32_t i_shifted;     /**< Reads found shifted, and realigned */
+    uint32_t i_max_shift;   /**< Largest shift found, in samples */
+    uint32_t i_unverified;  /**< Sectors delivered from reads whose
+                                 overlap never matched */
+  } cdio_rip_stats_t;
+
+  /**
+    Take i_bytes of PCM, a multiple of 4, continuing what came before.
+    Chunks don't follow sector boundaries.
+
+    @return DRIVER_OP_SUCCESS to go on; anything else stops the
+    extraction, and is what cdio_rip_audio() returns.
+  */
+  typedef driver_return_code_t (*cdio_rip_callback_t) (const uint8_t *p_pcm,
+                                                       size_t i_bytes,
+                                                       void *p_user_data);
+
+  /**
+    Extract the i_sectors audio sectors from i_lsn, passing their PCM
+    to callback. p_options may be NULL for the defaults; p_stats may
+    be NULL.
+
+    A few sectors past the end are read, where the disc has them, so
+    that a shift at the end can be made up.
+
+    @return DRIVER_OP_SUCCESS once all the PCM has been delivered, the
+    error of a read that kept failing, or what callback returned to
+    stop.
+  */
+  driver_return_code_t cdio_rip_audio(CdIo_t *p_cdio, lsn_t i_lsn,
+                                      uint32_t i_sectors,
+                                      const cdio_rip_options_t *p_options,
+                                      cdio_rip_callback_t callback,
+                                      void *p_user_data,
+                                      /*out*/ cdio_rip_stats_t *p_stats);
+
+  /**
+    Extract audio track i_track with cdio_rip_audio().
+
+    @return as cdio_rip_audio(), or DRIVER_OP_BAD_PARAMETER if the
+    track isn't an audio track.
+  */
+  driver_return_code_t cdio_rip_track(CdIo_t *p_cdio, track_t i_track,
+                                      const cdio_rip_options_t *p_options,
+                                      cdio_rip_callback_t callback,
+                                      void *p_user_data,
+                                      /*out*/ cdio_rip_stats_t *p_stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_RIP_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,154 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file stats.h
+ *
+ *  \brief I/O statistics and tracing for CdIo_t objects.
+ *
+ *  Every CdIo_t keeps counters of the reads, seeks and MMC commands
+ *  issued through it, along with the time spent in each kind of
+ *  driver operation. The counters can be fetched and reset at any
+ *  time. A trace callback can also be installed which is called once
+ *  per driver operation, after it completes.
+ *
+ *  iso9660_t and udf_t objects keep the same counters for the reads
+ *  they do on their own; see iso9660_get_stats() and udf_get_stats().
+ */
+
+#ifndef CDIO_STATS_H_
+#define CDIO_STATS_H_
+
+#include <cdio/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** The kinds of driver operation that are counted and traced. */
+  typedef enum {
+    CDIO_STATS_READ_AUDIO,  /**< cdio_read_audio_sector(s) */
+    CDIO_STATS_READ_DATA,   /**< cdio_read_data_sectors */
+    CDIO_STATS_READ_MODE1,  /**< cdio_read_mode1_sector(s) */
+    CDIO_STATS_READ_MODE2,  /**< cdio_read_mode2_sector(s) */
+    CDIO_STATS_READ,        /**< cdio_read, and the block reads an
+                                 iso9660_t or udf_t does on an image
+                                 file */
+    CDIO_STATS_SEEK,        /**< cdio_lseek */
+    CDIO_STATS_MMC,         /**< an MMC command sent to the drive */
+    CDIO_STATS_OP_COUNT     /**< Number of entries above; not an
+                                 operation. */
+  } cdio_stats_op_t;
+
+  /** Counters for one kind of driver operation. */
+  typedef struct cdio_stats_op_counter_s {
+    uint64_t i_calls;       /**< Number of times the operation ran. */
+    uint64_t i_errors;      /**< How many of those failed. */
+    uint64_t i_nsec;        /**< Total time spent in it, in
+                                 nanoseconds. */
+  } cdio_stats_op_counter_t;
+
+  /** I/O statistics for a CdIo_t, iso9660_t or udf_t. */
+  typedef struct cdio_stats_s {
+    uint64_t i_sectors_read;  /**< Sectors returned by successful
+                                   reads. */
+    uint64_t i_read_calls;    /**< Read operations, including failed
+                                   ones. */
+    uint64_t i_seeks;         /**< Explicit seeks, plus reads which
+                                   did not start where the previous
+                                   read ended. */
+    uint64_t i_bytes_copied;  /**< Bytes returned by successful
+                                   reads. */
+    uint64_t i_cache_hits;    /**< LSN-to-track lookups answered
+                                   from the cached TOC without going
+                                   to the driver. */
+    uint64_t i_mmc_cmds;      /**< MMC commands issued. */
+    cdio_stats_op_counter_t op[CDIO_STATS_OP_COUNT]; /**< Per-operation
+                                                        counters and
+                                                        latency. */
+  } cdio_stats_t;
+
+  /** What a trace callback is told about a driver operation. */
+  typedef struct cdio_trace_event_s {
+    cdio_stats_op_t e_op;       /**< Kind of operation. */
+    const char *psz_source;     /**< Name the object was opened with;
+                                     may be NULL. */
+    lsn_t    i_lsn;             /**< First sector, or CDIO_INVALID_LSN
+                                     if the operation isn't
+                                     sector-addressed. */
+    uint32_t i_blocks;          /**< Number of sectors asked for. */
+    uint64_t i_bytes;           /**< Bytes returned; 0 on error. */
+    uint8_t  i_mmc_opcode;      /**< First CDB byte for
+                                     CDIO_STATS_MMC; else 0. */
+    int      i_status;          /**< driver_return_code_t of the
+                                     operation, or for
+                                     CDIO_STATS_READ and
+                                     CDIO_STATS_SEEK the negative
+                                     value returned on failure. */
+    uint64_t i_nsec;            /**< Time the operation took, in
+                                     nanoseconds. */
+  } cdio_trace_event_t;
+
+  /** Trace callback type. p_event is only valid during the call. */
+  typedef void (*cdio_trace_callback_t) (const cdio_trace_event_t *p_event,
+                                         void *p_user_data);
+
+  /*!
+    Return a short name for e_op, like "read_audio" or "mmc", suitable
+    for use as a metric label.
+  */
+  const char *cdio_stats_op2str(cdio_stats_op_t e_op);
+
+  /*!
+    Copy the I/O statistics of p_cdio into p_stats.
+
+    @return DRIVER_OP_SUCCESS, or DRIVER_OP_UNINIT if p_cdio is NULL,
+    or DRIVER_OP_BAD_POINTER if p_stats is NULL.
+  */
+  driver_return_code_t cdio_get_stats(const CdIo_t *p_cdio,
+                                      /*out*/ cdio_stats_t *p_stats);
+
+  /*!
+    Set all of the I/O statistics of p_cdio back to zero. The trace
+    callback, if any, stays installed.
+  */
+  driver_return_code_t cdio_reset_stats(CdIo_t *p_cdio);
+
+  /*!
+    Install callback to be called after every driver operation done
+    through p_cdio, or remove the callback if it is NULL. p_user_data
+    is passed to the callback as given.
+
+    The callback runs in the thread that issued the operation and adds
+    to its latency, so it should be quick.
+  */
+  driver_return_code_t cdio_set_trace_callback(CdIo_t *p_cdio,
+                                               cdio_trace_callback_t callback,
+                                               void *p_user_data);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_STATS_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
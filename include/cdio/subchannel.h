@@ -0,0 +1,182 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file subchannel.h
+ *
+ *  \brief Decoding Q sub-channel, and scanning a disc for what it
+ *  holds.
+ *
+ *  Every sector carries 12 bytes of Q sub-channel. Most give the
+ *  position: the track, the index and the time. Now and then one
+ *  gives the Media Catalog Number (MCN) or, in an audio track, the
+ *  track's ISRC instead.
+ *
+ *  cdio_subq_scan() reads the Q of a range of sectors in a single
+ *  sequential pass, with READ CD asking for no main channel data, and
+ *  gathers the MCN, every track's ISRC, and the first sector of every
+ *  index at once. Index 0 is the pregap. This takes the place of a
+ *  READ SUB-CHANNEL, with its seek, for each track.
+ *
+ *  cdio_subq_find_indices() gets the same from a physical disc
+ *  without reading all of it: it searches for where each pregap and
+ *  each index begins around the boundaries the TOC gives, a few
+ *  sectors at a time, so that the reads it takes grow with the log of
+ *  the lengths involved rather than with the disc. What it finds is
+ *  all a CUE sheet needs.
+ */
+
+#ifndef CDIO_SUBCHANNEL_H_
+#define CDIO_SUBCHANNEL_H_
+
+#include <cdio/types.h>
+#include <cdio/device.h>
+#include <cdio/track.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /** What a Q sub-channel frame holds. */
+  typedef enum {
+    CDIO_SUBQ_POSITION = 1, /**< Track, index and time */
+    CDIO_SUBQ_MCN      = 2, /**< Media Catalog Number */
+    CDIO_SUBQ_ISRC     = 3  /**< ISRC of the track */
+  } cdio_subq_adr_t;
+
+  /** The highest index a track can have. */
+#define CDIO_SUBQ_MAX_INDEX 99
+
+  /** The track number Q gives in the leadout. */
+#define CDIO_SUBQ_LEADOUT 0xAA
+
+  /** A decoded Q sub-channel frame. */
+  typedef struct cdio_subq_s {
+    uint8_t i_control;  /**< Track flags: 4-channel, copy, pre-emphasis,
+                             data */
+    uint8_t i_adr;      /**< cdio_subq_adr_t: which fields below are
+                             set */
+    track_t i_track;    /**< CDIO_SUBQ_POSITION: the track, or
+                             CDIO_SUBQ_LEADOUT */
+    uint8_t i_index;    /**< CDIO_SUBQ_POSITION: the index */
+    int32_t i_rel;      /**< CDIO_SUBQ_POSITION: sectors from index 1
+                             of the track; negative in the pregap */
+    lsn_t   i_lsn;      /**< CDIO_SUBQ_POSITION: the sector's own
+                             address; otherwise CDIO_INVALID_LSN */
+    char    psz_text[CDIO_MCN_SIZE + 1]; /**< CDIO_SUBQ_MCN: the MCN;
+                                              CDIO_SUBQ_ISRC: the ISRC */
+  } cdio_subq_t;
+
+  /**
+    Decode the 12 bytes of Q sub-channel p_q, as in a
+    MMC_READ_PLANE_SUBQ plane, into p_subq. A frame with a CRC that
+    doesn't match is rejected; one with no CRC at all, as some drives
+    give, is taken as it is.
+
+    @return false if the frame is corrupt or of an unknown kind.
+  */
+  bool cdio_subq_decode(const uint8_t *p_q, /*out*/ cdio_subq_t *p_subq);
+
+  /** Return the CRC a Q frame carries in its last two bytes for the
+      10 bytes of p_q. */
+  uint16_t cdio_subq_crc(const uint8_t *p_q);
+
+  /** What a scan found out about one track. */
+  typedef struct cdio_subq_track_s {
+    lsn_t   i_index[CDIO_SUBQ_MAX_INDEX + 1]; /**< First sector of each
+                                                   index seen, or
+                                                   CDIO_INVALID_LSN;
+                                                   index 0 is the
+                                                   pregap */
+    uint8_t i_last_index;  /**< Highest index seen */
+    uint8_t i_control;     /**< Track flags, as in cdio_subq_t */
+    char    psz_isrc[CDIO_ISRC_SIZE + 1]; /**< Empty if none was seen */
+  } cdio_subq_track_t;
+
+  /** What a scan found out about a disc. */
+  typedef struct cdio_subq_scan_s {
+    track_t  i_first_track;  /**< First track seen, or
+                                  CDIO_INVALID_TRACK */
+    track_t  i_last_track;   /**< Last track seen */
+    char     psz_mcn[CDIO_MCN_SIZE + 1]; /**< Empty if none was seen */
+    bool     b_subchannel;   /**< false if the driver has no sub-channel
+                                  and what is here came from its own
+                                  accessors */
+    uint32_t i_sectors;      /**< Sectors whose Q was read */
+    uint32_t i_reads;        /**< Batches read with
+                                  mmc_read_cd_batch() */
+    uint32_t i_bad;          /**< Q frames rejected */
+    cdio_subq_track_t track[CDIO_CD_MAX_TRACKS + 1]; /**< By track
+                                                          number */
+  } cdio_subq_scan_t;
+
+  /** Sectors read by each batch of a scan. */
+#define CDIO_SUBQ_SCAN_BATCH 300
+
+  /**
+    Read the Q sub-channel of the i_sectors sectors from i_lsn into
+    p_scan, which is reset first. An i_sectors of 0 scans up to the
+    leadout. The scan is about 16 bytes a sector, so a whole disc
+    takes as long as the drive needs to spin over it.
+
+    A driver without sub-channel, like the image drivers, fills in
+    p_scan from cdio_get_mcn(), cdio_get_track_isrc(),
+    cdio_get_track_pregap_lsn() and cdio_get_track_lsn() instead.
+
+    @return DRIVER_OP_SUCCESS, or the error of a read.
+  */
+  driver_return_code_t cdio_subq_scan(CdIo_t *p_cdio, lsn_t i_lsn,
+                                      uint32_t i_sectors,
+                                      /*out*/ cdio_subq_scan_t *p_scan);
+
+  /**
+    Find the pregap and the indices of every track of the disc in
+    p_cdio, and its MCN and ISRCs, into p_scan, which is reset first.
+
+    Index 1 of each track is taken from the TOC. Where the pregap
+    before it begins is found by binary search on the Q of sectors
+    before it, and indices 2 and up, if the Q near the end of the
+    track shows there are any, by binary search within it. The MCN
+    and the ISRC of every audio track are taken from the Q read
+    along the way, and from the first sectors of a track if need be.
+    Each probe is placed by the address in the Q it reads, so the
+    result is exact even from a drive that returns the Q of a sector
+    near the one asked for. A track takes a few dozen short reads at
+    most, whatever its length.
+
+    An index whose probes find no Q that can be read is left out
+    of p_scan; the rest of the disc is searched all the same. A
+    driver without sub-channel fills in p_scan as cdio_subq_scan()
+    does.
+
+    @return DRIVER_OP_SUCCESS, or the error of a read.
+  */
+  driver_return_code_t cdio_subq_find_indices(CdIo_t *p_cdio,
+                                              /*out*/ cdio_subq_scan_t *p_scan);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_SUBCHANNEL_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
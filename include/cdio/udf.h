@@ -87,6 +87,29 @@ extern "C" {
   driver_return_code_t udf_read_sectors (const udf_t *p_udf, void *ptr, 
                                          lsn_t i_start,  long int i_blocks);
 
+  /*!
+    Copy the I/O statistics of the reads done through
+    udf_read_sectors() on p_udf into p_stats. See <cdio/stats.h>.
+
+    @return DRIVER_OP_SUCCESS, or DRIVER_OP_UNINIT if p_udf is NULL,
+    or DRIVER_OP_BAD_POINTER if p_stats is NULL.
+  */
+  driver_return_code_t udf_get_stats (const udf_t *p_udf,
+                                      /*out*/ cdio_stats_t *p_stats);
+
+  /*!
+    Set all of the I/O statistics of p_udf back to zero.
+  */
+  driver_return_code_t udf_reset_stats (udf_t *p_udf);
+
+  /*!
+    Install callback to be called after every udf_read_sectors() on
+    p_udf, or remove it if callback is NULL.
+  */
+  driver_return_code_t udf_set_trace_callback (udf_t *p_udf,
+                                               cdio_trace_callback_t callback,
+                                               void *p_user_data);
+
   /*!
     Open an UDF for reading. Maybe in the future we will have
     a mode. NULL is returned on error.
@@ -91,6 +91,23 @@ bool cdio_charset_from_utf8(cdio_utf8_t * src, char ** dst,
 bool cdio_charset_to_utf8(const char *src, size_t src_len, cdio_utf8_t **dst,
                           const char * src_charset);
 
+/** \brief Convert big-endian UCS-2 to UTF-8 without iconv
+ *  \param src Source string
+ *  \param src_len Length of the source string in bytes
+ *  \param dst Destination buffer, always 0 terminated
+ *  \param dst_size Size of dst: 3 bytes per source character and one
+ *  more hold anything
+ *  \returns the length of the string put in dst.
+ *
+ *  Conversion stops at a 0 character, and at the last character that
+ *  fits whole in dst. UTF-16 surrogate pairs are decoded, and lone
+ *  surrogates become U+FFFD. cdio_charset_to_utf8() uses this for
+ *  "UCS-2BE", as used in Joliet and UDF names.
+ */
+
+size_t cdio_ucs2be_to_utf8(const uint8_t *src, size_t src_len,
+                           cdio_utf8_t *dst, size_t dst_size);
+
 #ifdef _WIN32
 /** \brief Convert an UTF8 string to UTF-16 (allocate returned string)
  *  \param str Source string
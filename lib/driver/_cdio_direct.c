@@ -0,0 +1,293 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A data source which reads around the operating system's file cache,
+   for scanning whole images without evicting everything else from
+   it. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include <cdio/logging.h>
+#include <cdio/util.h>
+#include "_cdio_stream.h"
+#include "_cdio_stdio.h"
+#include "_cdio_direct.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* O_DIRECT wants the file offset, transfer size and buffer address
+   all to be multiples of the device's logical block size. 4 KiB
+   covers every device we are likely to see. Reads are made a window
+   at a time so that bypassing the cache doesn't cost throughput. */
+#define CDIO_DIRECT_ALIGN  4096
+#define CDIO_DIRECT_WINDOW (2*1024*1024)
+
+#if !defined(_WIN32)
+typedef struct {
+  char *pathname;
+  int fd;
+  bool b_direct;       /* fd was opened with O_DIRECT */
+  void *p_alloc;       /* what malloc gave us for p_buf */
+  uint8_t *p_buf;      /* CDIO_DIRECT_WINDOW bytes, aligned */
+  off_t i_buf_start;   /* file offset of p_buf[0] */
+  size_t i_buf_len;    /* bytes of p_buf holding file data */
+  off_t i_pos;         /* where the next read starts */
+  off_t st_size;
+} _DirectData;
+
+static int
+_direct_open_fd(_DirectData *ud, bool b_direct)
+{
+  int flags = O_RDONLY | O_BINARY;
+#ifdef O_DIRECT
+  if (b_direct) flags |= O_DIRECT;
+#endif
+  ud->fd = open (ud->pathname, flags);
+  ud->b_direct = b_direct && ud->fd >= 0;
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+  if (ud->fd >= 0) fcntl (ud->fd, F_NOCACHE, 1);
+#endif
+  return ud->fd;
+}
+
+static int
+_direct_open(void *user_data)
+{
+  _DirectData *ud = user_data;
+
+  /* Some filesystems, tmpfs for one, refuse O_DIRECT. */
+  if (_direct_open_fd (ud, true) < 0 && _direct_open_fd (ud, false) < 0)
+    return -1;
+
+  ud->p_alloc = malloc (CDIO_DIRECT_WINDOW + CDIO_DIRECT_ALIGN);
+  if (!ud->p_alloc) {
+    close (ud->fd);
+    ud->fd = -1;
+    return -1;
+  }
+  ud->p_buf = (uint8_t *)
+    (((uintptr_t) ud->p_alloc + CDIO_DIRECT_ALIGN - 1)
+     & ~(uintptr_t) (CDIO_DIRECT_ALIGN - 1));
+  ud->i_buf_start = 0;
+  ud->i_buf_len   = 0;
+  ud->i_pos       = 0;
+  return 0;
+}
+
+static int
+_direct_close(void *user_data)
+{
+  _DirectData *ud = user_data;
+
+  if (ud->fd >= 0) close (ud->fd);
+  ud->fd = -1;
+  free (ud->p_alloc);
+  ud->p_alloc = NULL;
+  ud->p_buf   = NULL;
+  return 0;
+}
+
+static void
+_direct_free(void *user_data)
+{
+  _DirectData *ud = user_data;
+
+  _direct_close (ud);
+  free (ud->pathname);
+  free (ud);
+}
+
+/* Read the aligned window holding file offset i_pos into p_buf.
+   Return false on error. */
+static bool
+_direct_fill(_DirectData *ud, off_t i_pos)
+{
+  const off_t i_start = i_pos & ~(off_t) (CDIO_DIRECT_ALIGN - 1);
+  ssize_t i_read;
+
+  ud->i_buf_len = 0;
+  if (lseek (ud->fd, i_start, SEEK_SET) != i_start) {
+    cdio_error ("lseek (): %s", strerror (errno));
+    return false;
+  }
+  i_read = read (ud->fd, ud->p_buf, CDIO_DIRECT_WINDOW);
+
+  if (i_read < 0 && EINVAL == errno && ud->b_direct) {
+    /* The open was allowed but the read isn't; carry on through the
+       cache. */
+    cdio_info ("%s: O_DIRECT reads refused; reading through the cache",
+               ud->pathname);
+    close (ud->fd);
+    if (_direct_open_fd (ud, false) < 0
+        || lseek (ud->fd, i_start, SEEK_SET) != i_start)
+      return false;
+    i_read = read (ud->fd, ud->p_buf, CDIO_DIRECT_WINDOW);
+  }
+  if (i_read < 0) {
+    cdio_error ("read (): %s", strerror (errno));
+    return false;
+  }
+
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_DONTNEED)
+  /* Without O_DIRECT, at least don't leave what we read behind. */
+  if (!ud->b_direct && i_read > 0)
+    posix_fadvise (ud->fd, i_start, i_read, POSIX_FADV_DONTNEED);
+#endif
+
+  ud->i_buf_start = i_start;
+  ud->i_buf_len   = i_read;
+  return true;
+}
+
+static ssize_t
+_direct_read(void *user_data, void *buf, size_t count)
+{
+  _DirectData *ud = user_data;
+  uint8_t *p = buf;
+  ssize_t i_total = 0;
+
+  while (count > 0) {
+    size_t i_off, i_now;
+    if (ud->i_pos < ud->i_buf_start
+        || ud->i_pos >= ud->i_buf_start + (off_t) ud->i_buf_len) {
+      if (!_direct_fill (ud, ud->i_pos)) break;
+      if (ud->i_pos >= ud->i_buf_start + (off_t) ud->i_buf_len) break; /* EOF */
+    }
+    i_off = (size_t) (ud->i_pos - ud->i_buf_start);
+    i_now = ud->i_buf_len - i_off;
+    if (i_now > count) i_now = count;
+    memcpy (p, ud->p_buf + i_off, i_now);
+    p         += i_now;
+    count     -= i_now;
+    i_total   += i_now;
+    ud->i_pos += i_now;
+  }
+  return i_total;
+}
+
+static int
+_direct_seek(void *user_data, off_t i_offset, int whence)
+{
+  _DirectData *ud = user_data;
+
+  switch (whence) {
+  case SEEK_SET:                           break;
+  case SEEK_CUR: i_offset += ud->i_pos;    break;
+  case SEEK_END: i_offset += ud->st_size;  break;
+  default:
+    errno = EINVAL;
+    return DRIVER_OP_ERROR;
+  }
+  if (i_offset < 0) {
+    errno = EINVAL;
+    return DRIVER_OP_ERROR;
+  }
+  ud->i_pos = i_offset;
+  return DRIVER_OP_SUCCESS;
+}
+
+static off_t
+_direct_stat(void *user_data)
+{
+  const _DirectData *ud = user_data;
+  return ud->st_size;
+}
+
+#endif /* !_WIN32 */
+
+CdioDataSource_t *
+cdio_direct_new(const char pathname[])
+{
+#if defined(_WIN32)
+  /* Would need FILE_FLAG_NO_BUFFERING and CreateFile. */
+  return cdio_stdio_new(pathname);
+#else
+  cdio_stream_io_functions funcs = { NULL, NULL, NULL, NULL, NULL, NULL };
+  _DirectData *ud;
+  struct stat statbuf;
+  char *pathdup;
+
+  if (pathname == NULL)
+    return NULL;
+
+  pathdup = _cdio_strdup_fixpath(pathname);
+  if (pathdup == NULL)
+    return NULL;
+
+  if (stat (pathdup, &statbuf) == -1)
+    {
+      cdio_warn ("could not retrieve file info for `%s': %s",
+                 pathdup, strerror (errno));
+      free(pathdup);
+      return NULL;
+    }
+
+  ud = calloc (1, sizeof (_DirectData));
+  if (!ud) {
+    free(pathdup);
+    return NULL;
+  }
+  ud->pathname = pathdup;
+  ud->fd       = -1;
+  ud->st_size  = statbuf.st_size;
+
+  funcs.open   = _direct_open;
+  funcs.seek   = _direct_seek;
+  funcs.stat   = _direct_stat;
+  funcs.read   = _direct_read;
+  funcs.close  = _direct_close;
+  funcs.free   = _direct_free;
+
+  return cdio_stream_new(ud, &funcs);
+#endif
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
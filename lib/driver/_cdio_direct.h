@@ -0,0 +1,46 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef CDIO_DIRECT_H_
+#define CDIO_DIRECT_H_
+
+#include "_cdio_stream.h"
+
+/*!
+  Initialize a new stream reading from pathname around the operating
+  system's file cache: with O_DIRECT where there is one, else with
+  F_NOCACHE, else by dropping what was read from the cache as we go.
+  Reads are made in large aligned chunks, so whole-image scans keep
+  their throughput.
+
+  A pointer to the stream is returned or NULL if there was an error.
+  cdio_stream_destroy should be called on it when you don't need the
+  stream any more.
+ */
+CdioDataSource_t * cdio_direct_new(const char psz_path[]);
+
+#endif /* CDIO_DIRECT_H_ */
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
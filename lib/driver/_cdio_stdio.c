@@ -39,6 +39,9 @@
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
 #include <ctype.h>
 
 #include <cdio/logging.h>
@@ -56,12 +59,12 @@
 #define CDIO_FSEEK fseek
 #endif
 
-/* Windows' fopen is not UTF-8 compliant, so we use our own */
-#if defined(_WIN32)
-#include <cdio/utf8.h>
-#define CDIO_FOPEN fopen_utf8
+#if defined(HAVE_FSEEKO64) && defined(_FILE_OFFSET_BITS) && (_FILE_OFFSET_BITS == 64)
+#define CDIO_FTELL ftello64
+#elif defined(HAVE_FSEEKO)
+#define CDIO_FTELL ftello
 #else
-#define CDIO_FOPEN fopen
+#define CDIO_FTELL ftell
 #endif
 
 /* Use _stati64 if needed, on platforms that don't have transparent LFS support */
@@ -90,15 +93,94 @@ static inline int _stati64_utf8(const char *path, struct _stati64 *buffer) {
 
 static const char _rcsid[] = "$Id: _cdio_stdio.c,v 1.6 2008/04/22 15:29:11 karl Exp $";
 
-#define CDIO_STDIO_BUFSIZE (128*1024)
+/* Buffer sizes for each cdio_stdio_buffering_t. */
+#define CDIO_STDIO_BUFSIZE            (128*1024)
+#define CDIO_STDIO_BUFSIZE_SEQUENTIAL (1024*1024)
+#define CDIO_STDIO_BUFSIZE_RANDOM     (16*1024)
+
+/* Access-pattern detection for CDIO_STDIO_BUFFER_AUTO. A run of
+   CDIO_STDIO_RUN_READS reads without a jump is sequential; it goes
+   unbuffered if its reads average at least CDIO_STDIO_DIRECT_READ
+   bytes. CDIO_STDIO_RANDOM_JUMPS jumps in a row, each after a shorter
+   run, are random access. A seek forward of up to CDIO_STDIO_NEAR
+   bytes, say to skip sector headers, isn't a jump. */
+#define CDIO_STDIO_RUN_READS    8
+#define CDIO_STDIO_DIRECT_READ  (64*1024)
+#define CDIO_STDIO_RANDOM_JUMPS 4
+#define CDIO_STDIO_NEAR         (64*1024)
+
+/* cdio_stdio_set_buffering() may be called while another thread reads,
+   so the request is handed over with an atomic exchange. */
+#if defined(__GNUC__)
+#define STDIO_EXCHANGE(p, v) __sync_lock_test_and_set((p), (v))
+#else
+static int
+_stdio_exchange(volatile int *p, int v)
+{
+  const int old = *p;
+  *p = v;
+  return old;
+}
+#define STDIO_EXCHANGE(p, v) _stdio_exchange((p), (v))
+#endif
 
 typedef struct {
   char *pathname;
   FILE *fd;
   char *fd_buf;
   off_t st_size; /* used only for source */
+
+  cdio_stdio_buffering_t e_buffering; /* what was asked for */
+  cdio_stdio_buffering_t e_current;   /* what fd is set up for */
+  volatile int i_request;             /* buffering set since the last
+                                         read or seek, or -1 */
+  off_t i_pos;                        /* position in the file */
+  unsigned int i_run_reads;           /* reads since the last jump */
+  uint64_t i_run_bytes;               /* bytes read since the last jump */
+  unsigned int i_short_runs;          /* jumps in a row after short runs */
 } _UserData;
 
+static size_t
+_stdio_bufsize(cdio_stdio_buffering_t e_buffering)
+{
+  switch (e_buffering) {
+  case CDIO_STDIO_BUFFER_NONE:       return 0;
+  case CDIO_STDIO_BUFFER_SEQUENTIAL: return CDIO_STDIO_BUFSIZE_SEQUENTIAL;
+  case CDIO_STDIO_BUFFER_RANDOM:     return CDIO_STDIO_BUFSIZE_RANDOM;
+  case CDIO_STDIO_BUFFER_AUTO:       break;
+  }
+  return CDIO_STDIO_BUFSIZE;
+}
+
+/* Give fd, which has just been opened, the buffer for e_buffering and
+   tell the kernel what read-ahead to do. Return the buffer, which is
+   NULL when unbuffered or if we couldn't get one. */
+static char *
+_stdio_setvbuf(FILE *fd, cdio_stdio_buffering_t e_buffering)
+{
+  const size_t i_size = _stdio_bufsize(e_buffering);
+  char *p_buf = i_size ? malloc (i_size) : NULL;
+
+  if (p_buf)
+    setvbuf (fd, p_buf, _IOFBF, i_size);
+  else if (!i_size)
+    setvbuf (fd, NULL, _IONBF, 0);
+
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_NORMAL)
+  {
+    int advice;
+    switch (e_buffering) {
+    case CDIO_STDIO_BUFFER_NONE:
+    case CDIO_STDIO_BUFFER_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+    case CDIO_STDIO_BUFFER_RANDOM:     advice = POSIX_FADV_RANDOM;     break;
+    default:                           advice = POSIX_FADV_NORMAL;
+    }
+    posix_fadvise (fileno (fd), 0, 0, advice);
+  }
+#endif
+  return p_buf;
+}
+
 static int
 _stdio_open (void *user_data) 
 {
@@ -106,13 +188,96 @@ _stdio_open (void *user_data)
 
   if ((ud->fd = CDIO_FOPEN (ud->pathname, "rb")))
     {
-      ud->fd_buf = calloc (1, CDIO_STDIO_BUFSIZE);
-      setvbuf (ud->fd, ud->fd_buf, _IOFBF, CDIO_STDIO_BUFSIZE);
+      ud->fd_buf = _stdio_setvbuf (ud->fd, ud->e_current);
+      ud->i_pos  = 0;
     }
 
   return (ud->fd == NULL);
 }
 
+/* Start buffering as e_buffering says. stdio only lets us change the
+   buffer of a stream before its first read, so an open stream is
+   swapped for a fresh one at the same position. If that fails we
+   carry on as we were. */
+static void
+_stdio_rebuffer (_UserData *ud, cdio_stdio_buffering_t e_buffering)
+{
+  FILE *fd;
+  char *fd_buf;
+
+  if (e_buffering == ud->e_current) return;
+  if (NULL == ud->fd) {
+    ud->e_current = e_buffering;
+    return;
+  }
+
+  if (NULL == (fd = CDIO_FOPEN (ud->pathname, "rb"))) return;
+  fd_buf = _stdio_setvbuf (fd, e_buffering);
+  if (ud->i_pos && CDIO_FSEEK (fd, ud->i_pos, SEEK_SET)) {
+    fclose (fd);
+    free (fd_buf);
+    return;
+  }
+
+  cdio_debug ("%s: buffering switched from %s to %s", ud->pathname,
+              cdio_stdio_buffering2str (ud->e_current),
+              cdio_stdio_buffering2str (e_buffering));
+  fclose (ud->fd);
+  free (ud->fd_buf);
+  ud->fd        = fd;
+  ud->fd_buf    = fd_buf;
+  ud->e_current = e_buffering;
+}
+
+/* Called before each read or seek: apply a buffering change asked for
+   with cdio_stdio_set_buffering(). */
+static void
+_stdio_check_buffering (_UserData *ud)
+{
+  int i_request;
+
+  if (ud->i_request < 0) return;
+  i_request = STDIO_EXCHANGE (&ud->i_request, -1);
+  if (i_request < 0) return;
+  ud->i_run_reads  = 0;
+  ud->i_run_bytes  = 0;
+  ud->i_short_runs = 0;
+  _stdio_rebuffer (ud, (cdio_stdio_buffering_t) i_request);
+}
+
+/* The access-pattern detector: note a read of i_count bytes. */
+static void
+_stdio_note_read (_UserData *ud, size_t i_count)
+{
+  ud->i_run_reads++;
+  ud->i_run_bytes += i_count;
+  if (CDIO_STDIO_BUFFER_AUTO == ud->e_buffering
+      && CDIO_STDIO_RUN_READS == ud->i_run_reads) {
+    ud->i_short_runs = 0;
+    _stdio_rebuffer (ud, (ud->i_run_bytes / ud->i_run_reads
+                          >= CDIO_STDIO_DIRECT_READ)
+                     ? CDIO_STDIO_BUFFER_NONE
+                     : CDIO_STDIO_BUFFER_SEQUENTIAL);
+  }
+}
+
+/* The access-pattern detector: note a move to i_offset. */
+static void
+_stdio_note_seek (_UserData *ud, off_t i_offset)
+{
+  if (i_offset >= ud->i_pos && i_offset - ud->i_pos <= CDIO_STDIO_NEAR)
+    return;
+
+  if (ud->i_run_reads < CDIO_STDIO_RUN_READS) {
+    if (++ud->i_short_runs >= CDIO_STDIO_RANDOM_JUMPS
+        && CDIO_STDIO_BUFFER_AUTO == ud->e_buffering)
+      _stdio_rebuffer (ud, CDIO_STDIO_BUFFER_RANDOM);
+  } else
+    ud->i_short_runs = 0;
+  ud->i_run_reads = 0;
+  ud->i_run_bytes = 0;
+}
+
 static int
 _stdio_close(void *user_data)
 {
@@ -173,9 +338,14 @@ _stdio_seek(void *p_user_data, off_t i_offset, int whence)
   }
 #endif
 
+  _stdio_check_buffering (ud);
+  if (SEEK_SET == whence)
+    _stdio_note_seek (ud, i_offset);
+
   if ( (ret=CDIO_FSEEK (ud->fd, i_offset, whence)) ) {
     cdio_error ( STRINGIFY(CDIO_FSEEK) " (): %s", strerror (errno));
-  }
+  } else
+    ud->i_pos = (SEEK_SET == whence) ? i_offset : CDIO_FTELL (ud->fd);
 
   return ret;
 }
@@ -211,7 +381,10 @@ _stdio_read(void *user_data, void *buf, size_t count)
   _UserData *const ud = user_data;
   long read_count;
 
+  _stdio_check_buffering (ud);
   read_count = fread(buf, 1, count, ud->fd);
+  ud->i_pos += read_count;
+  _stdio_note_read (ud, read_count);
 
   if (read_count != count)
     { /* fixme -- ferror/feof */
@@ -241,6 +414,57 @@ cdio_stdio_destroy(CdioDataSource_t *p_obj)
   cdio_stream_destroy(p_obj);
 }
 
+/*!
+  Make p_obj buffer as e_buffering says from its next read or seek.
+*/
+bool
+cdio_stdio_set_buffering(CdioDataSource_t *p_obj,
+                         cdio_stdio_buffering_t e_buffering)
+{
+  _UserData *ud = cdio_stream_get_user_data(p_obj, _stdio_read);
+
+  if (!ud) return false;
+  /* The stream may be in use by the pool in another thread, so leave
+     the work to the next read or seek. */
+  ud->e_buffering = e_buffering;
+  STDIO_EXCHANGE (&ud->i_request, (int) e_buffering);
+  return true;
+}
+
+cdio_stdio_buffering_t
+cdio_stdio_get_buffering(CdioDataSource_t *p_obj)
+{
+  _UserData *ud = cdio_stream_get_user_data(p_obj, _stdio_read);
+  return ud ? ud->e_buffering : CDIO_STDIO_BUFFER_AUTO;
+}
+
+static const char *const buffering_names[] = {
+  "auto", "none", "sequential", "random"
+};
+
+const char *
+cdio_stdio_buffering2str(cdio_stdio_buffering_t e_buffering)
+{
+  if ((unsigned int) e_buffering > CDIO_STDIO_BUFFER_RANDOM)
+    return "unknown";
+  return buffering_names[e_buffering];
+}
+
+bool
+cdio_stdio_str2buffering(const char *psz_name,
+                         /*out*/ cdio_stdio_buffering_t *p_buffering)
+{
+  unsigned int i;
+
+  if (!psz_name) return false;
+  for (i=0; i <= CDIO_STDIO_BUFFER_RANDOM; i++)
+    if (0 == strcmp(psz_name, buffering_names[i])) {
+      *p_buffering = (cdio_stdio_buffering_t) i;
+      return true;
+    }
+  return false;
+}
+
 CdioDataSource_t *
 cdio_stdio_new(const char pathname[])
 {
@@ -268,8 +492,9 @@ cdio_stdio_new(const char pathname[])
 
   ud = calloc (1, sizeof (_UserData));
 
-  ud->pathname = pathdup;
-  ud->st_size  = statbuf.st_size; /* let's hope it doesn't change... */
+  ud->pathname  = pathdup;
+  ud->st_size   = statbuf.st_size; /* let's hope it doesn't change... */
+  ud->i_request = -1;
 
   funcs.open   = _stdio_open;
   funcs.seek   = _stdio_seek;
@@ -22,6 +22,29 @@
 
 #include "_cdio_stream.h"
 
+/* Windows' fopen is not UTF-8 compliant, so we use our own */
+#if defined(_WIN32)
+#include <cdio/utf8.h>
+#define CDIO_FOPEN fopen_utf8
+#else
+#define CDIO_FOPEN fopen
+#endif
+
+/*!
+  How a stdio stream buffers what it reads.
+*/
+typedef enum {
+  CDIO_STDIO_BUFFER_AUTO = 0,   /**< Start with a medium buffer and pick
+                                     one of the below from how the
+                                     stream is being read. */
+  CDIO_STDIO_BUFFER_NONE,       /**< No buffer; for large sequential
+                                     transfers. */
+  CDIO_STDIO_BUFFER_SEQUENTIAL, /**< A large read-ahead window; for
+                                     ripping audio, say. */
+  CDIO_STDIO_BUFFER_RANDOM      /**< A small buffer; for browsing a
+                                     filesystem, say. */
+} cdio_stdio_buffering_t;
+
 /*!
   Initialize a new stdio stream reading from pathname.
   A pointer to the stream is returned or NULL if there was an error.
@@ -36,6 +59,35 @@ CdioDataSource_t * cdio_stdio_new(const char psz_path[]);
 */
 void cdio_stdio_destroy(CdioDataSource_t *p_obj);
 
+/*!
+  Make p_obj buffer as e_buffering says from its next read or seek.
+  Streams start out as CDIO_STDIO_BUFFER_AUTO. This may be called
+  while another thread is reading from p_obj.
+
+  @return false if p_obj isn't a stdio stream.
+*/
+bool cdio_stdio_set_buffering(CdioDataSource_t *p_obj,
+                              cdio_stdio_buffering_t e_buffering);
+
+/*!
+  Return how p_obj was asked to buffer, or CDIO_STDIO_BUFFER_AUTO if
+  it isn't a stdio stream.
+*/
+cdio_stdio_buffering_t cdio_stdio_get_buffering(CdioDataSource_t *p_obj);
+
+/*!
+  Return the name of e_buffering as accepted by the "buffering" key of
+  cdio_set_arg(): "auto", "none", "sequential" or "random".
+*/
+const char *cdio_stdio_buffering2str(cdio_stdio_buffering_t e_buffering);
+
+/*!
+  Set *p_buffering from a name returned by cdio_stdio_buffering2str().
+  Return false if psz_name isn't one of them.
+*/
+bool cdio_stdio_str2buffering(const char *psz_name,
+                              /*out*/ cdio_stdio_buffering_t *p_buffering);
+
 
 #endif /* CDIO_STDIO_H_ */
 
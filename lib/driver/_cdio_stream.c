@@ -33,12 +33,16 @@
 #ifdef HAVE_STDARG_H
 #include <stdarg.h>
 #endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 #include "cdio_assert.h"
 
 /* #define STREAM_DEBUG  */
 
 #include <cdio/logging.h>
 #include <cdio/util.h>
+#include <cdio/cdio.h>
 #include "_cdio_stream.h"
 
 static const char _rcsid[] = "$Id: _cdio_stream.c,v 1.9 2008/04/22 15:29:11 karl Exp $";
@@ -52,19 +56,226 @@ struct _CdioDataSource {
   cdio_stream_io_functions op;
   int is_open;
   off_t position;
+  cdio_stream_pool_t *p_pool;
+  CdioDataSource_t *p_newer;  /* neighbours in p_pool's list of open */
+  CdioDataSource_t *p_older;  /* streams, most recently used first */
+  unsigned int i_busy;        /* operations under way */
+  bool b_evicted;             /* closed by the pool; reopen at position */
+};
+
+/* Streams open at once unless cdio_set_max_open_image_files() says
+   otherwise. */
+#define CDIO_STREAM_POOL_DEFAULT_MAX 64
+
+struct cdio_stream_pool_s {
+  unsigned int i_max_open;
+  unsigned int i_open;
+  CdioDataSource_t *p_newest;
+  CdioDataSource_t *p_oldest;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t lock;
+#endif
 };
 
+#ifdef HAVE_PTHREAD_H
+# define POOL_LOCK(p_pool)   pthread_mutex_lock(&(p_pool)->lock)
+# define POOL_UNLOCK(p_pool) pthread_mutex_unlock(&(p_pool)->lock)
+#else
+# define POOL_LOCK(p_pool)
+# define POOL_UNLOCK(p_pool)
+#endif
+
+static cdio_stream_pool_t default_pool = {
+  CDIO_STREAM_POOL_DEFAULT_MAX, 0, NULL, NULL,
+#ifdef HAVE_PTHREAD_H
+  PTHREAD_MUTEX_INITIALIZER
+#endif
+};
+
+/* The following work on a pool whose lock is held. */
+
+static void
+_pool_unlink(cdio_stream_pool_t *p_pool, CdioDataSource_t *p_obj)
+{
+  if (p_obj->p_newer) p_obj->p_newer->p_older = p_obj->p_older;
+  else                p_pool->p_newest        = p_obj->p_older;
+  if (p_obj->p_older) p_obj->p_older->p_newer = p_obj->p_newer;
+  else                p_pool->p_oldest        = p_obj->p_newer;
+  p_obj->p_newer = p_obj->p_older = NULL;
+}
+
+static void
+_pool_push(cdio_stream_pool_t *p_pool, CdioDataSource_t *p_obj)
+{
+  p_obj->p_newer = NULL;
+  p_obj->p_older = p_pool->p_newest;
+  if (p_pool->p_newest) p_pool->p_newest->p_newer = p_obj;
+  else                  p_pool->p_oldest          = p_obj;
+  p_pool->p_newest = p_obj;
+}
+
+/* Close the least recently used idle streams until p_pool is within
+   its limit or only busy ones are left. */
+static void
+_pool_trim(cdio_stream_pool_t *p_pool)
+{
+  CdioDataSource_t *p_obj = p_pool->p_oldest;
+
+  while (p_pool->i_max_open && p_pool->i_open > p_pool->i_max_open
+         && p_obj) {
+    CdioDataSource_t *p_newer = p_obj->p_newer;
+    if (!p_obj->i_busy) {
+      cdio_debug ("pool closed source...");
+      _pool_unlink(p_pool, p_obj);
+      p_pool->i_open--;
+      p_obj->op.close(p_obj->user_data);
+      p_obj->is_open   = 0;
+      p_obj->b_evicted = true;
+    }
+    p_obj = p_newer;
+  }
+}
+
+cdio_stream_pool_t *
+cdio_stream_pool_new(unsigned int i_max_open)
+{
+  cdio_stream_pool_t *p_pool = calloc(1, sizeof(cdio_stream_pool_t));
+
+  if (!p_pool) return NULL;
+  p_pool->i_max_open = i_max_open;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&p_pool->lock, NULL);
+#endif
+  return p_pool;
+}
+
+void
+cdio_stream_pool_free(cdio_stream_pool_t *p_pool)
+{
+  if (!p_pool || p_pool == &default_pool) return;
+  cdio_assert (NULL == p_pool->p_newest);
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_destroy(&p_pool->lock);
+#endif
+  free(p_pool);
+}
+
+cdio_stream_pool_t *
+cdio_stream_pool_default(void)
+{
+  return &default_pool;
+}
+
+void
+cdio_stream_pool_set_max_open(cdio_stream_pool_t *p_pool,
+                              unsigned int i_max_open)
+{
+  if (!p_pool) return;
+  POOL_LOCK(p_pool);
+  p_pool->i_max_open = i_max_open;
+  _pool_trim(p_pool);
+  POOL_UNLOCK(p_pool);
+}
+
+unsigned int
+cdio_stream_pool_get_max_open(cdio_stream_pool_t *p_pool)
+{
+  unsigned int i_max_open;
+
+  if (!p_pool) return 0;
+  POOL_LOCK(p_pool);
+  i_max_open = p_pool->i_max_open;
+  POOL_UNLOCK(p_pool);
+  return i_max_open;
+}
+
+unsigned int
+cdio_stream_pool_get_open(cdio_stream_pool_t *p_pool)
+{
+  unsigned int i_open;
+
+  if (!p_pool) return 0;
+  POOL_LOCK(p_pool);
+  i_open = p_pool->i_open;
+  POOL_UNLOCK(p_pool);
+  return i_open;
+}
+
+/*!
+  Set the most files which the image drivers that read from many
+  files keep open at once, across all CdIo_t objects.
+*/
+driver_return_code_t
+cdio_set_max_open_image_files(unsigned int i_max_open)
+{
+  cdio_stream_pool_set_max_open(&default_pool, i_max_open);
+  return DRIVER_OP_SUCCESS;
+}
+
+unsigned int
+cdio_get_max_open_image_files(void)
+{
+  return cdio_stream_pool_get_max_open(&default_pool);
+}
+
+void
+cdio_stream_set_pool(CdioDataSource_t *p_obj, cdio_stream_pool_t *p_pool)
+{
+  cdio_stream_pool_t *p_old;
+
+  if (!p_obj || p_obj->p_pool == p_pool) return;
+
+  p_old = p_obj->p_pool;
+  if (p_old) {
+    POOL_LOCK(p_old);
+    if (p_obj->is_open) {
+      _pool_unlink(p_old, p_obj);
+      p_old->i_open--;
+    }
+    p_obj->p_pool = NULL;
+    POOL_UNLOCK(p_old);
+  }
+
+  if (p_pool) {
+    POOL_LOCK(p_pool);
+    p_obj->p_pool = p_pool;
+    if (p_obj->is_open) {
+      _pool_push(p_pool, p_obj);
+      p_pool->i_open++;
+      _pool_trim(p_pool);
+    }
+    POOL_UNLOCK(p_pool);
+  }
+}
+
 void
 cdio_stream_close(CdioDataSource_t *p_obj)
 {
+  cdio_stream_pool_t *p_pool;
+
   if (!p_obj) return;
 
+  p_pool = p_obj->p_pool;
+  if (p_pool) POOL_LOCK(p_pool);
   if (p_obj->is_open) {
     cdio_debug ("closed source...");
+    if (p_pool) {
+      _pool_unlink(p_pool, p_obj);
+      p_pool->i_open--;
+    }
     p_obj->op.close(p_obj->user_data);
     p_obj->is_open  = 0;
-    p_obj->position = 0;
   }
+  p_obj->position  = 0;
+  p_obj->b_evicted = false;
+  if (p_pool) POOL_UNLOCK(p_pool);
+}
+
+void *
+cdio_stream_get_user_data(CdioDataSource_t *p_obj, cdio_data_read_t f_read)
+{
+  if (!p_obj || p_obj->op.read != f_read) return NULL;
+  return p_obj->user_data;
 }
 
 void
@@ -73,6 +284,7 @@ cdio_stream_destroy(CdioDataSource_t *p_obj)
   if (!p_obj) return;
 
   cdio_stream_close(p_obj);
+  cdio_stream_set_pool(p_obj, NULL);
 
   p_obj->op.free(p_obj->user_data);
 
@@ -91,7 +303,8 @@ cdio_stream_destroy(CdioDataSource_t *p_obj)
 off_t
 cdio_stream_getpos(CdioDataSource_t* p_obj, /*out*/ off_t *i_offset)
 {
-  if (!p_obj || !p_obj->is_open) return DRIVER_OP_UNINIT;
+  if (!p_obj || !(p_obj->is_open || p_obj->b_evicted))
+    return DRIVER_OP_UNINIT;
   return *i_offset = p_obj->position;
 }
 
@@ -109,7 +322,8 @@ cdio_stream_new(void *user_data, const cdio_stream_io_functions *funcs)
 }
 
 /* 
-   Open if not already open. 
+   Open if not already open, going back to where we were if the pool
+   closed the stream behind our back.
    Return false if we hit an error. Errno should be set for that error.
 */
 static bool
@@ -121,15 +335,58 @@ _cdio_stream_open_if_necessary(CdioDataSource_t *p_obj)
     if (p_obj->op.open(p_obj->user_data)) {
       cdio_warn ("could not open input stream...");
       return false;
-    } else {
-      cdio_debug ("opened source...");
-      p_obj->is_open = 1;
-      p_obj->position = 0;
+    }
+    if (p_obj->b_evicted && p_obj->position
+        && p_obj->op.seek(p_obj->user_data, p_obj->position, SEEK_SET)) {
+      p_obj->op.close(p_obj->user_data);
+      return false;
+    }
+    cdio_debug ("opened source...");
+    if (!p_obj->b_evicted) p_obj->position = 0;
+    p_obj->b_evicted = false;
+    p_obj->is_open = 1;
+    if (p_obj->p_pool) {
+      cdio_stream_pool_t *p_pool = p_obj->p_pool;
+      POOL_LOCK(p_pool);
+      _pool_push(p_pool, p_obj);
+      p_pool->i_open++;
+      _pool_trim(p_pool);
+      POOL_UNLOCK(p_pool);
     }
   }
   return true;
 }
 
+/*
+   Bracket an operation on p_obj so that its pool leaves it open
+   meanwhile, and mark it as the most recently used.
+*/
+static void
+_cdio_stream_acquire(CdioDataSource_t *p_obj)
+{
+  cdio_stream_pool_t *p_pool = p_obj->p_pool;
+
+  if (!p_pool) return;
+  POOL_LOCK(p_pool);
+  p_obj->i_busy++;
+  if (p_obj->is_open && p_pool->p_newest != p_obj) {
+    _pool_unlink(p_pool, p_obj);
+    _pool_push(p_pool, p_obj);
+  }
+  POOL_UNLOCK(p_pool);
+}
+
+static void
+_cdio_stream_release(CdioDataSource_t *p_obj)
+{
+  cdio_stream_pool_t *p_pool = p_obj->p_pool;
+
+  if (!p_pool) return;
+  POOL_LOCK(p_pool);
+  p_obj->i_busy--;
+  POOL_UNLOCK(p_pool);
+}
+
 /**
   Like fread(3) and in fact may be the same.
   
@@ -153,10 +410,15 @@ cdio_stream_read(CdioDataSource_t* p_obj, void *ptr, size_t size, size_t nmemb)
   long read_bytes;
 
   if (!p_obj) return 0;
-  if (!_cdio_stream_open_if_necessary(p_obj)) return 0;
+  _cdio_stream_acquire(p_obj);
+  if (!_cdio_stream_open_if_necessary(p_obj)) {
+    _cdio_stream_release(p_obj);
+    return 0;
+  }
 
   read_bytes = (p_obj->op.read)(p_obj->user_data, ptr, size*nmemb);
   p_obj->position += read_bytes;
+  _cdio_stream_release(p_obj);
 
   return read_bytes;
 }
@@ -179,24 +441,29 @@ cdio_stream_read(CdioDataSource_t* p_obj, void *ptr, size_t size, size_t nmemb)
 int
 cdio_stream_seek(CdioDataSource_t* p_obj, off_t offset, int whence)
 {
+  int i_ret = 0;
+
   if (!p_obj) return DRIVER_OP_UNINIT;
 
-  if (!_cdio_stream_open_if_necessary(p_obj)) 
+  _cdio_stream_acquire(p_obj);
+  if (!_cdio_stream_open_if_necessary(p_obj)) {
     /* errno is set by _cdio_stream_open_if necessary. */
+    _cdio_stream_release(p_obj);
     return DRIVER_OP_ERROR;
+  }
 
-  if (offset < 0) return DRIVER_OP_ERROR;
-  if (p_obj->position < 0) return DRIVER_OP_ERROR;
-
-  if (p_obj->position != offset) {
+  if (offset < 0 || p_obj->position < 0)
+    i_ret = DRIVER_OP_ERROR;
+  else if (p_obj->position != offset) {
 #ifdef STREAM_DEBUG
     cdio_warn("had to reposition DataSource from %ld to %ld!", p_obj->position, offset);
 #endif
     p_obj->position = offset;
-    return p_obj->op.seek(p_obj->user_data, offset, whence);
+    i_ret = p_obj->op.seek(p_obj->user_data, offset, whence);
   }
 
-  return 0;
+  _cdio_stream_release(p_obj);
+  return i_ret;
 }
 
 /**
@@ -206,10 +473,15 @@ cdio_stream_seek(CdioDataSource_t* p_obj, off_t offset, int whence)
 off_t
 cdio_stream_stat(CdioDataSource_t *p_obj)
 {
+  off_t i_size = -1;
+
   if (!p_obj) return -1;
-  if (!_cdio_stream_open_if_necessary(p_obj)) return -1;
+  _cdio_stream_acquire(p_obj);
+  if (_cdio_stream_open_if_necessary(p_obj))
+    i_size = p_obj->op.stat(p_obj->user_data);
+  _cdio_stream_release(p_obj);
 
-  return p_obj->op.stat(p_obj->user_data);
+  return i_size;
 }
 
 
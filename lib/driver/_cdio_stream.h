@@ -121,7 +121,63 @@ extern "C" {
   void cdio_stream_destroy(CdioDataSource_t *p_obj);
   
   void cdio_stream_close(CdioDataSource_t *p_obj);
-  
+
+  /**
+    Return the user_data p_obj was made with if it reads with f_read,
+    otherwise NULL. This lets a kind of stream get at its own state.
+  */
+  void *cdio_stream_get_user_data(CdioDataSource_t *p_obj,
+                                  cdio_data_read_t f_read);
+
+  /**
+    A pool bounds how many of the streams attached to it are open at
+    once. When opening one more would go over the limit, the stream
+    which was used least recently is closed; it remembers its position
+    and is reopened there the next time it is read, seeked or stat'ed.
+    A stream which is in the middle of an operation is never closed
+    this way, so the limit can briefly be exceeded by streams in use in
+    other threads.
+  */
+  typedef struct cdio_stream_pool_s cdio_stream_pool_t;
+
+  /**
+    Return a new pool which keeps at most i_max_open streams open, or
+    any number of them if i_max_open is 0.
+  */
+  cdio_stream_pool_t *cdio_stream_pool_new(unsigned int i_max_open);
+
+  /**
+    Free p_pool. Every stream attached to it must have been destroyed
+    or detached first.
+  */
+  void cdio_stream_pool_free(cdio_stream_pool_t *p_pool);
+
+  /**
+    The pool shared by the image drivers which read from many files.
+  */
+  cdio_stream_pool_t *cdio_stream_pool_default(void);
+
+  /**
+    Change the limit of p_pool, closing streams at once if there are
+    now too many open.
+  */
+  void cdio_stream_pool_set_max_open(cdio_stream_pool_t *p_pool,
+                                     unsigned int i_max_open);
+
+  unsigned int cdio_stream_pool_get_max_open(cdio_stream_pool_t *p_pool);
+
+  /**
+    Return how many streams attached to p_pool are open right now.
+  */
+  unsigned int cdio_stream_pool_get_open(cdio_stream_pool_t *p_pool);
+
+  /**
+    Attach p_obj to p_pool, or detach it from its pool if p_pool is
+    NULL.
+  */
+  void cdio_stream_set_pool(CdioDataSource_t *p_obj,
+                            cdio_stream_pool_t *p_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -97,23 +97,26 @@ strrdirsep(const char *path)
 
 const char * cdio_dirname(const char *fname);
 
+/* Return the directory part of fname. The result is always malloc'd,
+   so callers can free it. */
 const char *
 cdio_dirname(const char *fname)
 {
     const char *p;
     p = strrdirsep(fname);
-    if (!p) return ".";
+    if (!p) return strdup(".");
     return strndup(fname, p - fname);
 }
 
 const char *cdio_abspath(const char *cwd, const char *fname);
 
 
-/* If fname isn't absolute, add cwd to it. */
+/* If fname isn't absolute, add cwd to it. The result is always
+   malloc'd, so callers can free it either way. */
 const char *
 cdio_abspath(const char *cwd, const char *fname)
 {
-    if (isdirsep(*fname)) return fname;
+    if (isdirsep(*fname)) return strdup(fname);
     {
 	size_t len   = strlen(cwd) + strlen(fname) + 2;
 	char* result = calloc(sizeof(char), len);
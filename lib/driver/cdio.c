@@ -70,6 +70,12 @@ cdio_new (generic_img_private_t *p_env, cdio_funcs_t *p_funcs)
   p_env->cdio     = p_new_cdio; /* A way for the driver-dependent routines 
                                    to access the higher-level general cdio 
                                    object. */
+  cdio_stats_state_init(&p_new_cdio->stats);
+  if (p_funcs->run_mmc_cmd) {
+    /* Route MMC commands through a wrapper that counts them. */
+    p_new_cdio->driver_run_mmc_cmd = p_funcs->run_mmc_cmd;
+    p_new_cdio->op.run_mmc_cmd     = cdio_stats_run_mmc_cmd;
+  }
   return p_new_cdio;
 }
 
@@ -83,6 +89,8 @@ cdio_set_arg (CdIo_t *p_cdio, const char key[], const char value[])
   if (!p_cdio->op.set_arg) return DRIVER_OP_UNSUPPORTED;
   if (!key) return DRIVER_OP_ERROR;
 
+  /* A new source may well have a different TOC. */
+  cdio_track_table_invalidate(p_cdio);
   return p_cdio->op.set_arg (p_cdio->env, key, value);
 }
 
@@ -29,7 +29,9 @@
 #include <cdio/cdio.h>
 #include <cdio/audio.h>
 #include <cdio/cdtext.h>
+#include <cdio/util.h>
 #include "mmc/mmc_private.h"
+#include "stats_private.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -433,14 +435,135 @@ extern "C" {
   } cdio_funcs_t;
 
 
+  /*!
+    One track of the flattened TOC kept on a CdIo_t.
+  */
+  typedef struct {
+    lsn_t          start_lsn;  /**< First sector of the track */
+    lsn_t          end_lsn;    /**< Last sector before the next track
+                                    or the leadout */
+    track_format_t format;     /**< As returned by get_track_format */
+    bool           b_green;    /**< As returned by get_track_green */
+  } cdio_track_entry_t;
+
+  /*!
+    Snapshot of the TOC taken the first time a LSN-to-track lookup is
+    done. Once b_valid is set the table is not changed until
+    cdio_track_table_invalidate() is called, e.g. because the media
+    changed.
+  */
+  typedef struct {
+    bool    b_valid;           /**< True if the entries below are filled
+                                    in */
+    track_t i_first_track;
+    track_t i_last_track;
+    lsn_t   leadout_lsn;
+    track_t i_hint;            /**< Track found in the last lookup.
+                                    Sequential reads usually stay in it */
+    cdio_track_entry_t entry[CDIO_CD_MAX_TRACKS+1]; /**< Indexed by track
+                                                       number */
+  } cdio_track_table_t;
+
   /*! Implementation of CdIo type */
   struct _CdIo {
     driver_id_t driver_id; /**< Particular driver opened. */
     cdio_funcs_t op;       /**< driver-specific routines handling
                                 implementation*/
     void *env;             /**< environment. Passed to routine above. */
+    cdio_track_table_t track_table; /**< Cached TOC. Use
+                                         cdio_track_table_ready()
+                                         before accessing. */
+    cdio_stats_state_t stats;       /**< I/O counters and trace hook. */
+    mmc_run_cmd_fn_t driver_run_mmc_cmd; /**< The driver's own
+                                            run_mmc_cmd. op.run_mmc_cmd
+                                            counts the command and
+                                            then calls this. */
   };
 
+  /*!
+    Return the name p_cdio was opened with, for trace events.
+  */
+  static CDIO_INLINE const char *
+  cdio_stats_source(const CdIo_t *p_cdio)
+  {
+    return p_cdio->env
+      ? ((const generic_img_private_t *) p_cdio->env)->source_name : NULL;
+  }
+
+  /*!
+    Fill in the track table of p_cdio from the driver's TOC.
+    @return true if the table could be built.
+  */
+  bool cdio_track_table_init(CdIo_t *p_cdio);
+
+  /*!
+    Drop the cached track table of p_cdio so that the next lookup
+    reads the TOC again.
+  */
+  void cdio_track_table_invalidate(CdIo_t *p_cdio);
+
+  /*!
+    Return true if the track table of p_cdio is usable, building it
+    if that hasn't been done yet.
+  */
+  static CDIO_INLINE bool
+  cdio_track_table_ready(const CdIo_t *p_cdio)
+  {
+    if (p_cdio->track_table.b_valid)
+      return true;
+    return cdio_track_table_init((CdIo_t *) p_cdio);
+  }
+
+  /*!
+    Find the track which contains i_lsn in a valid track table. The
+    return values are the same as for cdio_get_track().
+
+    The track found is remembered so that the next lookup, which for
+    sequential reads is usually in the same or the following track,
+    does not have to search.
+  */
+  static CDIO_INLINE track_t
+  cdio_track_table_find(cdio_track_table_t *p_table, lsn_t i_lsn)
+  {
+    track_t i_hint = p_table->i_hint;
+    track_t i_low  = p_table->i_first_track;
+    track_t i_high = p_table->i_last_track;
+
+    if (i_lsn < p_table->entry[i_low].start_lsn)
+      return 0; /* We're in the pre-gap of first track */
+    if (i_lsn >= p_table->leadout_lsn)
+      return (i_lsn == p_table->leadout_lsn)
+        ? i_high + 1 : CDIO_INVALID_TRACK;
+
+    if (i_lsn >= p_table->entry[i_hint].start_lsn) {
+      if (i_lsn <= p_table->entry[i_hint].end_lsn)
+        return i_hint;
+      if (i_hint < i_high && i_lsn <= p_table->entry[i_hint+1].end_lsn)
+        return p_table->i_hint = i_hint + 1;
+    }
+
+    while (i_low < i_high) {
+      const track_t i_mid = (i_low + i_high + 1) / 2;
+      if (i_lsn < p_table->entry[i_mid].start_lsn)
+        i_high = i_mid - 1;
+      else
+        i_low  = i_mid;
+    }
+    return p_table->i_hint = i_low;
+  }
+
+  /*!
+    Return the format of track i_track in a valid track table, or
+    TRACK_FORMAT_ERROR if there is no such track.
+  */
+  static CDIO_INLINE track_format_t
+  cdio_track_table_format(const cdio_track_table_t *p_table, track_t i_track)
+  {
+    if (i_track < p_table->i_first_track || i_track > p_table->i_last_track)
+      return TRACK_FORMAT_ERROR;
+    return p_table->entry[i_track].format;
+  }
+
   /* This is used in drivers that must keep their own internal 
      position pointer for doing seeks. Stream-based drivers (like bincue,
      nrg, toc, network) would use this. 
@@ -454,6 +577,16 @@ extern "C" {
   
   CdIo_t * cdio_new (generic_img_private_t *p_env, cdio_funcs_t *p_funcs);
 
+  /*!
+    Counting wrapper which cdio_new() puts in place of a driver's
+    run_mmc_cmd. p_user_data must be the driver environment.
+  */
+  driver_return_code_t
+  cdio_stats_run_mmc_cmd(void *p_user_data, unsigned int i_timeout_ms,
+                         unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                         cdio_mmc_direction_t e_direction, unsigned int i_buf,
+                         /*in/out*/ void *p_buf);
+
   /* The below structure describes a specific CD Input driver  */
   typedef struct 
   {
@@ -0,0 +1,960 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file checksum.c
+ *
+ *  \brief Checksums of tracks and whole discs.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+# define HAVE_CRC32_CLMUL 1
+# include <immintrin.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include "cdio_private.h"
+
+/* Sectors read by each call to the driver. */
+#define CHECKSUM_BATCH   64
+/* Batches in flight between the reader and the digest threads. */
+#define CHECKSUM_BUFFERS 4
+
+/* AccurateRip counts samples of two 16-bit channels. */
+#define AR_SAMPLES_PER_SECTOR (CDIO_CD_FRAMESIZE_RAW / 4)
+#define AR_SKIP_SECTORS       5
+
+/*
+ * CRC-32 (the polynomial of zlib and zip), eight bytes at a time with
+ * the "slicing-by-8" tables, or with carry-less multiplication on x86
+ * processors which have it.
+ */
+
+static uint32_t crc32_table[8][256];
+
+static void
+crc32_init_tables(void)
+{
+  unsigned int i, j;
+
+  for (i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (j = 0; j < 8; j++)
+      c = (c & 1) ? (c >> 1) ^ 0xedb88320 : c >> 1;
+    crc32_table[0][i] = c;
+  }
+  for (i = 0; i < 256; i++)
+    for (j = 1; j < 8; j++)
+      crc32_table[j][i] = (crc32_table[j-1][i] >> 8)
+        ^ crc32_table[0][crc32_table[j-1][i] & 0xff];
+}
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+# define CRC32_INIT() pthread_once(&crc32_once, crc32_init_tables)
+#else
+static bool b_crc32_ready = false;
+# define CRC32_INIT() \
+  do { if (!b_crc32_ready) { crc32_init_tables(); b_crc32_ready = true; } } \
+  while (0)
+#endif
+
+/* Work on the bit-inverted CRC. */
+static uint32_t
+crc32_slice8(uint32_t c, const uint8_t *p, size_t i_len)
+{
+  while (i_len && ((uintptr_t) p & 3)) {
+    c = crc32_table[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+    i_len--;
+  }
+  while (i_len >= 8) {
+    const uint32_t lo = c ^ (p[0] | (uint32_t) p[1] << 8
+                             | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24);
+    const uint32_t hi = p[4] | (uint32_t) p[5] << 8
+                        | (uint32_t) p[6] << 16 | (uint32_t) p[7] << 24;
+    c = crc32_table[7][lo & 0xff] ^ crc32_table[6][(lo >> 8) & 0xff]
+      ^ crc32_table[5][(lo >> 16) & 0xff] ^ crc32_table[4][lo >> 24]
+      ^ crc32_table[3][hi & 0xff] ^ crc32_table[2][(hi >> 8) & 0xff]
+      ^ crc32_table[1][(hi >> 16) & 0xff] ^ crc32_table[0][hi >> 24];
+    p += 8;
+    i_len -= 8;
+  }
+  while (i_len--)
+    c = crc32_table[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+  return c;
+}
+
+#ifdef HAVE_CRC32_CLMUL
+
+/* Fold 64-byte blocks with PCLMULQDQ, then reduce to 32 bits (Intel,
+   "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ").
+   i_len must be at least 64 and a multiple of 16. */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t
+crc32_clmul(uint32_t c, const uint8_t *p, size_t i_len)
+{
+  static const uint64_t k1k2[2] __attribute__((aligned(16))) =
+    { 0x0154442bd4ULL, 0x01c6e41596ULL };
+  static const uint64_t k3k4[2] __attribute__((aligned(16))) =
+    { 0x01751997d0ULL, 0x00ccaa009eULL };
+  static const uint64_t k5k0[2] __attribute__((aligned(16))) =
+    { 0x0163cd6124ULL, 0 };
+  static const uint64_t poly[2] __attribute__((aligned(16))) =
+    { 0x01db710641ULL, 0x01f7011641ULL };
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128((const __m128i *) (p + 0x00));
+  x2 = _mm_loadu_si128((const __m128i *) (p + 0x10));
+  x3 = _mm_loadu_si128((const __m128i *) (p + 0x20));
+  x4 = _mm_loadu_si128((const __m128i *) (p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) c));
+  x0 = _mm_load_si128((const __m128i *) k1k2);
+  p += 64;
+  i_len -= 64;
+
+  while (i_len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                       _mm_loadu_si128((const __m128i *) (p + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                       _mm_loadu_si128((const __m128i *) (p + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                       _mm_loadu_si128((const __m128i *) (p + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                       _mm_loadu_si128((const __m128i *) (p + 0x30)));
+    p += 64;
+    i_len -= 64;
+  }
+
+  /* Fold the four lanes into one. */
+  x0 = _mm_load_si128((const __m128i *) k3k4);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  while (i_len >= 16) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *) p)),
+                       x5);
+    p += 16;
+    i_len -= 16;
+  }
+
+  /* 128 bits to 64. */
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x0 = _mm_loadl_epi64((const __m128i *) k5k0);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits. */
+  x0 = _mm_load_si128((const __m128i *) poly);
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return (uint32_t) _mm_extract_epi32(x1, 1);
+}
+
+static int
+crc32_have_clmul(void)
+{
+  static int i_have = -1;
+  if (i_have < 0) {
+    __builtin_cpu_init();
+    i_have = __builtin_cpu_supports("pclmul")
+      && __builtin_cpu_supports("sse4.1");
+  }
+  return i_have;
+}
+#endif /* HAVE_CRC32_CLMUL */
+
+/*!
+  Return the CRC-32 of p_buf continuing from i_crc, which is 0 to
+  start with.
+*/
+uint32_t
+cdio_crc32(uint32_t i_crc, const void *p_buf, size_t i_len)
+{
+  const uint8_t *p = p_buf;
+  uint32_t c = ~i_crc;
+
+  CRC32_INIT();
+#ifdef HAVE_CRC32_CLMUL
+  if (i_len >= 64 && crc32_have_clmul()) {
+    const size_t i_fold = i_len & ~(size_t) 15;
+    c = crc32_clmul(c, p, i_fold);
+    p += i_fold;
+    i_len -= i_fold;
+  }
+#endif
+  return ~crc32_slice8(c, p, i_len);
+}
+
+/*
+ * MD5 (RFC 1321).
+ */
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint32_t
+get_le32(const uint8_t *p)
+{
+  return p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+    | (uint32_t) p[3] << 24;
+}
+
+static uint32_t
+get_be32(const uint8_t *p)
+{
+  return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16
+    | (uint32_t) p[2] << 8 | p[3];
+}
+
+static void
+md5_block(uint32_t state[4], const uint8_t *p)
+{
+  static const uint32_t K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+  };
+  static const uint8_t R[16] = {
+    7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21
+  };
+  uint32_t M[16];
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  unsigned int i;
+
+  for (i = 0; i < 16; i++)
+    M[i] = get_le32(p + 4*i);
+
+  for (i = 0; i < 64; i++) {
+    uint32_t f, t;
+    unsigned int g;
+    switch (i >> 4) {
+    case 0:  f = d ^ (b & (c ^ d)); g = i;               break;
+    case 1:  f = c ^ (d & (b ^ c)); g = (5*i + 1) & 15;  break;
+    case 2:  f = b ^ c ^ d;         g = (3*i + 5) & 15;  break;
+    default: f = c ^ (b | ~d);      g = (7*i) & 15;      break;
+    }
+    t = d;
+    d = c;
+    c = b;
+    b = b + ROL32(a + f + K[i] + M[g], R[(i >> 4) * 4 + (i & 3)]);
+    a = t;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+}
+
+void
+cdio_md5_init(cdio_md5_t *p_md5)
+{
+  p_md5->state[0] = 0x67452301;
+  p_md5->state[1] = 0xefcdab89;
+  p_md5->state[2] = 0x98badcfe;
+  p_md5->state[3] = 0x10325476;
+  p_md5->i_bytes  = 0;
+}
+
+void
+cdio_md5_update(cdio_md5_t *p_md5, const void *p_buf, size_t i_len)
+{
+  const uint8_t *p = p_buf;
+  unsigned int i_used = p_md5->i_bytes & 63;
+
+  p_md5->i_bytes += i_len;
+  if (i_used) {
+    unsigned int i_now = 64 - i_used;
+    if (i_now > i_len) i_now = i_len;
+    memcpy(p_md5->block + i_used, p, i_now);
+    p += i_now;
+    i_len -= i_now;
+    if (i_used + i_now < 64) return;
+    md5_block(p_md5->state, p_md5->block);
+  }
+  for (; i_len >= 64; p += 64, i_len -= 64)
+    md5_block(p_md5->state, p);
+  memcpy(p_md5->block, p, i_len);
+}
+
+void
+cdio_md5_final(cdio_md5_t *p_md5, /*out*/ uint8_t digest[CDIO_MD5_DIGEST_SIZE])
+{
+  static const uint8_t pad[64] = { 0x80 };
+  const uint64_t i_bits = p_md5->i_bytes * 8;
+  uint8_t length[8];
+  unsigned int i;
+
+  for (i = 0; i < 8; i++)
+    length[i] = (uint8_t) (i_bits >> (8*i));
+  cdio_md5_update(p_md5, pad, 1 + ((119 - (p_md5->i_bytes & 63)) & 63));
+  cdio_md5_update(p_md5, length, 8);
+  for (i = 0; i < 16; i++)
+    digest[i] = (uint8_t) (p_md5->state[i/4] >> (8*(i%4)));
+}
+
+/*
+ * SHA-256 (FIPS 180-4).
+ */
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void
+sha256_block(uint32_t state[8], const uint8_t *p)
+{
+  static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+  uint32_t W[64];
+  uint32_t a, b, c, d, e, f, g, h;
+  unsigned int i;
+
+  for (i = 0; i < 16; i++)
+    W[i] = get_be32(p + 4*i);
+  for (i = 16; i < 64; i++) {
+    const uint32_t s0 = ROR32(W[i-15], 7) ^ ROR32(W[i-15], 18) ^ (W[i-15] >> 3);
+    const uint32_t s1 = ROR32(W[i-2], 17) ^ ROR32(W[i-2], 19) ^ (W[i-2] >> 10);
+    W[i] = W[i-16] + s0 + W[i-7] + s1;
+  }
+
+  a = state[0]; b = state[1]; c = state[2]; d = state[3];
+  e = state[4]; f = state[5]; g = state[6]; h = state[7];
+  for (i = 0; i < 64; i++) {
+    const uint32_t S1 = ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25);
+    const uint32_t ch = (e & f) ^ (~e & g);
+    const uint32_t t1 = h + S1 + ch + K[i] + W[i];
+    const uint32_t S0 = ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22);
+    const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    const uint32_t t2 = S0 + maj;
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void
+cdio_sha256_init(cdio_sha256_t *p_sha)
+{
+  static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  memcpy(p_sha->state, H0, sizeof(H0));
+  p_sha->i_bytes = 0;
+}
+
+void
+cdio_sha256_update(cdio_sha256_t *p_sha, const void *p_buf, size_t i_len)
+{
+  const uint8_t *p = p_buf;
+  unsigned int i_used = p_sha->i_bytes & 63;
+
+  p_sha->i_bytes += i_len;
+  if (i_used) {
+    unsigned int i_now = 64 - i_used;
+    if (i_now > i_len) i_now = i_len;
+    memcpy(p_sha->block + i_used, p, i_now);
+    p += i_now;
+    i_len -= i_now;
+    if (i_used + i_now < 64) return;
+    sha256_block(p_sha->state, p_sha->block);
+  }
+  for (; i_len >= 64; p += 64, i_len -= 64)
+    sha256_block(p_sha->state, p);
+  memcpy(p_sha->block, p, i_len);
+}
+
+void
+cdio_sha256_final(cdio_sha256_t *p_sha,
+                  /*out*/ uint8_t digest[CDIO_SHA256_DIGEST_SIZE])
+{
+  static const uint8_t pad[64] = { 0x80 };
+  const uint64_t i_bits = p_sha->i_bytes * 8;
+  uint8_t length[8];
+  unsigned int i;
+
+  for (i = 0; i < 8; i++)
+    length[i] = (uint8_t) (i_bits >> (56 - 8*i));
+  cdio_sha256_update(p_sha, pad, 1 + ((119 - (p_sha->i_bytes & 63)) & 63));
+  cdio_sha256_update(p_sha, length, 8);
+  for (i = 0; i < 32; i++)
+    digest[i] = (uint8_t) (p_sha->state[i/4] >> (24 - 8*(i%4)));
+}
+
+/*
+ * AccurateRip. Each sample, both channels as a little-endian 32-bit
+ * word, is multiplied by its 1-based position in the track. v1 adds
+ * up the low 32 bits of the products; v2 adds up both halves.
+ */
+
+void
+cdio_accuraterip_init(cdio_accuraterip_t *p_ar, uint32_t i_sectors,
+                      bool b_first_track, bool b_last_track)
+{
+  const uint32_t i_samples = i_sectors * AR_SAMPLES_PER_SECTOR;
+  const uint32_t i_skip    = AR_SKIP_SECTORS * AR_SAMPLES_PER_SECTOR;
+
+  memset(p_ar, 0, sizeof(*p_ar));
+  p_ar->i_multiplier = 1;
+  p_ar->i_from = b_first_track ? i_skip : 1;
+  p_ar->i_to   = i_samples;
+  if (b_last_track)
+    p_ar->i_to = (i_samples > i_skip) ? i_samples - i_skip : 0;
+}
+
+static void
+accuraterip_sample(cdio_accuraterip_t *p_ar, uint32_t i_sample)
+{
+  if (p_ar->i_multiplier >= p_ar->i_from && p_ar->i_multiplier <= p_ar->i_to) {
+    const uint64_t i_product = (uint64_t) i_sample * p_ar->i_multiplier;
+    p_ar->v1 += (uint32_t) i_product;
+    p_ar->v2 += (uint32_t) i_product + (uint32_t) (i_product >> 32);
+  }
+  p_ar->i_multiplier++;
+}
+
+void
+cdio_accuraterip_update(cdio_accuraterip_t *p_ar, const void *p_buf,
+                        size_t i_len)
+{
+  const uint8_t *p = p_buf;
+
+  while (p_ar->i_partial && i_len) {
+    p_ar->partial[p_ar->i_partial++] = *p++;
+    i_len--;
+    if (4 == p_ar->i_partial) {
+      accuraterip_sample(p_ar, get_le32(p_ar->partial));
+      p_ar->i_partial = 0;
+    }
+  }
+  for (; i_len >= 4; p += 4, i_len -= 4)
+    accuraterip_sample(p_ar, get_le32(p));
+  memcpy(p_ar->partial, p, i_len);
+  p_ar->i_partial = i_len;
+}
+
+void
+cdio_accuraterip_final(const cdio_accuraterip_t *p_ar,
+                       /*out*/ uint32_t *p_v1, /*out*/ uint32_t *p_v2)
+{
+  if (p_v1) *p_v1 = p_ar->v1;
+  if (p_v2) *p_v2 = p_ar->v2;
+}
+
+const char *
+cdio_checksum_kind2str(cdio_checksum_kind_t e_kind)
+{
+  switch (e_kind) {
+  case CDIO_CHECKSUM_CRC32:       return "crc32";
+  case CDIO_CHECKSUM_MD5:         return "md5";
+  case CDIO_CHECKSUM_SHA256:      return "sha256";
+  case CDIO_CHECKSUM_ACCURATERIP: return "accuraterip";
+  default:                        return "unknown";
+  }
+}
+
+/*
+ * The engine. The calling thread reads batches of sectors into a ring
+ * of CHECKSUM_BUFFERS buffers; one digest thread per checksum kind
+ * consumes each batch, and a buffer is refilled once every digest
+ * thread is done with it.
+ */
+
+typedef struct {
+  uint8_t     *p_data;
+  size_t       i_bytes;
+  unsigned int i_track;     /* index into the reports */
+  bool         b_track_end; /* last batch of that track */
+  bool         b_eof;       /* nothing after this */
+  unsigned int i_seq;       /* batch number held */
+  unsigned int i_pending;   /* digest threads yet to see it */
+} checksum_batch_t;
+
+typedef struct checksum_job_s checksum_job_t;
+
+typedef struct {
+  checksum_job_t      *p_job;
+  cdio_checksum_kind_t e_kind;
+  union {
+    uint32_t           crc32;
+    cdio_md5_t         md5;
+    cdio_sha256_t      sha256;
+    cdio_accuraterip_t ar;
+  } track, disc;
+} checksum_worker_t;
+
+struct checksum_job_s {
+  cdio_checksum_report_t *p_tracks;  /* one per track read */
+  unsigned int            i_tracks;
+  cdio_checksum_report_t *p_disc;    /* or NULL */
+  bool                    b_first_on_disc; /* p_tracks[0] is the first track */
+  bool                    b_last_on_disc;  /* p_tracks[i_tracks-1] is the last */
+  checksum_batch_t        batch[CHECKSUM_BUFFERS];
+  unsigned int            i_workers;
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_t         lock;
+  pthread_cond_t          filled;
+  pthread_cond_t          drained;
+#endif
+};
+
+static void
+worker_start_track(checksum_worker_t *p_worker, unsigned int i_track)
+{
+  const checksum_job_t *p_job = p_worker->p_job;
+  const cdio_checksum_report_t *p_report = &p_job->p_tracks[i_track];
+
+  switch (p_worker->e_kind) {
+  case CDIO_CHECKSUM_CRC32:  p_worker->track.crc32 = 0;              break;
+  case CDIO_CHECKSUM_MD5:    cdio_md5_init(&p_worker->track.md5);       break;
+  case CDIO_CHECKSUM_SHA256: cdio_sha256_init(&p_worker->track.sha256); break;
+  case CDIO_CHECKSUM_ACCURATERIP:
+    cdio_accuraterip_init(&p_worker->track.ar, p_report->i_sectors,
+                          0 == i_track && p_job->b_first_on_disc,
+                          p_job->i_tracks - 1 == i_track
+                          && p_job->b_last_on_disc);
+    break;
+  default: break;
+  }
+}
+
+static void
+worker_consume(checksum_worker_t *p_worker, const checksum_batch_t *p_batch)
+{
+  const checksum_job_t *p_job = p_worker->p_job;
+  cdio_checksum_report_t *p_report = &p_job->p_tracks[p_batch->i_track];
+  const bool b_disc = NULL != p_job->p_disc;
+
+  switch (p_worker->e_kind) {
+  case CDIO_CHECKSUM_CRC32:
+    p_worker->track.crc32 =
+      cdio_crc32(p_worker->track.crc32, p_batch->p_data, p_batch->i_bytes);
+    if (b_disc)
+      p_worker->disc.crc32 =
+        cdio_crc32(p_worker->disc.crc32, p_batch->p_data, p_batch->i_bytes);
+    if (p_batch->b_track_end)
+      p_report->crc32 = p_worker->track.crc32;
+    if (p_batch->b_eof && b_disc)
+      p_job->p_disc->crc32 = p_worker->disc.crc32;
+    break;
+  case CDIO_CHECKSUM_MD5:
+    cdio_md5_update(&p_worker->track.md5, p_batch->p_data, p_batch->i_bytes);
+    if (b_disc)
+      cdio_md5_update(&p_worker->disc.md5, p_batch->p_data, p_batch->i_bytes);
+    if (p_batch->b_track_end)
+      cdio_md5_final(&p_worker->track.md5, p_report->md5);
+    if (p_batch->b_eof && b_disc)
+      cdio_md5_final(&p_worker->disc.md5, p_job->p_disc->md5);
+    break;
+  case CDIO_CHECKSUM_SHA256:
+    cdio_sha256_update(&p_worker->track.sha256, p_batch->p_data,
+                       p_batch->i_bytes);
+    if (b_disc)
+      cdio_sha256_update(&p_worker->disc.sha256, p_batch->p_data,
+                         p_batch->i_bytes);
+    if (p_batch->b_track_end)
+      cdio_sha256_final(&p_worker->track.sha256, p_report->sha256);
+    if (p_batch->b_eof && b_disc)
+      cdio_sha256_final(&p_worker->disc.sha256, p_job->p_disc->sha256);
+    break;
+  case CDIO_CHECKSUM_ACCURATERIP:
+    if (p_report->b_audio)
+      cdio_accuraterip_update(&p_worker->track.ar, p_batch->p_data,
+                              p_batch->i_bytes);
+    if (p_batch->b_track_end && p_report->b_audio)
+      cdio_accuraterip_final(&p_worker->track.ar, &p_report->accuraterip_v1,
+                             &p_report->accuraterip_v2);
+    break;
+  default:
+    break;
+  }
+
+  if (p_batch->b_track_end && p_batch->i_track + 1 < p_job->i_tracks)
+    worker_start_track(p_worker, p_batch->i_track + 1);
+}
+
+static void
+worker_init(checksum_worker_t *p_worker, checksum_job_t *p_job,
+            cdio_checksum_kind_t e_kind)
+{
+  memset(p_worker, 0, sizeof(*p_worker));
+  p_worker->p_job  = p_job;
+  p_worker->e_kind = e_kind;
+  switch (e_kind) {
+  case CDIO_CHECKSUM_MD5:    cdio_md5_init(&p_worker->disc.md5);       break;
+  case CDIO_CHECKSUM_SHA256: cdio_sha256_init(&p_worker->disc.sha256); break;
+  default: break;
+  }
+  worker_start_track(p_worker, 0);
+}
+
+#ifdef HAVE_PTHREAD_H
+static void *
+worker_thread(void *p_arg)
+{
+  checksum_worker_t *p_worker = p_arg;
+  checksum_job_t *p_job = p_worker->p_job;
+  unsigned int i_seq;
+  bool b_eof = false;
+
+  for (i_seq = 0; !b_eof; i_seq++) {
+    checksum_batch_t *p_batch = &p_job->batch[i_seq % CHECKSUM_BUFFERS];
+
+    pthread_mutex_lock(&p_job->lock);
+    while (p_batch->i_seq != i_seq || 0 == p_batch->i_pending)
+      pthread_cond_wait(&p_job->filled, &p_job->lock);
+    pthread_mutex_unlock(&p_job->lock);
+
+    worker_consume(p_worker, p_batch);
+    b_eof = p_batch->b_eof;
+
+    pthread_mutex_lock(&p_job->lock);
+    if (0 == --p_batch->i_pending)
+      pthread_cond_signal(&p_job->drained);
+    pthread_mutex_unlock(&p_job->lock);
+  }
+  return NULL;
+}
+#endif
+
+/* Read i_blocks sectors of p_report's track from i_lsn into p_buf. */
+static driver_return_code_t
+checksum_read(CdIo_t *p_cdio, const cdio_checksum_report_t *p_report,
+              void *p_buf, lsn_t i_lsn, uint32_t i_blocks)
+{
+  if (p_report->b_audio)
+    return cdio_read_audio_sectors(p_cdio, p_buf, i_lsn, i_blocks);
+  return cdio_read_data_sectors(p_cdio, p_buf, i_lsn, CDIO_CD_FRAMESIZE,
+                                i_blocks);
+}
+
+/* Read every track of p_job, handing the batches to the workers. */
+static driver_return_code_t
+checksum_run(CdIo_t *p_cdio, checksum_job_t *p_job,
+             checksum_worker_t *p_workers)
+{
+  driver_return_code_t i_ret = DRIVER_OP_SUCCESS;
+  unsigned int i_seq = 0;
+  unsigned int i_track;
+
+  for (i_track = 0; i_track < p_job->i_tracks; i_track++) {
+    cdio_checksum_report_t *p_report = &p_job->p_tracks[i_track];
+    const unsigned int i_blocksize =
+      p_report->b_audio ? CDIO_CD_FRAMESIZE_RAW : CDIO_CD_FRAMESIZE;
+    uint32_t i_done = 0;
+    bool b_end = false;
+
+    while (!b_end) {
+      checksum_batch_t *p_batch = &p_job->batch[i_seq % CHECKSUM_BUFFERS];
+      uint32_t i_blocks = p_report->i_sectors - i_done;
+      driver_return_code_t i_status;
+
+      if (i_blocks > CHECKSUM_BATCH) i_blocks = CHECKSUM_BATCH;
+
+#ifdef HAVE_PTHREAD_H
+      pthread_mutex_lock(&p_job->lock);
+      while (p_batch->i_pending)
+        pthread_cond_wait(&p_job->drained, &p_job->lock);
+      pthread_mutex_unlock(&p_job->lock);
+#endif
+
+      i_status = i_blocks
+        ? checksum_read(p_cdio, p_report, p_batch->p_data,
+                        p_report->i_lsn + i_done, i_blocks)
+        : DRIVER_OP_SUCCESS;
+      if (DRIVER_OP_SUCCESS != i_status) {
+        /* Find out which sector is bad, keeping those before it. */
+        uint32_t i;
+        for (i = 0; i < i_blocks; i++) {
+          i_status = checksum_read(p_cdio, p_report,
+                                   p_batch->p_data + i * i_blocksize,
+                                   p_report->i_lsn + i_done + i, 1);
+          if (DRIVER_OP_SUCCESS != i_status) break;
+        }
+        cdio_warn("track %d: can't read sector %ld",
+                  p_report->i_track, (long int) (p_report->i_lsn + i_done + i));
+        p_report->i_status = i_status;
+        if (DRIVER_OP_SUCCESS == i_ret) i_ret = i_status;
+        i_blocks = i;
+        b_end = true;
+      }
+      i_done += i_blocks;
+      if (i_done >= p_report->i_sectors) b_end = true;
+
+      p_batch->i_bytes     = (size_t) i_blocks * i_blocksize;
+      p_batch->i_track     = i_track;
+      p_batch->b_track_end = b_end;
+      p_batch->b_eof       = b_end && i_track + 1 == p_job->i_tracks;
+
+#ifdef HAVE_PTHREAD_H
+      pthread_mutex_lock(&p_job->lock);
+      p_batch->i_seq     = i_seq;
+      p_batch->i_pending = p_job->i_workers;
+      pthread_cond_broadcast(&p_job->filled);
+      pthread_mutex_unlock(&p_job->lock);
+#else
+      {
+        unsigned int i;
+        for (i = 0; i < p_job->i_workers; i++)
+          worker_consume(&p_workers[i], p_batch);
+      }
+#endif
+      i_seq++;
+    }
+  }
+  return i_ret;
+}
+
+/* Compute the i_kinds checksums of the i_tracks reports in p_tracks,
+   whose track, LSN, size and audio fields are filled in, and of all
+   of them in p_disc if that isn't NULL. */
+static driver_return_code_t
+checksum_tracks(CdIo_t *p_cdio, unsigned int i_kinds,
+                cdio_checksum_report_t *p_tracks, unsigned int i_tracks,
+                bool b_first_on_disc, bool b_last_on_disc,
+                cdio_checksum_report_t *p_disc)
+{
+  static const cdio_checksum_kind_t kinds[] = {
+    CDIO_CHECKSUM_CRC32, CDIO_CHECKSUM_MD5, CDIO_CHECKSUM_SHA256,
+    CDIO_CHECKSUM_ACCURATERIP
+  };
+  checksum_job_t job;
+  checksum_worker_t workers[sizeof(kinds)/sizeof(kinds[0])];
+  driver_return_code_t i_ret;
+  unsigned int i;
+#ifdef HAVE_PTHREAD_H
+  pthread_t threads[sizeof(kinds)/sizeof(kinds[0])];
+  unsigned int i_threads = 0;
+#endif
+
+  memset(&job, 0, sizeof(job));
+  job.p_tracks        = p_tracks;
+  job.i_tracks        = i_tracks;
+  job.p_disc          = p_disc;
+  job.b_first_on_disc = b_first_on_disc;
+  job.b_last_on_disc  = b_last_on_disc;
+
+  for (i = 0; i < i_tracks; i++) {
+    p_tracks[i].i_status = DRIVER_OP_SUCCESS;
+    p_tracks[i].i_kinds  = i_kinds & CDIO_CHECKSUM_ALL;
+    if (!p_tracks[i].b_audio)
+      p_tracks[i].i_kinds &= ~CDIO_CHECKSUM_ACCURATERIP;
+  }
+  if (p_disc) {
+    p_disc->i_status = DRIVER_OP_SUCCESS;
+    p_disc->i_kinds  = i_kinds & CDIO_CHECKSUM_ALL & ~CDIO_CHECKSUM_ACCURATERIP;
+  }
+  if (0 == i_tracks) return DRIVER_OP_SUCCESS;
+
+  for (i = 0; i < CHECKSUM_BUFFERS; i++) {
+    job.batch[i].i_seq = (unsigned int) -1;
+    job.batch[i].p_data = malloc(CHECKSUM_BATCH * CDIO_CD_FRAMESIZE_RAW);
+    if (!job.batch[i].p_data) {
+      while (i--) free(job.batch[i].p_data);
+      return DRIVER_OP_ERROR;
+    }
+  }
+
+  for (i = 0; i < sizeof(kinds)/sizeof(kinds[0]); i++)
+    if (i_kinds & kinds[i])
+      worker_init(&workers[job.i_workers++], &job, kinds[i]);
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.filled, NULL);
+  pthread_cond_init(&job.drained, NULL);
+  for (i_threads = 0; i_threads < job.i_workers; i_threads++)
+    if (0 != pthread_create(&threads[i_threads], NULL, worker_thread,
+                            &workers[i_threads]))
+      break;
+  if (i_threads < job.i_workers) {
+    /* Some of the checksums asked for would be missing. Let the
+       threads we got finish on an empty last batch, and fail. */
+    checksum_batch_t *p_batch = &job.batch[0];
+    cdio_warn("could only start %u of %u checksum threads",
+              i_threads, job.i_workers);
+    pthread_mutex_lock(&job.lock);
+    job.i_workers        = i_threads;
+    p_batch->i_bytes     = 0;
+    p_batch->i_track     = 0;
+    p_batch->b_track_end = false;
+    p_batch->b_eof       = true;
+    p_batch->i_seq       = 0;
+    p_batch->i_pending   = i_threads;
+    pthread_cond_broadcast(&job.filled);
+    pthread_mutex_unlock(&job.lock);
+    i_ret = DRIVER_OP_ERROR;
+    for (i = 0; i < i_tracks; i++)
+      p_tracks[i].i_status = i_ret;
+  } else
+#endif
+    i_ret = checksum_run(p_cdio, &job, workers);
+
+#ifdef HAVE_PTHREAD_H
+  for (i = 0; i < i_threads; i++)
+    pthread_join(threads[i], NULL);
+  pthread_cond_destroy(&job.drained);
+  pthread_cond_destroy(&job.filled);
+  pthread_mutex_destroy(&job.lock);
+#endif
+
+  for (i = 0; i < CHECKSUM_BUFFERS; i++)
+    free(job.batch[i].p_data);
+
+  if (p_disc) p_disc->i_status = i_ret;
+  return i_ret;
+}
+
+/* Fill in the range and kind of track i_track of p_cdio. */
+static driver_return_code_t
+checksum_track_range(CdIo_t *p_cdio, track_t i_track,
+                     /*out*/ cdio_checksum_report_t *p_report)
+{
+  const lsn_t i_first = cdio_get_track_lsn(p_cdio, i_track);
+  const lsn_t i_last  = cdio_get_track_last_lsn(p_cdio, i_track);
+  const track_format_t e_format = cdio_get_track_format(p_cdio, i_track);
+
+  memset(p_report, 0, sizeof(*p_report));
+  if (CDIO_INVALID_LSN == i_first || CDIO_INVALID_LSN == i_last
+      || i_last < i_first || TRACK_FORMAT_ERROR == e_format)
+    return DRIVER_OP_ERROR;
+  p_report->i_track   = i_track;
+  p_report->i_lsn     = i_first;
+  p_report->i_sectors = (uint32_t) (i_last - i_first + 1);
+  p_report->b_audio   = (TRACK_FORMAT_AUDIO == e_format);
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Compute the i_kinds checksums of every track of the disc in p_cdio,
+  and of all of them together.
+*/
+driver_return_code_t
+cdio_checksum_disc(CdIo_t *p_cdio, unsigned int i_kinds,
+                   /*out*/ cdio_disc_checksum_t *p_sums)
+{
+  track_t i_first, i_tracks, i;
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_sums) return DRIVER_OP_BAD_POINTER;
+
+  memset(p_sums, 0, sizeof(*p_sums));
+  i_first  = cdio_get_first_track_num(p_cdio);
+  i_tracks = cdio_get_num_tracks(p_cdio);
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || i_tracks > CDIO_CD_MAX_TRACKS)
+    return DRIVER_OP_ERROR;
+
+  for (i = 0; i < i_tracks; i++)
+    if (DRIVER_OP_SUCCESS !=
+        checksum_track_range(p_cdio, i_first + i, &p_sums->track[i]))
+      return DRIVER_OP_ERROR;
+  p_sums->i_tracks       = i_tracks;
+  p_sums->disc.i_lsn     = p_sums->track[0].i_lsn;
+  for (i = 0; i < i_tracks; i++)
+    p_sums->disc.i_sectors += p_sums->track[i].i_sectors;
+
+  return checksum_tracks(p_cdio, i_kinds, p_sums->track, i_tracks,
+                         true, true, &p_sums->disc);
+}
+
+/*!
+  Compute the i_kinds checksums of track i_track.
+*/
+driver_return_code_t
+cdio_checksum_track(CdIo_t *p_cdio, track_t i_track, unsigned int i_kinds,
+                    /*out*/ cdio_checksum_report_t *p_sum)
+{
+  track_t i_first, i_last;
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_sum) return DRIVER_OP_BAD_POINTER;
+  if (DRIVER_OP_SUCCESS != checksum_track_range(p_cdio, i_track, p_sum))
+    return DRIVER_OP_ERROR;
+
+  i_first = cdio_get_first_track_num(p_cdio);
+  i_last  = cdio_get_last_track_num(p_cdio);
+  return checksum_tracks(p_cdio, i_kinds, p_sum, 1, i_track == i_first,
+                         i_track == i_last, NULL);
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,296 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file convert.c
+ *
+ *  \brief Converting between disc image formats.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/convert.h>
+#include "_cdio_stdio.h"
+
+/* Take a 64-bit offset where there is a way to. */
+#if defined(HAVE_FSEEKO64) && defined(_FILE_OFFSET_BITS) && (_FILE_OFFSET_BITS == 64)
+#define CDIO_FSEEK fseeko64
+#elif defined(HAVE_FSEEKO)
+#define CDIO_FSEEK fseeko
+#else
+#define CDIO_FSEEK fseek
+#endif
+
+/* Sectors read, encoded and written at a time. */
+#define CONVERT_BATCH        64
+/* Don't split the image finer than this among threads. */
+#define CONVERT_MIN_SECTORS  (16 * CONVERT_BATCH)
+#define CONVERT_MAX_THREADS  8
+
+/* One thread's share of a conversion. */
+typedef struct {
+  const char          *psz_iso;
+  const char          *psz_bin;
+  cdio_raw_mode_t      e_mode;
+  lsn_t                i_first;    /* first sector */
+  lsn_t                i_end;      /* one past the last */
+  driver_return_code_t i_status;
+} convert_range_t;
+
+/* Encode and write the sectors of p_range. */
+static driver_return_code_t
+convert_range(convert_range_t *p_range)
+{
+  uint8_t *p_in  = calloc(CONVERT_BATCH, CDIO_CD_FRAMESIZE);
+  uint8_t *p_out = malloc(CONVERT_BATCH * CDIO_CD_FRAMESIZE_RAW);
+  FILE *p_iso = CDIO_FOPEN(p_range->psz_iso, "rb");
+  FILE *p_bin = CDIO_FOPEN(p_range->psz_bin, "r+b");
+  driver_return_code_t i_ret = DRIVER_OP_SUCCESS;
+  lsn_t i_lsn;
+
+  if (!p_in || !p_out || !p_iso || !p_bin) {
+    cdio_warn("can't convert %s: %s", p_range->psz_iso, strerror(errno));
+    i_ret = DRIVER_OP_ERROR;
+    goto done;
+  }
+
+  if (0 != CDIO_FSEEK(p_iso, (off_t) p_range->i_first * CDIO_CD_FRAMESIZE,
+                      SEEK_SET)
+      || 0 != CDIO_FSEEK(p_bin,
+                         (off_t) p_range->i_first * CDIO_CD_FRAMESIZE_RAW,
+                         SEEK_SET)) {
+    cdio_warn("can't seek in %s: %s", p_range->psz_iso, strerror(errno));
+    i_ret = DRIVER_OP_ERROR;
+    goto done;
+  }
+
+  for (i_lsn = p_range->i_first; i_lsn < p_range->i_end;
+       i_lsn += CONVERT_BATCH) {
+    unsigned int i_now = CONVERT_BATCH, i;
+    size_t i_read;
+
+    if (i_lsn + (lsn_t) i_now > p_range->i_end)
+      i_now = (unsigned int) (p_range->i_end - i_lsn);
+
+    i_read = fread(p_in, 1, (size_t) i_now * CDIO_CD_FRAMESIZE, p_iso);
+    if (i_read < (size_t) i_now * CDIO_CD_FRAMESIZE) {
+      if (ferror(p_iso)) {
+        cdio_warn("error reading %s: %s", p_range->psz_iso, strerror(errno));
+        i_ret = DRIVER_OP_ERROR;
+        break;
+      }
+      /* A short last block is padded out with zeros. */
+      memset(p_in + i_read, 0, (size_t) i_now * CDIO_CD_FRAMESIZE - i_read);
+    }
+
+    for (i = 0; i < i_now; i++)
+      cdio_sector_encode(p_out + (size_t) i * CDIO_CD_FRAMESIZE_RAW,
+                         i_lsn + (lsn_t) i, p_range->e_mode, NULL,
+                         p_in + (size_t) i * CDIO_CD_FRAMESIZE);
+
+    if (fwrite(p_out, CDIO_CD_FRAMESIZE_RAW, i_now, p_bin) != i_now) {
+      cdio_warn("error writing %s: %s", p_range->psz_bin, strerror(errno));
+      i_ret = DRIVER_OP_ERROR;
+      break;
+    }
+  }
+
+ done:
+  if (p_bin && 0 != fclose(p_bin) && DRIVER_OP_SUCCESS == i_ret) {
+    cdio_warn("error writing %s: %s", p_range->psz_bin, strerror(errno));
+    i_ret = DRIVER_OP_ERROR;
+  }
+  if (p_iso) fclose(p_iso);
+  free(p_out);
+  free(p_in);
+  return i_ret;
+}
+
+#ifdef HAVE_PTHREAD_H
+static void *
+convert_thread(void *p_arg)
+{
+  convert_range_t *p_range = p_arg;
+  p_range->i_status = convert_range(p_range);
+  return NULL;
+}
+#endif
+
+/* Write the CUE sheet psz_cue for the single-track image psz_bin. */
+static driver_return_code_t
+convert_write_cue(const char *psz_cue, const char *psz_bin,
+                  cdio_raw_mode_t e_mode)
+{
+  const char *psz_base = strrchr(psz_bin, '/');
+  FILE *p_cue = CDIO_FOPEN(psz_cue, "w");
+
+#ifdef _WIN32
+  if (!psz_base) psz_base = strrchr(psz_bin, '\\');
+#endif
+  psz_base = psz_base ? psz_base + 1 : psz_bin;
+
+  if (!p_cue) {
+    cdio_warn("can't create %s: %s", psz_cue, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  fprintf(p_cue, "FILE \"%s\" BINARY\n", psz_base);
+  fprintf(p_cue, "  TRACK 01 %s\n",
+          CDIO_RAW_MODE1 == e_mode ? "MODE1/2352" : "MODE2/2352");
+  fprintf(p_cue, "    INDEX 01 00:00:00\n");
+  if (0 != fclose(p_cue)) {
+    cdio_warn("error writing %s: %s", psz_cue, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Convert the ISO 9660 image psz_iso into the raw image psz_bin of
+  e_mode sectors, writing a CUE sheet to psz_cue unless it is NULL.
+*/
+driver_return_code_t
+cdio_convert_iso_to_bin(const char *psz_iso, const char *psz_bin,
+                        const char *psz_cue, cdio_raw_mode_t e_mode,
+                        unsigned int i_threads)
+{
+  convert_range_t ranges[CONVERT_MAX_THREADS];
+  driver_return_code_t i_ret = DRIVER_OP_SUCCESS;
+  struct stat statbuf;
+  lsn_t i_sectors;
+  unsigned int i;
+  FILE *p_bin;
+
+  if (!psz_iso || !psz_bin) return DRIVER_OP_BAD_POINTER;
+  if (CDIO_RAW_MODE1 != e_mode && CDIO_RAW_MODE2_FORM1 != e_mode)
+    return DRIVER_OP_BAD_PARAMETER;
+
+  if (0 != stat(psz_iso, &statbuf)) {
+    cdio_warn("can't stat %s: %s", psz_iso, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  if (statbuf.st_size > (off_t) CDIO_CD_MAX_LSN * CDIO_CD_FRAMESIZE) {
+    cdio_warn("%s is too big for a CD", psz_iso);
+    return DRIVER_OP_BAD_PARAMETER;
+  }
+  i_sectors = (lsn_t) ((statbuf.st_size + CDIO_CD_FRAMESIZE - 1)
+                       / CDIO_CD_FRAMESIZE);
+
+  /* Create the image, so that each thread can open it to write its
+     share. */
+  p_bin = CDIO_FOPEN(psz_bin, "wb");
+  if (!p_bin || 0 != fclose(p_bin)) {
+    cdio_warn("can't create %s: %s", psz_bin, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+
+  if (0 == i_threads) {
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+    const long i_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    i_threads = i_cpus > 0 ? (unsigned int) i_cpus : 1;
+#else
+    i_threads = 1;
+#endif
+  }
+#ifndef HAVE_PTHREAD_H
+  i_threads = 1;
+#endif
+  if (i_threads > CONVERT_MAX_THREADS) i_threads = CONVERT_MAX_THREADS;
+  if ((lsn_t) i_threads * CONVERT_MIN_SECTORS > i_sectors)
+    i_threads = (unsigned int) (i_sectors / CONVERT_MIN_SECTORS);
+  if (0 == i_threads) i_threads = 1;
+
+  /* Equal shares, rounded to whole batches. */
+  for (i = 0; i < i_threads; i++) {
+    const lsn_t i_share = ((i_sectors / (lsn_t) i_threads + CONVERT_BATCH - 1)
+                           / CONVERT_BATCH) * CONVERT_BATCH;
+    ranges[i].psz_iso  = psz_iso;
+    ranges[i].psz_bin  = psz_bin;
+    ranges[i].e_mode   = e_mode;
+    ranges[i].i_first  = (lsn_t) i * i_share;
+    ranges[i].i_end    = (i + 1 == i_threads)
+      ? i_sectors : (lsn_t) (i + 1) * i_share;
+    if (ranges[i].i_first > i_sectors) ranges[i].i_first = i_sectors;
+    if (ranges[i].i_end > i_sectors) ranges[i].i_end = i_sectors;
+    ranges[i].i_status = DRIVER_OP_SUCCESS;
+  }
+
+#ifdef HAVE_PTHREAD_H
+  {
+    pthread_t threads[CONVERT_MAX_THREADS];
+    bool b_started[CONVERT_MAX_THREADS];
+
+    for (i = 1; i < i_threads; i++)
+      b_started[i] = (0 == pthread_create(&threads[i], NULL, convert_thread,
+                                          &ranges[i]));
+    ranges[0].i_status = convert_range(&ranges[0]);
+    for (i = 1; i < i_threads; i++) {
+      if (b_started[i])
+        pthread_join(threads[i], NULL);
+      else
+        ranges[i].i_status = convert_range(&ranges[i]);
+    }
+  }
+#else
+  ranges[0].i_status = convert_range(&ranges[0]);
+#endif
+
+  for (i = 0; i < i_threads; i++)
+    if (DRIVER_OP_SUCCESS != ranges[i].i_status) {
+      i_ret = ranges[i].i_status;
+      break;
+    }
+
+  if (DRIVER_OP_SUCCESS == i_ret && psz_cue)
+    i_ret = convert_write_cue(psz_cue, psz_bin, e_mode);
+  return i_ret;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -829,8 +829,11 @@ int
 cdio_get_media_changed(CdIo_t *p_cdio)
 {
   if (!p_cdio) return DRIVER_OP_UNINIT;
-  if (p_cdio->op.get_media_changed)
-    return p_cdio->op.get_media_changed(p_cdio->env);
+  if (p_cdio->op.get_media_changed) {
+    int i_changed = p_cdio->op.get_media_changed(p_cdio->env);
+    if (1 == i_changed) cdio_track_table_invalidate(p_cdio);
+    return i_changed;
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
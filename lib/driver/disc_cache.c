@@ -0,0 +1,687 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file disc_cache.c
+ *
+ *  \brief Keeping what was learned about a disc on disk.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_FCNTL_H) && defined(HAVE_UNISTD_H)
+# define HAVE_DISC_CACHE_MMAP 1
+# include <sys/mman.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/mmc.h>
+#include <cdio/checksum.h>
+#include <cdio/disc_cache.h>
+#include "_cdio_stdio.h"
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+# define disc_cache_mkdir(psz) mkdir(psz)
+#else
+# define disc_cache_mkdir(psz) mkdir(psz, 0755)
+#endif
+
+/* A cache file is a header, a record for each track, then the raw
+   CD-Text packs. It is written in host byte order; DISC_CACHE_ORDER
+   tells a file of the other order apart. */
+#define DISC_CACHE_MAGIC   "CDIODISC"
+#define DISC_CACHE_VERSION 1
+#define DISC_CACHE_ORDER   0x01020304
+
+typedef struct {
+  char     magic[8];
+  uint32_t i_version;
+  uint32_t i_order;
+  uint32_t i_size;          /* of the whole file */
+  uint32_t i_discid;
+  int32_t  i_leadout;
+  uint32_t i_toc_crc;
+  uint8_t  i_first_track;
+  uint8_t  i_tracks;
+  uint8_t  b_mcn;
+  uint8_t  reserved;
+  char     psz_mcn[CDIO_MCN_SIZE + 3]; /* NUL-terminated, padded */
+  uint32_t i_cdtext_len;    /* bytes of CD-Text packs */
+} disc_cache_header_t;
+
+typedef struct {
+  int32_t  i_lsn;
+  uint32_t i_format;        /* track_format_t */
+  uint32_t i_fs;            /* cdio_fs_anal_t */
+  uint32_t i_joliet_level;
+  uint32_t i_isofs_size;
+  uint8_t  i_udf_major;
+  uint8_t  i_udf_minor;
+  uint8_t  b_isrc;
+  char     psz_isrc[CDIO_ISRC_SIZE + 1];
+  char     psz_iso_label[33];
+  uint8_t  reserved[3];
+} disc_cache_track_t;
+
+struct cdio_disc_info_s {
+  uint8_t                   *p_data;   /* the file's contents */
+  size_t                     i_size;
+  bool                       b_mapped; /* p_data is mmap()ed */
+  const disc_cache_header_t *p_hdr;
+  const disc_cache_track_t  *p_tracks;
+  cdtext_t                  *p_cdtext; /* parsed when first asked for */
+};
+
+struct cdio_disc_cache_s {
+  char             *psz_dir;
+  CdIo_t           *p_cdio;   /* the handle p_info came from */
+  cdio_disc_info_t *p_info;
+};
+
+bool
+cdio_disc_cache_key(CdIo_t *p_cdio, /*out*/ cdio_disc_key_t *p_key)
+{
+  track_t i_first, i_tracks, i;
+  lsn_t i_start, i_leadout;
+  unsigned int n = 0;
+  uint32_t i_crc = 0;
+
+  if (!p_cdio || !p_key) return false;
+  i_first  = cdio_get_first_track_num(p_cdio);
+  i_tracks = cdio_get_num_tracks(p_cdio);
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || 0 == i_tracks)
+    return false;
+
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    lsn_t i_lsn = cdio_get_track_lsn(p_cdio, i);
+    uint8_t rec[5];
+    unsigned int s;
+
+    if (CDIO_INVALID_LSN == i_lsn) return false;
+    /* As cddb_discid() does: the sum of the decimal digits of each
+       track's start in seconds. */
+    for (s = (i_lsn + CDIO_PREGAP_SECTORS) / CDIO_CD_FRAMES_PER_SEC; s;
+         s /= 10)
+      n += s % 10;
+    rec[0] = i_lsn >> 24; rec[1] = i_lsn >> 16;
+    rec[2] = i_lsn >> 8;  rec[3] = i_lsn;
+    rec[4] = (uint8_t) cdio_get_track_format(p_cdio, i);
+    i_crc = cdio_crc32(i_crc, rec, sizeof(rec));
+  }
+
+  i_start   = cdio_get_track_lsn(p_cdio, i_first);
+  i_leadout = cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);
+  if (CDIO_INVALID_LSN == i_leadout) return false;
+
+  p_key->i_discid  = (n % 0xff) << 24
+    | ((i_leadout - i_start) / CDIO_CD_FRAMES_PER_SEC) << 8 | i_tracks;
+  p_key->i_leadout = i_leadout;
+  p_key->i_toc_crc = i_crc;
+  return true;
+}
+
+static char *
+key_path(const cdio_disc_cache_t *p_cache, const cdio_disc_key_t *p_key)
+{
+  size_t i_len = strlen(p_cache->psz_dir) + sizeof("/01234567-01234567-01234567");
+  char *psz_path = malloc(i_len);
+
+  if (psz_path)
+    snprintf(psz_path, i_len, "%s/%08x-%08x-%08x", p_cache->psz_dir,
+             (unsigned int) p_key->i_discid, (unsigned int) p_key->i_leadout,
+             (unsigned int) p_key->i_toc_crc);
+  return psz_path;
+}
+
+static bool
+make_dir(const char *psz_dir)
+{
+  struct stat st;
+
+  if (0 == disc_cache_mkdir(psz_dir) || EEXIST == errno)
+    return 0 == stat(psz_dir, &st) && S_ISDIR(st.st_mode);
+  return false;
+}
+
+cdio_disc_cache_t *
+cdio_disc_cache_open(const char *psz_dir)
+{
+  cdio_disc_cache_t *p_cache;
+  char *psz_path = NULL;
+
+  if (!psz_dir) {
+    const char *psz_base = getenv("XDG_CACHE_HOME");
+    const char *psz_home = getenv("HOME");
+    size_t i_len;
+
+    if (psz_base && *psz_base) {
+      i_len = strlen(psz_base) + sizeof("/libcdio");
+      if (!(psz_path = malloc(i_len))) return NULL;
+      snprintf(psz_path, i_len, "%s/libcdio", psz_base);
+    } else if (psz_home && *psz_home) {
+      i_len = strlen(psz_home) + sizeof("/.cache/libcdio");
+      if (!(psz_path = malloc(i_len))) return NULL;
+      snprintf(psz_path, i_len, "%s/.cache", psz_home);
+      make_dir(psz_path);
+      snprintf(psz_path, i_len, "%s/.cache/libcdio", psz_home);
+    } else {
+      cdio_warn("disc cache: neither XDG_CACHE_HOME nor HOME is set");
+      return NULL;
+    }
+  } else if (!(psz_path = strdup(psz_dir)))
+    return NULL;
+
+  if (!make_dir(psz_path)) {
+    cdio_warn("disc cache: can't make directory %s: %s", psz_path,
+              strerror(errno));
+    free(psz_path);
+    return NULL;
+  }
+
+  p_cache = calloc(1, sizeof(cdio_disc_cache_t));
+  if (!p_cache) {
+    free(psz_path);
+    return NULL;
+  }
+  p_cache->psz_dir = psz_path;
+  return p_cache;
+}
+
+static void
+info_free(cdio_disc_info_t *p_info)
+{
+  if (!p_info) return;
+  if (p_info->p_cdtext) {
+    cdtext_destroy(p_info->p_cdtext);
+    free(p_info->p_cdtext);
+  }
+#ifdef HAVE_DISC_CACHE_MMAP
+  if (p_info->b_mapped)
+    munmap(p_info->p_data, p_info->i_size);
+  else
+#endif
+    free(p_info->p_data);
+  free(p_info);
+}
+
+void
+cdio_disc_cache_close(cdio_disc_cache_t *p_cache)
+{
+  if (!p_cache) return;
+  info_free(p_cache->p_info);
+  free(p_cache->psz_dir);
+  free(p_cache);
+}
+
+/* Whether the i_size bytes of psz hold a string. */
+static bool
+str_fits(const char *psz, size_t i_size)
+{
+  return NULL != memchr(psz, '\0', i_size);
+}
+
+/* Whether the strings of a cache file all end within their fields:
+   the file may have been damaged or written by someone else, and its
+   strings are handed out as they are. */
+static bool
+info_strings_ok(const disc_cache_header_t *p_hdr)
+{
+  const disc_cache_track_t *p_track = (const disc_cache_track_t *) (p_hdr + 1);
+  unsigned int i;
+
+  if (!str_fits(p_hdr->psz_mcn, sizeof(p_hdr->psz_mcn))) return false;
+  for (i = 0; i < p_hdr->i_tracks; i++, p_track++)
+    if (!str_fits(p_track->psz_isrc, sizeof(p_track->psz_isrc))
+        || !str_fits(p_track->psz_iso_label, sizeof(p_track->psz_iso_label)))
+      return false;
+  return true;
+}
+
+/* Make an entry of i_size bytes of p_data, or NULL if they aren't a
+   cache file for p_key. The entry takes p_data over either way. */
+static cdio_disc_info_t *
+info_new(uint8_t *p_data, size_t i_size, bool b_mapped,
+         const cdio_disc_key_t *p_key)
+{
+  const disc_cache_header_t *p_hdr = (const disc_cache_header_t *) p_data;
+  cdio_disc_info_t *p_info = calloc(1, sizeof(cdio_disc_info_t));
+
+  if (p_info) {
+    p_info->p_data   = p_data;
+    p_info->i_size   = i_size;
+    p_info->b_mapped = b_mapped;
+  }
+  if (!p_info || i_size < sizeof(disc_cache_header_t)
+      || 0 != memcmp(p_hdr->magic, DISC_CACHE_MAGIC, sizeof(p_hdr->magic))
+      || DISC_CACHE_VERSION != p_hdr->i_version
+      || DISC_CACHE_ORDER != p_hdr->i_order
+      || i_size != p_hdr->i_size
+      || i_size != sizeof(disc_cache_header_t)
+                   + p_hdr->i_tracks * sizeof(disc_cache_track_t)
+                   + p_hdr->i_cdtext_len
+      || p_key->i_discid != p_hdr->i_discid
+      || p_key->i_leadout != p_hdr->i_leadout
+      || p_key->i_toc_crc != p_hdr->i_toc_crc
+      || !info_strings_ok(p_hdr)) {
+    if (p_info) info_free(p_info);
+#ifdef HAVE_DISC_CACHE_MMAP
+    else if (b_mapped) munmap(p_data, i_size);
+#endif
+    else free(p_data);
+    return NULL;
+  }
+  p_info->p_hdr    = p_hdr;
+  p_info->p_tracks = (const disc_cache_track_t *) (p_hdr + 1);
+  return p_info;
+}
+
+/* Read the cache file for p_key, if there is one. */
+static cdio_disc_info_t *
+info_load(const cdio_disc_cache_t *p_cache, const cdio_disc_key_t *p_key)
+{
+  char *psz_path = key_path(p_cache, p_key);
+  uint8_t *p_data = NULL;
+  size_t i_size = 0;
+  bool b_mapped = false;
+
+  if (!psz_path) return NULL;
+
+#ifdef HAVE_DISC_CACHE_MMAP
+  {
+    int fd = open(psz_path, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0) {
+      free(psz_path);
+      return NULL;
+    }
+    if (0 == fstat(fd, &st) && st.st_size > 0) {
+      void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != p) {
+        p_data   = p;
+        i_size   = st.st_size;
+        b_mapped = true;
+      }
+    }
+    close(fd);
+  }
+#endif
+
+  if (!p_data) {
+    FILE *fp = CDIO_FOPEN(psz_path, "rb");
+    long i_len;
+
+    if (fp && 0 == fseek(fp, 0, SEEK_END) && (i_len = ftell(fp)) > 0
+        && 0 == fseek(fp, 0, SEEK_SET)
+        && NULL != (p_data = malloc(i_len))) {
+      i_size = i_len;
+      if (1 != fread(p_data, i_size, 1, fp)) {
+        free(p_data);
+        p_data = NULL;
+      }
+    }
+    if (fp) fclose(fp);
+  }
+
+  if (!p_data) {
+    free(psz_path);
+    return NULL;
+  }
+  {
+    cdio_disc_info_t *p_info = info_new(p_data, i_size, b_mapped, p_key);
+    if (!p_info)
+      cdio_debug("disc cache: ignoring stale or foreign %s", psz_path);
+    free(psz_path);
+    return p_info;
+  }
+}
+
+/* Ask the drive for everything an entry holds. */
+static cdio_disc_info_t *
+info_read(CdIo_t *p_cdio, const cdio_disc_key_t *p_key)
+{
+  track_t i_first  = cdio_get_first_track_num(p_cdio);
+  track_t i_tracks = cdio_get_num_tracks(p_cdio);
+  uint8_t *p_cdtext_raw = cdio_get_cdtext_raw(p_cdio);
+  size_t i_cdtext_len = 0;
+  disc_cache_header_t *p_hdr;
+  disc_cache_track_t *p_track;
+  size_t i_size;
+  uint8_t *p_data;
+  char *psz;
+  track_t i;
+
+  if (p_cdtext_raw) {
+    size_t i_len = CDIO_MMC_GET_LEN16(p_cdtext_raw);
+    /* The length counts the two reserved bytes before the packs. */
+    if (i_len > 2) i_cdtext_len = i_len - 2;
+  }
+
+  i_size = sizeof(disc_cache_header_t)
+    + i_tracks * sizeof(disc_cache_track_t) + i_cdtext_len;
+  p_data = calloc(1, i_size);
+  if (!p_data) {
+    free(p_cdtext_raw);
+    return NULL;
+  }
+
+  p_hdr = (disc_cache_header_t *) p_data;
+  memcpy(p_hdr->magic, DISC_CACHE_MAGIC, sizeof(p_hdr->magic));
+  p_hdr->i_version     = DISC_CACHE_VERSION;
+  p_hdr->i_order       = DISC_CACHE_ORDER;
+  p_hdr->i_size        = i_size;
+  p_hdr->i_discid      = p_key->i_discid;
+  p_hdr->i_leadout     = p_key->i_leadout;
+  p_hdr->i_toc_crc     = p_key->i_toc_crc;
+  p_hdr->i_first_track = i_first;
+  p_hdr->i_tracks      = i_tracks;
+  p_hdr->i_cdtext_len  = i_cdtext_len;
+
+  if (NULL != (psz = cdio_get_mcn(p_cdio))) {
+    p_hdr->b_mcn = 1;
+    strncpy(p_hdr->psz_mcn, psz, CDIO_MCN_SIZE);
+    free(psz);
+  }
+
+  p_track = (disc_cache_track_t *) (p_hdr + 1);
+  for (i = 0; i < i_tracks; i++, p_track++) {
+    const track_t i_track = i_first + i;
+    track_format_t format = cdio_get_track_format(p_cdio, i_track);
+
+    p_track->i_lsn    = cdio_get_track_lsn(p_cdio, i_track);
+    p_track->i_format = format;
+    if (TRACK_FORMAT_AUDIO == format) {
+      p_track->i_fs = CDIO_FS_AUDIO;
+      if (NULL != (psz = cdio_get_track_isrc(p_cdio, i_track))) {
+        p_track->b_isrc = 1;
+        strncpy(p_track->psz_isrc, psz, CDIO_ISRC_SIZE);
+        free(psz);
+      }
+    } else {
+      cdio_iso_analysis_t analysis;
+
+      memset(&analysis, 0, sizeof(analysis));
+      p_track->i_fs = cdio_guess_cd_type(p_cdio, p_track->i_lsn, i_track,
+                                         &analysis);
+      p_track->i_joliet_level = analysis.joliet_level;
+      p_track->i_isofs_size   = analysis.isofs_size;
+      p_track->i_udf_major    = analysis.UDFVerMajor;
+      p_track->i_udf_minor    = analysis.UDFVerMinor;
+      memcpy(p_track->psz_iso_label, analysis.iso_label,
+             sizeof(p_track->psz_iso_label));
+      p_track->psz_iso_label[sizeof(p_track->psz_iso_label) - 1] = '\0';
+    }
+  }
+
+  if (i_cdtext_len)
+    memcpy(p_track, p_cdtext_raw + 4, i_cdtext_len);
+  free(p_cdtext_raw);
+
+  return info_new(p_data, i_size, false, p_key);
+}
+
+/* Write p_info out, through a temporary file so that readers never
+   see half of it. */
+static void
+info_store(const cdio_disc_cache_t *p_cache, const cdio_disc_info_t *p_info,
+           const cdio_disc_key_t *p_key)
+{
+  char *psz_path = key_path(p_cache, p_key);
+  char *psz_tmp;
+  size_t i_len;
+  FILE *fp;
+  bool b_ok;
+
+  if (!psz_path) return;
+  i_len = strlen(psz_path) + sizeof(".tmp.4294967295");
+  if (!(psz_tmp = malloc(i_len))) {
+    free(psz_path);
+    return;
+  }
+#ifdef HAVE_UNISTD_H
+  snprintf(psz_tmp, i_len, "%s.tmp.%u", psz_path, (unsigned int) getpid());
+#else
+  snprintf(psz_tmp, i_len, "%s.tmp", psz_path);
+#endif
+
+  fp = CDIO_FOPEN(psz_tmp, "wb");
+  b_ok = fp && 1 == fwrite(p_info->p_data, p_info->i_size, 1, fp);
+  if (fp && 0 != fclose(fp)) b_ok = false;
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  /* rename() won't replace a file here. */
+  if (b_ok) remove(psz_path);
+#endif
+  if (!b_ok || 0 != rename(psz_tmp, psz_path)) {
+    cdio_warn("disc cache: can't write %s: %s", psz_path, strerror(errno));
+    remove(psz_tmp);
+  }
+  free(psz_tmp);
+  free(psz_path);
+}
+
+static bool
+key_equal(const cdio_disc_info_t *p_info, const cdio_disc_key_t *p_key)
+{
+  return p_key->i_discid == p_info->p_hdr->i_discid
+    && p_key->i_leadout == p_info->p_hdr->i_leadout
+    && p_key->i_toc_crc == p_info->p_hdr->i_toc_crc;
+}
+
+cdio_disc_info_t *
+cdio_disc_cache_get(cdio_disc_cache_t *p_cache, CdIo_t *p_cdio,
+                    /*out*/ bool *pb_cached)
+{
+  cdio_disc_key_t key;
+  cdio_disc_info_t *p_info;
+
+  if (pb_cached) *pb_cached = true;
+  if (!p_cache || !p_cdio) return NULL;
+
+  /* Same handle, same disc: don't even read the TOC. */
+  if (p_cache->p_info && p_cache->p_cdio == p_cdio
+      && 0 == cdio_get_media_changed(p_cdio))
+    return p_cache->p_info;
+
+  if (!cdio_disc_cache_key(p_cdio, &key)) return NULL;
+
+  if (p_cache->p_info && key_equal(p_cache->p_info, &key)) {
+    p_cache->p_cdio = p_cdio;
+    return p_cache->p_info;
+  }
+
+  info_free(p_cache->p_info);
+  p_cache->p_info = NULL;
+  p_cache->p_cdio = NULL;
+
+  p_info = info_load(p_cache, &key);
+  if (!p_info) {
+    if (pb_cached) *pb_cached = false;
+    p_info = info_read(p_cdio, &key);
+    if (!p_info) return NULL;
+    info_store(p_cache, p_info, &key);
+  }
+
+  p_cache->p_info = p_info;
+  p_cache->p_cdio = p_cdio;
+  return p_info;
+}
+
+bool
+cdio_disc_cache_remove(cdio_disc_cache_t *p_cache,
+                       const cdio_disc_key_t *p_key)
+{
+  char *psz_path;
+  bool b_removed;
+
+  if (!p_cache || !p_key) return false;
+  if (p_cache->p_info && key_equal(p_cache->p_info, p_key)) {
+    info_free(p_cache->p_info);
+    p_cache->p_info = NULL;
+    p_cache->p_cdio = NULL;
+  }
+  if (!(psz_path = key_path(p_cache, p_key))) return false;
+  b_removed = 0 == remove(psz_path);
+  free(psz_path);
+  return b_removed;
+}
+
+void
+cdio_disc_info_get_key(const cdio_disc_info_t *p_info,
+                       /*out*/ cdio_disc_key_t *p_key)
+{
+  if (!p_info || !p_key) return;
+  p_key->i_discid  = p_info->p_hdr->i_discid;
+  p_key->i_leadout = p_info->p_hdr->i_leadout;
+  p_key->i_toc_crc = p_info->p_hdr->i_toc_crc;
+}
+
+track_t
+cdio_disc_info_get_first_track_num(const cdio_disc_info_t *p_info)
+{
+  return p_info ? p_info->p_hdr->i_first_track : CDIO_INVALID_TRACK;
+}
+
+track_t
+cdio_disc_info_get_num_tracks(const cdio_disc_info_t *p_info)
+{
+  return p_info ? p_info->p_hdr->i_tracks : CDIO_INVALID_TRACK;
+}
+
+/* Return the record of track i_track, or NULL if there is none. */
+static const disc_cache_track_t *
+get_track(const cdio_disc_info_t *p_info, track_t i_track)
+{
+  if (!p_info || i_track < p_info->p_hdr->i_first_track
+      || i_track >= p_info->p_hdr->i_first_track + p_info->p_hdr->i_tracks)
+    return NULL;
+  return &p_info->p_tracks[i_track - p_info->p_hdr->i_first_track];
+}
+
+lsn_t
+cdio_disc_info_get_track_lsn(const cdio_disc_info_t *p_info, track_t i_track)
+{
+  const disc_cache_track_t *p_track;
+
+  if (p_info && CDIO_CDROM_LEADOUT_TRACK == i_track)
+    return p_info->p_hdr->i_leadout;
+  p_track = get_track(p_info, i_track);
+  return p_track ? p_track->i_lsn : CDIO_INVALID_LSN;
+}
+
+track_format_t
+cdio_disc_info_get_track_format(const cdio_disc_info_t *p_info,
+                                track_t i_track)
+{
+  const disc_cache_track_t *p_track = get_track(p_info, i_track);
+  return p_track ? (track_format_t) p_track->i_format : TRACK_FORMAT_ERROR;
+}
+
+const char *
+cdio_disc_info_get_mcn(const cdio_disc_info_t *p_info)
+{
+  return p_info && p_info->p_hdr->b_mcn ? p_info->p_hdr->psz_mcn : NULL;
+}
+
+const char *
+cdio_disc_info_get_isrc(const cdio_disc_info_t *p_info, track_t i_track)
+{
+  const disc_cache_track_t *p_track = get_track(p_info, i_track);
+  return p_track && p_track->b_isrc ? p_track->psz_isrc : NULL;
+}
+
+cdio_fs_anal_t
+cdio_disc_info_get_fs(const cdio_disc_info_t *p_info, track_t i_track,
+                      /*out*/ cdio_iso_analysis_t *p_iso_analysis)
+{
+  const disc_cache_track_t *p_track = get_track(p_info, i_track);
+
+  if (p_iso_analysis) {
+    memset(p_iso_analysis, 0, sizeof(cdio_iso_analysis_t));
+    if (p_track) {
+      p_iso_analysis->joliet_level = p_track->i_joliet_level;
+      p_iso_analysis->isofs_size   = p_track->i_isofs_size;
+      p_iso_analysis->UDFVerMajor  = p_track->i_udf_major;
+      p_iso_analysis->UDFVerMinor  = p_track->i_udf_minor;
+      memcpy(p_iso_analysis->iso_label, p_track->psz_iso_label,
+             sizeof(p_iso_analysis->iso_label));
+    }
+  }
+  return p_track ? (cdio_fs_anal_t) p_track->i_fs : CDIO_FS_UNKNOWN;
+}
+
+cdtext_t *
+cdio_disc_info_get_cdtext(cdio_disc_info_t *p_info)
+{
+  uint8_t *p_packs;
+  size_t i_len;
+
+  if (!p_info || !p_info->p_hdr->i_cdtext_len) return NULL;
+  if (p_info->p_cdtext) return p_info->p_cdtext;
+
+  /* The packs may be mapped read-only; parse a copy. */
+  i_len = p_info->p_hdr->i_cdtext_len;
+  if (!(p_packs = malloc(i_len))) return NULL;
+  memcpy(p_packs, p_info->p_tracks + p_info->p_hdr->i_tracks, i_len);
+
+  p_info->p_cdtext = cdtext_init();
+  if (p_info->p_cdtext && 0 != cdtext_data_init(p_info->p_cdtext, p_packs,
+                                                 i_len)) {
+    cdtext_destroy(p_info->p_cdtext);
+    free(p_info->p_cdtext);
+    p_info->p_cdtext = NULL;
+  }
+  free(p_packs);
+  return p_info->p_cdtext;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
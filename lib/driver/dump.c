@@ -0,0 +1,564 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file dump.c
+ *
+ *  \brief Dumping a whole disc to a raw image.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/mmc.h>
+#include <cdio/mmc_ll_cmds.h>
+#include <cdio/subchannel.h>
+#include <cdio/dump.h>
+#include "_cdio_stdio.h"
+
+/* Batches between the reader and the writer: one being read into
+   while the other is written out. */
+#define DUMP_SLOTS 2
+
+typedef struct {
+  CdIo_t              *p_cdio;
+  cdio_dump_options_t  opts;
+  cdio_dump_stats_t    stats;
+  bool                 b_mmc;       /* read with MMC READ CD */
+
+  const char          *psz_bin;
+  FILE                *p_bin;
+  uint8_t             *p_slot[DUMP_SLOTS];
+  uint32_t             i_slot_blocks[DUMP_SLOTS];
+  unsigned long        i_head;      /* batches read */
+  unsigned long        i_tail;      /* batches written */
+  driver_return_code_t i_write_status;
+#ifdef HAVE_PTHREAD_H
+  bool                 b_done;      /* the reader has finished */
+  pthread_mutex_t      lock;
+  pthread_cond_t       filled;      /* a batch was read, or we're done */
+  pthread_cond_t       emptied;     /* a batch was written */
+#endif
+} dump_job_t;
+
+/* Write the batch in slot i_slot out to the image. */
+static driver_return_code_t
+dump_write(dump_job_t *p_job, unsigned long i_slot)
+{
+  const uint32_t i_blocks = p_job->i_slot_blocks[i_slot];
+
+  if (fwrite(p_job->p_slot[i_slot], CDIO_CD_FRAMESIZE_RAW, i_blocks,
+             p_job->p_bin) != i_blocks) {
+    cdio_warn("error writing %s: %s", p_job->psz_bin, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+#ifdef HAVE_PTHREAD_H
+static void *
+dump_writer(void *p_arg)
+{
+  dump_job_t *p_job = p_arg;
+
+  pthread_mutex_lock(&p_job->lock);
+  for (;;) {
+    unsigned long i_slot;
+    driver_return_code_t i_ret;
+
+    while (p_job->i_tail == p_job->i_head && !p_job->b_done)
+      pthread_cond_wait(&p_job->filled, &p_job->lock);
+    if (p_job->i_tail == p_job->i_head) break;
+    i_slot = p_job->i_tail % DUMP_SLOTS;
+    pthread_mutex_unlock(&p_job->lock);
+
+    i_ret = dump_write(p_job, i_slot);
+
+    pthread_mutex_lock(&p_job->lock);
+    p_job->i_tail++;
+    if (DRIVER_OP_SUCCESS != i_ret) p_job->i_write_status = i_ret;
+    pthread_cond_signal(&p_job->emptied);
+    if (DRIVER_OP_SUCCESS != i_ret) break;
+  }
+  pthread_mutex_unlock(&p_job->lock);
+  return NULL;
+}
+#endif /* HAVE_PTHREAD_H */
+
+/* Return a slot to read a batch into, once the writer has one free,
+   or NULL if the writer has failed. */
+static uint8_t *
+dump_slot_get(dump_job_t *p_job)
+{
+  uint8_t *p_slot = NULL;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&p_job->lock);
+  if (p_job->i_head - p_job->i_tail == DUMP_SLOTS
+      && DRIVER_OP_SUCCESS == p_job->i_write_status) {
+    p_job->stats.i_waits++;
+    while (p_job->i_head - p_job->i_tail == DUMP_SLOTS
+           && DRIVER_OP_SUCCESS == p_job->i_write_status)
+      pthread_cond_wait(&p_job->emptied, &p_job->lock);
+  }
+  if (DRIVER_OP_SUCCESS == p_job->i_write_status)
+    p_slot = p_job->p_slot[p_job->i_head % DUMP_SLOTS];
+  pthread_mutex_unlock(&p_job->lock);
+#else
+  if (DRIVER_OP_SUCCESS == p_job->i_write_status)
+    p_slot = p_job->p_slot[0];
+#endif
+  return p_slot;
+}
+
+/* Hand the i_blocks sectors read into the slot from dump_slot_get()
+   over to the writer. */
+static void
+dump_slot_put(dump_job_t *p_job, uint32_t i_blocks)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock(&p_job->lock);
+  p_job->i_slot_blocks[p_job->i_head % DUMP_SLOTS] = i_blocks;
+  p_job->i_head++;
+  pthread_cond_signal(&p_job->filled);
+  pthread_mutex_unlock(&p_job->lock);
+#else
+  p_job->i_slot_blocks[0] = i_blocks;
+  p_job->i_write_status = dump_write(p_job, 0);
+  p_job->i_head++;
+  p_job->i_tail++;
+#endif
+}
+
+/* Read i_blocks raw sectors from i_lsn into p_buf, as i_read_type
+   sectors. */
+static driver_return_code_t
+dump_read(dump_job_t *p_job, uint8_t *p_buf, lsn_t i_lsn, uint32_t i_blocks,
+          int i_read_type)
+{
+  p_job->stats.i_reads++;
+  if (p_job->b_mmc) {
+    /* Audio sectors are all user data; for the others, ask for the
+       sync, the headers and the EDC/ECC too. */
+    const bool b_raw = CDIO_MMC_READ_TYPE_CDDA != i_read_type;
+    const driver_return_code_t i_ret =
+      mmc_read_cd(p_job->p_cdio, p_buf, i_lsn, i_read_type, false, b_raw,
+                  b_raw ? 3 : 0, true, b_raw, 0, 0, CDIO_CD_FRAMESIZE_RAW,
+                  i_blocks);
+    if (DRIVER_OP_UNSUPPORTED != i_ret) return i_ret;
+    p_job->b_mmc = false;
+  }
+  return cdio_read_audio_sectors(p_job->p_cdio, p_buf, i_lsn, i_blocks);
+}
+
+/* Read the i_blocks sectors from i_lsn into p_buf: all at once if
+   that works, or else sector by sector, trying each a few times and
+   the last time as any type of sector. */
+static driver_return_code_t
+dump_read_batch(dump_job_t *p_job, uint8_t *p_buf, lsn_t i_lsn,
+                uint32_t i_blocks, int i_read_type)
+{
+  driver_return_code_t i_ret = dump_read(p_job, p_buf, i_lsn, i_blocks,
+                                         i_read_type);
+  uint32_t i;
+
+  if (DRIVER_OP_SUCCESS == i_ret) return i_ret;
+  for (i = 0; i < i_blocks; i++) {
+    uint8_t *p_sector = p_buf + (size_t) i * CDIO_CD_FRAMESIZE_RAW;
+    unsigned int i_try;
+
+    for (i_try = 0; i_try < p_job->opts.i_tries; i_try++) {
+      /* Only a read error is worth trying again. */
+      if (DRIVER_OP_ERROR != i_ret && DRIVER_OP_MMC_SENSE_DATA != i_ret)
+        return i_ret;
+      p_job->stats.i_rereads++;
+      i_ret = dump_read(p_job, p_sector, i_lsn + (lsn_t) i, 1,
+                        (i_try + 1 < p_job->opts.i_tries)
+                        ? i_read_type : CDIO_MMC_READ_TYPE_ANY);
+      if (DRIVER_OP_SUCCESS == i_ret) break;
+    }
+    if (DRIVER_OP_SUCCESS != i_ret) {
+      cdio_warn("can't read sector %ld", (long int) (i_lsn + i));
+      if (!p_job->opts.b_skip_bad) return i_ret;
+      memset(p_sector, 0, CDIO_CD_FRAMESIZE_RAW);
+      p_job->stats.i_bad_sectors++;
+    }
+    /* The next sector starts out as if its batch read had failed. */
+    i_ret = DRIVER_OP_ERROR;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Read the sectors from i_lsn up to i_end, as i_read_type sectors,
+   handing them to the writer a batch at a time. */
+static driver_return_code_t
+dump_range(dump_job_t *p_job, lsn_t i_lsn, lsn_t i_end, int i_read_type)
+{
+  while (i_lsn < i_end) {
+    const uint32_t i_left = (uint32_t) (i_end - i_lsn);
+    const uint32_t i_blocks = (i_left < p_job->opts.i_batch)
+      ? i_left : p_job->opts.i_batch;
+    uint8_t *p_slot = dump_slot_get(p_job);
+    driver_return_code_t i_ret;
+
+    if (!p_slot) return p_job->i_write_status;
+    i_ret = dump_read_batch(p_job, p_slot, i_lsn, i_blocks, i_read_type);
+    if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+    dump_slot_put(p_job, i_blocks);
+    p_job->stats.i_sectors += i_blocks;
+    i_lsn += (lsn_t) i_blocks;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* The READ CD sector type to read track i_track of p_cdio as. */
+static int
+dump_read_type(CdIo_t *p_cdio, track_t i_track)
+{
+  switch (cdio_get_track_format(p_cdio, i_track)) {
+  case TRACK_FORMAT_AUDIO:
+    return CDIO_MMC_READ_TYPE_CDDA;
+  case TRACK_FORMAT_DATA:
+    return CDIO_MMC_READ_TYPE_MODE1;
+  default:
+    /* Mode 2 sectors of a track can be of either form. */
+    return CDIO_MMC_READ_TYPE_ANY;
+  }
+}
+
+/* Where track i_track of p_scan starts, with its pregap. */
+static lsn_t
+dump_track_begin(const cdio_subq_scan_t *p_scan, track_t i_track)
+{
+  const cdio_subq_track_t *p_track = &p_scan->track[i_track];
+  return (CDIO_INVALID_LSN != p_track->i_index[0])
+    ? p_track->i_index[0] : p_track->i_index[1];
+}
+
+/* Fill in p_scan from the TOC alone, for a drive whose Q can't be
+   read. */
+static void
+dump_scan_from_toc(CdIo_t *p_cdio, track_t i_first, track_t i_tracks,
+                   /*out*/ cdio_subq_scan_t *p_scan)
+{
+  char *psz_mcn = cdio_get_mcn(p_cdio);
+  unsigned int i, j;
+
+  memset(p_scan, 0, sizeof(cdio_subq_scan_t));
+  for (i = 0; i <= CDIO_CD_MAX_TRACKS; i++)
+    for (j = 0; j <= CDIO_SUBQ_MAX_INDEX; j++)
+      p_scan->track[i].i_index[j] = CDIO_INVALID_LSN;
+  p_scan->i_first_track = i_first;
+  p_scan->i_last_track  = i_first + i_tracks - 1;
+  if (psz_mcn) {
+    strncpy(p_scan->psz_mcn, psz_mcn, CDIO_MCN_SIZE);
+    free(psz_mcn);
+  }
+  for (i = i_first; i < (unsigned int) (i_first + i_tracks); i++) {
+    p_scan->track[i].i_index[1]   = cdio_get_track_lsn(p_cdio, i);
+    p_scan->track[i].i_last_index = 1;
+  }
+}
+
+/* Write "MM:SS:FF" for i_frames. */
+static void
+dump_print_msf(FILE *p_file, lsn_t i_frames)
+{
+  const long int i_secs = (long int) i_frames / CDIO_CD_FRAMES_PER_SEC;
+
+  fprintf(p_file, "%02ld:%02ld:%02ld", i_secs / CDIO_CD_SECS_PER_MIN,
+          i_secs % CDIO_CD_SECS_PER_MIN,
+          (long int) i_frames % CDIO_CD_FRAMES_PER_SEC);
+}
+
+/* Write the CUE sheet for the image psz_base of p_cdio to p_sheet. */
+static void
+dump_write_cue(FILE *p_sheet, CdIo_t *p_cdio, const char *psz_base,
+               const cdio_subq_scan_t *p_scan, track_t i_first,
+               track_t i_tracks)
+{
+  track_t i;
+
+  if (p_scan->psz_mcn[0]) fprintf(p_sheet, "CATALOG %s\n", p_scan->psz_mcn);
+  fprintf(p_sheet, "FILE \"%s\" BINARY\n", psz_base);
+
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    const cdio_subq_track_t *p_track = &p_scan->track[i];
+    const track_format_t format = cdio_get_track_format(p_cdio, i);
+    const bool b_dcp = CDIO_TRACK_FLAG_TRUE
+      == cdio_get_track_copy_permit(p_cdio, i);
+    const bool b_pre = TRACK_FORMAT_AUDIO == format
+      && CDIO_TRACK_FLAG_TRUE == cdio_get_track_preemphasis(p_cdio, i);
+    const bool b_4ch = TRACK_FORMAT_AUDIO == format
+      && 4 == cdio_get_track_channels(p_cdio, i);
+    unsigned int j;
+
+    fprintf(p_sheet, "  TRACK %02u %s\n", (unsigned int) i,
+            TRACK_FORMAT_AUDIO == format ? "AUDIO"
+            : TRACK_FORMAT_DATA == format ? "MODE1/2352" : "MODE2/2352");
+    if (b_dcp || b_pre || b_4ch)
+      fprintf(p_sheet, "    FLAGS%s%s%s\n", b_dcp ? " DCP" : "",
+              b_pre ? " PRE" : "", b_4ch ? " 4CH" : "");
+    if (TRACK_FORMAT_AUDIO == format && p_track->psz_isrc[0])
+      fprintf(p_sheet, "    ISRC %s\n", p_track->psz_isrc);
+    for (j = 0; j <= p_track->i_last_index; j++) {
+      if (CDIO_INVALID_LSN == p_track->i_index[j]) continue;
+      fprintf(p_sheet, "    INDEX %02u ", j);
+      dump_print_msf(p_sheet, p_track->i_index[j]);
+      fprintf(p_sheet, "\n");
+    }
+  }
+}
+
+/* Write the cdrdao TOC file for the image psz_base of p_cdio, whose
+   leadout is i_leadout, to p_sheet. */
+static void
+dump_write_toc(FILE *p_sheet, CdIo_t *p_cdio, const char *psz_base,
+               const cdio_subq_scan_t *p_scan, track_t i_first,
+               track_t i_tracks, lsn_t i_leadout)
+{
+  const char *psz_mode = "CD_DA";
+  track_t i;
+
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    const track_format_t format = cdio_get_track_format(p_cdio, i);
+    if (TRACK_FORMAT_DATA == format && 0 == strcmp("CD_DA", psz_mode))
+      psz_mode = "CD_ROM";
+    else if (TRACK_FORMAT_AUDIO != format && TRACK_FORMAT_DATA != format)
+      psz_mode = "CD_ROM_XA";
+  }
+  fprintf(p_sheet, "%s\n", psz_mode);
+  if (p_scan->psz_mcn[0])
+    fprintf(p_sheet, "CATALOG \"%s\"\n", p_scan->psz_mcn);
+
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    const cdio_subq_track_t *p_track = &p_scan->track[i];
+    const track_format_t format = cdio_get_track_format(p_cdio, i);
+    const lsn_t i_begin = (i == i_first) ? 0 : dump_track_begin(p_scan, i);
+    const lsn_t i_end = (i + 1 < i_first + i_tracks)
+      ? dump_track_begin(p_scan, i + 1) : i_leadout;
+    unsigned int j;
+
+    fprintf(p_sheet, "\n// Track %u\n", (unsigned int) i);
+    fprintf(p_sheet, "TRACK %s\n",
+            TRACK_FORMAT_AUDIO == format ? "AUDIO"
+            : TRACK_FORMAT_DATA == format ? "MODE1_RAW" : "MODE2_RAW");
+    fprintf(p_sheet, "%sCOPY\n", CDIO_TRACK_FLAG_TRUE
+            == cdio_get_track_copy_permit(p_cdio, i) ? "" : "NO ");
+    if (TRACK_FORMAT_AUDIO == format) {
+      fprintf(p_sheet, "%sPRE_EMPHASIS\n", CDIO_TRACK_FLAG_TRUE
+              == cdio_get_track_preemphasis(p_cdio, i) ? "" : "NO ");
+      fprintf(p_sheet, "%s_CHANNEL_AUDIO\n",
+              4 == cdio_get_track_channels(p_cdio, i) ? "FOUR" : "TWO");
+      if (p_track->psz_isrc[0])
+        fprintf(p_sheet, "ISRC \"%s\"\n", p_track->psz_isrc);
+    }
+    fprintf(p_sheet, "FILE \"%s\" ", psz_base);
+    dump_print_msf(p_sheet, i_begin);
+    fprintf(p_sheet, " ");
+    dump_print_msf(p_sheet, i_end - i_begin);
+    fprintf(p_sheet, "\n");
+    if (p_track->i_index[1] > i_begin) {
+      fprintf(p_sheet, "START ");
+      dump_print_msf(p_sheet, p_track->i_index[1] - i_begin);
+      fprintf(p_sheet, "\n");
+    }
+    /* Indices are counted from index 1. */
+    for (j = 2; j <= p_track->i_last_index; j++) {
+      if (CDIO_INVALID_LSN == p_track->i_index[j]) continue;
+      fprintf(p_sheet, "INDEX ");
+      dump_print_msf(p_sheet, p_track->i_index[j] - p_track->i_index[1]);
+      fprintf(p_sheet, "\n");
+    }
+  }
+}
+
+/* Write the sheet psz_sheet for the image psz_bin of p_cdio. */
+static driver_return_code_t
+dump_write_sheet(const char *psz_sheet, const char *psz_bin,
+                 cdio_dump_format_t e_format, CdIo_t *p_cdio,
+                 const cdio_subq_scan_t *p_scan, track_t i_first,
+                 track_t i_tracks, lsn_t i_leadout)
+{
+  const char *psz_base = strrchr(psz_bin, '/');
+  FILE *p_sheet = CDIO_FOPEN(psz_sheet, "w");
+
+#ifdef _WIN32
+  if (!psz_base) psz_base = strrchr(psz_bin, '\\');
+#endif
+  psz_base = psz_base ? psz_base + 1 : psz_bin;
+
+  if (!p_sheet) {
+    cdio_warn("can't create %s: %s", psz_sheet, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  if (CDIO_DUMP_TOC == e_format)
+    dump_write_toc(p_sheet, p_cdio, psz_base, p_scan, i_first, i_tracks,
+                   i_leadout);
+  else
+    dump_write_cue(p_sheet, p_cdio, psz_base, p_scan, i_first, i_tracks);
+  if (0 != fclose(p_sheet)) {
+    cdio_warn("error writing %s: %s", psz_sheet, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Dump the disc in p_cdio to the raw image psz_bin, and write a sheet
+  for it to psz_sheet.
+*/
+driver_return_code_t
+cdio_dump_disc(CdIo_t *p_cdio, const char *psz_bin, const char *psz_sheet,
+               const cdio_dump_options_t *p_options,
+               /*out*/ cdio_dump_stats_t *p_stats)
+{
+  dump_job_t job;
+  cdio_subq_scan_t *p_scan;
+  driver_return_code_t i_ret = DRIVER_OP_SUCCESS;
+  track_t i_first, i_tracks, i;
+  lsn_t i_leadout;
+  unsigned int j;
+
+  if (p_stats) memset(p_stats, 0, sizeof(cdio_dump_stats_t));
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!psz_bin || !psz_sheet) return DRIVER_OP_BAD_POINTER;
+
+  memset(&job, 0, sizeof(job));
+  if (p_options) job.opts = *p_options;
+  if (CDIO_DUMP_TOC != job.opts.e_format && CDIO_DUMP_CUE != job.opts.e_format)
+    return DRIVER_OP_BAD_PARAMETER;
+  if (0 == job.opts.i_batch) job.opts.i_batch = CDIO_DUMP_BATCH;
+  if (0 == job.opts.i_tries) job.opts.i_tries = CDIO_DUMP_TRIES;
+  /* A slot holds a whole batch. */
+  if (job.opts.i_batch > (size_t) -1 / CDIO_CD_FRAMESIZE_RAW)
+    return DRIVER_OP_BAD_PARAMETER;
+  job.p_cdio  = p_cdio;
+  job.psz_bin = psz_bin;
+  job.b_mmc   = true;
+  job.i_write_status = DRIVER_OP_SUCCESS;
+
+  i_first   = cdio_get_first_track_num(p_cdio);
+  i_tracks  = cdio_get_num_tracks(p_cdio);
+  i_leadout = cdio_get_disc_last_lsn(p_cdio);
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || 0 == i_tracks || i_first + i_tracks - 1 > CDIO_CD_MAX_TRACKS
+      || CDIO_INVALID_LSN == i_leadout) {
+    cdio_warn("can't read the table of contents");
+    return DRIVER_OP_ERROR;
+  }
+
+  p_scan = malloc(sizeof(cdio_subq_scan_t));
+  if (!p_scan) return DRIVER_OP_ERROR;
+  if (DRIVER_OP_SUCCESS != cdio_subq_find_indices(p_cdio, p_scan)) {
+    cdio_warn("can't read the Q sub-channel; "
+              "pregaps and indices are left out");
+    dump_scan_from_toc(p_cdio, i_first, i_tracks, p_scan);
+  }
+
+  for (j = 0; j < DUMP_SLOTS; j++) {
+    job.p_slot[j] = malloc((size_t) job.opts.i_batch * CDIO_CD_FRAMESIZE_RAW);
+    if (!job.p_slot[j]) i_ret = DRIVER_OP_ERROR;
+  }
+  job.p_bin = CDIO_FOPEN(psz_bin, "wb");
+  if (!job.p_bin) {
+    cdio_warn("can't create %s: %s", psz_bin, strerror(errno));
+    i_ret = DRIVER_OP_ERROR;
+  }
+  if (DRIVER_OP_SUCCESS != i_ret) goto done;
+
+#ifdef HAVE_PTHREAD_H
+  {
+    pthread_t writer;
+    bool b_writer;
+
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.filled, NULL);
+    pthread_cond_init(&job.emptied, NULL);
+    b_writer = (0 == pthread_create(&writer, NULL, dump_writer, &job));
+    if (!b_writer) {
+      cdio_warn("can't start the image writer thread");
+      i_ret = DRIVER_OP_ERROR;
+    }
+#endif
+
+    /* The image starts at sector 0, whatever comes before track 1. */
+    for (i = i_first; i < i_first + i_tracks && DRIVER_OP_SUCCESS == i_ret;
+         i++) {
+      const lsn_t i_begin = (i == i_first) ? 0 : dump_track_begin(p_scan, i);
+      const lsn_t i_end = (i + 1 < i_first + i_tracks)
+        ? dump_track_begin(p_scan, i + 1) : i_leadout;
+      i_ret = dump_range(&job, i_begin, i_end, dump_read_type(p_cdio, i));
+    }
+
+#ifdef HAVE_PTHREAD_H
+    if (b_writer) {
+      pthread_mutex_lock(&job.lock);
+      job.b_done = true;
+      pthread_cond_signal(&job.filled);
+      pthread_mutex_unlock(&job.lock);
+      pthread_join(writer, NULL);
+    }
+    pthread_cond_destroy(&job.emptied);
+    pthread_cond_destroy(&job.filled);
+    pthread_mutex_destroy(&job.lock);
+  }
+#endif
+  if (DRIVER_OP_SUCCESS == i_ret) i_ret = job.i_write_status;
+
+ done:
+  if (job.p_bin && 0 != fclose(job.p_bin) && DRIVER_OP_SUCCESS == i_ret) {
+    cdio_warn("error writing %s: %s", psz_bin, strerror(errno));
+    i_ret = DRIVER_OP_ERROR;
+  }
+  if (DRIVER_OP_SUCCESS == i_ret)
+    i_ret = dump_write_sheet(psz_sheet, psz_bin, job.opts.e_format, p_cdio,
+                             p_scan, i_first, i_tracks, i_leadout);
+  for (j = 0; j < DUMP_SLOTS; j++) free(job.p_slot[j]);
+  free(p_scan);
+  if (p_stats) *p_stats = job.stats;
+  return i_ret;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,485 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file ecc.c
+ *
+ *  \brief EDC and ECC of raw data sectors (ECMA-130 Annex A and B).
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/ecc.h>
+
+/* Where things are in a raw sector. */
+#define ECC_MODE_BYTE      15
+#define ECC_SUBMODE_BYTE   18
+#define ECC_SUBMODE_FORM2  0x20
+#define ECC_M1_EDC_OFFSET  2064  /* after sync, header and data */
+#define ECC_F1_EDC_OFFSET  2072  /* after sync, header, subheader, data */
+#define ECC_F2_EDC_OFFSET  2348
+#define ECC_P_OFFSET       2076
+#define ECC_Q_OFFSET       2248
+
+/* The P and Q codewords. Their data are the 2236 bytes from the
+   header up to the P parity (the Q parity also covers the P parity),
+   as 16-bit words split into a "most" and a "least significant" byte
+   plane. P has 86 codewords of 24 bytes and 2 parity bytes, running
+   down the columns of a 43 x 24 word matrix; Q has 52 of 43 bytes and
+   2 parity bytes, running along its diagonals. */
+#define ECC_DATA_SIZE      2236
+#define ECC_P_WORDS        86
+#define ECC_P_LEN          24
+#define ECC_Q_WORDS        52
+#define ECC_Q_LEN          43
+
+/* Rounds of P and Q correction; each can fix what the other couldn't. */
+#define ECC_MAX_ROUNDS     4
+
+static const uint8_t sync_pattern[CDIO_CD_SYNC_SIZE] = {
+  0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00
+};
+
+static uint32_t edc_table[8][256];
+static uint8_t  gf_log[256];     /* log base alpha; gf_log[0] unused */
+static uint8_t  gf_exp[255];
+static uint8_t  gf_mul2[256];    /* multiply by alpha */
+
+/* The tables: the EDC's sliced eight ways, and those of GF(2^8) with
+   the field polynomial x^8 + x^4 + x^3 + x^2 + 1, where alpha is 2. */
+static void
+ecc_init_tables(void)
+{
+  unsigned int i, j;
+  uint8_t x = 1;
+
+  for (i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (j = 0; j < 8; j++)
+      c = (c & 1) ? (c >> 1) ^ 0xd8018001 : c >> 1;
+    edc_table[0][i] = c;
+  }
+  for (i = 0; i < 256; i++)
+    for (j = 1; j < 8; j++)
+      edc_table[j][i] = (edc_table[j-1][i] >> 8)
+        ^ edc_table[0][edc_table[j-1][i] & 0xff];
+
+  for (i = 0; i < 255; i++) {
+    gf_exp[i] = x;
+    gf_log[x] = (uint8_t) i;
+    x = (uint8_t) ((x << 1) ^ ((x & 0x80) ? 0x1d : 0));
+  }
+  for (i = 0; i < 256; i++)
+    gf_mul2[i] = (uint8_t) ((i << 1) ^ ((i & 0x80) ? 0x1d : 0));
+}
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t ecc_once = PTHREAD_ONCE_INIT;
+# define ECC_INIT() pthread_once(&ecc_once, ecc_init_tables)
+#else
+static bool b_ecc_ready = false;
+# define ECC_INIT() \
+  do { if (!b_ecc_ready) { ecc_init_tables(); b_ecc_ready = true; } } \
+  while (0)
+#endif
+
+static uint32_t
+get_le32(const uint8_t *p)
+{
+  return p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16
+    | (uint32_t) p[3] << 24;
+}
+
+static uint32_t
+edc_compute(const uint8_t *p, size_t i_len)
+{
+  uint32_t c = 0;
+
+  while (i_len >= 8) {
+    const uint32_t lo = c ^ get_le32(p);
+    const uint32_t hi = get_le32(p + 4);
+    c = edc_table[7][lo & 0xff] ^ edc_table[6][(lo >> 8) & 0xff]
+      ^ edc_table[5][(lo >> 16) & 0xff] ^ edc_table[4][lo >> 24]
+      ^ edc_table[3][hi & 0xff] ^ edc_table[2][(hi >> 8) & 0xff]
+      ^ edc_table[1][(hi >> 16) & 0xff] ^ edc_table[0][hi >> 24];
+    p += 8;
+    i_len -= 8;
+  }
+  while (i_len--)
+    c = edc_table[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+  return c;
+}
+
+uint32_t
+cdio_edc(const void *p_buf, size_t i_len)
+{
+  ECC_INIT();
+  return edc_compute(p_buf, i_len);
+}
+
+/* The kinds of raw sector, as far as checking them goes. */
+typedef enum {
+  ECC_SECTOR_NONE,     /* no sync, Mode 0, formless Mode 2 ... */
+  ECC_SECTOR_MODE1,
+  ECC_SECTOR_FORM1,
+  ECC_SECTOR_FORM2
+} ecc_sector_kind_t;
+
+static ecc_sector_kind_t
+ecc_sector_kind(const uint8_t *p_sector)
+{
+  if (0 != memcmp(p_sector, sync_pattern, sizeof(sync_pattern)))
+    return ECC_SECTOR_NONE;
+  switch (p_sector[ECC_MODE_BYTE]) {
+  case 1:
+    return ECC_SECTOR_MODE1;
+  case 2:
+    /* XA sectors repeat their subheader; Mode 2 sectors without one
+       have nothing we can check. */
+    if (0 != memcmp(p_sector + 16, p_sector + 20, 4))
+      return ECC_SECTOR_NONE;
+    return (p_sector[ECC_SUBMODE_BYTE] & ECC_SUBMODE_FORM2)
+      ? ECC_SECTOR_FORM2 : ECC_SECTOR_FORM1;
+  default:
+    return ECC_SECTOR_NONE;
+  }
+}
+
+static cdio_sector_status_t
+edc_check(const uint8_t *p_sector, ecc_sector_kind_t e_kind)
+{
+  uint32_t i_stored;
+
+  switch (e_kind) {
+  case ECC_SECTOR_MODE1:
+    i_stored = get_le32(p_sector + ECC_M1_EDC_OFFSET);
+    return edc_compute(p_sector, ECC_M1_EDC_OFFSET) == i_stored
+      ? CDIO_SECTOR_OK : CDIO_SECTOR_BAD;
+  case ECC_SECTOR_FORM1:
+    i_stored = get_le32(p_sector + ECC_F1_EDC_OFFSET);
+    return edc_compute(p_sector + 16, ECC_F1_EDC_OFFSET - 16) == i_stored
+      ? CDIO_SECTOR_OK : CDIO_SECTOR_BAD;
+  case ECC_SECTOR_FORM2:
+    i_stored = get_le32(p_sector + ECC_F2_EDC_OFFSET);
+    if (0 == i_stored) return CDIO_SECTOR_UNCHECKED;
+    return edc_compute(p_sector + 16, ECC_F2_EDC_OFFSET - 16) == i_stored
+      ? CDIO_SECTOR_OK : CDIO_SECTOR_BAD;
+  default:
+    return CDIO_SECTOR_UNCHECKED;
+  }
+}
+
+cdio_sector_status_t
+cdio_sector_verify(const uint8_t *p_sector)
+{
+  ECC_INIT();
+  return edc_check(p_sector, ecc_sector_kind(p_sector));
+}
+
+unsigned int
+cdio_sectors_verify(const uint8_t *p_sectors, unsigned int i_sectors,
+                    /*out*/ cdio_sector_status_t *p_status)
+{
+  unsigned int i, i_bad = 0;
+
+  ECC_INIT();
+  for (i = 0; i < i_sectors; i++) {
+    const uint8_t *p_sector = p_sectors + (size_t) i * CDIO_CD_FRAMESIZE_RAW;
+    const cdio_sector_status_t e_status =
+      edc_check(p_sector, ecc_sector_kind(p_sector));
+    if (CDIO_SECTOR_BAD == e_status) i_bad++;
+    if (p_status) p_status[i] = e_status;
+  }
+  return i_bad;
+}
+
+/*
+ * Correction. A codeword v[0..n-1] of P or Q satisfies
+ *   v[0] + ... + v[n-1] = 0  and  a^(n-1) v[0] + ... + a^0 v[n-1] = 0,
+ * so a single damaged byte v[k] = v'[k] + e leaves the syndromes
+ *   S0 = e  and  S1 = a^(n-1-k) e,
+ * which give both where the damage is and how to undo it.
+ */
+
+/* Correct at most one byte of the codeword whose i_len data bytes are
+   p_data[i_first], stepping by i_step modulo ECC_DATA_SIZE, and whose
+   parity is p_parity[0] and p_parity[i_words]. Return -1 if it can't
+   be corrected, 1 if it was, and 0 if it was fine. */
+static int
+ecc_correct_codeword(uint8_t *p_data, unsigned int i_first,
+                     unsigned int i_len, unsigned int i_step,
+                     uint8_t *p_parity, unsigned int i_words)
+{
+  const unsigned int n = i_len + 2;
+  unsigned int i_index = i_first;
+  unsigned int k;
+  uint8_t s0 = 0, s1 = 0;
+  int i_pos;
+
+  for (k = 0; k < i_len; k++) {
+    s0 ^= p_data[i_index];
+    s1 = gf_mul2[s1] ^ p_data[i_index];
+    i_index += i_step;
+    if (i_index >= ECC_DATA_SIZE) i_index -= ECC_DATA_SIZE;
+  }
+  s0 ^= p_parity[0];
+  s1 = gf_mul2[s1] ^ p_parity[0];
+  s0 ^= p_parity[i_words];
+  s1 = gf_mul2[s1] ^ p_parity[i_words];
+
+  if (0 == s0 && 0 == s1) return 0;
+  if (0 == s0 || 0 == s1) return -1;
+
+  i_pos = (int) n - 1 - (((int) gf_log[s1] - (int) gf_log[s0] + 255) % 255);
+  if (i_pos < 0) return -1;
+
+  if ((unsigned int) i_pos < i_len)
+    p_data[(i_first + (unsigned int) i_pos * i_step) % ECC_DATA_SIZE] ^= s0;
+  else if ((unsigned int) i_pos == i_len)
+    p_parity[0] ^= s0;
+  else
+    p_parity[i_words] ^= s0;
+  return 1;
+}
+
+/* Correct p_sector, whose header is as the ECC saw it, with rounds of
+   P and Q. Return false if some codeword is still damaged. */
+static bool
+ecc_correct(uint8_t *p_sector)
+{
+  uint8_t *p_data = p_sector + CDIO_CD_SYNC_SIZE;
+  unsigned int i_round, i;
+
+  for (i_round = 0; i_round < ECC_MAX_ROUNDS; i_round++) {
+    bool b_damaged = false, b_changed = false;
+
+    for (i = 0; i < ECC_P_WORDS; i++) {
+      const int r = ecc_correct_codeword(p_data, i, ECC_P_LEN, ECC_P_WORDS,
+                                         p_sector + ECC_P_OFFSET + i,
+                                         ECC_P_WORDS);
+      if (r < 0) b_damaged = true;
+      if (r > 0) b_changed = true;
+    }
+    for (i = 0; i < ECC_Q_WORDS; i++) {
+      const int r = ecc_correct_codeword(p_data,
+                                         (i >> 1) * ECC_P_WORDS + (i & 1),
+                                         ECC_Q_LEN, ECC_P_WORDS + 2,
+                                         p_sector + ECC_Q_OFFSET + i,
+                                         ECC_Q_WORDS);
+      if (r < 0) b_damaged = true;
+      if (r > 0) b_changed = true;
+    }
+    if (!b_damaged && !b_changed) return true;
+    if (!b_changed) return false;
+  }
+  return false;
+}
+
+cdio_sector_status_t
+cdio_sector_repair(uint8_t *p_sector)
+{
+  const ecc_sector_kind_t e_kind = ecc_sector_kind(p_sector);
+  uint8_t work[CDIO_CD_FRAMESIZE_RAW];
+  cdio_sector_status_t e_status;
+
+  ECC_INIT();
+  e_status = edc_check(p_sector, e_kind);
+  if (CDIO_SECTOR_BAD != e_status) return e_status;
+  if (ECC_SECTOR_FORM2 == e_kind) return CDIO_SECTOR_BAD;
+
+  /* Form 1 parity is computed as if the header were zero, so that
+     it stays the same when the sector moves. */
+  memcpy(work, p_sector, sizeof(work));
+  if (ECC_SECTOR_FORM1 == e_kind)
+    memset(work + CDIO_CD_SYNC_SIZE, 0, CDIO_CD_HEADER_SIZE);
+
+  if (!ecc_correct(work)) return CDIO_SECTOR_BAD;
+
+  if (ECC_SECTOR_FORM1 == e_kind)
+    memcpy(work + CDIO_CD_SYNC_SIZE, p_sector + CDIO_CD_SYNC_SIZE,
+           CDIO_CD_HEADER_SIZE);
+  /* A burst too big for the parity can still look corrected. */
+  if (CDIO_SECTOR_OK != edc_check(work, ecc_sector_kind(work)))
+    return CDIO_SECTOR_BAD;
+
+  memcpy(p_sector, work, sizeof(work));
+  return CDIO_SECTOR_CORRECTED;
+}
+
+/*
+ * Encoding. The two parity bytes of a codeword are what make both
+ * syndromes of it 0: with D0 and D1 the syndromes of the data alone,
+ *   p0 = (D0 + D1) / (1 + a)  and  p1 = D0 + p0.
+ */
+
+/* Fill in the parity of the codeword laid out as for
+   ecc_correct_codeword(). */
+static void
+ecc_parity_codeword(const uint8_t *p_data, unsigned int i_first,
+                    unsigned int i_len, unsigned int i_step,
+                    uint8_t *p_parity, unsigned int i_words)
+{
+  unsigned int i_index = i_first;
+  unsigned int k;
+  uint8_t d0 = 0, d1 = 0, p0 = 0;
+
+  for (k = 0; k < i_len; k++) {
+    d0 ^= p_data[i_index];
+    d1 = gf_mul2[d1] ^ p_data[i_index];
+    i_index += i_step;
+    if (i_index >= ECC_DATA_SIZE) i_index -= ECC_DATA_SIZE;
+  }
+  d1 = gf_mul2[gf_mul2[d1]];
+
+  /* log(1 + a) = log 3 = 25 */
+  if (d0 ^ d1)
+    p0 = gf_exp[((int) gf_log[d0 ^ d1] - (int) gf_log[3] + 255) % 255];
+  p_parity[0]       = p0;
+  p_parity[i_words] = d0 ^ p0;
+}
+
+/* Fill in the P and Q parity of p_sector. */
+static void
+ecc_generate(uint8_t *p_sector)
+{
+  const uint8_t *p_data = p_sector + CDIO_CD_SYNC_SIZE;
+  unsigned int i;
+
+  for (i = 0; i < ECC_P_WORDS; i++)
+    ecc_parity_codeword(p_data, i, ECC_P_LEN, ECC_P_WORDS,
+                        p_sector + ECC_P_OFFSET + i, ECC_P_WORDS);
+  for (i = 0; i < ECC_Q_WORDS; i++)
+    ecc_parity_codeword(p_data, (i >> 1) * ECC_P_WORDS + (i & 1),
+                        ECC_Q_LEN, ECC_P_WORDS + 2,
+                        p_sector + ECC_Q_OFFSET + i, ECC_Q_WORDS);
+}
+
+static void
+put_le32(uint8_t *p, uint32_t i)
+{
+  p[0] = (uint8_t) i;
+  p[1] = (uint8_t) (i >> 8);
+  p[2] = (uint8_t) (i >> 16);
+  p[3] = (uint8_t) (i >> 24);
+}
+
+driver_return_code_t
+cdio_sector_encode(/*out*/ uint8_t *p_sector, lsn_t i_lsn,
+                   cdio_raw_mode_t e_mode, const uint8_t *p_subheader,
+                   const void *p_data)
+{
+  uint8_t header[CDIO_CD_HEADER_SIZE];
+  msf_t msf;
+
+  if (i_lsn < -CDIO_PREGAP_SECTORS || i_lsn > CDIO_CD_MAX_LSN)
+    return DRIVER_OP_BAD_PARAMETER;
+
+  ECC_INIT();
+  cdio_lsn_to_msf(i_lsn, &msf);
+  header[0] = msf.m;
+  header[1] = msf.s;
+  header[2] = msf.f;
+
+  memcpy(p_sector, sync_pattern, sizeof(sync_pattern));
+
+  switch (e_mode) {
+  case CDIO_RAW_MODE1:
+    header[3] = 1;
+    memcpy(p_sector + CDIO_CD_SYNC_SIZE, header, sizeof(header));
+    memcpy(p_sector + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE, p_data,
+           CDIO_CD_FRAMESIZE);
+    put_le32(p_sector + ECC_M1_EDC_OFFSET,
+             edc_compute(p_sector, ECC_M1_EDC_OFFSET));
+    memset(p_sector + ECC_M1_EDC_OFFSET + CDIO_CD_EDC_SIZE, 0,
+           CDIO_CD_M1F1_ZERO_SIZE);
+    ecc_generate(p_sector);
+    return DRIVER_OP_SUCCESS;
+
+  case CDIO_RAW_MODE2_FORM1:
+  case CDIO_RAW_MODE2_FORM2:
+    {
+      uint8_t *p_sub = p_sector + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE;
+      const bool b_form2 = (CDIO_RAW_MODE2_FORM2 == e_mode);
+
+      header[3] = 2;
+      if (p_subheader)
+        memcpy(p_sub, p_subheader, 4);
+      else {
+        p_sub[0] = p_sub[1] = p_sub[3] = 0;
+        p_sub[2] = b_form2 ? 0 : 0x08; /* "data" */
+      }
+      if (b_form2)
+        p_sub[2] |= ECC_SUBMODE_FORM2;
+      else
+        p_sub[2] &= ~ECC_SUBMODE_FORM2;
+      memcpy(p_sub + 4, p_sub, 4);
+
+      if (b_form2) {
+        memcpy(p_sector + CDIO_CD_XA_SYNC_HEADER, p_data,
+               CDIO_CD_M2F2_DATA_SIZE);
+        memcpy(p_sector + CDIO_CD_SYNC_SIZE, header, sizeof(header));
+        put_le32(p_sector + ECC_F2_EDC_OFFSET,
+                 edc_compute(p_sector + 16, ECC_F2_EDC_OFFSET - 16));
+        return DRIVER_OP_SUCCESS;
+      }
+
+      memcpy(p_sector + CDIO_CD_XA_SYNC_HEADER, p_data, CDIO_CD_FRAMESIZE);
+      put_le32(p_sector + ECC_F1_EDC_OFFSET,
+               edc_compute(p_sector + 16, ECC_F1_EDC_OFFSET - 16));
+      /* The parity treats the header as zero. */
+      memset(p_sector + CDIO_CD_SYNC_SIZE, 0, CDIO_CD_HEADER_SIZE);
+      ecc_generate(p_sector);
+      memcpy(p_sector + CDIO_CD_SYNC_SIZE, header, sizeof(header));
+      return DRIVER_OP_SUCCESS;
+    }
+
+  default:
+    return DRIVER_OP_BAD_PARAMETER;
+  }
+}
+
+const char *
+cdio_sector_status2str(cdio_sector_status_t e_status)
+{
+  switch (e_status) {
+  case CDIO_SECTOR_OK:        return "ok";
+  case CDIO_SECTOR_UNCHECKED: return "unchecked";
+  case CDIO_SECTOR_CORRECTED: return "corrected";
+  case CDIO_SECTOR_BAD:       return "bad";
+  default:                    return "unknown";
+  }
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,523 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file farm.c
+ *
+ *  \brief Running jobs on many drives at once.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/cd_types.h>
+#include <cdio/mmc_cmds.h>
+#include <cdio/farm.h>
+#include "stats_private.h"
+
+#ifdef HAVE_PTHREAD_H
+
+/* A queued job. */
+typedef struct farm_job_s {
+  cdio_farm_job_t     job;
+  void               *p_user_data;
+  char               *psz_drive;   /* NULL: any drive */
+  struct farm_job_s  *p_next;
+} farm_job_t;
+
+/* A drive and its thread. Everything but p_cdio, which only the
+   drive's thread touches, is guarded by the farm's lock. */
+typedef struct {
+  cdio_farm_t  *p_farm;
+  char         *psz_drive;
+  CdIo_t       *p_cdio;
+  pthread_t     thread;
+  bool          b_started;
+  bool          b_loaded;      /* a disc is in */
+  bool          b_fresh;       /* ...and no job has run on it */
+  bool          b_busy;        /* running a job */
+  uint64_t      i_busy_since;  /* cdio_stats_now() when the job began */
+  uint64_t      i_busy_nsec;
+  uint64_t      i_jobs_done;
+  uint64_t      i_jobs_failed;
+  uint64_t      i_bytes;
+} farm_drive_t;
+
+struct cdio_farm_s {
+  pthread_mutex_t lock;
+  pthread_cond_t  work;        /* a job was queued, or we're stopping */
+  pthread_cond_t  idle;        /* a job finished */
+  farm_job_t     *p_head;
+  farm_job_t     *p_tail;
+  unsigned int    i_queued;
+  farm_drive_t   *p_drives;
+  unsigned int    i_drives;
+  driver_id_t     driver_id;
+  unsigned int    i_poll_ms;
+  bool            b_eject;
+  bool            b_stop;
+  uint64_t        i_start;
+};
+
+/* Turn "i_ms milliseconds from now" into a time for
+   pthread_cond_timedwait(). */
+static void
+farm_deadline(unsigned int i_ms, /*out*/ struct timespec *p_ts)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  p_ts->tv_sec  = tv.tv_sec + i_ms / 1000;
+  p_ts->tv_nsec = (tv.tv_usec + (long) (i_ms % 1000) * 1000) * 1000;
+  if (p_ts->tv_nsec >= 1000000000) {
+    p_ts->tv_sec++;
+    p_ts->tv_nsec -= 1000000000;
+  }
+}
+
+/* Count the bytes read by a job. */
+static void
+farm_trace(const cdio_trace_event_t *p_event, void *p_user_data)
+{
+  farm_drive_t *p_drive = p_user_data;
+
+  if (0 == p_event->i_bytes) return;
+  pthread_mutex_lock(&p_drive->p_farm->lock);
+  p_drive->i_bytes += p_event->i_bytes;
+  pthread_mutex_unlock(&p_drive->p_farm->lock);
+}
+
+static bool
+farm_open_drive(farm_drive_t *p_drive)
+{
+  p_drive->p_cdio = cdio_open(p_drive->psz_drive, p_drive->p_farm->driver_id);
+  if (!p_drive->p_cdio) return false;
+  cdio_set_trace_callback(p_drive->p_cdio, farm_trace, p_drive);
+  return true;
+}
+
+/* Is there a disc in p_drive? *pb_new is set if the drive says one
+   was put in since it was last asked. */
+static bool
+farm_poll_media(farm_drive_t *p_drive, /*out*/ bool *pb_new)
+{
+  uint8_t status[2];
+  discmode_t discmode;
+
+  *pb_new = false;
+  if (!p_drive->p_cdio && !farm_open_drive(p_drive)) return false;
+
+  if (DRIVER_OP_SUCCESS == mmc_get_event_status(p_drive->p_cdio, status)) {
+    const uint8_t i_event = status[0] & 0x0f;
+    /* NewMedia or MediaChanged */
+    *pb_new = (2 == i_event || 4 == i_event);
+    return 0 != (status[1] & 0x02);
+  }
+
+  /* No GET EVENT STATUS NOTIFICATION: an image, or an old drive. */
+  if (1 == cdio_get_media_changed(p_drive->p_cdio)) *pb_new = true;
+  discmode = cdio_get_discmode(p_drive->p_cdio);
+  return CDIO_DISC_MODE_NO_INFO != discmode
+    && CDIO_DISC_MODE_ERROR != discmode;
+}
+
+/* Unlink and return the first queued job p_drive can run, or NULL.
+   Called with the lock held. */
+static farm_job_t *
+farm_take_job(cdio_farm_t *p_farm, const farm_drive_t *p_drive)
+{
+  farm_job_t *p_prev = NULL, *p_job;
+
+  for (p_job = p_farm->p_head; p_job; p_prev = p_job, p_job = p_job->p_next) {
+    if (p_job->psz_drive && 0 != strcmp(p_job->psz_drive, p_drive->psz_drive))
+      continue;
+    if (p_prev)
+      p_prev->p_next = p_job->p_next;
+    else
+      p_farm->p_head = p_job->p_next;
+    if (p_farm->p_tail == p_job) p_farm->p_tail = p_prev;
+    p_farm->i_queued--;
+    return p_job;
+  }
+  return NULL;
+}
+
+static void *
+farm_worker(void *p_arg)
+{
+  farm_drive_t *p_drive = p_arg;
+  cdio_farm_t *p_farm = p_drive->p_farm;
+
+  pthread_mutex_lock(&p_farm->lock);
+  while (!p_farm->b_stop) {
+    farm_job_t *p_job = NULL;
+    driver_return_code_t i_ret;
+    struct timespec ts;
+    bool b_loaded, b_new;
+
+    /* Polling can take a while on a real drive; don't hold up the
+       others. */
+    pthread_mutex_unlock(&p_farm->lock);
+    b_loaded = farm_poll_media(p_drive, &b_new);
+    pthread_mutex_lock(&p_farm->lock);
+
+    if (b_loaded && (b_new || !p_drive->b_loaded)) p_drive->b_fresh = true;
+    if (!b_loaded) p_drive->b_fresh = false;
+    p_drive->b_loaded = b_loaded;
+
+    if (p_drive->b_fresh && !p_farm->b_stop)
+      p_job = farm_take_job(p_farm, p_drive);
+    if (!p_job) {
+      farm_deadline(p_farm->i_poll_ms, &ts);
+      if (!p_farm->b_stop)
+        pthread_cond_timedwait(&p_farm->work, &p_farm->lock, &ts);
+      continue;
+    }
+
+    p_drive->b_fresh      = false;
+    p_drive->b_busy       = true;
+    p_drive->i_busy_since = cdio_stats_now();
+    pthread_mutex_unlock(&p_farm->lock);
+
+    /* Start the job on a fresh handle, so that nothing read from the
+       last disc is left over. */
+    cdio_destroy(p_drive->p_cdio);
+    if (farm_open_drive(p_drive)) {
+      i_ret = p_job->job(p_drive->p_cdio, p_drive->psz_drive,
+                         p_job->p_user_data);
+      if (p_farm->b_eject && p_drive->p_cdio)
+        cdio_eject_media(&p_drive->p_cdio);
+    } else {
+      cdio_warn("can't reopen %s", p_drive->psz_drive);
+      i_ret = DRIVER_OP_ERROR;
+    }
+    free(p_job->psz_drive);
+    free(p_job);
+
+    pthread_mutex_lock(&p_farm->lock);
+    p_drive->b_busy = false;
+    p_drive->i_busy_nsec += cdio_stats_now() - p_drive->i_busy_since;
+    if (DRIVER_OP_SUCCESS == i_ret)
+      p_drive->i_jobs_done++;
+    else
+      p_drive->i_jobs_failed++;
+    pthread_cond_broadcast(&p_farm->idle);
+  }
+  pthread_mutex_unlock(&p_farm->lock);
+  return NULL;
+}
+
+/* Add what p_drive has done to p_stats. Called with the lock held. */
+static void
+farm_add_stats(const farm_drive_t *p_drive, uint64_t i_now,
+               cdio_farm_stats_t *p_stats)
+{
+  p_stats->i_drives++;
+  if (p_drive->b_loaded) p_stats->i_loaded++;
+  if (p_drive->b_busy) p_stats->i_busy++;
+  p_stats->i_jobs_done   += p_drive->i_jobs_done;
+  p_stats->i_jobs_failed += p_drive->i_jobs_failed;
+  p_stats->i_bytes       += p_drive->i_bytes;
+  p_stats->i_busy_nsec   += p_drive->i_busy_nsec;
+  if (p_drive->b_busy)
+    p_stats->i_busy_nsec += i_now - p_drive->i_busy_since;
+}
+
+static void
+farm_finish_stats(const cdio_farm_t *p_farm, uint64_t i_now,
+                  cdio_farm_stats_t *p_stats)
+{
+  p_stats->i_queued = p_farm->i_queued;
+  p_stats->i_nsec   = i_now - p_farm->i_start;
+  p_stats->i_bytes_per_sec = p_stats->i_nsec
+    ? (uint64_t) ((double) p_stats->i_bytes * 1e9 / p_stats->i_nsec) : 0;
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+/*!
+  Open the drives in ppsz_drives, or all of them, and start a thread
+  for each.
+*/
+cdio_farm_t *
+cdio_farm_new(char *ppsz_drives[], driver_id_t driver_id,
+              unsigned int i_poll_ms, bool b_eject)
+{
+#ifdef HAVE_PTHREAD_H
+  char **ppsz_found = NULL;
+  cdio_farm_t *p_farm;
+  unsigned int i_names = 0, i;
+
+  if (!ppsz_drives) {
+    ppsz_found = cdio_get_devices_with_cap(NULL, CDIO_FS_MATCH_ALL, true);
+    if (!ppsz_found) return NULL;
+    ppsz_drives = ppsz_found;
+  }
+  while (ppsz_drives[i_names]) i_names++;
+
+  p_farm = calloc(1, sizeof(cdio_farm_t));
+  if (p_farm && i_names)
+    p_farm->p_drives = calloc(i_names, sizeof(farm_drive_t));
+  if (!p_farm || !p_farm->p_drives) {
+    free(p_farm);
+    cdio_free_device_list(ppsz_found);
+    return NULL;
+  }
+  pthread_mutex_init(&p_farm->lock, NULL);
+  pthread_cond_init(&p_farm->work, NULL);
+  pthread_cond_init(&p_farm->idle, NULL);
+  p_farm->driver_id = driver_id;
+  p_farm->i_poll_ms = i_poll_ms ? i_poll_ms : CDIO_FARM_POLL_MS;
+  p_farm->b_eject   = b_eject;
+  p_farm->i_start   = cdio_stats_now();
+
+  for (i = 0; i < i_names; i++) {
+    farm_drive_t *p_drive = &p_farm->p_drives[p_farm->i_drives];
+    p_drive->p_farm    = p_farm;
+    p_drive->psz_drive = strdup(ppsz_drives[i]);
+    if (!p_drive->psz_drive || !farm_open_drive(p_drive)) {
+      cdio_warn("can't open %s for the drive farm", ppsz_drives[i]);
+      free(p_drive->psz_drive);
+      p_drive->psz_drive = NULL;
+      continue;
+    }
+    p_farm->i_drives++;
+  }
+  cdio_free_device_list(ppsz_found);
+
+  if (0 == p_farm->i_drives) {
+    cdio_farm_destroy(p_farm);
+    return NULL;
+  }
+
+  for (i = 0; i < p_farm->i_drives; i++) {
+    farm_drive_t *p_drive = &p_farm->p_drives[i];
+    p_drive->b_started = (0 == pthread_create(&p_drive->thread, NULL,
+                                              farm_worker, p_drive));
+    if (!p_drive->b_started)
+      cdio_warn("can't start a thread for %s: %s", p_drive->psz_drive,
+                strerror(errno));
+  }
+  return p_farm;
+#else
+  cdio_warn("drive farms need threads");
+  return NULL;
+#endif
+}
+
+/*!
+  Queue job for the next disc loaded into psz_drive, or into any
+  drive if psz_drive is NULL.
+*/
+bool
+cdio_farm_submit(cdio_farm_t *p_farm, cdio_farm_job_t job,
+                 void *p_user_data, const char *psz_drive)
+{
+#ifdef HAVE_PTHREAD_H
+  farm_job_t *p_job;
+
+  if (!p_farm || !job) return false;
+  p_job = calloc(1, sizeof(farm_job_t));
+  if (!p_job) return false;
+  p_job->job         = job;
+  p_job->p_user_data = p_user_data;
+  if (psz_drive && !(p_job->psz_drive = strdup(psz_drive))) {
+    free(p_job);
+    return false;
+  }
+
+  pthread_mutex_lock(&p_farm->lock);
+  if (p_farm->p_tail)
+    p_farm->p_tail->p_next = p_job;
+  else
+    p_farm->p_head = p_job;
+  p_farm->p_tail = p_job;
+  p_farm->i_queued++;
+  pthread_cond_broadcast(&p_farm->work);
+  pthread_mutex_unlock(&p_farm->lock);
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*!
+  Wait until no job is queued or running, for at most i_timeout_ms
+  milliseconds or, if that is 0, for as long as it takes.
+*/
+bool
+cdio_farm_wait(cdio_farm_t *p_farm, unsigned int i_timeout_ms)
+{
+#ifdef HAVE_PTHREAD_H
+  struct timespec ts;
+  bool b_idle = false;
+
+  if (!p_farm) return false;
+  farm_deadline(i_timeout_ms, &ts);
+  pthread_mutex_lock(&p_farm->lock);
+  for (;;) {
+    unsigned int i;
+    int i_rc;
+
+    b_idle = (0 == p_farm->i_queued);
+    for (i = 0; b_idle && i < p_farm->i_drives; i++)
+      if (p_farm->p_drives[i].b_busy) b_idle = false;
+    if (b_idle) break;
+
+    if (0 == i_timeout_ms)
+      i_rc = pthread_cond_wait(&p_farm->idle, &p_farm->lock);
+    else
+      i_rc = pthread_cond_timedwait(&p_farm->idle, &p_farm->lock, &ts);
+    if (ETIMEDOUT == i_rc) break;
+  }
+  pthread_mutex_unlock(&p_farm->lock);
+  return b_idle;
+#else
+  return false;
+#endif
+}
+
+unsigned int
+cdio_farm_num_drives(const cdio_farm_t *p_farm)
+{
+#ifdef HAVE_PTHREAD_H
+  if (p_farm) return p_farm->i_drives;
+#endif
+  return 0;
+}
+
+const char *
+cdio_farm_get_drive(const cdio_farm_t *p_farm, unsigned int i_drive)
+{
+#ifdef HAVE_PTHREAD_H
+  if (p_farm && i_drive < p_farm->i_drives)
+    return p_farm->p_drives[i_drive].psz_drive;
+#endif
+  return NULL;
+}
+
+driver_return_code_t
+cdio_farm_get_stats(cdio_farm_t *p_farm, /*out*/ cdio_farm_stats_t *p_stats)
+{
+#ifdef HAVE_PTHREAD_H
+  uint64_t i_now;
+  unsigned int i;
+
+  if (!p_farm) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  memset(p_stats, 0, sizeof(cdio_farm_stats_t));
+
+  pthread_mutex_lock(&p_farm->lock);
+  i_now = cdio_stats_now();
+  for (i = 0; i < p_farm->i_drives; i++)
+    farm_add_stats(&p_farm->p_drives[i], i_now, p_stats);
+  farm_finish_stats(p_farm, i_now, p_stats);
+  pthread_mutex_unlock(&p_farm->lock);
+  return DRIVER_OP_SUCCESS;
+#else
+  return DRIVER_OP_UNSUPPORTED;
+#endif
+}
+
+driver_return_code_t
+cdio_farm_get_drive_stats(cdio_farm_t *p_farm, unsigned int i_drive,
+                          /*out*/ cdio_farm_stats_t *p_stats)
+{
+#ifdef HAVE_PTHREAD_H
+  uint64_t i_now;
+
+  if (!p_farm) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  if (i_drive >= p_farm->i_drives) return DRIVER_OP_BAD_PARAMETER;
+  memset(p_stats, 0, sizeof(cdio_farm_stats_t));
+
+  pthread_mutex_lock(&p_farm->lock);
+  i_now = cdio_stats_now();
+  farm_add_stats(&p_farm->p_drives[i_drive], i_now, p_stats);
+  farm_finish_stats(p_farm, i_now, p_stats);
+  pthread_mutex_unlock(&p_farm->lock);
+  return DRIVER_OP_SUCCESS;
+#else
+  return DRIVER_OP_UNSUPPORTED;
+#endif
+}
+
+/*!
+  Let running jobs finish, drop queued ones, close the drives and
+  free p_farm.
+*/
+void
+cdio_farm_destroy(cdio_farm_t *p_farm)
+{
+#ifdef HAVE_PTHREAD_H
+  unsigned int i;
+
+  if (!p_farm) return;
+
+  pthread_mutex_lock(&p_farm->lock);
+  p_farm->b_stop = true;
+  pthread_cond_broadcast(&p_farm->work);
+  pthread_mutex_unlock(&p_farm->lock);
+
+  for (i = 0; i < p_farm->i_drives; i++) {
+    farm_drive_t *p_drive = &p_farm->p_drives[i];
+    if (p_drive->b_started) pthread_join(p_drive->thread, NULL);
+    cdio_destroy(p_drive->p_cdio);
+    free(p_drive->psz_drive);
+  }
+  while (p_farm->p_head) {
+    farm_job_t *p_job = p_farm->p_head;
+    p_farm->p_head = p_job->p_next;
+    free(p_job->psz_drive);
+    free(p_job);
+  }
+
+  pthread_cond_destroy(&p_farm->idle);
+  pthread_cond_destroy(&p_farm->work);
+  pthread_mutex_destroy(&p_farm->lock);
+  free(p_farm->p_drives);
+  free(p_farm);
+#endif
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -72,6 +72,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <dirent.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
@@ -1411,6 +1418,293 @@ checklist2[] =
   };
 static const int checklist2_size = sizeof(checklist2) / sizeof(checklist2[0]);
 
+/* The CD drives sysfs lists, by their names under /sys/block, kept
+   for the whole process so that finding drives opens none of them.
+   Where there is inotify, additions and removals in /dev update the
+   list; elsewhere it is read again each time it is used. */
+static struct {
+  char       **ppsz_names;  /* "sr0", "sr1", ... in order */
+  unsigned int i_names;
+  bool         b_valid;
+  int          i_inotify;   /* watching psz_dev, or -1 */
+  const char  *psz_sys_block; /* "/sys/block", or a tree for tests */
+  const char  *psz_dev;       /* "/dev", or a directory for tests */
+} drive_registry = { NULL, 0, false, -1, "/sys/block", "/dev" };
+
+#ifdef HAVE_PTHREAD_H
+static pthread_mutex_t drive_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+# define DRIVE_REGISTRY_LOCK()   pthread_mutex_lock(&drive_registry_lock)
+# define DRIVE_REGISTRY_UNLOCK() pthread_mutex_unlock(&drive_registry_lock)
+#else
+# define DRIVE_REGISTRY_LOCK()
+# define DRIVE_REGISTRY_UNLOCK()
+#endif
+
+/* Read the first line of /sys/block/psz_name/psz_attr into buf. The
+   registry lock must be held. */
+static bool
+sysfs_read_attr(const char *psz_name, const char *psz_attr, char *buf,
+                size_t i_size)
+{
+  char psz_path[PATH_MAX];
+  ssize_t i_read;
+  int fd;
+
+  if (snprintf(psz_path, sizeof(psz_path), "%s/%s/%s",
+               drive_registry.psz_sys_block, psz_name, psz_attr)
+      >= (int) sizeof(psz_path))
+    return false;
+  fd = open(psz_path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  i_read = read(fd, buf, i_size - 1);
+  close(fd);
+  if (i_read <= 0)
+    return false;
+  buf[i_read] = '\0';
+  buf[strcspn(buf, "\n")] = '\0';
+  return true;
+}
+
+/* Is the block device psz_name a CD drive? SCSI drives, and ATAPI
+   drives under libata, give their SCSI type; IDE drives under the old
+   ide driver say what media they take. Nothing is opened but sysfs
+   attributes. */
+static bool
+sysfs_is_cdrom(const char *psz_name)
+{
+  char buf[32];
+
+  if (strchr(psz_name, '/'))
+    return false;
+  if (sysfs_read_attr(psz_name, "device/type", buf, sizeof(buf))) {
+    const int i_type = atoi(buf);
+    return TYPE_ROM == i_type || TYPE_WORM == i_type;
+  }
+  if (sysfs_read_attr(psz_name, "device/media", buf, sizeof(buf)))
+    return 0 == strcmp(buf, "cdrom");
+  return false;
+}
+
+/* Order names so that sr2 comes before sr10. */
+static int
+drive_name_cmp(const char *psz_a, const char *psz_b)
+{
+  const size_t i_a = strlen(psz_a), i_b = strlen(psz_b);
+  if (i_a != i_b)
+    return i_a < i_b ? -1 : 1;
+  return strcmp(psz_a, psz_b);
+}
+
+/* Return where psz_name is in the registry, or where it would go. */
+static unsigned int
+drive_registry_find(const char *psz_name, bool *pb_found)
+{
+  unsigned int i;
+
+  for (i = 0; i < drive_registry.i_names; i++) {
+    const int i_cmp = drive_name_cmp(drive_registry.ppsz_names[i], psz_name);
+    if (i_cmp >= 0) {
+      *pb_found = (0 == i_cmp);
+      return i;
+    }
+  }
+  *pb_found = false;
+  return i;
+}
+
+static void
+drive_registry_add(const char *psz_name)
+{
+  bool b_found;
+  const unsigned int i = drive_registry_find(psz_name, &b_found);
+  char **ppsz_names;
+  char *psz_copy;
+
+  if (b_found)
+    return;
+  ppsz_names = realloc(drive_registry.ppsz_names,
+                       (drive_registry.i_names + 1) * sizeof(char *));
+  if (!ppsz_names)
+    return;
+  drive_registry.ppsz_names = ppsz_names;
+  psz_copy = strdup(psz_name);
+  if (!psz_copy)
+    return;
+  memmove(&ppsz_names[i + 1], &ppsz_names[i],
+          (drive_registry.i_names - i) * sizeof(char *));
+  ppsz_names[i] = psz_copy;
+  drive_registry.i_names++;
+}
+
+static void
+drive_registry_remove(const char *psz_name)
+{
+  bool b_found;
+  const unsigned int i = drive_registry_find(psz_name, &b_found);
+
+  if (!b_found)
+    return;
+  free(drive_registry.ppsz_names[i]);
+  drive_registry.i_names--;
+  memmove(&drive_registry.ppsz_names[i], &drive_registry.ppsz_names[i + 1],
+          (drive_registry.i_names - i) * sizeof(char *));
+}
+
+/* Fill the registry from /sys/block. Returns false if there is no
+   sysfs to read. */
+static bool
+drive_registry_scan(void)
+{
+  struct dirent *p_entry;
+  DIR *p_dir;
+
+#ifdef HAVE_SYS_INOTIFY_H
+  /* Watch first, so that nothing between reading and watching is
+     missed. */
+  if (drive_registry.i_inotify < 0) {
+    drive_registry.i_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (drive_registry.i_inotify >= 0
+        && inotify_add_watch(drive_registry.i_inotify,
+                             drive_registry.psz_dev,
+                             IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                             | IN_MOVED_TO) < 0) {
+      close(drive_registry.i_inotify);
+      drive_registry.i_inotify = -1;
+    }
+  }
+#endif
+
+  p_dir = opendir(drive_registry.psz_sys_block);
+  if (!p_dir)
+    return false;
+
+  while (drive_registry.i_names > 0)
+    free(drive_registry.ppsz_names[--drive_registry.i_names]);
+  while (NULL != (p_entry = readdir(p_dir)))
+    if ('.' != p_entry->d_name[0] && sysfs_is_cdrom(p_entry->d_name))
+      drive_registry_add(p_entry->d_name);
+  closedir(p_dir);
+
+  drive_registry.b_valid = true;
+  return true;
+}
+
+/* Empty the registry and stop watching, so that the next use reads
+   sysfs again. */
+static void
+drive_registry_free(void)
+{
+  while (drive_registry.i_names > 0)
+    free(drive_registry.ppsz_names[--drive_registry.i_names]);
+  free(drive_registry.ppsz_names);
+  drive_registry.ppsz_names = NULL;
+  drive_registry.b_valid = false;
+  if (drive_registry.i_inotify >= 0) {
+    close(drive_registry.i_inotify);
+    drive_registry.i_inotify = -1;
+  }
+}
+
+#ifdef __GNUC__
+/* Give back the registry's descriptor when the library is unloaded. */
+static void drive_registry_fini(void) __attribute__((destructor));
+static void
+drive_registry_fini(void)
+{
+  DRIVE_REGISTRY_LOCK();
+  drive_registry_free();
+  DRIVE_REGISTRY_UNLOCK();
+}
+#endif
+
+/* Bring the registry up to date. Returns false if there is no sysfs
+   to read. */
+static bool
+drive_registry_refresh(void)
+{
+#ifdef HAVE_SYS_INOTIFY_H
+  if (drive_registry.b_valid && drive_registry.i_inotify >= 0) {
+    union {
+      struct inotify_event event;
+      char buf[4096];
+    } u;
+    bool b_rescan = false;
+    ssize_t i_read;
+
+    while ((i_read = read(drive_registry.i_inotify, u.buf, sizeof(u.buf)))
+           > 0) {
+      ssize_t i = 0;
+      while (i + (ssize_t) sizeof(struct inotify_event) <= i_read) {
+        const struct inotify_event *p_event = (void *) &u.buf[i];
+        if (p_event->mask & IN_Q_OVERFLOW)
+          b_rescan = true;
+        else if (p_event->len > 0) {
+          drive_registry_remove(p_event->name);
+          if ((p_event->mask & (IN_CREATE | IN_MOVED_TO))
+              && sysfs_is_cdrom(p_event->name))
+            drive_registry_add(p_event->name);
+        }
+        i += sizeof(struct inotify_event) + p_event->len;
+      }
+    }
+    if (i_read < 0 && EAGAIN != errno && EINTR != errno) {
+      close(drive_registry.i_inotify);
+      drive_registry.i_inotify = -1;
+      b_rescan = true;
+    }
+    if (!b_rescan)
+      return true;
+  }
+#endif
+  return drive_registry_scan();
+}
+
+/* Return the CD drives in sysfs, with /dev/cdrom and /dev/dvd first
+   when they name one of them, or NULL if there is no sysfs. */
+static char **
+get_devices_sysfs_linux(void)
+{
+  char **drives = NULL;
+  unsigned int num_drives = 0;
+  char drive[40];
+  unsigned int i;
+
+  DRIVE_REGISTRY_LOCK();
+  if (!drive_registry_refresh()) {
+    DRIVE_REGISTRY_UNLOCK();
+    return NULL;
+  }
+
+  for ( i=0; i < checklist1_size; ++i ) {
+    char real_drive[PATH_MAX];
+    const char *psz_base;
+    bool b_found = false;
+
+    if (snprintf(drive, sizeof(drive), "/dev/%s", checklist1[i]) < 0
+        || !cdio_is_device_quiet_generic(drive))
+      continue;
+    cdio_realpath(drive, real_drive);
+    psz_base = strrchr(real_drive, '/');
+    if (psz_base)
+      drive_registry_find(psz_base + 1, &b_found);
+    if (b_found)
+      cdio_add_device_list(&drives, drive, &num_drives);
+  }
+
+  for ( i=0; i < drive_registry.i_names; ++i ) {
+    if (snprintf(drive, sizeof(drive), "/dev/%s",
+                 drive_registry.ppsz_names[i]) >= (int) sizeof(drive))
+      continue;
+    if (cdio_is_device_quiet_generic(drive))
+      cdio_add_device_list(&drives, drive, &num_drives);
+  }
+  DRIVE_REGISTRY_UNLOCK();
+
+  cdio_add_device_list(&drives, NULL, &num_drives);
+  return drives;
+}
+
 
 /* Set CD-ROM drive speed */
 static driver_return_code_t
@@ -1424,6 +1718,52 @@ set_speed_linux (void *p_user_data, int i_drive_speed)
 
 #endif /* HAVE_LINUX_CDROM */
 
+/*!
+  Have the drive registry read psz_sys_block rather than /sys/block
+  and watch psz_dev rather than /dev, starting afresh; NULLs put back
+  the defaults.
+*/
+void
+cdio_linux_registry_set_roots(const char *psz_sys_block, const char *psz_dev)
+{
+#ifdef HAVE_LINUX_CDROM
+  DRIVE_REGISTRY_LOCK();
+  drive_registry_free();
+  drive_registry.psz_sys_block = psz_sys_block ? psz_sys_block : "/sys/block";
+  drive_registry.psz_dev       = psz_dev ? psz_dev : "/dev";
+  DRIVE_REGISTRY_UNLOCK();
+#endif /*HAVE_LINUX_CDROM*/
+}
+
+/*!
+  Return the names in the drive registry, brought up to date, as a
+  list to free with cdio_free_device_list(), or NULL if sysfs can't be
+  read.
+*/
+char **
+cdio_linux_registry_get_names(void)
+{
+#ifndef HAVE_LINUX_CDROM
+  return NULL;
+#else
+  char **ppsz_names = NULL;
+  unsigned int i_names = 0;
+  unsigned int i;
+
+  DRIVE_REGISTRY_LOCK();
+  if (!drive_registry_refresh()) {
+    DRIVE_REGISTRY_UNLOCK();
+    return NULL;
+  }
+  for (i = 0; i < drive_registry.i_names; i++)
+    cdio_add_device_list(&ppsz_names, drive_registry.ppsz_names[i], &i_names);
+  DRIVE_REGISTRY_UNLOCK();
+
+  cdio_add_device_list(&ppsz_names, NULL, &i_names);
+  return ppsz_names;
+#endif /*HAVE_LINUX_CDROM*/
+}
+
 /*!
   Return an array of strings giving possible CD devices.
  */
@@ -1439,6 +1779,10 @@ cdio_get_devices_linux (void)
   char **drives = NULL;
   unsigned int num_drives=0;
 
+  /* Ask sysfs first; that opens no devices. */
+  if (NULL != (drives = get_devices_sysfs_linux()))
+    return drives;
+
   /* Scan the system for CD-ROM drives.
   */
   for ( i=0; i < checklist1_size; ++i ) {
@@ -1492,6 +1836,14 @@ cdio_get_default_device_linux(void)
   unsigned int i;
   char drive[40];
   char *ret_drive;
+  char **drives;
+
+  /* Ask sysfs first; that opens no devices. */
+  if (NULL != (drives = get_devices_sysfs_linux())) {
+    ret_drive = drives[0] ? strdup(drives[0]) : NULL;
+    cdio_free_device_list(drives);
+    return ret_drive;
+  }
 
   /* Scan the system for CD-ROM drives.
   */
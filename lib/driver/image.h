@@ -39,6 +39,21 @@
 #include "cdio_private.h"
 #include <cdio/sector.h>
 
+/*!
+  A file holding some of the sectors of a disc image, for image
+  formats like BIN/CUE where the sectors can be spread over several
+  files. Several tracks may share a file.
+*/
+typedef struct {
+  char             *psz_filename;
+  CdioDataSource_t *data_source; /**< Opened on the first read */
+  off_t             offset;      /**< Byte offset of the first sector in
+                                      the file, e.g. the size of a WAVE
+                                      header */
+  lsn_t             start_lsn;   /**< LSN of the first sector */
+  lsn_t             i_sectors;   /**< Number of sectors in the file */
+} image_file_t;
+
 /*! 
   The universal format for information about a track for CD image readers
   It may be that some fields can be derived from other fields.
@@ -60,6 +75,8 @@ typedef struct {
   char          *isrc;          /**< IRSC Code (5.22.4) exactly 12 bytes */
   char          *filename;
   CdioDataSource_t *data_source;
+  image_file_t  *p_file;        /**< File holding the track, if the
+                                     driver keeps a file table */
   off_t          offset;        /**< byte offset into data_start of track
                                      beginning. In cdrdao for example, one
                                      filename may cover many tracks and
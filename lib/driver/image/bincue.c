@@ -78,32 +78,24 @@
 #define DEFAULT_CDIO_DEVICE "videocd.bin"
 #define DEFAULT_CDIO_CUE    "videocd.cue"
 
-#ifdef _WIN32
-#define CDIO_FOPEN fopen_utf8
-#else
-#define CDIO_FOPEN fopen
-#endif
-
 static lsn_t get_disc_last_lsn_bincue(void *p_user_data);
 #include "image_common.h"
-static bool parse_cuefile(_img_private_t *cd, const char *toc_name);
+typedef struct cue_sheet_s cue_sheet_t;
+static bool cue_sheet_apply(_img_private_t *cd, const cue_sheet_t *p_sheet);
+static CdIo_t *open_bincue (const char *psz_source,
+                            const char *psz_access_mode);
 
 /*!
-  Initialize image structures.
+  Initialize image structures from p_sheet, the parsed CUE sheet.
  */
 static bool
-_init_bincue(_img_private_t *p_env)
+_init_bincue(_img_private_t *p_env, const cue_sheet_t *p_sheet)
 {
   lsn_t lead_lsn;
 
   if (p_env->gen.init)
     return false;
 
-  if (!(p_env->gen.data_source = cdio_stdio_new (p_env->gen.source_name))) {
-    cdio_warn ("init failed");
-    return false;
-  }
-
   /* Have to set init before calling get_disc_last_lsn_bincue() or we will
      get into infinite recursion calling passing right here.
    */
@@ -112,14 +104,14 @@ _init_bincue(_img_private_t *p_env)
   p_env->psz_mcn       = NULL;
   p_env->disc_mode     = CDIO_DISC_MODE_NO_INFO;
 
-  lead_lsn = get_disc_last_lsn_bincue( (_img_private_t *) p_env);
+  if ((p_env->psz_cue_name == NULL)) return false;
 
-  if (-1 == lead_lsn) return false;
+  /* Fill in tracks and files from the CUE sheet. */
+  if ( !cue_sheet_apply(p_env, p_sheet) ) return false;
 
-  if ((p_env->psz_cue_name == NULL)) return false;
+  lead_lsn = get_disc_last_lsn_bincue( (_img_private_t *) p_env);
 
-  /* Read in CUE sheet. */
-  if ( !parse_cuefile(p_env, p_env->psz_cue_name) ) return false;
+  if (-1 == lead_lsn) return false;
 
   /* Fake out leadout track and sector count for last track*/
   cdio_lsn_to_msf (lead_lsn, &p_env->tocent[p_env->gen.i_tracks].start_msf);
@@ -131,6 +123,79 @@ _init_bincue(_img_private_t *p_env)
   return true;
 }
 
+/*!
+  Return the file holding sector lsn, or NULL if no file does.
+
+  The file is looked up from the track lsn is in, using the track
+  table kept on the CdIo_t, and then moved to a neighbouring file if
+  lsn is in a pregap stored at the end of the previous track's file
+  or at the start of the next track's.
+*/
+static image_file_t *
+bincue_file_for_lsn(_img_private_t *p_env, lsn_t lsn)
+{
+  image_file_t *p_first = p_env->p_files;
+  image_file_t *p_last  = p_env->p_files + p_env->i_files - 1;
+  image_file_t *p_file  = p_first;
+  CdIo_t *p_cdio = p_env->gen.cdio;
+
+  if (0 == p_env->i_files) return NULL;
+
+  if (p_env->i_files > 1 && p_cdio && cdio_track_table_ready(p_cdio)) {
+    const track_t i_track =
+      cdio_track_table_find(&p_cdio->track_table, lsn);
+    if (i_track >= p_env->gen.i_first_track
+        && i_track < p_env->gen.i_first_track + p_env->gen.i_tracks)
+      p_file = p_env->tocent[i_track - p_env->gen.i_first_track].p_file;
+  }
+
+  while (p_file < p_last && lsn >= p_file->start_lsn + p_file->i_sectors)
+    p_file++;
+  while (p_file > p_first && lsn < p_file->start_lsn)
+    p_file--;
+
+  if (lsn < p_file->start_lsn || lsn >= p_file->start_lsn + p_file->i_sectors)
+    return NULL;
+  return p_file;
+}
+
+/*!
+  Read i_blocks CDIO_CD_FRAMESIZE_RAW-byte sectors starting at lsn
+  into p_buf. A range which spans several files is read with one
+  read per file.
+ */
+static driver_return_code_t
+read_raw_sectors_bincue (_img_private_t *p_env, void *p_buf, lsn_t lsn,
+                         unsigned int i_blocks)
+{
+  uint8_t *p = p_buf;
+
+  while (i_blocks > 0) {
+    image_file_t *p_file = bincue_file_for_lsn(p_env, lsn);
+    unsigned int i_now;
+    int ret;
+
+    if (NULL == p_file) return DRIVER_OP_ERROR;
+
+    i_now = p_file->start_lsn + p_file->i_sectors - lsn;
+    if (i_now > i_blocks) i_now = i_blocks;
+
+    ret = cdio_stream_seek (p_file->data_source, p_file->offset
+                            + (off_t) (lsn - p_file->start_lsn)
+                            * CDIO_CD_FRAMESIZE_RAW, SEEK_SET);
+    if (ret!=0) return ret;
+
+    if (cdio_stream_read (p_file->data_source, p, CDIO_CD_FRAMESIZE_RAW,
+                          i_now) != (ssize_t) i_now * CDIO_CD_FRAMESIZE_RAW)
+      return DRIVER_OP_ERROR;
+
+    p        += i_now * CDIO_CD_FRAMESIZE_RAW;
+    lsn      += i_now;
+    i_blocks -= i_now;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
 /*!
   Reads into buf the next size bytes.
   Returns -1 on error. 
@@ -154,6 +219,9 @@ _lseek_bincue (void *p_user_data, off_t offset, int whence)
   for (i=0; i<p_env->gen.i_tracks; i++) {
     track_info_t  *this_track=&(p_env->tocent[i]);
     p_env->pos.index = i;
+    /* Offsets count from the start of the file holding the track. */
+    if (i > 0 && this_track->p_file != p_env->tocent[i-1].p_file)
+      real_offset = 0;
     if ( (this_track->sec_count*this_track->datasize) >= offset) {
       int blocks            = (int) (offset / this_track->datasize);
       int rem               = (int) (offset % this_track->datasize);
@@ -172,8 +240,9 @@ _lseek_bincue (void *p_user_data, off_t offset, int whence)
     cdio_warn ("seeking outside range of disk image");
     return DRIVER_OP_ERROR;
   } else {
-    real_offset += p_env->tocent[i].datastart;
-    return cdio_stream_seek(p_env->gen.data_source, real_offset, whence);
+    image_file_t *p_file = p_env->tocent[i].p_file;
+    real_offset += p_file->offset + p_env->tocent[i].datastart;
+    return cdio_stream_seek(p_file->data_source, real_offset, whence);
   }
 }
 
@@ -193,12 +262,13 @@ _read_bincue (void *p_user_data, void *data, size_t size)
   ssize_t final_size=0;
   ssize_t this_size;
   track_info_t  *this_track=&(p_env->tocent[p_env->pos.index]);
+  CdioDataSource_t *p_source = this_track->p_file->data_source;
   ssize_t skip_size = this_track->datastart + this_track->endsize;
 
   while (size > 0) {
     long int rem = (long int) (this_track->datasize - p_env->pos.buff_offset);
     if ((long int) size <= rem) {
-      this_size = cdio_stream_read(p_env->gen.data_source, buf, size, 1);
+      this_size = cdio_stream_read(p_source, buf, size, 1);
       final_size += this_size;
       memcpy (p, buf, this_size);
       break;
@@ -208,15 +278,15 @@ _read_bincue (void *p_user_data, void *data, size_t size)
     cdio_warn ("Reading across block boundaries not finished");
 
     size -= rem;
-    this_size = cdio_stream_read(p_env->gen.data_source, buf, rem, 1);
+    this_size = cdio_stream_read(p_source, buf, rem, 1);
     final_size += this_size;
     memcpy (p, buf, this_size);
     p += this_size;
-    this_size = cdio_stream_read(p_env->gen.data_source, buf, rem, 1);
+    this_size = cdio_stream_read(p_source, buf, rem, 1);
     
     /* Skip over stuff at end of this sector and the beginning of the next.
      */
-    cdio_stream_read(p_env->gen.data_source, buf, skip_size, 1);
+    cdio_stream_read(p_source, buf, skip_size, 1);
 
     /* Get ready to read another sector. */
     p_env->pos.buff_offset=0;
@@ -224,9 +294,20 @@ _read_bincue (void *p_user_data, void *data, size_t size)
 
     /* Have gone into next track. */
     if (p_env->pos.lba >= p_env->tocent[p_env->pos.index+1].start_lba) {
+      image_file_t *p_file;
       p_env->pos.index++;
       this_track=&(p_env->tocent[p_env->pos.index]);
       skip_size = this_track->datastart + this_track->endsize;
+      p_file = this_track->p_file;
+      if (p_file->data_source != p_source) {
+        /* The track is in another file; continue from its start. */
+        p_source = p_file->data_source;
+        cdio_stream_seek(p_source, p_file->offset
+                         + (off_t) (cdio_lba_to_lsn(this_track->start_lba)
+                                    - p_file->start_lsn)
+                         * this_track->blocksize + this_track->datastart,
+                         SEEK_SET);
+      }
     }
   }
   return final_size;
@@ -239,93 +320,295 @@ static lsn_t
 get_disc_last_lsn_bincue (void *p_user_data)
 {
   _img_private_t *p_env = p_user_data;
-  off_t size;
+  const image_file_t *p_last;
 
-  size = cdio_stream_stat (p_env->gen.data_source);
+  if (0 == p_env->i_files) return -1;
 
-  if (size % CDIO_CD_FRAMESIZE_RAW)
-    {
-      cdio_warn ("image %s size (%" PRId64 ") not multiple of blocksize (%d)", 
-                 p_env->gen.source_name, (int64_t)size, CDIO_CD_FRAMESIZE_RAW);
-      if (size % M2RAW_SECTOR_SIZE == 0)
-        cdio_warn ("this may be a 2336-type disc image");
-      else if (size % CDIO_CD_FRAMESIZE_RAW == 0)
-        cdio_warn ("this may be a 2352-type disc image");
-      /* exit (EXIT_FAILURE); */
-    }
+  p_last = &(p_env->p_files[p_env->i_files - 1]);
+  return p_last->start_lsn + p_last->i_sectors;
+}
 
-  size /= CDIO_CD_FRAMESIZE_RAW;
+/* CUE sheet parsing.
 
-  return (lsn_t)size;
-}
+   A sheet is read into memory with a single read and tokenized in
+   place into a cue_sheet_t. Nothing here keeps state outside of the
+   sheet being parsed, so sheets can be parsed in several threads at
+   once. The parsed sheet is what cdio_is_cuefile() checks and what
+   cdio_open_cue() builds the track table from, so a CUE file which
+   is opened is read and parsed only once.
+*/
 
-#define MAXLINE 4096            /* maximum line length + 1 */
+/*! How a TRACK's mode word maps onto track_info_t. */
+typedef struct {
+  const char     *psz_name;
+  trackmode_t     mode;
+  uint16_t        blocksize;
+  uint16_t        datastart;
+  uint16_t        datasize;
+  uint16_t        endsize;
+  track_format_t  track_format;
+  bool            track_green;
+  discmode_t      disc_mode;  /**< CD_DA, CD_DATA or CD_XA: what a disc
+                                   made only of tracks like this is */
+} cue_track_mode_t;
+
+static const cue_track_mode_t cue_track_modes[] = {
+  {"AUDIO",      AUDIO,       CDIO_CD_FRAMESIZE_RAW, 0,
+   CDIO_CD_FRAMESIZE_RAW, 0,
+   TRACK_FORMAT_AUDIO, false, CDIO_DISC_MODE_CD_DA},
+  /* Is the datastart below correct? */
+  {"MODE1/2048", MODE1,       2048, 0, CDIO_CD_FRAMESIZE, 0,
+   TRACK_FORMAT_DATA,  false, CDIO_DISC_MODE_CD_DATA},
+  {"MODE1/2352", MODE1_RAW,   2352, CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+   CDIO_CD_FRAMESIZE,
+   CDIO_CD_EDC_SIZE + CDIO_CD_M1F1_ZERO_SIZE + CDIO_CD_ECC_SIZE,
+   TRACK_FORMAT_DATA,  false, CDIO_DISC_MODE_CD_DATA},
+  {"MODE2/2336", MODE2,       2336, CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+   M2RAW_SECTOR_SIZE, 0,
+   TRACK_FORMAT_XA,    true,  CDIO_DISC_MODE_CD_DATA},
+  {"MODE2/2048", MODE2_FORM1, 2048, 0, 0, 0,
+   TRACK_FORMAT_XA,    true,  CDIO_DISC_MODE_CD_XA},
+  {"MODE2/2324", MODE2_FORM2, 2324, 0, 0, 0,
+   TRACK_FORMAT_XA,    true,  CDIO_DISC_MODE_CD_XA},
+  {"MODE2/2352", MODE2_RAW,   2352,
+   CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE + CDIO_CD_SUBHEADER_SIZE,
+   CDIO_CD_FRAMESIZE, CDIO_CD_SYNC_SIZE + CDIO_CD_ECC_SIZE,
+   TRACK_FORMAT_XA,    true,  CDIO_DISC_MODE_CD_XA},
+  {NULL, }
+};
+
+/*! A FILE line of a CUE sheet. */
+typedef struct {
+  char          *psz_filename;  /**< as written in the sheet */
+  char          *psz_filetype;  /**< BINARY, WAVE, ... or NULL */
+} cue_file_t;
+
+/*! What a CUE sheet says about one track. INDEX times are relative
+    to the start of the FILE they come after, which need not be the
+    same for INDEX 00 and INDEX 01. */
+typedef struct {
+  int            i_file;        /**< FILE of INDEX 01, or the FILE in
+                                     effect at TRACK; -1 if none */
+  int            i_pregap_file; /**< FILE of INDEX 00 */
+  const cue_track_mode_t *p_mode;
+  char          *psz_isrc;
+  flag_t         flags;
+  lba_t          silence;       /**< PREGAP */
+  lba_t          pregap;        /**< INDEX 00 */
+  lba_t          start_lba;     /**< first INDEX 01 */
+  int            num_indices;   /**< number of INDEX 01 lines */
+} cue_track_t;
+
+/*! A CD-Text line, or a CDTEXTFILE line if key is
+    CDTEXT_FIELD_INVALID. These are kept in the order they appear
+    since a later line overrides an earlier one. */
+typedef struct {
+  cdtext_field_t key;
+  int            i_track;       /**< index into cue_sheet_t.track, or -1
+                                     for the disc */
+  unsigned int   i_line;
+  char          *psz_value;
+} cue_cdtext_t;
+
+/*! A parsed CUE sheet. All strings point into psz_text. */
+struct cue_sheet_s {
+  char          *psz_text;      /**< the sheet, tokenized in place */
+  char          *psz_mcn;
+  int            i_tracks;
+  cue_track_t    track[CDIO_CD_MAX_TRACKS+1];
+  int            i_files;
+  cue_file_t     file[CDIO_CD_MAX_TRACKS];
+  cue_cdtext_t  *p_cdtext;
+  unsigned int   i_cdtext;
+  unsigned int   i_cdtext_alloc;
+};
+
+static void
+cue_sheet_free(cue_sheet_t *p_sheet)
+{
+  if (NULL == p_sheet) return;
+  free(p_sheet->psz_text);
+  free(p_sheet->p_cdtext);
+  free(p_sheet);
+}
 
+/*!
+  Append a CD-Text or CDTEXTFILE line to p_sheet. False is returned
+  if there is no memory for it.
+*/
 static bool
-parse_cuefile (_img_private_t *cd, const char *psz_cue_name)
+cue_add_cdtext(cue_sheet_t *p_sheet, cdtext_field_t key, int i_track,
+               unsigned int i_line, char *psz_value)
 {
-  /* The below declarations may be common in other image-parse routines. */
-  FILE *fp;
-  char         psz_line[MAXLINE];   /* text of current line read in file fp. */
-  unsigned int i_line=0;            /* line number in file of psz_line. */
-  int          i = -1;              /* Position in tocent. Same as 
-				       cd->gen.i_tracks - 1 */
-  char *psz_keyword, *psz_field, *psz_cue_name_dup;
-  cdio_log_level_t log_level = (NULL == cd) ? CDIO_LOG_INFO : CDIO_LOG_WARN;
-  cdtext_field_t cdtext_key;
+  cue_cdtext_t *p_line;
+
+  if (p_sheet->i_cdtext == p_sheet->i_cdtext_alloc) {
+    unsigned int i_alloc = p_sheet->i_cdtext_alloc
+      ? 2 * p_sheet->i_cdtext_alloc : 16;
+    cue_cdtext_t *p_cdtext =
+      realloc(p_sheet->p_cdtext, i_alloc * sizeof(cue_cdtext_t));
+    if (NULL == p_cdtext) return false;
+    p_sheet->p_cdtext       = p_cdtext;
+    p_sheet->i_cdtext_alloc = i_alloc;
+  }
+  p_line = &(p_sheet->p_cdtext[p_sheet->i_cdtext++]);
+  p_line->key       = key;
+  p_line->i_track   = i_track;
+  p_line->i_line    = i_line;
+  p_line->psz_value = psz_value;
+  return true;
+}
 
-  /* The below declarations may be unique to this image-parse routine. */
-  int start_index;
-  bool b_first_index_for_track=false;
+/*!
+  Return the next token in *pp_next, that is the next run of
+  characters not in psz_delim, and advance *pp_next past it. NULL is
+  returned if there are no more tokens. This is strtok_r(), which is
+  not available everywhere.
+*/
+static char *
+cue_next_token(char **pp_next, const char *psz_delim)
+{
+  char *p_token = *pp_next + strspn(*pp_next, psz_delim);
+  char *p_end;
 
-  if (NULL == psz_cue_name) 
-    return false;
+  if ('\0' == *p_token) {
+    *pp_next = p_token;
+    return NULL;
+  }
+  p_end = p_token + strcspn(p_token, psz_delim);
+  if ('\0' != *p_end) *p_end++ = '\0';
+  *pp_next = p_end;
+  return p_token;
+}
 
-  psz_cue_name_dup = _cdio_strdup_fixpath(psz_cue_name);
-  if (NULL == psz_cue_name_dup) 
-    return false;
+/*!
+  Return the contents of psz_cue_name as a NUL-terminated string, or
+  NULL on error.
+*/
+static char *
+cue_read_file(const char *psz_cue_name, cdio_log_level_t log_level)
+{
+  char *psz_cue_name_dup = _cdio_strdup_fixpath(psz_cue_name);
+  size_t i_size = 0;
+  size_t i_alloc = 8192;
+  char *psz_text;
+  FILE *fp;
+
+  if (NULL == psz_cue_name_dup)
+    return NULL;
 
-  fp = CDIO_FOPEN (psz_cue_name_dup, "r");
+  fp = CDIO_FOPEN (psz_cue_name_dup, "rb");
   free(psz_cue_name_dup);
   if (fp == NULL) {
-    cdio_log(log_level, "error opening %s for reading: %s", 
+    cdio_log(log_level, "error opening %s for reading: %s",
              psz_cue_name, strerror(errno));
-    return false;
+    return NULL;
   }
 
-  if (cd) {
-    cd->gen.i_tracks=0;
-    cd->gen.i_first_track=1;
-    cd->psz_mcn=NULL;
+  /* Size the buffer from the file so that it is normally read in
+     one go. */
+  if (0 == fseek(fp, 0, SEEK_END)) {
+    long int i_file_size = ftell(fp);
+    if (i_file_size > 0) i_alloc = (size_t) i_file_size + 1;
+    rewind(fp);
+  }
+
+  psz_text = malloc(i_alloc);
+  while (NULL != psz_text) {
+    i_size += fread(psz_text + i_size, 1, i_alloc - i_size - 1, fp);
+    if (i_size < i_alloc - 1) break;
+    i_alloc *= 2;
+    {
+      char *psz_bigger = realloc(psz_text, i_alloc);
+      if (NULL == psz_bigger) free(psz_text);
+      psz_text = psz_bigger;
+    }
   }
-  
-  while ((fgets(psz_line, MAXLINE, fp)) != NULL) {
+
+  if (NULL == psz_text) {
+    cdio_log(log_level, "out of memory reading %s", psz_cue_name);
+  } else if (ferror(fp)) {
+    cdio_log(log_level, "error reading %s: %s",
+             psz_cue_name, strerror(errno));
+    free(psz_text);
+    psz_text = NULL;
+  } else
+    psz_text[i_size] = '\0';
+
+  fclose (fp);
+  return psz_text;
+}
+
+/*!
+  Read and parse CUE sheet psz_cue_name. Problems are logged at
+  log_level. NULL is returned if the sheet can't be read or isn't
+  valid; otherwise the caller owns the result and frees it with
+  cue_sheet_free().
+*/
+static cue_sheet_t *
+cue_sheet_parse(const char *psz_cue_name, cdio_log_level_t log_level)
+{
+  cue_sheet_t *p_sheet;
+  char *psz_next_line;           /* what is left of the sheet */
+  char *psz_line;                /* text of current line */
+  unsigned int i_line=0;         /* line number in file of psz_line. */
+  int          i = -1;           /* Position in track. Same as
+                                    p_sheet->i_tracks - 1 */
+  char *psz_keyword, *psz_field;
+  cdtext_field_t cdtext_key;
+  int start_index;
+
+  if (NULL == psz_cue_name)
+    return NULL;
+
+  p_sheet = calloc(1, sizeof(cue_sheet_t));
+  if (NULL == p_sheet)
+    return NULL;
+
+  if (NULL == (p_sheet->psz_text = cue_read_file(psz_cue_name, log_level))) {
+    free(p_sheet);
+    return NULL;
+  }
+
+  psz_next_line = p_sheet->psz_text;
+  while ('\0' != *psz_next_line) {
+    char *psz_rest;                /* what is left of psz_line */
+    char *psz_eol;
+
+    psz_line = psz_next_line;
+    psz_eol  = strchr(psz_line, '\n');
+    if (NULL != psz_eol) {
+      *psz_eol = '\0';
+      psz_next_line = psz_eol + 1;
+    } else
+      psz_next_line = psz_line + strlen(psz_line);
+    psz_rest = psz_line;
 
     i_line++;
 
-    if (NULL != (psz_keyword = strtok (psz_line, " \t\n\r"))) {
+    if (NULL != (psz_keyword = cue_next_token (&psz_rest, " \t\n\r"))) {
       /* REM remarks ... */
       if (0 == strcmp ("REM", psz_keyword)) {
         ;
-        
+
         /* global section */
         /* CATALOG ddddddddddddd */
       } else if (0 == strcmp ("CATALOG", psz_keyword)) {
         if (-1 == i) {
-          if (NULL == (psz_field = strtok (NULL, " \t\n\r"))) {
-            cdio_log(log_level, 
+          if (NULL == (psz_field = cue_next_token (&psz_rest, " \t\n\r"))) {
+            cdio_log(log_level,
                      "%s line %d after word CATALOG: ",
                      psz_cue_name, i_line);
-            cdio_log(log_level, 
+            cdio_log(log_level,
                      "expecting 13-digit media catalog number, got nothing.");
             goto err_exit;
           }
           if (strlen(psz_field) != 13) {
-            cdio_log(log_level, 
+            cdio_log(log_level,
                      "%s line %d after word CATALOG: ",
                      psz_cue_name, i_line);
-            cdio_log(log_level, 
-                       "Token %s has length %ld. Should be 13 digits.", 
+            cdio_log(log_level,
+                       "Token %s has length %ld. Should be 13 digits.",
                      psz_field, (long int) strlen(psz_field));
             goto err_exit;
           } else {
@@ -333,341 +616,111 @@ parse_cuefile (_img_private_t *cd, const char *psz_cue_name)
             unsigned int i;
             for (i=0; i<13; i++) {
               if (!isdigit((unsigned char) psz_field[i])) {
-                cdio_log(log_level, 
-                         "%s line %d after word CATALOG:", 
+                cdio_log(log_level,
+                         "%s line %d after word CATALOG:",
                          psz_cue_name, i_line);
-                cdio_log(log_level, 
+                cdio_log(log_level,
                          "Character \"%c\" at postition %i of token \"%s\" "
-                         "is not all digits.", 
+                         "is not all digits.",
                          psz_field[i], i+1, psz_field);
                 goto err_exit;
               }
             }
           }
-              
-          if (cd) cd->psz_mcn = strdup (psz_field);
-          if (NULL != (psz_field = strtok (NULL, " \t\n\r"))) {
+
+          p_sheet->psz_mcn = psz_field;
+          if (NULL != (psz_field = cue_next_token (&psz_rest, " \t\n\r"))) {
             goto format_error;
           }
         } else {
           goto not_in_global_section;
         }
 
-  /* CDTEXTFILE "<filename>" */
-  } else if (0 == strcmp ("CDTEXTFILE", psz_keyword)) {
-    if(NULL != (psz_field = strtok (NULL, "\"\t\n\r"))) {
-      if (cd) {
-        uint8_t cdt_data[CDTEXT_LEN_BINARY_MAX+4];
-        int size;
-        CdioDataSource_t *source;
-        const char *dirname = cdio_dirname(psz_cue_name);
-        const char *psz_filename = cdio_abspath (dirname, psz_field);
-
-        if(NULL == (source = cdio_stdio_new(psz_filename))) {
-          cdio_log(log_level, "%s line %d: can't open file `%s' for reading", 
-		   psz_cue_name, i_line, psz_field);
-          goto err_exit;
-        }
-        size = cdio_stream_read(source, cdt_data, CDTEXT_LEN_BINARY_MAX, 1);
-
-        if (size < 5) {
-          cdio_log(log_level, 
-		   "%s line %d: file `%s' is too small to contain CD-TEXT",
-                   psz_cue_name, i_line, (char *) psz_filename);
-          goto err_exit;
-        }
-
-        /* Truncate header when it is too large. */
-        if (cdt_data[0] > 0x80) {
-          size -= 4;
-        }
-
-        /* ignore trailing 0 */
-        if (1 == size % 18)
-          size -= 1;
-
-        /* init cdtext */
-        if (NULL == cd->gen.cdtext) {
-          cd->gen.cdtext = cdtext_init ();
+        /* CDTEXTFILE "<filename>" */
+      } else if (0 == strcmp ("CDTEXTFILE", psz_keyword)) {
+        if (NULL != (psz_field = cue_next_token (&psz_rest, "\"\t\n\r"))) {
+          if (!cue_add_cdtext(p_sheet, CDTEXT_FIELD_INVALID, i, i_line,
+                              psz_field)) {
+            cdio_log(log_level, "out of memory reading %s", psz_cue_name);
+            goto err_exit;
+          }
+        } else {
+          goto format_error;
         }
 
-        if(0 != cdtext_data_init(cd->gen.cdtext, cdt_data, size))
-          cdio_log (log_level, "%s line %d: failed to parse CD-TEXT file `%s'", psz_cue_name, i_line, (char *) psz_filename);
-
-        cdio_stdio_destroy (source);
-      }
-    } else {
-      goto format_error;
-    }
-        
         /* FILE "<filename>" <BINARY|WAVE|other?> */
       } else if (0 == strcmp ("FILE", psz_keyword)) {
-        if (NULL != (psz_field = strtok (NULL, "\"\t\n\r"))) {
-          const char *dirname = cdio_dirname(psz_cue_name);
-          const char *filename = cdio_abspath (dirname, psz_field);
-          if (cd) cd->tocent[i + 1].filename = (char *) filename;
+        if (NULL != (psz_field = cue_next_token (&psz_rest, "\"\t\n\r"))) {
+          cue_file_t *p_file;
+          if (p_sheet->i_files >= CDIO_CD_MAX_TRACKS) {
+            cdio_log(log_level, "%s line %d: more than %d files",
+                     psz_cue_name, i_line, CDIO_CD_MAX_TRACKS);
+            goto err_exit;
+          }
+          p_file = &(p_sheet->file[p_sheet->i_files]);
+          p_file->psz_filename = psz_field;
+          p_file->psz_filetype = cue_next_token (&psz_rest, " \t\n\r");
+          p_sheet->i_files++;
         } else {
           goto format_error;
         }
-        
+
         /* TRACK N <mode> */
       } else if (0 == strcmp("TRACK", psz_keyword)) {
         int i_track;
 
-        if (NULL != (psz_field = strtok(NULL, " \t\n\r"))) {
+        if (NULL != (psz_field = cue_next_token(&psz_rest, " \t\n\r"))) {
           if (1!=sscanf(psz_field, "%d", &i_track)) {
-            cdio_log(log_level, 
+            cdio_log(log_level,
                      "%s line %d after word TRACK:",
                      psz_cue_name, i_line);
-            cdio_log(log_level, 
+            cdio_log(log_level,
                      "Expecting a track number, got %s", psz_field);
             goto err_exit;
           }
         }
-        if (NULL != (psz_field = strtok(NULL, " \t\n\r"))) {
-          track_info_t  *this_track=NULL;
-
-          if (cd) {
-            this_track = &(cd->tocent[cd->gen.i_tracks]);
-            this_track->track_num   = cd->gen.i_tracks;
-            this_track->num_indices = 0;
-            b_first_index_for_track = false;
-            cd->gen.i_tracks++;
+        if (NULL != (psz_field = cue_next_token(&psz_rest, " \t\n\r"))) {
+          const cue_track_mode_t *p_mode;
+
+          if (i + 1 >= CDIO_CD_MAX_TRACKS) {
+            cdio_log(log_level, "%s line %d: more than %d tracks",
+                     psz_cue_name, i_line, CDIO_CD_MAX_TRACKS);
+            goto err_exit;
           }
-          i++;
-          
-          if (0 == strcmp("AUDIO", psz_field)) {
-            if (cd) {
-              this_track->mode           = AUDIO;
-              this_track->blocksize      = CDIO_CD_FRAMESIZE_RAW;
-              this_track->datasize       = CDIO_CD_FRAMESIZE_RAW;
-              this_track->datastart      = 0;
-              this_track->endsize        = 0;
-              this_track->track_format   = TRACK_FORMAT_AUDIO;
-              this_track->track_green    = false;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_DA;
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DATA:
-              case CDIO_DISC_MODE_CD_XA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE1/2048", psz_field)) {
-            if (cd) {
-              this_track->mode        = MODE1;
-              this_track->blocksize   = 2048;
-              this_track->track_format= TRACK_FORMAT_DATA;
-              this_track->track_green = false;
-              /* Is the below correct? */
-              this_track->datastart   = 0;         
-              this_track->datasize    = CDIO_CD_FRAMESIZE;
-              this_track->endsize     = 0;  
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_DATA;
-                break;
-              case CDIO_DISC_MODE_CD_DATA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_XA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE1/2352", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2352;
-              this_track->track_format= TRACK_FORMAT_DATA;
-              this_track->track_green = false;
-              this_track->datastart   = CDIO_CD_SYNC_SIZE 
-                + CDIO_CD_HEADER_SIZE;
-              this_track->datasize    = CDIO_CD_FRAMESIZE; 
-              this_track->endsize     = CDIO_CD_EDC_SIZE 
-                + CDIO_CD_M1F1_ZERO_SIZE + CDIO_CD_ECC_SIZE;
-              this_track->mode        = MODE1_RAW; 
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_DATA;
-                break;
-              case CDIO_DISC_MODE_CD_DATA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_XA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE2/2336", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2336;
-              this_track->track_format= TRACK_FORMAT_XA;
-              this_track->track_green = true;
-              this_track->mode        = MODE2;
-              this_track->datastart   = CDIO_CD_SYNC_SIZE 
-                + CDIO_CD_HEADER_SIZE;
-              this_track->datasize    = M2RAW_SECTOR_SIZE;  
-              this_track->endsize     = 0;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_DATA;
-                break;
-              case CDIO_DISC_MODE_CD_DATA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_XA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE2/2048", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2048;
-              this_track->track_format= TRACK_FORMAT_XA;
-              this_track->track_green = true;
-              this_track->mode        = MODE2_FORM1;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_XA;
-                break;
-              case CDIO_DISC_MODE_CD_XA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_DATA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE2/2324", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2324;
-              this_track->track_format= TRACK_FORMAT_XA;
-              this_track->track_green = true;
-              this_track->mode        = MODE2_FORM2;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_XA;
-                break;
-              case CDIO_DISC_MODE_CD_XA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_DATA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE2/2336", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2336;
-              this_track->track_format= TRACK_FORMAT_XA;
-              this_track->track_green = true;
-              this_track->mode        = MODE2_FORM_MIX;
-              this_track->datastart   = CDIO_CD_SYNC_SIZE 
-                + CDIO_CD_HEADER_SIZE;
-              this_track->datasize    = M2RAW_SECTOR_SIZE;  
-              this_track->endsize     = 0;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_XA;
-                break;
-              case CDIO_DISC_MODE_CD_XA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_DATA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else if (0 == strcmp("MODE2/2352", psz_field)) {
-            if (cd) {
-              this_track->blocksize   = 2352;
-              this_track->track_format= TRACK_FORMAT_XA;
-              this_track->track_green = true;
-              this_track->mode        = MODE2_RAW;
-              this_track->datastart   = CDIO_CD_SYNC_SIZE 
-                + CDIO_CD_HEADER_SIZE + CDIO_CD_SUBHEADER_SIZE;
-              this_track->datasize    = CDIO_CD_FRAMESIZE;
-              this_track->endsize     = CDIO_CD_SYNC_SIZE + CDIO_CD_ECC_SIZE;
-              switch(cd->disc_mode) {
-              case CDIO_DISC_MODE_NO_INFO:
-                cd->disc_mode = CDIO_DISC_MODE_CD_XA;
-                break;
-              case CDIO_DISC_MODE_CD_XA:
-              case CDIO_DISC_MODE_CD_MIXED:
-              case CDIO_DISC_MODE_ERROR:
-                /* Disc type stays the same. */
-                break;
-              case CDIO_DISC_MODE_CD_DA:
-              case CDIO_DISC_MODE_CD_DATA:
-                cd->disc_mode = CDIO_DISC_MODE_CD_MIXED;
-                break;
-              default:
-                cd->disc_mode = CDIO_DISC_MODE_ERROR;
-              }
-            }
-          } else {
-            cdio_log(log_level, 
+
+          for (p_mode = cue_track_modes; NULL != p_mode->psz_name; p_mode++)
+            if (0 == strcmp(p_mode->psz_name, psz_field)) break;
+
+          if (NULL == p_mode->psz_name) {
+            cdio_log(log_level,
                      "%s line %d after word TRACK:",
                      psz_cue_name, i_line);
-            cdio_log(log_level, 
+            cdio_log(log_level,
                      "Unknown track mode %s", psz_field);
             goto err_exit;
           }
+
+          i++;
+          p_sheet->i_tracks++;
+          p_sheet->track[i].p_mode        = p_mode;
+          p_sheet->track[i].i_file        = p_sheet->i_files - 1;
+          p_sheet->track[i].i_pregap_file = p_sheet->i_files - 1;
         } else {
           goto format_error;
         }
-        
+
         /* FLAGS flag1 flag2 ... */
       } else if (0 == strcmp("FLAGS", psz_keyword)) {
         if (0 <= i) {
-          while (NULL != (psz_field = strtok (NULL, " \t\n\r"))) {
+          while (NULL != (psz_field = cue_next_token (&psz_rest, " \t\n\r"))) {
             if (0 == strcmp ("PRE", psz_field)) {
-              if (cd) cd->tocent[i].flags |= PRE_EMPHASIS;
+              p_sheet->track[i].flags |= PRE_EMPHASIS;
             } else if (0 == strcmp ("DCP", psz_field)) {
-              if (cd) cd->tocent[i].flags |= COPY_PERMITTED;
+              p_sheet->track[i].flags |= COPY_PERMITTED;
             } else if (0 == strcmp ("4CH", psz_field)) {
-              if (cd) cd->tocent[i].flags |= FOUR_CHANNEL_AUDIO;
+              p_sheet->track[i].flags |= FOUR_CHANNEL_AUDIO;
             } else if (0 == strcmp ("SCMS", psz_field)) {
-              if (cd) cd->tocent[i].flags |= SCMS;
+              p_sheet->track[i].flags |= SCMS;
             } else {
               goto format_error;
             }
@@ -675,199 +728,445 @@ parse_cuefile (_img_private_t *cd, const char *psz_cue_name)
         } else {
           goto format_error;
         }
-        
+
         /* ISRC CCOOOYYSSSSS */
       } else if (0 == strcmp("ISRC", psz_keyword)) {
         if (0 <= i) {
-          if (NULL != (psz_field = strtok (NULL, " \t\n\r"))) {
-            if (cd) cd->tocent[i].isrc = strdup (psz_field);
+          if (NULL != (psz_field = cue_next_token (&psz_rest, " \t\n\r"))) {
+            p_sheet->track[i].psz_isrc = psz_field;
           } else {
             goto format_error;
           }
         } else {
           goto in_global_section;
         }
-        
+
         /* PREGAP MM:SS:FF */
       } else if (0 == strcmp("PREGAP", psz_keyword)) {
         if (0 <= i) {
-          if (NULL != (psz_field = strtok(NULL, " \t\n\r"))) {
+          if (NULL != (psz_field = cue_next_token(&psz_rest, " \t\n\r"))) {
             lba_t lba = cdio_lsn_to_lba(cdio_mmssff_to_lba (psz_field));
             if (CDIO_INVALID_LBA == lba) {
-              cdio_log(log_level, "%s line %d: after word PREGAP:", 
+              cdio_log(log_level, "%s line %d: after word PREGAP:",
                        psz_cue_name, i_line);
-              cdio_log(log_level, "Invalid MSF string %s", 
+              cdio_log(log_level, "Invalid MSF string %s",
                        psz_field);
               goto err_exit;
             }
-            if (cd) {
-              cd->tocent[i].silence = lba;
-            }
+            p_sheet->track[i].silence = lba;
           } else {
             goto format_error;
-          } if (NULL != (psz_field = strtok(NULL, " \t\n\r"))) {
+          } if (NULL != (psz_field = cue_next_token(&psz_rest, " \t\n\r"))) {
             goto format_error;
           }
         } else {
           goto in_global_section;
         }
-        
+
         /* INDEX [##] MM:SS:FF */
       } else if (0 == strcmp ("INDEX", psz_keyword)) {
         if (0 <= i) {
-          if (NULL != (psz_field = strtok(NULL, " \t\n\r")))
-            if (1!=sscanf(psz_field, "%d", &start_index)) {
-              cdio_log(log_level, 
-                       "%s line %d after word INDEX:",
-                       psz_cue_name, i_line);
-              cdio_log(log_level, 
-                       "expecting an index number, got %s", 
-                       psz_field);
-              goto err_exit;
-            }
-          if (NULL != (psz_field = strtok(NULL, " \t\n\r"))) {
+          if (NULL == (psz_field = cue_next_token(&psz_rest, " \t\n\r")))
+            goto format_error;
+          if (1!=sscanf(psz_field, "%d", &start_index)) {
+            cdio_log(log_level,
+                     "%s line %d after word INDEX:",
+                     psz_cue_name, i_line);
+            cdio_log(log_level,
+                     "expecting an index number, got %s",
+                     psz_field);
+            goto err_exit;
+          }
+          if (NULL != (psz_field = cue_next_token(&psz_rest, " \t\n\r"))) {
+            cue_track_t *p_track = &(p_sheet->track[i]);
             lba_t lba = cdio_mmssff_to_lba (psz_field);
             if (CDIO_INVALID_LBA == lba) {
-              cdio_log(log_level, "%s line %d: after word INDEX:", 
+              cdio_log(log_level, "%s line %d: after word INDEX:",
                        psz_cue_name, i_line);
-              cdio_log(log_level, "Invalid MSF string %s", 
+              cdio_log(log_level, "Invalid MSF string %s",
                        psz_field);
               goto err_exit;
             }
-            if (cd) {
-#if FIXED_ME
-              cd->tocent[i].indexes[cd->tocent[i].nindex++] = lba;
-#else     
-              track_info_t  *this_track=
-                &(cd->tocent[cd->gen.i_tracks - cd->gen.i_first_track]);
-
-              switch (start_index) {
-
-              case 0:
-                lba += CDIO_PREGAP_SECTORS;
-                this_track->pregap = lba;
-                break;
-
-              case 1:
-                if (!b_first_index_for_track) {
-                  lba += CDIO_PREGAP_SECTORS;
-                  cdio_lba_to_msf(lba, &(this_track->start_msf));
-                  b_first_index_for_track = true;
-                  this_track->start_lba   = lba;
-                }
-                
-                if (cd->gen.i_tracks > 1) {
-                  /* Figure out number of sectors for previous track */
-                  track_info_t *prev_track=&(cd->tocent[cd->gen.i_tracks-2]);
-                  if ( this_track->start_lba < prev_track->start_lba ) {
-                    cdio_log (log_level,
-                              "track %d at LBA %lu starts before track %d at LBA %lu", 
-                              cd->gen.i_tracks,   
-                              (unsigned long int) this_track->start_lba, 
-                              cd->gen.i_tracks, 
-                              (unsigned long int) prev_track->start_lba);
-                    prev_track->sec_count = 0;
-                  } else if ( this_track->start_lba >= prev_track->start_lba 
-                              + CDIO_PREGAP_SECTORS ) {
-                    prev_track->sec_count = this_track->start_lba - 
-                      prev_track->start_lba - CDIO_PREGAP_SECTORS ;
-                  } else {
-                    cdio_log (log_level, 
-                              "%lu fewer than pregap (%d) sectors in track %d",
-                              (long unsigned int) 
-                              this_track->start_lba - prev_track->start_lba,
-                              CDIO_PREGAP_SECTORS,
-                              cd->gen.i_tracks);
-                    /* Include pregap portion in sec_count. Maybe the pregap
-                       was omitted. */
-                    prev_track->sec_count = this_track->start_lba - 
-                      prev_track->start_lba;
-                  }
-                }
-                this_track->num_indices++;
-                break;
-
-              default:
-                break;
+
+            switch (start_index) {
+
+            case 0:
+              p_track->pregap        = lba + CDIO_PREGAP_SECTORS;
+              p_track->i_pregap_file = p_sheet->i_files - 1;
+              break;
+
+            case 1:
+              if (0 == p_track->num_indices) {
+                p_track->start_lba = lba + CDIO_PREGAP_SECTORS;
+                p_track->i_file    = p_sheet->i_files - 1;
               }
+              p_track->num_indices++;
+              break;
+
+            default:
+              break;
             }
-#endif  
           } else {
             goto format_error;
           }
         } else {
           goto in_global_section;
         }
-        
+
         /* CD-Text */
-      } else if ( CDTEXT_FIELD_INVALID != 
+      } else if ( CDTEXT_FIELD_INVALID !=
                   (cdtext_key = cdtext_is_field (psz_keyword)) ) {
-        if (cd) {
-          if (NULL == cd->gen.cdtext) {
-            cd->gen.cdtext = cdtext_init ();
-            cd->gen.cdtext->block[cd->gen.cdtext->block_i].language_code = CDTEXT_LANGUAGE_ENGLISH;
-          }
-          cdtext_set (cd->gen.cdtext, cdtext_key, (uint8_t*) strtok(NULL, "\"\t\n\r"), 
-                      (-1 == i ? 0 : cd->gen.i_first_track + i),
-                      "ISO-8859-1");
-        } 
-        
+        psz_field = cue_next_token(&psz_rest, "\"\t\n\r");
+        if (!cue_add_cdtext(p_sheet, cdtext_key, i, i_line, psz_field)) {
+          cdio_log(log_level, "out of memory reading %s", psz_cue_name);
+          goto err_exit;
+        }
+
         /* unrecognized line */
       } else {
-        cdio_log(log_level, "%s line %d: warning: unrecognized keyword: %s", 
+        cdio_log(log_level, "%s line %d: warning: unrecognized keyword: %s",
                  psz_cue_name, i_line, psz_keyword);
         goto err_exit;
       }
     }
   }
 
-  if (NULL != cd) {
-    cd->gen.toc_init = true;
-  }
-
-  fclose (fp);
-  return true;
+  return p_sheet;
 
  format_error:
-  cdio_log(log_level, "%s line %d after word %s", 
+  cdio_log(log_level, "%s line %d after word %s",
            psz_cue_name, i_line, psz_keyword);
   goto err_exit;
 
  in_global_section:
-  cdio_log(log_level, "%s line %d: word %s not allowed in global section", 
+  cdio_log(log_level, "%s line %d: word %s not allowed in global section",
            psz_cue_name, i_line, psz_keyword);
   goto err_exit;
 
  not_in_global_section:
-  cdio_log(log_level, "%s line %d: word %s only allowed in global section", 
+  cdio_log(log_level, "%s line %d: word %s only allowed in global section",
            psz_cue_name, i_line, psz_keyword);
 
- err_exit: 
-  fclose (fp);
-  return false;
+ err_exit:
+  cue_sheet_free(p_sheet);
+  return NULL;
+}
 
+/*!
+  Return what the disc mode becomes when a track whose mode, on its
+  own, makes a disc of track_disc_mode is added to a disc of
+  disc_mode.
+*/
+static discmode_t
+cue_add_disc_mode(discmode_t disc_mode, discmode_t track_disc_mode)
+{
+  switch(disc_mode) {
+  case CDIO_DISC_MODE_NO_INFO:
+    return track_disc_mode;
+  case CDIO_DISC_MODE_CD_MIXED:
+  case CDIO_DISC_MODE_ERROR:
+    /* Disc type stays the same. */
+    return disc_mode;
+  case CDIO_DISC_MODE_CD_DA:
+  case CDIO_DISC_MODE_CD_DATA:
+  case CDIO_DISC_MODE_CD_XA:
+    return (disc_mode == track_disc_mode)
+      ? disc_mode : CDIO_DISC_MODE_CD_MIXED;
+  default:
+    return CDIO_DISC_MODE_ERROR;
+  }
+}
+
+/*!
+  Read a CD-TEXT file named in a CUE sheet into cd's CD-Text.
+*/
+static bool
+cue_read_cdtext_file(_img_private_t *cd, const char *psz_cue_name,
+                     const char *psz_dirname, const cue_cdtext_t *p_line)
+{
+  uint8_t cdt_data[CDTEXT_LEN_BINARY_MAX+4];
+  int size;
+  CdioDataSource_t *source;
+  char *psz_filename = (char *) cdio_abspath (psz_dirname, p_line->psz_value);
+  bool b_ok = false;
+
+  if(NULL == (source = cdio_stdio_new(psz_filename))) {
+    cdio_warn("%s line %d: can't open file `%s' for reading",
+              psz_cue_name, p_line->i_line, p_line->psz_value);
+    goto out;
+  }
+  size = cdio_stream_read(source, cdt_data, CDTEXT_LEN_BINARY_MAX, 1);
+
+  if (size < 5) {
+    cdio_warn("%s line %d: file `%s' is too small to contain CD-TEXT",
+              psz_cue_name, p_line->i_line, psz_filename);
+    cdio_stdio_destroy (source);
+    goto out;
+  }
+
+  /* Truncate header when it is too large. */
+  if (cdt_data[0] > 0x80) {
+    size -= 4;
+  }
+
+  /* ignore trailing 0 */
+  if (1 == size % 18)
+    size -= 1;
+
+  /* init cdtext */
+  if (NULL == cd->gen.cdtext) {
+    cd->gen.cdtext = cdtext_init ();
+  }
+
+  if(0 != cdtext_data_init(cd->gen.cdtext, cdt_data, size))
+    cdio_warn ("%s line %d: failed to parse CD-TEXT file `%s'",
+               psz_cue_name, p_line->i_line, psz_filename);
+
+  cdio_stdio_destroy (source);
+  b_ok = true;
+
+ out:
+  free(psz_filename);
+  return b_ok;
+}
+
+/*!
+  Find the samples in WAVE file p_file. Their byte offset is put in
+  p_file->offset and their size in bytes is returned, or -1 if this
+  isn't a WAVE file holding CD audio.
+*/
+static off_t
+cue_wave_data(image_file_t *p_file)
+{
+  CdioDataSource_t *p_source = p_file->data_source;
+  const off_t i_size = cdio_stream_stat(p_source);
+  uint8_t buf[16];
+  off_t i_pos = 12;
+
+  if (cdio_stream_seek(p_source, 0, SEEK_SET)
+      || 12 != cdio_stream_read(p_source, buf, 12, 1)
+      || memcmp(buf, "RIFF", 4) || memcmp(buf + 8, "WAVE", 4))
+    return -1;
+
+  /* Walk the chunks up to "data", checking "fmt " on the way. */
+  while (i_pos + 8 <= i_size) {
+    uint32_t i_len;
+
+    if (cdio_stream_seek(p_source, i_pos, SEEK_SET)
+        || 8 != cdio_stream_read(p_source, buf, 8, 1))
+      return -1;
+    i_len = buf[4] | (buf[5] << 8) | (buf[6] << 16) | ((uint32_t) buf[7] << 24);
+    i_pos += 8;
+
+    if (0 == memcmp(buf, "fmt ", 4)) {
+      /* 16-bit stereo PCM at 44.1 kHz */
+      if (i_len < 16 || 16 != cdio_stream_read(p_source, buf, 16, 1)
+          || 1 != (buf[0] | (buf[1] << 8)) || 2 != (buf[2] | (buf[3] << 8))
+          || 44100 != (buf[4] | (buf[5] << 8) | (buf[6] << 16))
+          || 16 != (buf[14] | (buf[15] << 8)))
+        return -1;
+    } else if (0 == memcmp(buf, "data", 4)) {
+      p_file->offset = i_pos;
+      return (i_len < i_size - i_pos) ? i_len : i_size - i_pos;
+    }
+    i_pos += i_len + (i_len & 1);
+  }
+  return -1;
+}
+
+/*!
+  Set up the next entry of cd->p_files for FILE p_cue_file of the
+  sheet, or for the BIN file named after the CUE file if p_cue_file
+  is NULL. If b_use_bin is set, that BIN file is tried first, as it
+  always was when a sheet only names one file.
+
+  The file is opened just long enough to find its size; it is opened
+  again on the first read.
+*/
+static bool
+cue_add_file(_img_private_t *cd, const cue_file_t *p_cue_file,
+             const char *psz_dirname, bool b_use_bin)
+{
+  image_file_t *p_file = &(cd->p_files[cd->i_files]);
+  const char *psz_filetype = p_cue_file ? p_cue_file->psz_filetype : NULL;
+  off_t i_size;
+
+  if (b_use_bin || NULL == p_cue_file) {
+    p_file->data_source = _cdio_image_source_new (cd, cd->gen.source_name);
+    if (p_file->data_source)
+      p_file->psz_filename = strdup (cd->gen.source_name);
+  }
+  if (NULL == p_file->data_source && p_cue_file) {
+    p_file->psz_filename =
+      (char *) cdio_abspath (psz_dirname, p_cue_file->psz_filename);
+    if (NULL == (p_file->data_source =
+                 _cdio_image_source_new (cd, p_file->psz_filename)))
+      free_if_notnull (p_file->psz_filename);
+  }
+  if (NULL == p_file->data_source) {
+    cdio_warn ("init failed");
+    return false;
+  }
+
+  if (cd->i_files > 0)
+    p_file->start_lsn = p_file[-1].start_lsn + p_file[-1].i_sectors;
+  cd->i_files++;
+
+  if (psz_filetype && 0 == strcmp ("WAVE", psz_filetype)) {
+    if (-1 == (i_size = cue_wave_data (p_file))) {
+      cdio_warn ("%s is not a 16-bit stereo 44.1 kHz WAVE file",
+                 p_file->psz_filename);
+      return false;
+    }
+  } else {
+    if (psz_filetype && 0 != strcmp ("BINARY", psz_filetype))
+      cdio_warn ("%s: FILE type %s is not supported; reading it as BINARY",
+                 p_file->psz_filename, psz_filetype);
+    i_size = cdio_stream_stat (p_file->data_source);
+  }
+
+  if (i_size % CDIO_CD_FRAMESIZE_RAW)
+    {
+      cdio_warn ("image %s size (%" PRId64 ") not multiple of blocksize (%d)",
+                 p_file->psz_filename, (int64_t)i_size, CDIO_CD_FRAMESIZE_RAW);
+      if (i_size % M2RAW_SECTOR_SIZE == 0)
+        cdio_warn ("this may be a 2336-type disc image");
+      else if (i_size % CDIO_CD_FRAMESIZE_RAW == 0)
+        cdio_warn ("this may be a 2352-type disc image");
+      /* exit (EXIT_FAILURE); */
+    }
+
+  p_file->i_sectors = (lsn_t) (i_size / CDIO_CD_FRAMESIZE_RAW);
+  cdio_stream_close (p_file->data_source);
+  return true;
 }
 
 /*!
-   Reads a single audio sector from CD device into data starting
+  Fill in the track table, MCN, disc mode and CD-Text of cd from
+  p_sheet, which was parsed from cd->psz_cue_name.
+*/
+static bool
+cue_sheet_apply(_img_private_t *cd, const cue_sheet_t *p_sheet)
+{
+  const char *psz_cue_name = cd->psz_cue_name;
+  char *psz_dirname = (char *) cdio_dirname(psz_cue_name);
+  unsigned int i_cdtext;
+  int i;
+
+  cd->gen.i_tracks=0;
+  cd->gen.i_first_track=1;
+  cd->psz_mcn = p_sheet->psz_mcn ? strdup (p_sheet->psz_mcn) : NULL;
+
+  /* Files come one after the other on the disc. */
+  cd->p_files = calloc (p_sheet->i_files ? p_sheet->i_files : 1,
+                        sizeof (image_file_t));
+  cd->i_files = 0;
+  if (0 == p_sheet->i_files) {
+    if (!cue_add_file (cd, NULL, psz_dirname, true)) goto err_exit;
+  } else {
+    for (i=0; i<p_sheet->i_files; i++)
+      if (!cue_add_file (cd, &(p_sheet->file[i]), psz_dirname,
+                         1 == p_sheet->i_files))
+        goto err_exit;
+  }
+
+  for (i=0; i<p_sheet->i_tracks; i++) {
+    const cue_track_t *p_track = &(p_sheet->track[i]);
+    const cue_track_mode_t *p_mode = p_track->p_mode;
+    track_info_t *this_track = &(cd->tocent[i]);
+    const image_file_t *p_pregap_file =
+      &(cd->p_files[p_track->i_pregap_file < 0 ? 0 : p_track->i_pregap_file]);
+
+    this_track->p_file = &(cd->p_files[p_track->i_file < 0 ? 0 : p_track->i_file]);
+    this_track->filename = strdup (this_track->p_file->psz_filename);
+    if (p_track->psz_isrc)
+      this_track->isrc = strdup (p_track->psz_isrc);
+
+    this_track->track_num    = i;
+    this_track->num_indices  = p_track->num_indices;
+    this_track->flags       |= p_track->flags;
+    this_track->silence      = p_track->silence;
+    this_track->mode         = p_mode->mode;
+    this_track->blocksize    = p_mode->blocksize;
+    this_track->datastart    = p_mode->datastart;
+    this_track->datasize     = p_mode->datasize;
+    this_track->endsize      = p_mode->endsize;
+    this_track->track_format = p_mode->track_format;
+    this_track->track_green  = p_mode->track_green;
+    cd->disc_mode = cue_add_disc_mode(cd->disc_mode, p_mode->disc_mode);
+    cd->gen.i_tracks++;
+
+    if (p_track->pregap)
+      this_track->pregap     = p_track->pregap + p_pregap_file->start_lsn;
+
+    if (0 == p_track->num_indices) continue;
+
+    this_track->start_lba = p_track->start_lba + this_track->p_file->start_lsn;
+    cdio_lba_to_msf(this_track->start_lba, &(this_track->start_msf));
+
+    if (i > 0) {
+      /* Figure out number of sectors for previous track */
+      track_info_t *prev_track=&(cd->tocent[i-1]);
+      if ( this_track->start_lba < prev_track->start_lba ) {
+        cdio_warn ("track %d at LBA %lu starts before track %d at LBA %lu",
+                   i+1, (unsigned long int) this_track->start_lba,
+                   i, (unsigned long int) prev_track->start_lba);
+        prev_track->sec_count = 0;
+      } else if ( this_track->start_lba >= prev_track->start_lba
+                  + CDIO_PREGAP_SECTORS ) {
+        prev_track->sec_count = this_track->start_lba -
+          prev_track->start_lba - CDIO_PREGAP_SECTORS ;
+      } else {
+        cdio_warn ("%lu fewer than pregap (%d) sectors in track %d",
+                   (long unsigned int)
+                   this_track->start_lba - prev_track->start_lba,
+                   CDIO_PREGAP_SECTORS, i+1);
+        /* Include pregap portion in sec_count. Maybe the pregap
+           was omitted. */
+        prev_track->sec_count = this_track->start_lba -
+          prev_track->start_lba;
+      }
+    }
+  }
+
+  for (i_cdtext=0; i_cdtext<p_sheet->i_cdtext; i_cdtext++) {
+    const cue_cdtext_t *p_line = &(p_sheet->p_cdtext[i_cdtext]);
+
+    if (CDTEXT_FIELD_INVALID == p_line->key) {
+      if (!cue_read_cdtext_file(cd, psz_cue_name, psz_dirname, p_line))
+        goto err_exit;
+      continue;
+    }
+
+    if (NULL == cd->gen.cdtext) {
+      cd->gen.cdtext = cdtext_init ();
+      cd->gen.cdtext->block[cd->gen.cdtext->block_i].language_code =
+        CDTEXT_LANGUAGE_ENGLISH;
+    }
+    cdtext_set (cd->gen.cdtext, p_line->key, (uint8_t*) p_line->psz_value,
+                (-1 == p_line->i_track
+                 ? 0 : cd->gen.i_first_track + p_line->i_track),
+                "ISO-8859-1");
+  }
+
+  free(psz_dirname);
+  cd->gen.toc_init = true;
+  return true;
+
+ err_exit:
+  free(psz_dirname);
+  return false;
+}
+
+/*!
+   Reads nblocks audio sectors from CD device into data starting
    from lsn. Returns 0 if no error. 
  */
 static driver_return_code_t
 _read_audio_sectors_bincue (void *p_user_data, void *data, lsn_t lsn, 
                           unsigned int nblocks)
 {
-  _img_private_t *p_env = p_user_data;
-  int ret;
-
-  ret = cdio_stream_seek (p_env->gen.data_source, 
-            lsn * CDIO_CD_FRAMESIZE_RAW, SEEK_SET);
-  if (ret!=0) return ret;
-
-  ret = cdio_stream_read (p_env->gen.data_source, data, 
-            CDIO_CD_FRAMESIZE_RAW, nblocks);
-
-  /* ret is number of bytes if okay, but we need to return 0 okay. */
-  return ret == 0;
+  return read_raw_sectors_bincue (p_user_data, data, lsn, nblocks);
 }
 
 /*!
@@ -881,14 +1180,12 @@ _read_mode1_sector_bincue (void *p_user_data, void *data, lsn_t lsn,
   _img_private_t *p_env = p_user_data;
   int ret;
   char buf[CDIO_CD_FRAMESIZE_RAW] = { 0, };
-  int blocksize = CDIO_CD_FRAMESIZE_RAW;
-
-  ret = cdio_stream_seek (p_env->gen.data_source, lsn * blocksize, SEEK_SET);
-  if (ret!=0) return ret;
 
   /* FIXME: Not completely sure the below is correct. */
-  ret = cdio_stream_read (p_env->gen.data_source, buf, CDIO_CD_FRAMESIZE_RAW, 1);
-  if (ret==0) return ret;
+  ret = read_raw_sectors_bincue (p_env, buf, lsn, 1);
+  if (ret!=0) return ret;
+  ret = _cdio_image_check_sector (p_env, (uint8_t *) buf, lsn);
+  if (ret!=0) return ret;
 
   memcpy (data, buf + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE, 
           b_form2 ? M2RAW_SECTOR_SIZE: CDIO_CD_FRAMESIZE);
@@ -937,14 +1234,10 @@ _read_mode2_sector_bincue (void *p_user_data, void *data, lsn_t lsn,
      Review this sector 2336 stuff later.
   */
 
-  int blocksize = CDIO_CD_FRAMESIZE_RAW;
-
-  ret = cdio_stream_seek (p_env->gen.data_source, lsn * blocksize, SEEK_SET);
+  ret = read_raw_sectors_bincue (p_env, buf, lsn, 1);
+  if (ret!=0) return ret;
+  ret = _cdio_image_check_sector (p_env, (uint8_t *) buf, lsn);
   if (ret!=0) return ret;
-
-  ret = cdio_stream_read (p_env->gen.data_source, buf, CDIO_CD_FRAMESIZE_RAW, 1);
-  if (ret==0) return ret;
-
 
   /* See NOTE above. */
   if (b_form2)
@@ -1129,16 +1422,18 @@ _get_lba_track_bincue(void *p_user_data, track_t i_track)
     return CDIO_INVALID_LBA;
 }
 
-/*! 
+/*!
   Return corresponding BIN file if psz_cue_name is a cue file or NULL
-  if not a CUE file.
+  if not a CUE file. If pp_sheet is not NULL, the parsed sheet is
+  handed back in it when psz_cue_name is a CUE file.
 */
-char *
-cdio_is_cuefile(const char *psz_cue_name) 
+static char *
+is_cuefile(const char *psz_cue_name, /*out*/ cue_sheet_t **pp_sheet)
 {
   int   i;
   char *psz_bin_name;
-  
+  cue_sheet_t *p_sheet;
+
   if (psz_cue_name == NULL) return NULL;
 
   /* FIXME? Now that we have cue parsing, should we really force
@@ -1152,18 +1447,20 @@ cdio_is_cuefile(const char *psz_cue_name)
   if (i>0) {
     if (psz_cue_name[i]=='c' && psz_cue_name[i+1]=='u' && psz_cue_name[i+2]=='e') {
       psz_bin_name[i++]='b'; psz_bin_name[i++]='i'; psz_bin_name[i++]='n';
-      if (parse_cuefile(NULL, psz_cue_name))
-        return psz_bin_name;
-      else 
-        goto error;
     } 
     else if (psz_cue_name[i]=='C' && psz_cue_name[i+1]=='U' && psz_cue_name[i+2]=='E') {
       psz_bin_name[i++]='B'; psz_bin_name[i++]='I'; psz_bin_name[i++]='N';
-      if (parse_cuefile(NULL, psz_cue_name))
-        return psz_bin_name;
-      else 
-        goto error;
     }
+    else
+      goto error;
+
+    if (NULL == (p_sheet = cue_sheet_parse(psz_cue_name, CDIO_LOG_INFO)))
+      goto error;
+    if (pp_sheet)
+      *pp_sheet = p_sheet;
+    else
+      cue_sheet_free(p_sheet);
+    return psz_bin_name;
   }
  error:
   free(psz_bin_name);
@@ -1171,6 +1468,16 @@ cdio_is_cuefile(const char *psz_cue_name)
 }
 
 /*! 
+  Return corresponding BIN file if psz_cue_name is a cue file or NULL
+  if not a CUE file.
+*/
+char *
+cdio_is_cuefile(const char *psz_cue_name)
+{
+  return is_cuefile(psz_cue_name, NULL);
+}
+
+/*!
   Return corresponding CUE file if psz_bin_name is a bin file or NULL
   if not a BIN file.
 */
@@ -1207,39 +1514,21 @@ cdio_is_binfile(const char *psz_bin_name)
 CdIo_t *
 cdio_open_am_bincue (const char *psz_source_name, const char *psz_access_mode)
 {
-  if (psz_access_mode != NULL)
-    cdio_warn ("there is only one access mode for bincue. Arg %s ignored",
-               psz_access_mode);
-  return cdio_open_bincue(psz_source_name);
+  return open_bincue(psz_source_name, psz_access_mode);
 }
 
 /*!
-  Initialization routine. This is the only thing that doesn't
-  get called via a function pointer. In fact *we* are the
-  ones to set that up.
+  Open CUE file psz_cue_name, whose BIN file is psz_bin_name and
+  whose parsed contents are p_sheet, with access mode psz_access_mode.
+  psz_bin_name and p_sheet are freed.
  */
-CdIo_t *
-cdio_open_bincue (const char *psz_source)
-{
-  char *psz_bin_name = cdio_is_cuefile(psz_source);
-
-  if (NULL != psz_bin_name) {
-    free(psz_bin_name);
-    return cdio_open_cue(psz_source);
-  } else {
-    char *psz_cue_name = cdio_is_binfile(psz_source);
-    CdIo_t *cdio = cdio_open_cue(psz_cue_name);
-    free(psz_cue_name);
-    return cdio;
-  }
-}
-
-CdIo_t *
-cdio_open_cue (const char *psz_cue_name)
+static CdIo_t *
+open_cue (const char *psz_cue_name, char *psz_bin_name, cue_sheet_t *p_sheet,
+          const char *psz_access_mode)
 {
   CdIo_t *ret;
   _img_private_t *p_data;
-  char *psz_bin_name;
+  bool b_ok;
   
   cdio_funcs_t _funcs;
 
@@ -1282,8 +1571,6 @@ cdio_open_cue (const char *psz_cue_name)
   _funcs.set_speed             = cdio_generic_unimplemented_set_speed;
   _funcs.set_blocksize         = cdio_generic_unimplemented_set_blocksize;
   
-  if (NULL == psz_cue_name) return NULL;
-  
   p_data                 = calloc(1, sizeof (_img_private_t));
   p_data->gen.init       = false;
   p_data->psz_cue_name   = NULL;
@@ -1292,23 +1579,22 @@ cdio_open_cue (const char *psz_cue_name)
   
   if (ret == NULL) {
     free(p_data);
+    free(psz_bin_name);
+    cue_sheet_free(p_sheet);
     return NULL;
   }
   
   ret->driver_id = DRIVER_BINCUE;
-  psz_bin_name = cdio_is_cuefile(psz_cue_name);
-  
-  if (NULL == psz_bin_name) {
-    cdio_error ("source name %s is not recognized as a CUE file", 
-                psz_cue_name);
-  }
   
   _set_arg_image (p_data, "cue", psz_cue_name);
   _set_arg_image (p_data, "source", psz_bin_name);
   _set_arg_image (p_data, "access-mode", "bincue");
+  _cdio_image_set_access_mode (p_data, "bincue", psz_access_mode);
   free(psz_bin_name);
   
-  if (_init_bincue(p_data)) {
+  b_ok = _init_bincue(p_data, p_sheet);
+  cue_sheet_free(p_sheet);
+  if (b_ok) {
     return ret;
   } else {
     _free_image(p_data);
@@ -1317,6 +1603,57 @@ cdio_open_cue (const char *psz_cue_name)
   }
 }
 
+static CdIo_t *
+open_cue_am (const char *psz_cue_name, const char *psz_access_mode)
+{
+  cue_sheet_t *p_sheet = NULL;
+  char *psz_bin_name;
+
+  if (NULL == psz_cue_name) return NULL;
+
+  psz_bin_name = is_cuefile(psz_cue_name, &p_sheet);
+  if (NULL == psz_bin_name) {
+    cdio_error ("source name %s is not recognized as a CUE file",
+                psz_cue_name);
+    return NULL;
+  }
+
+  return open_cue(psz_cue_name, psz_bin_name, p_sheet, psz_access_mode);
+}
+
+static CdIo_t *
+open_bincue (const char *psz_source, const char *psz_access_mode)
+{
+  cue_sheet_t *p_sheet = NULL;
+  char *psz_bin_name = is_cuefile(psz_source, &p_sheet);
+
+  if (NULL != psz_bin_name) {
+    return open_cue(psz_source, psz_bin_name, p_sheet, psz_access_mode);
+  } else {
+    char *psz_cue_name = cdio_is_binfile(psz_source);
+    CdIo_t *cdio = open_cue_am(psz_cue_name, psz_access_mode);
+    free(psz_cue_name);
+    return cdio;
+  }
+}
+
+/*!
+  Initialization routine. This is the only thing that doesn't
+  get called via a function pointer. In fact *we* are the
+  ones to set that up.
+ */
+CdIo_t *
+cdio_open_bincue (const char *psz_source)
+{
+  return open_bincue(psz_source, NULL);
+}
+
+CdIo_t *
+cdio_open_cue (const char *psz_cue_name)
+{
+  return open_cue_am(psz_cue_name, NULL);
+}
+
 bool
 cdio_have_bincue (void)
 {
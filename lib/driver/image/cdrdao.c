@@ -69,17 +69,13 @@
 #define DEFAULT_CDIO_DEVICE "videocd.bin"
 #define DEFAULT_CDIO_CDRDAO "videocd.toc"
 
-#ifdef _WIN32
-#define CDIO_FOPEN fopen_utf8
-#else
-#define CDIO_FOPEN fopen
-#endif
-
 #include "image_common.h"
 #include "cdtext_private.h"
 
 static lsn_t get_disc_last_lsn_cdrdao (void *p_user_data);
 static bool parse_tocfile (_img_private_t *cd, const char *p_toc_name);
+static CdIo_t *open_cdrdao (const char *psz_cue_name,
+                            const char *psz_access_mode);
 
 
 static bool
@@ -101,6 +97,27 @@ check_track_is_blocksize_multiple(const char *psz_fname,
   return true;
 }
 
+/*!
+  Point track i of cd at psz_field, a FILE or DATAFILE name relative
+  to the directory of the TOC file. Tracks in the same file share its
+  data source. Return false if the file can't be opened.
+ */
+static bool
+set_track_file(_img_private_t *cd, int i, const char *psz_toc_name,
+	       const char *psz_field)
+{
+  char *psz_dirname = (char *) cdio_dirname(psz_toc_name);
+  char *psz_filename = (char *) cdio_abspath(psz_dirname, psz_field);
+  image_file_t *p_file = _cdio_image_file_get(cd, psz_filename);
+
+  free(psz_dirname);
+  free_if_notnull(cd->tocent[i].filename);
+  cd->tocent[i].filename    = psz_filename;
+  cd->tocent[i].p_file      = p_file;
+  cd->tocent[i].data_source = p_file ? p_file->data_source : NULL;
+  return NULL != p_file;
+}
+
 
 /*!
   Initialize image structures.
@@ -697,11 +714,7 @@ parse_tocfile (_img_private_t *cd, const char *psz_cue_name)
 	  if (NULL != (psz_field = strtok (NULL, "\"\t\n\r"))) {
 	    /* Handle "<filename>" */
 	    if (cd) {
-	      const char *dirname = cdio_dirname(psz_cue_name);
-	      const char *filename = cdio_abspath (dirname, psz_field);
-	      cd->tocent[i].filename = strdup (filename);
-	      /* To do: do something about reusing existing files. */
-	      if (!(cd->tocent[i].data_source = cdio_stdio_new (psz_field))) {
+	      if (!set_track_file(cd, i, psz_cue_name, psz_field)) {
 		cdio_log (log_level, 
 			  "%s line %d: can't open file `%s' for reading", 
 			   psz_cue_name, i_line, psz_field);
@@ -769,19 +782,19 @@ parse_tocfile (_img_private_t *cd, const char *psz_cue_name)
 	if (0 <= i) {
 	  if (NULL != (psz_field = strtok (NULL, "\"\t\n\r"))) {
 	    /* Handle <filename> */
-	    const char *psz_dirname = cdio_dirname(psz_cue_name);
-	    const char *psz_filename = cdio_abspath (psz_dirname, psz_field);
 	    if (cd) {
-	      cd->tocent[i].filename = (char *) psz_filename;
-	      /* To do: do something about reusing existing files. */
-	      if (!(cd->tocent[i].data_source = cdio_stdio_new (psz_field))) {
+	      if (!set_track_file(cd, i, psz_cue_name, psz_field)) {
 		cdio_log (log_level, 
 			  "%s line %d: can't open file `%s' for reading", 
 			  psz_cue_name, i_line, psz_field);
 		goto err_exit;
 	      }
 	    } else {
+	      char *psz_dirname = (char *) cdio_dirname(psz_cue_name);
+	      char *psz_filename = (char *) cdio_abspath (psz_dirname, psz_field);
 	      CdioDataSource_t *s = cdio_stdio_new (psz_filename);
+	      free(psz_dirname);
+	      free(psz_filename);
 	      if (!s) {
 		cdio_log (log_level, 
 			  "%s line %d: can't open file `%s' for reading", 
@@ -1038,6 +1051,8 @@ _read_mode1_sector_cdrdao (void *user_data, void *data, lsn_t lsn,
   ret = cdio_stream_read (env->tocent[0].data_source, buf, 
 			  CDIO_CD_FRAMESIZE_RAW, 1);
   if (ret==0) return ret;
+  ret = _cdio_image_check_sector (env, (uint8_t *) buf, lsn);
+  if (ret!=0) return ret;
 
   memcpy (data, buf + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE, 
 	  b_form2 ? M2RAW_SECTOR_SIZE: CDIO_CD_FRAMESIZE);
@@ -1098,6 +1113,8 @@ _read_mode2_sector_cdrdao (void *user_data, void *data, lsn_t lsn,
   ret = cdio_stream_read (env->tocent[0].data_source, buf, 
 			  CDIO_CD_FRAMESIZE_RAW, 1);
   if (ret==0) return ret;
+  ret = _cdio_image_check_sector (env, (uint8_t *) buf, lsn);
+  if (ret!=0) return ret;
 
 
   /* See NOTE above. */
@@ -1273,10 +1290,7 @@ cdio_is_tocfile(const char *psz_cue_name)
 CdIo_t *
 cdio_open_am_cdrdao (const char *psz_source_name, const char *psz_access_mode)
 {
-  if (psz_access_mode != NULL && strcmp(psz_access_mode, "image"))
-    cdio_warn ("there is only one access mode, 'image' for cdrdao. Arg %s ignored",
-	       psz_access_mode);
-  return cdio_open_cdrdao(psz_source_name);
+  return open_cdrdao(psz_source_name, psz_access_mode);
 }
 
 /*!
@@ -1286,6 +1300,12 @@ cdio_open_am_cdrdao (const char *psz_source_name, const char *psz_access_mode)
  */
 CdIo_t *
 cdio_open_cdrdao (const char *psz_cue_name)
+{
+  return open_cdrdao(psz_cue_name, NULL);
+}
+
+static CdIo_t *
+open_cdrdao (const char *psz_cue_name, const char *psz_access_mode)
 {
   CdIo_t *ret;
   _img_private_t *p_data;
@@ -1358,6 +1378,7 @@ cdio_open_cdrdao (const char *psz_cue_name)
   _set_arg_image (p_data, "cue", psz_cue_name);
   _set_arg_image (p_data, "source", psz_cue_name);
   _set_arg_image (p_data, "access-mode", "cdrdao");
+  _cdio_image_set_access_mode (p_data, "cdrdao", psz_access_mode);
 
   if (_init_cdrdao(p_data)) {
     return ret;
@@ -48,6 +48,7 @@
 #include <cdio/version.h>
 #include "cdio_assert.h"
 #include "_cdio_stdio.h"
+#include "_cdio_direct.h"
 #include "nrg.h"
 #include "cdtext_private.h"
 
@@ -75,6 +76,7 @@ typedef struct {
 static bool  parse_nrg (_img_private_t *env, const char *psz_cue_name,
 			const cdio_log_level_t log_level);
 static lsn_t get_disc_last_lsn_nrg (void *p_user_data);
+static CdIo *open_nrg (const char *psz_source, const char *psz_access_mode);
 
 /* Updates internal track TOC, so we can later 
    simulate ioctl(CDROMREADTOCENTRY).
@@ -804,7 +806,10 @@ _init_nrg (_img_private_t *p_env)
     return false;
   }
   
-  if (!(p_env->gen.data_source = cdio_stdio_new (p_env->gen.source_name))) {
+  p_env->gen.data_source = p_env->b_direct
+    ? cdio_direct_new (p_env->gen.source_name)
+    : cdio_stdio_new (p_env->gen.source_name);
+  if (!p_env->gen.data_source) {
     cdio_warn ("can't open nrg image file %s for reading", 
 	       p_env->gen.source_name);
     return false;
@@ -995,6 +1000,8 @@ _read_mode1_sector_nrg (void *p_user_data, void *data, lsn_t lsn,
 
   if (!node)
     cdio_warn ("reading into pre gap (lsn %lu)", (long unsigned int) lsn);
+  else if (_cdio_image_check_sector (p_env, (uint8_t *) buf, lsn))
+    return DRIVER_OP_ERROR;
 
   memcpy (data, buf + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE, 
 	  b_form2 ? M2RAW_SECTOR_SIZE: CDIO_CD_FRAMESIZE);
@@ -1064,6 +1071,8 @@ _read_mode2_sector_nrg (void *p_user_data, void *data, lsn_t lsn,
 
   if (!node)
     cdio_warn ("reading into pre gap (lsn %lu)", (long unsigned int) lsn);
+  else if (_cdio_image_check_sector (p_env, (uint8_t *) buf, lsn))
+    return DRIVER_OP_ERROR;
 
   if (b_form2)
     memcpy (data, buf + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE, 
@@ -1302,15 +1311,18 @@ cdio_is_nrg(const char *psz_nrg)
 CdIo *
 cdio_open_am_nrg (const char *psz_source_name, const char *psz_access_mode)
 {
-  if (psz_access_mode != NULL && strcmp(psz_access_mode, "image"))
-    cdio_warn ("there is only one access mode for nrg. Arg %s ignored",
-	       psz_access_mode);
-  return cdio_open_nrg(psz_source_name);
+  return open_nrg(psz_source_name, psz_access_mode);
 }
 
 
 CdIo *
 cdio_open_nrg (const char *psz_source)
+{
+  return open_nrg(psz_source, NULL);
+}
+
+static CdIo *
+open_nrg (const char *psz_source, const char *psz_access_mode)
 {
   CdIo *ret;
   _img_private_t *_data;
@@ -1375,6 +1387,7 @@ cdio_open_nrg (const char *psz_source)
   _set_arg_image(_data, "source", (NULL == psz_source) 
 	       ? DEFAULT_CDIO_DEVICE: psz_source);
   _set_arg_image (_data, "access-mode", "Nero");
+  _cdio_image_set_access_mode (_data, "nrg", psz_access_mode);
 
   _data->psz_cue_name   = strdup(_get_arg_image(_data, "source"));
 
@@ -24,9 +24,11 @@
   image.h
 */
 
+#include <cdio/logging.h>
 #include "image.h"
 #include "image_common.h"
 #include "_cdio_stdio.h"
+#include "_cdio_direct.h"
 
 #ifdef HAVE_STDLIB_H
 #include <stdlib.h>
@@ -56,6 +58,7 @@ _free_image (void *p_user_data)
 {
   _img_private_t *p_env = p_user_data;
   track_t i_track;
+  unsigned int i_file;
 
   if (NULL == p_env) return;
 
@@ -63,9 +66,18 @@ _free_image (void *p_user_data)
     track_info_t *p_tocent = &(p_env->tocent[i_track]);
     free_if_notnull(p_tocent->filename);
     free_if_notnull(p_tocent->isrc);
-    if (p_tocent->data_source) cdio_stdio_destroy(p_tocent->data_source);
+    /* Sources in the file table are freed with it below. */
+    if (p_tocent->data_source && !p_tocent->p_file)
+      cdio_stdio_destroy(p_tocent->data_source);
   }
 
+  for (i_file=0; i_file < p_env->i_files; i_file++) {
+    image_file_t *p_file = &(p_env->p_files[i_file]);
+    free_if_notnull(p_file->psz_filename);
+    if (p_file->data_source) cdio_stdio_destroy(p_file->data_source);
+  }
+  free_if_notnull(p_env->p_files);
+
   free_if_notnull(p_env->psz_mcn);
   free_if_notnull(p_env->psz_cue_name);
   free_if_notnull(p_env->psz_access_mode);
@@ -74,6 +86,125 @@ _free_image (void *p_user_data)
   free(p_env);
 }
 
+/*!
+  Return a new data source reading psz_filename, or NULL if there is
+  no such file. The source counts against the pool of open image
+  files set by cdio_set_max_open_image_files().
+*/
+CdioDataSource_t *
+_cdio_image_source_new(const _img_private_t *p_env, const char *psz_filename)
+{
+  CdioDataSource_t *p_source = p_env->b_direct
+    ? cdio_direct_new(psz_filename) : cdio_stdio_new(psz_filename);
+  if (p_source) cdio_stream_set_pool(p_source, cdio_stream_pool_default());
+  return p_source;
+}
+
+/*!
+  Return the entry of p_env->p_files for psz_filename, adding one if
+  there isn't one yet, so that all the tracks in a file share a data
+  source.
+*/
+image_file_t *
+_cdio_image_file_get(_img_private_t *p_env, const char *psz_filename)
+{
+  image_file_t *p_file;
+  unsigned int i_file;
+
+  for (i_file=0; i_file < p_env->i_files; i_file++)
+    if (0 == strcmp(p_env->p_files[i_file].psz_filename, psz_filename))
+      return &(p_env->p_files[i_file]);
+
+  if (NULL == p_env->p_files) {
+    p_env->p_files = calloc(CDIO_CD_MAX_TRACKS, sizeof(image_file_t));
+    if (NULL == p_env->p_files) return NULL;
+  }
+  if (p_env->i_files >= CDIO_CD_MAX_TRACKS) return NULL;
+
+  p_file = &(p_env->p_files[p_env->i_files]);
+  p_file->data_source = _cdio_image_source_new(p_env, psz_filename);
+  if (NULL == p_file->data_source)
+    return NULL;
+  p_file->psz_filename = strdup(psz_filename);
+  p_env->i_files++;
+  return p_file;
+}
+
+/*!
+  Set p_env->b_direct from psz_access_mode, given to the driver's
+  cdio_open_am_xxx().
+*/
+void
+_cdio_image_set_access_mode(_img_private_t *p_env, const char *psz_driver,
+                            const char *psz_access_mode)
+{
+  p_env->b_direct = false;
+  if (NULL == psz_access_mode || 0 == strcmp(psz_access_mode, "image"))
+    return;
+  if (0 == strcmp(psz_access_mode, "direct"))
+    p_env->b_direct = true;
+  else
+    cdio_warn ("%s access modes are 'image' and 'direct'. Arg %s ignored",
+               psz_driver, psz_access_mode);
+}
+
+/*!
+  Check the raw sector p_sector, just read from lsn, as p_env->e_ecc
+  says.
+*/
+driver_return_code_t
+_cdio_image_check_sector(const _img_private_t *p_env, uint8_t *p_sector,
+                         lsn_t lsn)
+{
+  cdio_sector_status_t e_status;
+
+  switch (p_env->e_ecc) {
+  case CDIO_ECC_VERIFY:
+    e_status = cdio_sector_verify (p_sector);
+    break;
+  case CDIO_ECC_CORRECT:
+    e_status = cdio_sector_repair (p_sector);
+    break;
+  default:
+    return DRIVER_OP_SUCCESS;
+  }
+
+  switch (e_status) {
+  case CDIO_SECTOR_CORRECTED:
+    cdio_info ("corrected damaged sector %ld", (long int) lsn);
+    return DRIVER_OP_SUCCESS;
+  case CDIO_SECTOR_BAD:
+    cdio_warn ("EDC mismatch in sector %ld%s", (long int) lsn,
+               CDIO_ECC_CORRECT == p_env->e_ecc ? "; can't correct it" : "");
+    return DRIVER_OP_ERROR;
+  default:
+    return DRIVER_OP_SUCCESS;
+  }
+}
+
+/* Return the first data source the image reads from, or NULL. */
+static CdioDataSource_t *
+_image_first_source (_img_private_t *p_env)
+{
+  if (p_env->gen.data_source) return p_env->gen.data_source;
+  if (p_env->i_files) return p_env->p_files[0].data_source;
+  return p_env->tocent[0].data_source;
+}
+
+/* Make every data source of the image buffer as e_buffering says. */
+static void
+_image_set_buffering (_img_private_t *p_env,
+                      cdio_stdio_buffering_t e_buffering)
+{
+  unsigned int i;
+
+  cdio_stdio_set_buffering (p_env->gen.data_source, e_buffering);
+  for (i=0; i < p_env->i_files; i++)
+    cdio_stdio_set_buffering (p_env->p_files[i].data_source, e_buffering);
+  for (i=0; i < p_env->gen.i_tracks; i++)
+    cdio_stdio_set_buffering (p_env->tocent[i].data_source, e_buffering);
+}
+
 /*!
   Return the value associated with the key "arg".
 */
@@ -82,12 +213,21 @@ _get_arg_image (void *user_data, const char key[])
 {
   _img_private_t *p_env = user_data;
 
-  if (!strcmp (key, "source")) {
+  if (!strcmp (key, "buffering")) {
+    return cdio_stdio_buffering2str
+      (cdio_stdio_get_buffering (_image_first_source (p_env)));
+  } else if (!strcmp (key, "source")) {
     return p_env->gen.source_name;
   } else if (!strcmp (key, "cue")) {
     return p_env->psz_cue_name;
   } else if (!strcmp(key, "access-mode")) {
-    return "image";
+    return p_env->b_direct ? "direct" : "image";
+  } else if (!strcmp (key, "ecc")) {
+    switch (p_env->e_ecc) {
+    case CDIO_ECC_VERIFY:  return "verify";
+    case CDIO_ECC_CORRECT: return "correct";
+    default:               return "off";
+    }
   } else if (!strcmp (key, "mmc-supported?")) {
     return "false";
   } 
@@ -329,20 +469,34 @@ read_data_sectors_image ( void *p_user_data, void *p_buf,
   if (!p_env || !p_env->gen.cdio) return DRIVER_OP_UNINIT;
   
   {
-    CdIo_t *p_cdio                = p_env->gen.cdio;
-    track_t i_track               = cdio_get_track(p_cdio, i_lsn);
-    track_format_t e_track_format = cdio_get_track_format(p_cdio, i_track);
+    CdIo_t *p_cdio = p_env->gen.cdio;
+    track_format_t e_track_format;
+
+    if (cdio_track_table_ready(p_cdio)) {
+      cdio_track_table_t *p_table = &p_cdio->track_table;
+      e_track_format =
+        cdio_track_table_format(p_table, cdio_track_table_find(p_table, i_lsn));
+    } else {
+      track_t i_track = cdio_get_track(p_cdio, i_lsn);
+      e_track_format  = cdio_get_track_format(p_cdio, i_track);
+    }
 
     switch(e_track_format) {
     case TRACK_FORMAT_PSX:
     case TRACK_FORMAT_AUDIO:
     case TRACK_FORMAT_ERROR:
       return DRIVER_OP_ERROR;
+    /* Go to the driver directly: cdio_read_data_sectors() has
+       already counted this read. */
     case TRACK_FORMAT_DATA:
-      return cdio_read_mode1_sectors (p_cdio, p_buf, i_lsn, false, i_blocks);
+      if (!p_cdio->op.read_mode1_sectors) return DRIVER_OP_UNSUPPORTED;
+      return p_cdio->op.read_mode1_sectors (p_user_data, p_buf, i_lsn, false,
+                                            i_blocks);
     case TRACK_FORMAT_CDI:
     case TRACK_FORMAT_XA:
-      return cdio_read_mode2_sectors (p_cdio, p_buf, i_lsn, false, i_blocks);
+      if (!p_cdio->op.read_mode2_sectors) return DRIVER_OP_UNSUPPORTED;
+      return p_cdio->op.read_mode2_sectors (p_user_data, p_buf, i_lsn, false,
+                                            i_blocks);
     }
   }
   return DRIVER_OP_ERROR;
@@ -378,6 +532,28 @@ _set_arg_image (void *p_user_data, const char key[], const char value[])
       if (!value) return DRIVER_OP_ERROR;
       p_env->psz_access_mode = strdup (value);
     }
+  else if (!strcmp (key, "buffering"))
+    {
+      cdio_stdio_buffering_t e_buffering;
+      if (!cdio_stdio_str2buffering (value, &e_buffering))
+        return DRIVER_OP_ERROR;
+      /* Direct access has no stdio buffer to set. */
+      if (p_env->b_direct)
+        return DRIVER_OP_UNSUPPORTED;
+      _image_set_buffering (p_env, e_buffering);
+    }
+  else if (!strcmp (key, "ecc"))
+    {
+      if (!value) return DRIVER_OP_ERROR;
+      if (!strcmp (value, "off"))
+        p_env->e_ecc = CDIO_ECC_OFF;
+      else if (!strcmp (value, "verify"))
+        p_env->e_ecc = CDIO_ECC_VERIFY;
+      else if (!strcmp (value, "correct"))
+        p_env->e_ecc = CDIO_ECC_CORRECT;
+      else
+        return DRIVER_OP_ERROR;
+    }
   else
     return DRIVER_OP_ERROR;
 
@@ -43,6 +43,15 @@ typedef struct {
   track_info_t  tocent[CDIO_CD_MAX_TRACKS+1]; /* entry info for each track 
                                                  add 1 for leadout. */
   discmode_t    disc_mode;
+  image_file_t *p_files;        /* Files holding the sectors, in disc
+                                   order, for drivers which allow more
+                                   than one. */
+  unsigned int  i_files;
+  bool          b_direct;       /* Read the files around the operating
+                                   system's cache: access mode
+                                   "direct". */
+  cdio_ecc_mode_t e_ecc;        /* How raw data sectors read are
+                                   checked: arg "ecc". */
 
 #ifdef NEED_NERO_STRUCT
   /* Nero Specific stuff. Note: for the image_free to work, this *must*
@@ -71,6 +80,42 @@ void  _free_image (void *p_user_data);
 
 int _eject_media_image(void *p_user_data);
 
+/*!
+  Return a new data source reading psz_filename, or NULL if there is
+  no such file. The source counts against the pool of open image
+  files set by cdio_set_max_open_image_files(), and bypasses the
+  file cache if p_env->b_direct is set.
+*/
+CdioDataSource_t *_cdio_image_source_new(const _img_private_t *p_env,
+                                         const char *psz_filename);
+
+/*!
+  Set p_env->b_direct from psz_access_mode, given to the driver's
+  cdio_open_am_xxx(): NULL or "image" reads through the file cache and
+  "direct" around it. Anything else is warned about and ignored.
+*/
+void _cdio_image_set_access_mode(_img_private_t *p_env,
+                                 const char *psz_driver,
+                                 const char *psz_access_mode);
+
+/*!
+  Return the entry of p_env->p_files for psz_filename, adding one if
+  there isn't one yet, so that all the tracks in a file share a data
+  source. p_env->p_files is allocated here, with room for
+  CDIO_CD_MAX_TRACKS files, if the driver hasn't done so. NULL is
+  returned if the file can't be opened or there are too many files.
+*/
+image_file_t *_cdio_image_file_get(_img_private_t *p_env,
+                                   const char *psz_filename);
+
+/*!
+  Check the raw sector p_sector, just read from lsn, as p_env->e_ecc
+  says: with CDIO_ECC_VERIFY a damaged sector is an error; with
+  CDIO_ECC_CORRECT it is repaired in place if possible.
+*/
+driver_return_code_t _cdio_image_check_sector(const _img_private_t *p_env,
+                                              uint8_t *p_sector, lsn_t lsn);
+
 /*!
   Return the value associated with the key "arg".
 */
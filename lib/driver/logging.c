@@ -31,11 +31,34 @@
 #ifdef HAVE_STDIO_H
 #include <stdio.h>
 #endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
 
 #include <cdio/logging.h>
+#include <cdio/util.h>
 #include "cdio_assert.h"
 #include "portable.h"
 
+/* The functions below are the real thing whatever CDIO_LOG_MIN_LEVEL
+   says. */
+#undef cdio_debug
+#undef cdio_info
+#undef cdio_warn
+#undef cdio_log
+
+/* The asynchronous sink needs threads and atomic operations. */
+#if defined(HAVE_PTHREAD_H) && defined(__GNUC__)
+# define HAVE_ASYNC_LOG 1
+# include <pthread.h>
+# include <sched.h>
+# define THREAD_LOCAL __thread
+#else
+# define THREAD_LOCAL
+#endif
+
+#define LOG_MESSAGE_SIZE 1024
+
 cdio_log_level_t cdio_loglevel_default = CDIO_LOG_WARN;
 
 static void
@@ -82,11 +105,40 @@ default_cdio_log_handler(cdio_log_level_t level, const char message[])
 
 static cdio_log_handler_t _handler = default_cdio_log_handler;
 
+#ifdef HAVE_ASYNC_LOG
+static void async_log_handler(cdio_log_level_t level, const char message[]);
+
+/* The handler to put back when the asynchronous sink stops. */
+static cdio_log_handler_t _async_prev_handler = NULL;
+#endif
+
+/* The handler that messages end up with: _handler, or the one the
+   asynchronous sink delivers to. */
+static cdio_log_handler_t _final_handler = default_cdio_log_handler;
+
+/* Return true if a message at level could be shown, so that it is
+   worth formatting. Only the default handler is known to go by
+   cdio_loglevel_default; other handlers see every message. */
+static CDIO_INLINE bool
+log_level_wanted(cdio_log_level_t level)
+{
+  return level >= cdio_loglevel_default || level >= CDIO_LOG_ERROR
+    || _final_handler != default_cdio_log_handler;
+}
+
 cdio_log_handler_t
 cdio_log_set_handler(cdio_log_handler_t new_handler)
 {
-  cdio_log_handler_t old_handler = _handler;
+  cdio_log_handler_t old_handler = _final_handler;
 
+  if (!new_handler) new_handler = default_cdio_log_handler;
+  _final_handler = new_handler;
+#ifdef HAVE_ASYNC_LOG
+  if (_handler == async_log_handler) {
+    _async_prev_handler = new_handler;
+    return old_handler;
+  }
+#endif
   _handler = new_handler;
 
   return old_handler;
@@ -95,8 +147,8 @@ cdio_log_set_handler(cdio_log_handler_t new_handler)
 static void
 cdio_logv(cdio_log_level_t level, const char format[], va_list args)
 {
-  char buf[1024] = { 0, };
-  static int in_recursion = 0;
+  char buf[LOG_MESSAGE_SIZE] = { 0, };
+  static THREAD_LOCAL int in_recursion = 0;
 
   if (in_recursion)
     cdio_assert_not_reached ();
@@ -114,6 +166,7 @@ void
 cdio_log(cdio_log_level_t level, const char format[], ...)
 {
   va_list args;
+  if (!log_level_wanted(level)) return;
   va_start (args, format);
   cdio_logv (level, format, args);
   va_end (args);
@@ -124,6 +177,7 @@ void \
 cdio_ ## level (const char format[], ...) \
 { \
   va_list args; \
+  if (!log_level_wanted(CDIO_LOG_ ## LEVEL)) return; \
   va_start (args, format); \
   cdio_logv (CDIO_LOG_ ## LEVEL, format, args); \
   va_end (args); \
@@ -136,6 +190,232 @@ CDIO_LOG_TEMPLATE(error, ERROR)
 
 #undef CDIO_LOG_TEMPLATE
 
+#ifdef HAVE_ASYNC_LOG
+
+/* The ring buffer is a bounded multi-producer queue after Dmitry
+   Vyukov's design: each slot carries a sequence number which says
+   whether it is free for the producer at a given position or holds a
+   message for the consumer. Producers claim a position with a
+   compare-and-swap and never wait; the single consumer is the
+   background thread. */
+typedef struct {
+  volatile unsigned long i_seq;
+  cdio_log_level_t       level;
+  char                   message[LOG_MESSAGE_SIZE];
+} log_slot_t;
+
+static struct {
+  log_slot_t             *p_slots;
+  unsigned long           i_mask;     /* number of slots - 1 */
+  volatile unsigned long  i_head;     /* next position to fill */
+  volatile unsigned long  i_tail;     /* next position to drain */
+  volatile unsigned long  i_dropped;
+  volatile unsigned long  i_writers;  /* producers inside the handler */
+  volatile bool           b_accepting; /* producers may use the ring */
+  volatile bool           b_running;
+  volatile bool           b_sleeping; /* consumer waits for a signal */
+  pthread_t               thread;
+  pthread_mutex_t         lock;
+  pthread_cond_t          wake;
+} async_log;
+
+/* Deliver one message if there is one. Consumer only. */
+static bool
+async_log_drain_one(void)
+{
+  log_slot_t *p_slot = &async_log.p_slots[async_log.i_tail & async_log.i_mask];
+
+  if (p_slot->i_seq != async_log.i_tail + 1) return false;
+  __sync_synchronize();
+  _final_handler(p_slot->level, p_slot->message);
+  __sync_synchronize();
+  p_slot->i_seq = async_log.i_tail + async_log.i_mask + 1;
+  __sync_fetch_and_add(&async_log.i_tail, 1);
+  return true;
+}
+
+static void *
+async_log_thread(void *p_unused)
+{
+  for (;;) {
+    if (async_log_drain_one()) continue;
+    if (!async_log.b_running) break;
+
+    /* Either a producer sees b_sleeping after publishing its slot and
+       signals, or we see its slot here: both sides store, then fence,
+       then load. The signal can't be lost since it is sent under the
+       lock, which we hold until we wait. */
+    pthread_mutex_lock(&async_log.lock);
+    async_log.b_sleeping = true;
+    __sync_synchronize();
+    if (async_log.b_running &&
+        async_log.p_slots[async_log.i_tail & async_log.i_mask].i_seq
+        != async_log.i_tail + 1)
+      pthread_cond_wait(&async_log.wake, &async_log.lock);
+    async_log.b_sleeping = false;
+    __sync_synchronize();
+    pthread_mutex_unlock(&async_log.lock);
+  }
+  return p_unused;
+}
+
+static void
+async_log_wake(void)
+{
+  pthread_mutex_lock(&async_log.lock);
+  pthread_cond_signal(&async_log.wake);
+  pthread_mutex_unlock(&async_log.lock);
+}
+
+static void
+async_log_handler(cdio_log_level_t level, const char message[])
+{
+  unsigned long i_pos;
+  log_slot_t *p_slot;
+
+  /* A caller may have picked up _handler just before
+     cdio_log_async_stop() replaced it. Announce ourselves, then check
+     that the ring is still there: stop clears b_accepting before it
+     waits for i_writers to drop to zero, so one of the two sees the
+     other. */
+  __sync_fetch_and_add(&async_log.i_writers, 1);
+  if (!async_log.b_accepting) {
+    __sync_fetch_and_sub(&async_log.i_writers, 1);
+    _final_handler(level, message);
+    return;
+  }
+
+  if (level >= CDIO_LOG_ERROR) {
+    /* This probably ends the program, so let what came before it out
+       first. The background thread can't wait for itself, though. */
+    if (!pthread_equal(pthread_self(), async_log.thread))
+      while (__sync_fetch_and_add(&async_log.i_tail, 0) != async_log.i_head) {
+        async_log_wake();
+        sched_yield();
+      }
+    __sync_fetch_and_sub(&async_log.i_writers, 1);
+    _final_handler(level, message);
+    return;
+  }
+
+  i_pos = async_log.i_head;
+  for (;;) {
+    long int i_diff;
+    p_slot = &async_log.p_slots[i_pos & async_log.i_mask];
+    i_diff = (long int) p_slot->i_seq - (long int) i_pos;
+    if (0 == i_diff) {
+      if (__sync_bool_compare_and_swap(&async_log.i_head, i_pos, i_pos + 1))
+        break;
+      i_pos = async_log.i_head;
+    } else if (i_diff < 0) {
+      __sync_fetch_and_add(&async_log.i_dropped, 1);
+      __sync_fetch_and_sub(&async_log.i_writers, 1);
+      return;
+    } else
+      i_pos = async_log.i_head;
+  }
+
+  p_slot->level = level;
+  strncpy(p_slot->message, message, LOG_MESSAGE_SIZE-1);
+  p_slot->message[LOG_MESSAGE_SIZE-1] = '\0';
+  __sync_synchronize();
+  p_slot->i_seq = i_pos + 1;
+  __sync_synchronize();
+
+  if (async_log.b_sleeping) async_log_wake();
+  __sync_fetch_and_sub(&async_log.i_writers, 1);
+}
+
+bool
+cdio_log_async_start(cdio_log_handler_t handler, unsigned int i_slots)
+{
+  unsigned long i, i_count = 1;
+
+  if (async_log.b_running) return false;
+  if (0 == i_slots) i_slots = 256;
+  while (i_count < i_slots) i_count <<= 1;
+
+  async_log.p_slots = calloc(i_count, sizeof(log_slot_t));
+  if (!async_log.p_slots) return false;
+  for (i = 0; i < i_count; i++)
+    async_log.p_slots[i].i_seq = i;
+  async_log.i_mask     = i_count - 1;
+  async_log.i_head     = 0;
+  async_log.i_tail     = 0;
+  async_log.i_dropped  = 0;
+  async_log.b_sleeping = false;
+  async_log.b_running  = true;
+  pthread_mutex_init(&async_log.lock, NULL);
+  pthread_cond_init(&async_log.wake, NULL);
+
+  if (0 != pthread_create(&async_log.thread, NULL, async_log_thread, NULL)) {
+    async_log.b_running = false;
+    pthread_cond_destroy(&async_log.wake);
+    pthread_mutex_destroy(&async_log.lock);
+    free(async_log.p_slots);
+    async_log.p_slots = NULL;
+    return false;
+  }
+
+  _async_prev_handler = _handler;
+  if (handler) _final_handler = handler;
+  async_log.b_accepting = true;
+  __sync_synchronize();
+  _handler = async_log_handler;
+  return true;
+}
+
+void
+cdio_log_async_stop(void)
+{
+  if (!async_log.b_running) return;
+
+  /* New messages bypass the buffer from here on; wait for those
+     already on their way in. A producer which read _handler before
+     the switch but hasn't yet counted itself in i_writers will see
+     b_accepting false and go straight to the final handler. */
+  _handler = _final_handler;
+  async_log.b_accepting = false;
+  __sync_synchronize();
+  while (__sync_fetch_and_add(&async_log.i_writers, 0)) sched_yield();
+  async_log.b_running = false;
+  async_log_wake();
+  pthread_join(async_log.thread, NULL);
+
+  _handler = _final_handler = _async_prev_handler;
+  pthread_cond_destroy(&async_log.wake);
+  pthread_mutex_destroy(&async_log.lock);
+  free(async_log.p_slots);
+  async_log.p_slots = NULL;
+}
+
+unsigned long
+cdio_log_async_dropped(void)
+{
+  return async_log.i_dropped;
+}
+
+#else
+
+bool
+cdio_log_async_start(cdio_log_handler_t handler, unsigned int i_slots)
+{
+  return false;
+}
+
+void
+cdio_log_async_stop(void)
+{
+}
+
+unsigned long
+cdio_log_async_dropped(void)
+{
+  return 0;
+}
+
+#endif /* HAVE_ASYNC_LOG */
+
 
 /* 
  * Local variables:
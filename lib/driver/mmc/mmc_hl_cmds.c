@@ -22,6 +22,13 @@
 # define __CDIO_CONFIG_H__ 1
 #endif
 
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <cdio/cdio.h>
 #include <cdio/mmc_cmds.h>
 
@@ -206,3 +213,236 @@ mmc_set_drive_speed( const CdIo_t *p_cdio, int i_drive_speed )
 {
     return mmc_set_speed(p_cdio, i_drive_speed * 176, 0);
 }
+
+/* Bytes the drive sends for each sector of p_batch, and the READ CD
+   fields that ask for them. */
+static unsigned int
+batch_sector_size(const mmc_read_batch_t *p_batch, /*out*/ bool *pb_main,
+                  /*out*/ uint8_t *pi_c2, /*out*/ uint8_t *pi_sub)
+{
+    const unsigned int i_planes = p_batch->i_planes;
+    unsigned int i_size = 0;
+
+    /* Without the main channel a drive sends just the sub-channel,
+       which is much less to transfer. */
+    *pb_main = 0 != (i_planes & (MMC_READ_PLANE_DATA|MMC_READ_PLANE_C2));
+    *pi_c2   = (i_planes & MMC_READ_PLANE_C2) ? 1 : 0;
+    if (i_planes & MMC_READ_PLANE_SUBPW)
+        *pi_sub = 1;  /* raw P-W, from which Q can be taken too */
+    else if (i_planes & MMC_READ_PLANE_SUBQ)
+        *pi_sub = 2;  /* formatted Q */
+    else
+        *pi_sub = 0;
+
+    if (*pb_main) i_size += CDIO_CD_FRAMESIZE_RAW;
+    if (*pi_c2)   i_size += MMC_C2_SIZE;
+    if (1 == *pi_sub) i_size += CDIO_CD_FRAMESIZE_SUB;
+    if (2 == *pi_sub) i_size += 16;
+    return i_size;
+}
+
+/* Number of bits set in the C2 pointers of a sector. */
+static uint16_t
+batch_count_c2(const uint8_t *p_c2)
+{
+    static const uint8_t nibble_bits[16] =
+        { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+    uint16_t i_count = 0;
+    unsigned int i;
+
+    for (i = 0; i < MMC_C2_SIZE; i++)
+        i_count += nibble_bits[p_c2[i] & 0xf] + nibble_bits[p_c2[i] >> 4];
+    return i_count;
+}
+
+/* Read i_blocks sectors from i_lsn and spread them over the planes of
+   p_batch from sector i_at on. If b_if_better, a sector already there
+   is only replaced by one with fewer C2 errors. */
+static driver_return_code_t
+batch_transfer(const CdIo_t *p_cdio, mmc_read_batch_t *p_batch, lsn_t i_lsn,
+               uint32_t i_blocks, uint32_t i_at, bool b_if_better)
+{
+    bool b_main;
+    uint8_t i_c2, i_sub;
+    const unsigned int i_size =
+        batch_sector_size(p_batch, &b_main, &i_c2, &i_sub);
+    driver_return_code_t i_status;
+    uint32_t i;
+
+    i_status = mmc_read_cd(p_cdio, p_batch->p_raw, i_lsn, 0, false,
+                           b_main, b_main ? 3 : 0, b_main, b_main,
+                           i_c2, i_sub, (uint16_t) i_size, i_blocks);
+    if (DRIVER_OP_SUCCESS != i_status) return i_status;
+
+    for (i = 0; i < i_blocks; i++) {
+        const uint8_t *p_raw = p_batch->p_raw + (size_t) i * i_size;
+        const uint8_t *p_c2  = p_raw + (b_main ? CDIO_CD_FRAMESIZE_RAW : 0);
+        const uint8_t *p_sub = p_c2 + (i_c2 ? MMC_C2_SIZE : 0);
+        const uint32_t j = i_at + i;
+
+        if (i_c2) {
+            const uint16_t i_errors = batch_count_c2(p_c2);
+            if (b_if_better && i_errors >= p_batch->p_c2_errors[j])
+                continue;
+            p_batch->p_c2_errors[j] = i_errors;
+            memcpy(p_batch->p_c2 + (size_t) j * MMC_C2_SIZE, p_c2,
+                   MMC_C2_SIZE);
+        }
+        if (p_batch->p_data)
+            memcpy(p_batch->p_data + (size_t) j * CDIO_CD_FRAMESIZE_RAW,
+                   p_raw, CDIO_CD_FRAMESIZE_RAW);
+        if (1 == i_sub && p_batch->p_subpw)
+            memcpy(p_batch->p_subpw + (size_t) j * CDIO_CD_FRAMESIZE_SUB,
+                   p_sub, CDIO_CD_FRAMESIZE_SUB);
+        if (p_batch->p_subq) {
+            uint8_t *p_q = p_batch->p_subq + (size_t) j * MMC_SUBQ_SIZE;
+            if (1 == i_sub) {
+                /* Q is the second bit of each raw P-W byte. */
+                unsigned int k;
+                memset(p_q, 0, MMC_SUBQ_SIZE);
+                for (k = 0; k < CDIO_CD_FRAMESIZE_SUB; k++)
+                    p_q[k / 8] |= ((p_sub[k] >> 6) & 1) << (7 - k % 8);
+            } else
+                memcpy(p_q, p_sub, MMC_SUBQ_SIZE);
+        }
+    }
+    return DRIVER_OP_SUCCESS;
+}
+
+/* Count the sectors of p_batch with C2 errors. */
+static void
+batch_count_bad(mmc_read_batch_t *p_batch)
+{
+    uint32_t i;
+    p_batch->i_bad = 0;
+    if (!(p_batch->i_filled & MMC_READ_PLANE_C2)) return;
+    for (i = 0; i < p_batch->i_blocks; i++)
+        if (p_batch->p_c2_errors[i]) p_batch->i_bad++;
+}
+
+/**
+  Allocate a batch for up to i_max_blocks sectors of the
+  mmc_read_plane_t kinds in i_planes.
+*/
+mmc_read_batch_t *
+mmc_read_batch_new(unsigned int i_planes, uint32_t i_max_blocks)
+{
+    mmc_read_batch_t *p_batch = calloc(1, sizeof(mmc_read_batch_t));
+    bool b_main;
+    uint8_t i_c2, i_sub;
+    bool b_ok;
+
+    if (!p_batch) return NULL;
+    if (0 == i_max_blocks) i_max_blocks = 1;
+    p_batch->i_planes     = i_planes & (MMC_READ_PLANE_DATA|MMC_READ_PLANE_C2
+                                        |MMC_READ_PLANE_SUBQ
+                                        |MMC_READ_PLANE_SUBPW);
+    p_batch->i_max_blocks = i_max_blocks;
+    p_batch->p_raw = malloc((size_t) i_max_blocks *
+                            batch_sector_size(p_batch, &b_main, &i_c2, &i_sub));
+    b_ok = NULL != p_batch->p_raw;
+
+#define BATCH_PLANE(FLAG, FIELD, SIZE)                                  \
+    if (b_ok && (p_batch->i_planes & FLAG)) {                           \
+        p_batch->FIELD = malloc((size_t) i_max_blocks * (SIZE));        \
+        b_ok = NULL != p_batch->FIELD;                                  \
+    }
+    BATCH_PLANE(MMC_READ_PLANE_DATA,  p_data,  CDIO_CD_FRAMESIZE_RAW);
+    BATCH_PLANE(MMC_READ_PLANE_C2,    p_c2,    MMC_C2_SIZE);
+    BATCH_PLANE(MMC_READ_PLANE_C2,    p_c2_errors, sizeof(uint16_t));
+    BATCH_PLANE(MMC_READ_PLANE_SUBQ,  p_subq,  MMC_SUBQ_SIZE);
+    BATCH_PLANE(MMC_READ_PLANE_SUBPW, p_subpw, CDIO_CD_FRAMESIZE_SUB);
+#undef BATCH_PLANE
+
+    if (!b_ok) {
+        mmc_read_batch_free(p_batch);
+        return NULL;
+    }
+    return p_batch;
+}
+
+void
+mmc_read_batch_free(mmc_read_batch_t *p_batch)
+{
+    if (!p_batch) return;
+    free(p_batch->p_raw);
+    free(p_batch->p_data);
+    free(p_batch->p_c2);
+    free(p_batch->p_c2_errors);
+    free(p_batch->p_subq);
+    free(p_batch->p_subpw);
+    free(p_batch);
+}
+
+/**
+  Read i_blocks raw sectors from i_lsn into p_batch, with the C2 error
+  pointers and sub-channel p_batch asks for.
+*/
+driver_return_code_t
+mmc_read_cd_batch(const CdIo_t *p_cdio, lsn_t i_lsn, uint32_t i_blocks,
+                  mmc_read_batch_t *p_batch)
+{
+    driver_return_code_t i_status;
+
+    if (!p_cdio) return DRIVER_OP_UNINIT;
+    if (!p_batch) return DRIVER_OP_BAD_POINTER;
+    if (i_blocks > p_batch->i_max_blocks) return DRIVER_OP_BAD_PARAMETER;
+
+    p_batch->i_lsn    = i_lsn;
+    p_batch->i_blocks = 0;
+    p_batch->i_filled = 0;
+    p_batch->i_bad    = 0;
+    if (0 == i_blocks) return DRIVER_OP_SUCCESS;
+
+    i_status = batch_transfer(p_cdio, p_batch, i_lsn, i_blocks, 0, false);
+    if (DRIVER_OP_UNSUPPORTED == i_status) {
+        /* No MMC: all that can be had is the main channel. */
+        if (!p_batch->p_data) return i_status;
+        i_status = cdio_read_audio_sectors(p_cdio, p_batch->p_data, i_lsn,
+                                           i_blocks);
+        if (DRIVER_OP_SUCCESS != i_status) return i_status;
+        p_batch->i_filled = MMC_READ_PLANE_DATA;
+    } else if (DRIVER_OP_SUCCESS != i_status)
+        return i_status;
+    else
+        p_batch->i_filled = p_batch->i_planes;
+
+    p_batch->i_blocks = i_blocks;
+    batch_count_bad(p_batch);
+    return DRIVER_OP_SUCCESS;
+}
+
+/**
+  Read again, up to i_tries times, just the sectors of p_batch that
+  have C2 errors.
+*/
+driver_return_code_t
+mmc_read_cd_batch_retry(const CdIo_t *p_cdio, mmc_read_batch_t *p_batch,
+                        unsigned int i_tries)
+{
+    unsigned int i_try;
+
+    if (!p_cdio) return DRIVER_OP_UNINIT;
+    if (!p_batch) return DRIVER_OP_BAD_POINTER;
+
+    for (i_try = 0; i_try < i_tries && p_batch->i_bad; i_try++) {
+        uint32_t i = 0;
+        while (i < p_batch->i_blocks) {
+            uint32_t i_end = i;
+            driver_return_code_t i_status;
+
+            if (!p_batch->p_c2_errors[i]) {
+                i++;
+                continue;
+            }
+            while (i_end < p_batch->i_blocks && p_batch->p_c2_errors[i_end])
+                i_end++;
+            i_status = batch_transfer(p_cdio, p_batch, p_batch->i_lsn + i,
+                                      i_end - i, i, true);
+            if (DRIVER_OP_SUCCESS != i_status) return i_status;
+            i = i_end;
+        }
+        batch_count_bad(p_batch);
+    }
+    return DRIVER_OP_SUCCESS;
+}
@@ -38,6 +38,27 @@
 #include <string.h>
 #endif
 
+/* Return the leadout LSN, from the cached track table if we can. */
+static lsn_t
+get_leadout_lsn(const CdIo_t *p_cdio)
+{
+  if (cdio_track_table_ready(p_cdio))
+    return p_cdio->track_table.leadout_lsn;
+  return cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);
+}
+
+/* Count a sector read which started at i_start and returned i_ret. */
+static driver_return_code_t
+record_read(const CdIo_t *p_cdio, cdio_stats_op_t e_op, lsn_t i_lsn,
+            uint32_t i_blocks, uint32_t i_blocksize,
+            driver_return_code_t i_ret, uint64_t i_start)
+{
+  cdio_stats_record(&((CdIo_t *) p_cdio)->stats, cdio_stats_source(p_cdio),
+                    e_op, i_lsn, i_blocks, (uint64_t) i_blocks * i_blocksize,
+                    0, i_ret, i_start);
+  return i_ret;
+}
+
 #define check_read_parms(p_cdio, p_buf, i_lsn)                          \
   if (!p_cdio) return DRIVER_OP_UNINIT;                                 \
   if (!p_buf || CDIO_INVALID_LSN == i_lsn)                              \
@@ -46,8 +67,7 @@
 #define check_lsn(i_lsn)                                                \
   check_read_parms(p_cdio, p_buf, i_lsn);                               \
   {                                                                     \
-    lsn_t end_lsn =                                                     \
-      cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);             \
+    lsn_t end_lsn = get_leadout_lsn(p_cdio);                            \
     if ( i_lsn > end_lsn ) {                                            \
       cdio_info("Trying to access past end of disk lsn: %ld, end lsn: %ld", \
                 (long int) i_lsn, (long int) end_lsn);                  \
@@ -58,8 +78,7 @@
 #define check_lsn_blocks(i_lsn, i_blocks)                               \
   check_read_parms(p_cdio, p_buf, i_lsn);                               \
   {                                                                     \
-    lsn_t end_lsn =                                                     \
-      cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);             \
+    lsn_t end_lsn = get_leadout_lsn(p_cdio);                            \
     if ( i_lsn > end_lsn ) {                                            \
       cdio_info("Trying to access past end of disk lsn: %ld, end lsn: %ld", \
                 (long int) i_lsn, (long int) end_lsn);                   \
@@ -84,8 +103,15 @@ cdio_lseek (const CdIo_t *p_cdio, off_t offset, int whence)
 {
   if (!p_cdio) return DRIVER_OP_UNINIT;
   
-  if (p_cdio->op.lseek)
-    return (p_cdio->op.lseek) (p_cdio->env, offset, whence);
+  if (p_cdio->op.lseek) {
+    const uint64_t i_start = cdio_stats_now();
+    off_t i_ret = (p_cdio->op.lseek) (p_cdio->env, offset, whence);
+    cdio_stats_record(&((CdIo_t *) p_cdio)->stats, cdio_stats_source(p_cdio),
+                      CDIO_STATS_SEEK, CDIO_INVALID_LSN, 0, 0, 0,
+                      i_ret < 0 ? DRIVER_OP_ERROR : DRIVER_OP_SUCCESS,
+                      i_start);
+    return i_ret;
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -106,8 +132,16 @@ cdio_read (const CdIo_t *p_cdio, void *p_buf, size_t i_size)
 {
   if (!p_cdio) return DRIVER_OP_UNINIT;
   
-  if (p_cdio->op.read)
-    return (p_cdio->op.read) (p_cdio->env, p_buf, i_size);
+  if (p_cdio->op.read) {
+    const uint64_t i_start = cdio_stats_now();
+    ssize_t i_ret = (p_cdio->op.read) (p_cdio->env, p_buf, i_size);
+    cdio_stats_record(&((CdIo_t *) p_cdio)->stats, cdio_stats_source(p_cdio),
+                      CDIO_STATS_READ, CDIO_INVALID_LSN, 0,
+                      i_ret > 0 ? i_ret : 0, 0,
+                      i_ret < 0 ? DRIVER_OP_ERROR : DRIVER_OP_SUCCESS,
+                      i_start);
+    return i_ret;
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -119,8 +153,14 @@ driver_return_code_t
 cdio_read_audio_sector (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn) 
 {
   check_lsn(i_lsn);
-  if  (p_cdio->op.read_audio_sectors)
-    return p_cdio->op.read_audio_sectors (p_cdio->env, p_buf, i_lsn, 1);
+  if  (p_cdio->op.read_audio_sectors) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_AUDIO, i_lsn, 1,
+                       CDIO_CD_FRAMESIZE_RAW,
+                       p_cdio->op.read_audio_sectors (p_cdio->env, p_buf,
+                                                      i_lsn, 1),
+                       i_start);
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -136,9 +176,14 @@ cdio_read_audio_sectors (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
 
   if (0 == i_blocks) return DRIVER_OP_SUCCESS;
 
-  if (p_cdio->op.read_audio_sectors)
-    return (p_cdio->op.read_audio_sectors) (p_cdio->env, p_buf, i_lsn, 
-                                            i_blocks);
+  if (p_cdio->op.read_audio_sectors) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_AUDIO, i_lsn, i_blocks,
+                       CDIO_CD_FRAMESIZE_RAW,
+                       (p_cdio->op.read_audio_sectors) (p_cdio->env, p_buf,
+                                                        i_lsn, i_blocks),
+                       i_start);
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -154,9 +199,14 @@ cdio_read_data_sectors (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
 
   if (0 == i_blocks) return DRIVER_OP_SUCCESS;
 
-  if  (p_cdio->op.read_data_sectors)
-    return p_cdio->op.read_data_sectors (p_cdio->env, p_buf, i_lsn, 
-                                         i_blocksize, i_blocks);
+  if  (p_cdio->op.read_data_sectors) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_DATA, i_lsn, i_blocks,
+                       i_blocksize,
+                       p_cdio->op.read_data_sectors (p_cdio->env, p_buf, i_lsn,
+                                                     i_blocksize, i_blocks),
+                       i_start);
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -177,7 +227,11 @@ cdio_read_mode1_sector (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
 
   check_lsn(i_lsn);
   if (p_cdio->op.read_mode1_sector) {
-    return p_cdio->op.read_mode1_sector(p_cdio->env, p_buf, i_lsn, b_form2);
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_MODE1, i_lsn, 1, size,
+                       p_cdio->op.read_mode1_sector(p_cdio->env, p_buf, i_lsn,
+                                                    b_form2),
+                       i_start);
   } else if (p_cdio->op.lseek && p_cdio->op.read) {
     char buf[M2RAW_SECTOR_SIZE] = { 0, };
     if (0 > cdio_lseek(p_cdio, CDIO_CD_FRAMESIZE*i_lsn, SEEK_SET))
@@ -209,9 +263,15 @@ cdio_read_mode1_sectors (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
 
   if (0 == i_blocks) return DRIVER_OP_SUCCESS;
 
-  if (p_cdio->op.read_mode1_sectors)
-    return (p_cdio->op.read_mode1_sectors) (p_cdio->env, p_buf, i_lsn, b_form2,
-                                            i_blocks);
+  if (p_cdio->op.read_mode1_sectors) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_MODE1, i_lsn, i_blocks,
+                       b_form2 ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE,
+                       (p_cdio->op.read_mode1_sectors) (p_cdio->env, p_buf,
+                                                        i_lsn, b_form2,
+                                                        i_blocks),
+                       i_start);
+  }
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -229,8 +289,14 @@ cdio_read_mode2_sector (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
                         bool b_form2)
 {
   check_lsn(i_lsn);
-  if (p_cdio->op.read_mode2_sector)
-    return p_cdio->op.read_mode2_sector (p_cdio->env, p_buf, i_lsn, b_form2);
+  if (p_cdio->op.read_mode2_sector) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_MODE2, i_lsn, 1,
+                       b_form2 ? M2F2_SECTOR_SIZE : CDIO_CD_FRAMESIZE,
+                       p_cdio->op.read_mode2_sector (p_cdio->env, p_buf,
+                                                     i_lsn, b_form2),
+                       i_start);
+  }
 
   /* fallback */
   if (p_cdio->op.read_mode2_sectors != NULL)
@@ -256,9 +322,15 @@ cdio_read_mode2_sectors (const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
 
   if (0 == i_blocks) return DRIVER_OP_SUCCESS;
 
-  if (p_cdio->op.read_mode2_sectors) 
-    return (p_cdio->op.read_mode2_sectors) (p_cdio->env, p_buf, i_lsn,
-                                            b_form2, i_blocks);
+  if (p_cdio->op.read_mode2_sectors) {
+    const uint64_t i_start = cdio_stats_now();
+    return record_read(p_cdio, CDIO_STATS_READ_MODE2, i_lsn, i_blocks,
+                       b_form2 ? M2F2_SECTOR_SIZE : CDIO_CD_FRAMESIZE,
+                       (p_cdio->op.read_mode2_sectors) (p_cdio->env, p_buf,
+                                                        i_lsn, b_form2,
+                                                        i_blocks),
+                       i_start);
+  }
   return DRIVER_OP_UNSUPPORTED;
   
 }
@@ -0,0 +1,323 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file read_ctl.c
+ *
+ *  \brief Bulk reads which adapt speed and transfer size to the disc.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/read_ctl.h>
+#include "stats_private.h"
+
+/* Good transfers in a row before transfers grow or the speed goes
+   up. */
+#define READ_CTL_GOOD_RUN   8
+/* A transfer is slow if it takes READ_CTL_SLOW_FACTOR times as long
+   per sector as usual, and at least READ_CTL_SLOW_NSEC. */
+#define READ_CTL_SLOW_FACTOR 8
+#define READ_CTL_SLOW_NSEC  (50 * 1000 * 1000)
+
+struct cdio_read_ctl_s {
+  CdIo_t                  *p_cdio;
+  cdio_read_ctl_options_t  opts;
+  bool                     b_speed;     /* the drive takes cdio_set_speed */
+  unsigned int             i_good;      /* good transfers in a row */
+  uint64_t                 i_avg_nsec;  /* running average per sector */
+  cdio_read_region_t      *p_regions;
+  unsigned int             i_regions;
+  cdio_read_ctl_stats_t    stats;
+};
+
+/* Bytes cdio_read_sectors() puts in the buffer for each sector. Form
+   2 comes with its subheader and EDC, as the drivers read it. */
+static uint32_t
+sector_size(cdio_read_mode_t read_mode)
+{
+  switch (read_mode) {
+  case CDIO_READ_MODE_AUDIO: return CDIO_CD_FRAMESIZE_RAW;
+  case CDIO_READ_MODE_M1F2:
+  case CDIO_READ_MODE_M2F2:  return M2RAW_SECTOR_SIZE;
+  case CDIO_READ_MODE_M1F1:
+  case CDIO_READ_MODE_M2F1:  break;
+  }
+  return CDIO_CD_FRAMESIZE;
+}
+
+/* Return the region i_lsn is in, growing the table as needed, or
+   NULL if there is no memory for it. */
+static cdio_read_region_t *
+get_region(cdio_read_ctl_t *p_ctl, lsn_t i_lsn)
+{
+  unsigned int i = i_lsn < 0 ? 0 : (unsigned int) i_lsn / CDIO_READ_CTL_REGION;
+
+  if (i >= p_ctl->i_regions) {
+    unsigned int n = p_ctl->i_regions ? p_ctl->i_regions : 1;
+    cdio_read_region_t *p;
+    unsigned int j;
+
+    while (n <= i) n *= 2;
+    p = realloc(p_ctl->p_regions, n * sizeof(cdio_read_region_t));
+    if (!p) return NULL;
+    memset(p + p_ctl->i_regions, 0,
+           (n - p_ctl->i_regions) * sizeof(cdio_read_region_t));
+    for (j = p_ctl->i_regions; j < n; j++)
+      p[j].i_lsn = (lsn_t) (j * CDIO_READ_CTL_REGION);
+    p_ctl->p_regions = p;
+    p_ctl->i_regions = n;
+  }
+  return &p_ctl->p_regions[i];
+}
+
+static void
+set_speed(cdio_read_ctl_t *p_ctl, int i_speed)
+{
+  driver_return_code_t rc;
+
+  if (!p_ctl->b_speed || i_speed == p_ctl->stats.i_speed) return;
+  rc = cdio_set_speed(p_ctl->p_cdio, i_speed);
+  if (DRIVER_OP_SUCCESS != rc) {
+    /* Don't try again; transfer sizes and retries still work. */
+    cdio_debug("read control: can't set speed %dx (%s); leaving it alone",
+               i_speed, cdio_driver_errmsg(rc));
+    p_ctl->b_speed = false;
+    p_ctl->stats.i_speed = 0;
+    return;
+  }
+  p_ctl->stats.i_speed = i_speed;
+  p_ctl->stats.i_speed_changes++;
+}
+
+static void
+speed_down(cdio_read_ctl_t *p_ctl)
+{
+  int i_speed = p_ctl->stats.i_speed / 2;
+
+  if (i_speed < p_ctl->opts.i_min_speed) i_speed = p_ctl->opts.i_min_speed;
+  set_speed(p_ctl, i_speed);
+}
+
+static void
+speed_up(cdio_read_ctl_t *p_ctl)
+{
+  int i_speed = p_ctl->stats.i_speed * 2;
+
+  if (i_speed > p_ctl->opts.i_max_speed) i_speed = p_ctl->opts.i_max_speed;
+  set_speed(p_ctl, i_speed);
+}
+
+/* Record a good transfer of i_blocks which took i_nsec: a slow one
+   slows the drive down; a run of normal ones lets transfers grow and
+   then the speed go up. */
+static void
+good_read(cdio_read_ctl_t *p_ctl, uint32_t i_blocks, uint64_t i_nsec)
+{
+  uint64_t i_per = i_nsec / i_blocks;
+
+  if (p_ctl->i_avg_nsec
+      && i_per > READ_CTL_SLOW_FACTOR * p_ctl->i_avg_nsec
+      && i_nsec > READ_CTL_SLOW_NSEC) {
+    p_ctl->stats.i_slow++;
+    p_ctl->i_good = 0;
+    speed_down(p_ctl);
+    return;
+  }
+
+  p_ctl->i_avg_nsec = p_ctl->i_avg_nsec
+    ? (p_ctl->i_avg_nsec * 7 + i_per) / 8 : i_per;
+
+  if (++p_ctl->i_good < READ_CTL_GOOD_RUN) return;
+  p_ctl->i_good = 0;
+  if (p_ctl->stats.i_blocks < p_ctl->opts.i_max_blocks) {
+    p_ctl->stats.i_blocks *= 2;
+    if (p_ctl->stats.i_blocks > p_ctl->opts.i_max_blocks)
+      p_ctl->stats.i_blocks = p_ctl->opts.i_max_blocks;
+  } else
+    speed_up(p_ctl);
+}
+
+cdio_read_ctl_t *
+cdio_read_ctl_new(CdIo_t *p_cdio, const cdio_read_ctl_options_t *p_options)
+{
+  cdio_read_ctl_t *p_ctl;
+
+  if (!p_cdio) return NULL;
+  p_ctl = calloc(1, sizeof(cdio_read_ctl_t));
+  if (!p_ctl) return NULL;
+
+  if (p_options) p_ctl->opts = *p_options;
+  if (!p_ctl->opts.i_max_speed)  p_ctl->opts.i_max_speed  = CDIO_READ_CTL_MAX_SPEED;
+  if (!p_ctl->opts.i_min_speed)  p_ctl->opts.i_min_speed  = CDIO_READ_CTL_MIN_SPEED;
+  if (!p_ctl->opts.i_max_blocks) p_ctl->opts.i_max_blocks = CDIO_READ_CTL_MAX_BLOCKS;
+  if (!p_ctl->opts.i_tries)      p_ctl->opts.i_tries      = CDIO_READ_CTL_TRIES;
+  if (p_ctl->opts.i_min_speed > p_ctl->opts.i_max_speed)
+    p_ctl->opts.i_min_speed = p_ctl->opts.i_max_speed;
+
+  p_ctl->p_cdio = p_cdio;
+  p_ctl->b_speed = true;
+  p_ctl->stats.i_blocks = p_ctl->opts.i_max_blocks;
+
+  /* Start at full speed; this also finds out whether the speed can be
+     set at all. */
+  set_speed(p_ctl, p_ctl->opts.i_max_speed);
+  p_ctl->stats.i_speed_changes = 0;
+
+  {
+    lsn_t i_last = cdio_get_disc_last_lsn(p_cdio);
+    if (CDIO_INVALID_LSN != i_last) get_region(p_ctl, i_last);
+  }
+  return p_ctl;
+}
+
+void
+cdio_read_ctl_free(cdio_read_ctl_t *p_ctl)
+{
+  if (!p_ctl) return;
+  free(p_ctl->p_regions);
+  free(p_ctl);
+}
+
+driver_return_code_t
+cdio_read_ctl_read(cdio_read_ctl_t *p_ctl, void *p_buf, lsn_t i_lsn,
+                   cdio_read_mode_t read_mode, uint32_t i_blocks)
+{
+  const uint32_t i_size = sector_size(read_mode);
+  uint8_t *p = p_buf;
+  unsigned int i_tries = 0;
+
+  if (!p_ctl) return DRIVER_OP_UNINIT;
+  if (!p_buf) return DRIVER_OP_BAD_POINTER;
+
+  while (i_blocks > 0) {
+    cdio_read_region_t *p_region = get_region(p_ctl, i_lsn);
+    uint32_t n = i_blocks < p_ctl->stats.i_blocks
+      ? i_blocks : p_ctl->stats.i_blocks;
+    driver_return_code_t rc;
+    uint64_t i_start, i_nsec;
+
+    /* Where reads have failed before, keep transfers short, so that
+       a bad sector costs little time to find again. */
+    if (p_region && p_region->i_errors && n > p_ctl->opts.i_max_blocks / 8)
+      n = p_ctl->opts.i_max_blocks / 8 ? p_ctl->opts.i_max_blocks / 8 : 1;
+
+    i_start = cdio_stats_now();
+    rc = cdio_read_sectors(p_ctl->p_cdio, p, i_lsn, read_mode, n);
+    i_nsec = cdio_stats_now() - i_start;
+
+    p_ctl->stats.i_reads++;
+    if (p_region) {
+      p_region->i_reads++;
+      p_region->i_nsec += i_nsec;
+    }
+
+    if (DRIVER_OP_SUCCESS == rc) {
+      if (p_region) p_region->i_sectors += n;
+      p_ctl->stats.i_sectors += n;
+      good_read(p_ctl, n, i_nsec);
+      p     += (size_t) n * i_size;
+      i_lsn += n;
+      i_blocks -= n;
+      i_tries = 0;
+      continue;
+    }
+
+    /* Only errors from the medium are worth reading again. */
+    if (DRIVER_OP_ERROR != rc && DRIVER_OP_MMC_SENSE_DATA != rc)
+      return rc;
+
+    p_ctl->stats.i_errors++;
+    if (p_region) p_region->i_errors++;
+    p_ctl->i_good = 0;
+
+    /* Close in on the bad sector by halving the transfer. */
+    if (n > 1) {
+      p_ctl->stats.i_blocks = n / 2;
+      continue;
+    }
+
+    p_ctl->stats.i_blocks = 1;
+    speed_down(p_ctl);
+    if (++i_tries < p_ctl->opts.i_tries) continue;
+
+    if (!p_ctl->opts.b_skip_bad) {
+      cdio_warn("read control: giving up on sector %lu after %u tries",
+                (unsigned long int) i_lsn, i_tries);
+      return rc;
+    }
+    cdio_debug("read control: skipping sector %lu after %u tries",
+               (unsigned long int) i_lsn, i_tries);
+    memset(p, 0, i_size);
+    p_ctl->stats.i_bad_sectors++;
+    p_ctl->stats.i_sectors++;
+    p += i_size;
+    i_lsn++;
+    i_blocks--;
+    i_tries = 0;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+driver_return_code_t
+cdio_read_ctl_get_stats(const cdio_read_ctl_t *p_ctl,
+                        /*out*/ cdio_read_ctl_stats_t *p_stats)
+{
+  if (!p_ctl) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  *p_stats = p_ctl->stats;
+  return DRIVER_OP_SUCCESS;
+}
+
+driver_return_code_t
+cdio_read_ctl_get_region(const cdio_read_ctl_t *p_ctl, lsn_t i_lsn,
+                         /*out*/ cdio_read_region_t *p_region)
+{
+  unsigned int i;
+
+  if (!p_ctl) return DRIVER_OP_UNINIT;
+  if (!p_region) return DRIVER_OP_BAD_POINTER;
+  i = i_lsn < 0 ? 0 : (unsigned int) i_lsn / CDIO_READ_CTL_REGION;
+  if (i < p_ctl->i_regions)
+    *p_region = p_ctl->p_regions[i];
+  else {
+    memset(p_region, 0, sizeof(cdio_read_region_t));
+    p_region->i_lsn = (lsn_t) (i * CDIO_READ_CTL_REGION);
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,561 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file rip.c
+ *
+ *  \brief Extracting audio with jitter correction.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+/* Reading ahead on another thread needs threads and atomic
+   operations, as the asynchronous log sink does. */
+#if defined(HAVE_PTHREAD_H) && defined(__GNUC__)
+# define HAVE_RIP_THREAD 1
+# include <pthread.h>
+#endif
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/rip.h>
+
+#define SAMPLES CDIO_CD_SAMPLES_PER_SECTOR
+
+/* Samples of the previous read looked for in the next one. */
+#define RIP_PROBE 128
+/* Batches between the reader and the callback. */
+#define RIP_SLOTS 8
+
+typedef struct {
+  CdIo_t              *p_cdio;
+  lsn_t                i_lsn;       /* first sector */
+  uint32_t             i_sectors;   /* sectors to deliver */
+  uint32_t             i_readable;  /* sectors from i_lsn we may read */
+  cdio_rip_options_t   opts;
+
+  uint32_t            *p_read;      /* the current read */
+  uint32_t            *p_ref;       /* the end of the last one */
+  int64_t              i_ref;       /* sample of p_ref[0] */
+  uint32_t             i_ref_len;   /* samples in p_ref */
+  uint8_t             *p_hits;      /* candidates for the probe */
+  int                  i_shift;     /* shift of the last read */
+  int64_t              i_pos;       /* next sample to deliver */
+  cdio_rip_stats_t     stats;
+
+  cdio_rip_callback_t  callback;
+  void                *p_user_data;
+
+#ifdef HAVE_RIP_THREAD
+  /* A single-producer, single-consumer ring: the reader fills slot
+     i_head % RIP_SLOTS and the caller's thread empties slot
+     i_tail % RIP_SLOTS. Neither waits on the other except when the
+     ring is full or empty. */
+  uint8_t             *p_slot[RIP_SLOTS];
+  size_t               i_slot_bytes[RIP_SLOTS]; /* set when published */
+  size_t               i_slot_size;
+  size_t               i_fill;      /* bytes in the slot being filled */
+  volatile unsigned long i_head;
+  volatile unsigned long i_tail;
+  volatile bool        b_done;      /* the reader has finished */
+  volatile bool        b_stop;      /* the callback asked to stop */
+  volatile unsigned int i_sleepers; /* threads waiting on wake */
+  pthread_mutex_t      lock;
+  pthread_cond_t       wake;
+#endif
+  driver_return_code_t i_read_status;
+} rip_job_t;
+
+/* Set p_hit[i] for each of p_samples[0..i_count) that is i_needle. */
+static void
+rip_find_sample(const uint32_t *p_samples, size_t i_count, uint32_t i_needle,
+                /*out*/ uint8_t *p_hit)
+{
+  size_t i = 0;
+#ifdef __SSE2__
+  const __m128i needle = _mm_set1_epi32((int) i_needle);
+  for (; i + 4 <= i_count; i += 4) {
+    const __m128i x = _mm_loadu_si128((const __m128i *) (p_samples + i));
+    const int i_mask =
+      _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, needle)));
+    p_hit[i]     = i_mask & 1;
+    p_hit[i + 1] = (i_mask >> 1) & 1;
+    p_hit[i + 2] = (i_mask >> 2) & 1;
+    p_hit[i + 3] = (i_mask >> 3) & 1;
+  }
+#endif
+  for (; i < i_count; i++)
+    p_hit[i] = (p_samples[i] == i_needle);
+}
+
+/* Does the read of i_len samples whose first sample is i_start agree
+   with the reference where they overlap, and do they overlap by at
+   least half the reference? */
+static bool
+rip_overlap_matches(const rip_job_t *p_job, int64_t i_start, uint32_t i_len)
+{
+  const int64_t i_from = i_start > p_job->i_ref ? i_start : p_job->i_ref;
+  const int64_t i_ref_end = p_job->i_ref + p_job->i_ref_len;
+  const int64_t i_to = i_start + i_len < i_ref_end ? i_start + i_len
+    : i_ref_end;
+
+  if (2 * (i_to - i_from) < (int64_t) p_job->i_ref_len) return false;
+  return 0 == memcmp(p_job->p_read + (i_from - i_start),
+                     p_job->p_ref + (i_from - p_job->i_ref),
+                     (size_t) (i_to - i_from) * 4);
+}
+
+/* Find the shift of the read of i_len samples from sector i_first:
+   where its data really starts is i_first * SAMPLES + shift. The
+   probe from the middle of the reference is looked for within
+   i_jitter samples either way, nearest the last shift first, and the
+   first place where the whole overlap agrees wins. */
+static bool
+rip_align(rip_job_t *p_job, uint32_t i_first, uint32_t i_len,
+          /*out*/ int *pi_shift)
+{
+  const int i_jitter = (int) p_job->opts.i_jitter;
+  const int64_t i_probe = p_job->i_ref + p_job->i_ref_len / 2 - RIP_PROBE / 2;
+  const uint32_t *p_probe = p_job->p_ref + (i_probe - p_job->i_ref);
+  /* Index in p_read of the probe, for a shift of 0. */
+  const int64_t i_at = i_probe - (int64_t) i_first * SAMPLES;
+  int64_t i_lo = i_at - i_jitter, i_hi = i_at + i_jitter;
+  int i_dist;
+
+  if (p_job->i_ref_len < RIP_PROBE) return false;
+  if (i_lo < 0) i_lo = 0;
+  if (i_hi > (int64_t) i_len - RIP_PROBE) i_hi = (int64_t) i_len - RIP_PROBE;
+  if (i_hi < i_lo) return false;
+
+  rip_find_sample(p_job->p_read + i_lo, (size_t) (i_hi - i_lo + 1),
+                  p_probe[0], p_job->p_hits);
+
+  for (i_dist = 0; i_dist <= 2 * i_jitter; i_dist++) {
+    int i_side;
+    for (i_side = 0; i_side < (i_dist ? 2 : 1); i_side++) {
+      const int i_shift = p_job->i_shift + (i_side ? -i_dist : i_dist);
+      const int64_t i_idx = i_at - i_shift;
+      if (i_shift < -i_jitter || i_shift > i_jitter
+          || i_idx < i_lo || i_idx > i_hi || !p_job->p_hits[i_idx - i_lo])
+        continue;
+      if (0 != memcmp(p_job->p_read + i_idx, p_probe, RIP_PROBE * 4))
+        continue;
+      if (rip_overlap_matches(p_job,
+                              (int64_t) i_first * SAMPLES + i_shift, i_len)) {
+        *pi_shift = i_shift;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/* Read i_blocks sectors from sector i_first, trying again on errors. */
+static driver_return_code_t
+rip_read(rip_job_t *p_job, uint32_t i_first, uint32_t i_blocks)
+{
+  driver_return_code_t i_ret = DRIVER_OP_ERROR;
+  unsigned int i_try;
+
+  for (i_try = 0; i_try < p_job->opts.i_tries; i_try++) {
+    if (i_try) p_job->stats.i_rereads++;
+    p_job->stats.i_reads++;
+    i_ret = cdio_read_audio_sectors(p_job->p_cdio, p_job->p_read,
+                                    p_job->i_lsn + (lsn_t) i_first, i_blocks);
+    if (DRIVER_OP_SUCCESS == i_ret) break;
+  }
+  if (DRIVER_OP_SUCCESS != i_ret)
+    cdio_warn("can't read audio sectors %ld to %ld",
+              (long int) (p_job->i_lsn + i_first),
+              (long int) (p_job->i_lsn + i_first + i_blocks - 1));
+  return i_ret;
+}
+
+#ifdef HAVE_RIP_THREAD
+
+/* Wait a little for the other side of the ring: the reader while
+   the ring is full (b_full), the caller's thread while it is empty.
+   The condition is looked at again once this thread is counted as a
+   sleeper, so a change made before rip_ring_wake() saw the count is
+   not slept through; the timeout is only a safety net. */
+static void
+rip_ring_sleep(rip_job_t *p_job, bool b_full)
+{
+  struct timespec ts;
+  struct timeval tv;
+
+  pthread_mutex_lock(&p_job->lock);
+  p_job->i_sleepers++;
+  __sync_synchronize();
+  if (b_full ? (p_job->i_head - p_job->i_tail == RIP_SLOTS && !p_job->b_stop)
+      : (p_job->i_head == p_job->i_tail && !p_job->b_done)) {
+    gettimeofday(&tv, NULL);
+    ts.tv_sec  = tv.tv_sec;
+    ts.tv_nsec = (tv.tv_usec + 10000) * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&p_job->wake, &p_job->lock, &ts);
+  }
+  p_job->i_sleepers--;
+  pthread_mutex_unlock(&p_job->lock);
+}
+
+static void
+rip_ring_wake(rip_job_t *p_job)
+{
+  __sync_synchronize();
+  if (p_job->i_sleepers) {
+    pthread_mutex_lock(&p_job->lock);
+    pthread_cond_broadcast(&p_job->wake);
+    pthread_mutex_unlock(&p_job->lock);
+  }
+}
+
+/* Hand the slot being filled over to the caller's thread. */
+static void
+rip_ring_publish(rip_job_t *p_job)
+{
+  p_job->i_slot_bytes[p_job->i_head % RIP_SLOTS] = p_job->i_fill;
+  p_job->i_fill = 0;
+  __sync_synchronize();
+  p_job->i_head++;
+  rip_ring_wake(p_job);
+}
+
+#endif /* HAVE_RIP_THREAD */
+
+/* Pass i_count verified samples on to the callback. */
+static driver_return_code_t
+rip_emit(rip_job_t *p_job, const uint32_t *p_samples, size_t i_count)
+{
+#ifdef HAVE_RIP_THREAD
+  const uint8_t *p = (const uint8_t *) p_samples;
+  size_t i_bytes = i_count * 4;
+
+  while (i_bytes) {
+    const unsigned long i_head = p_job->i_head;
+    size_t i_now;
+
+    if (p_job->b_stop) return DRIVER_OP_ERROR;
+    if (i_head - p_job->i_tail == RIP_SLOTS) {
+      rip_ring_sleep(p_job, true);
+      continue;
+    }
+    __sync_synchronize();
+
+    i_now = p_job->i_slot_size - p_job->i_fill;
+    if (i_now > i_bytes) i_now = i_bytes;
+    memcpy(p_job->p_slot[i_head % RIP_SLOTS] + p_job->i_fill, p, i_now);
+    p_job->i_fill += i_now;
+    p             += i_now;
+    i_bytes       -= i_now;
+    if (p_job->i_fill == p_job->i_slot_size) rip_ring_publish(p_job);
+  }
+  return DRIVER_OP_SUCCESS;
+#else
+  return p_job->callback((const uint8_t *) p_samples, i_count * 4,
+                         p_job->p_user_data);
+#endif
+}
+
+/* Read, align and deliver the whole range. */
+static driver_return_code_t
+rip_run(rip_job_t *p_job)
+{
+  const uint32_t i_batch   = p_job->opts.i_batch;
+  const uint32_t i_overlap = p_job->opts.i_overlap;
+  const int64_t  i_total   = (int64_t) p_job->i_sectors * SAMPLES;
+  driver_return_code_t i_ret;
+  uint32_t i_prime = i_overlap < p_job->i_readable
+    ? i_overlap : p_job->i_readable;
+
+  /* The first read has nothing before it to be checked against, so
+     read its start on its own first. */
+  i_ret = rip_read(p_job, 0, i_prime);
+  if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+  memcpy(p_job->p_ref, p_job->p_read, (size_t) i_prime * SAMPLES * 4);
+  p_job->i_ref     = 0;
+  p_job->i_ref_len = i_prime * SAMPLES;
+
+  while (p_job->i_pos < i_total) {
+    const int64_t i_sector = p_job->i_pos / SAMPLES - i_overlap;
+    const uint32_t i_first = i_sector > 0 ? (uint32_t) i_sector : 0;
+    const uint32_t i_blocks = p_job->i_readable - i_first < i_batch
+      ? p_job->i_readable - i_first : i_batch;
+    const uint32_t i_len = i_blocks * SAMPLES;
+    int64_t i_start, i_end;
+    unsigned int i_try;
+    bool b_aligned = false;
+    int i_shift = p_job->i_shift;
+
+    for (i_try = 0; i_try < p_job->opts.i_tries && !b_aligned; i_try++) {
+      if (i_try) p_job->stats.i_rereads++;
+      i_ret = rip_read(p_job, i_first, i_blocks);
+      if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+      b_aligned = rip_align(p_job, i_first, i_len, &i_shift);
+    }
+    if (!b_aligned) {
+      /* Take the last read as it comes, at the last shift. */
+      i_shift = p_job->i_shift;
+      cdio_warn("can't verify audio sectors %ld to %ld",
+                (long int) (p_job->i_lsn + i_first),
+                (long int) (p_job->i_lsn + i_first + i_blocks - 1));
+    }
+    if (i_shift) {
+      const uint32_t i_abs = (uint32_t) (i_shift < 0 ? -i_shift : i_shift);
+      p_job->stats.i_shifted++;
+      if (i_abs > p_job->stats.i_max_shift) p_job->stats.i_max_shift = i_abs;
+    }
+
+    i_start = (int64_t) i_first * SAMPLES + i_shift;
+    i_end   = i_start + i_len < i_total ? i_start + i_len : i_total;
+    if (i_end <= p_job->i_pos) {
+      /* Shifted away from what is left, at the very end: there is
+         nothing more to read, so make up the rest with silence. */
+      static const uint32_t silence[SAMPLES];
+      while (p_job->i_pos < i_total) {
+        const int64_t i_now = i_total - p_job->i_pos < SAMPLES
+          ? i_total - p_job->i_pos : SAMPLES;
+        i_ret = rip_emit(p_job, silence, (size_t) i_now);
+        if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+        p_job->i_pos += i_now;
+        p_job->stats.i_unverified++;
+      }
+      break;
+    }
+
+    /* The start of the first read, when it came back shifted
+       forward, is still in the reference. */
+    if (i_start > p_job->i_pos) {
+      i_ret = rip_emit(p_job, p_job->p_ref + (p_job->i_pos - p_job->i_ref),
+                       (size_t) (i_start - p_job->i_pos));
+      if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+      p_job->i_pos = i_start;
+    }
+    i_ret = rip_emit(p_job, p_job->p_read + (p_job->i_pos - i_start),
+                     (size_t) (i_end - p_job->i_pos));
+    if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+    if (!b_aligned)
+      p_job->stats.i_unverified +=
+        (uint32_t) ((i_end - p_job->i_pos + SAMPLES - 1) / SAMPLES);
+    p_job->i_pos = i_end;
+
+    /* The end of what was delivered is what the next read has to
+       match. */
+    p_job->i_ref_len = (uint32_t) (i_end - i_start) < i_overlap * SAMPLES
+      ? (uint32_t) (i_end - i_start) : i_overlap * SAMPLES;
+    p_job->i_ref = i_end - p_job->i_ref_len;
+    memcpy(p_job->p_ref, p_job->p_read + (p_job->i_ref - i_start),
+           (size_t) p_job->i_ref_len * 4);
+    p_job->i_shift = i_shift;
+  }
+
+#ifdef HAVE_RIP_THREAD
+  /* The last slot, if it wasn't filled. */
+  if (p_job->i_fill)
+    rip_ring_publish(p_job);
+#endif
+  p_job->stats.i_sectors = p_job->i_sectors;
+  return DRIVER_OP_SUCCESS;
+}
+
+#ifdef HAVE_RIP_THREAD
+static void *
+rip_thread(void *p_arg)
+{
+  rip_job_t *p_job = p_arg;
+  p_job->i_read_status = rip_run(p_job);
+  __sync_synchronize();
+  p_job->b_done = true;
+  rip_ring_wake(p_job);
+  return NULL;
+}
+
+/* Run the reader on its own thread and the callback on this one. */
+static driver_return_code_t
+rip_run_threaded(rip_job_t *p_job)
+{
+  driver_return_code_t i_ret = DRIVER_OP_SUCCESS;
+  pthread_t thread;
+  unsigned int i;
+
+  p_job->i_slot_size = (size_t) p_job->opts.i_batch * CDIO_CD_FRAMESIZE_RAW;
+  for (i = 0; i < RIP_SLOTS; i++) {
+    p_job->p_slot[i] = malloc(p_job->i_slot_size);
+    if (!p_job->p_slot[i]) {
+      while (i--) free(p_job->p_slot[i]);
+      return DRIVER_OP_ERROR;
+    }
+  }
+  pthread_mutex_init(&p_job->lock, NULL);
+  pthread_cond_init(&p_job->wake, NULL);
+
+  if (0 != pthread_create(&thread, NULL, rip_thread, p_job)) {
+    cdio_warn("can't start the audio extraction thread");
+    i_ret = DRIVER_OP_ERROR;
+    goto done;
+  }
+
+  for (;;) {
+    const bool b_done = p_job->b_done;
+    __sync_synchronize();
+    if (p_job->i_tail != p_job->i_head) {
+      const unsigned long i_slot = p_job->i_tail % RIP_SLOTS;
+      i_ret = p_job->callback(p_job->p_slot[i_slot],
+                              p_job->i_slot_bytes[i_slot],
+                              p_job->p_user_data);
+      if (DRIVER_OP_SUCCESS != i_ret) p_job->b_stop = true;
+      __sync_synchronize();
+      p_job->i_tail++;
+      rip_ring_wake(p_job);
+      if (DRIVER_OP_SUCCESS != i_ret) break;
+    } else if (b_done)
+      break;
+    else
+      rip_ring_sleep(p_job, false);
+  }
+  pthread_join(thread, NULL);
+  if (DRIVER_OP_SUCCESS == i_ret) i_ret = p_job->i_read_status;
+
+ done:
+  pthread_cond_destroy(&p_job->wake);
+  pthread_mutex_destroy(&p_job->lock);
+  for (i = 0; i < RIP_SLOTS; i++) free(p_job->p_slot[i]);
+  return i_ret;
+}
+#endif /* HAVE_RIP_THREAD */
+
+/*!
+  Extract the i_sectors audio sectors from i_lsn, passing their PCM
+  to callback.
+*/
+driver_return_code_t
+cdio_rip_audio(CdIo_t *p_cdio, lsn_t i_lsn, uint32_t i_sectors,
+               const cdio_rip_options_t *p_options,
+               cdio_rip_callback_t callback, void *p_user_data,
+               /*out*/ cdio_rip_stats_t *p_stats)
+{
+  rip_job_t job;
+  driver_return_code_t i_ret;
+  lsn_t i_leadout;
+  uint32_t i_extra;
+
+  if (p_stats) memset(p_stats, 0, sizeof(cdio_rip_stats_t));
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!callback) return DRIVER_OP_BAD_POINTER;
+  if (CDIO_INVALID_LSN == i_lsn || i_lsn < 0)
+    return DRIVER_OP_BAD_PARAMETER;
+  if (0 == i_sectors) return DRIVER_OP_SUCCESS;
+
+  memset(&job, 0, sizeof(job));
+  if (p_options) job.opts = *p_options;
+  if (0 == job.opts.i_batch)   job.opts.i_batch   = CDIO_RIP_BATCH;
+  if (0 == job.opts.i_overlap) job.opts.i_overlap = CDIO_RIP_OVERLAP;
+  if (0 == job.opts.i_jitter)  job.opts.i_jitter  = CDIO_RIP_JITTER;
+  if (0 == job.opts.i_tries)   job.opts.i_tries   = CDIO_RIP_TRIES;
+  if (job.opts.i_batch < 2 * job.opts.i_overlap)
+    job.opts.i_batch = 2 * job.opts.i_overlap;
+  if (job.opts.i_jitter > job.opts.i_overlap * SAMPLES / 3)
+    job.opts.i_jitter = job.opts.i_overlap * SAMPLES / 3;
+
+  job.p_cdio      = p_cdio;
+  job.i_lsn       = i_lsn;
+  job.i_sectors   = i_sectors;
+  job.callback    = callback;
+  job.p_user_data = p_user_data;
+
+  /* Read a little past the end where the disc goes on, to make up
+     for a shift there. */
+  i_extra = (job.opts.i_jitter + SAMPLES - 1) / SAMPLES;
+  i_leadout = cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);
+  job.i_readable = i_sectors;
+  if (CDIO_INVALID_LSN != i_leadout && i_leadout > i_lsn + (lsn_t) i_sectors) {
+    const lsn_t i_after = i_leadout - i_lsn - (lsn_t) i_sectors;
+    job.i_readable += i_after < (lsn_t) i_extra ? (uint32_t) i_after : i_extra;
+  }
+
+  job.p_read = malloc((size_t) job.opts.i_batch * CDIO_CD_FRAMESIZE_RAW);
+  job.p_ref  = malloc((size_t) job.opts.i_overlap * CDIO_CD_FRAMESIZE_RAW);
+  job.p_hits = malloc(2 * job.opts.i_jitter + 1);
+  if (!job.p_read || !job.p_ref || !job.p_hits)
+    i_ret = DRIVER_OP_ERROR;
+  else {
+#ifdef HAVE_RIP_THREAD
+    i_ret = rip_run_threaded(&job);
+#else
+    i_ret = rip_run(&job);
+#endif
+  }
+  free(job.p_hits);
+  free(job.p_ref);
+  free(job.p_read);
+
+  if (p_stats) *p_stats = job.stats;
+  return i_ret;
+}
+
+/*!
+  Extract audio track i_track with cdio_rip_audio().
+*/
+driver_return_code_t
+cdio_rip_track(CdIo_t *p_cdio, track_t i_track,
+               const cdio_rip_options_t *p_options,
+               cdio_rip_callback_t callback, void *p_user_data,
+               /*out*/ cdio_rip_stats_t *p_stats)
+{
+  lsn_t i_first, i_last;
+
+  if (p_stats) memset(p_stats, 0, sizeof(cdio_rip_stats_t));
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (TRACK_FORMAT_AUDIO != cdio_get_track_format(p_cdio, i_track))
+    return DRIVER_OP_BAD_PARAMETER;
+  i_first = cdio_get_track_lsn(p_cdio, i_track);
+  i_last  = cdio_get_track_last_lsn(p_cdio, i_track);
+  if (CDIO_INVALID_LSN == i_first || CDIO_INVALID_LSN == i_last
+      || i_last < i_first)
+    return DRIVER_OP_ERROR;
+  return cdio_rip_audio(p_cdio, i_first, (uint32_t) (i_last - i_first + 1),
+                        p_options, callback, p_user_data, p_stats);
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,114 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file stats.c
+ *
+ *  \brief I/O statistics and tracing for CdIo_t objects.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#include <cdio/cdio.h>
+#include "cdio_private.h"
+
+/*!
+  Return a short name for e_op, like "read_audio" or "mmc", suitable
+  for use as a metric label.
+*/
+const char *
+cdio_stats_op2str(cdio_stats_op_t e_op)
+{
+  switch (e_op) {
+  case CDIO_STATS_READ_AUDIO: return "read_audio";
+  case CDIO_STATS_READ_DATA:  return "read_data";
+  case CDIO_STATS_READ_MODE1: return "read_mode1";
+  case CDIO_STATS_READ_MODE2: return "read_mode2";
+  case CDIO_STATS_READ:       return "read";
+  case CDIO_STATS_SEEK:       return "seek";
+  case CDIO_STATS_MMC:        return "mmc";
+  case CDIO_STATS_OP_COUNT:   break;
+  }
+  return "unknown";
+}
+
+/*!
+  Copy the I/O statistics of p_cdio into p_stats.
+*/
+driver_return_code_t
+cdio_get_stats(const CdIo_t *p_cdio, /*out*/ cdio_stats_t *p_stats)
+{
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  *p_stats = p_cdio->stats.stats;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Set all of the I/O statistics of p_cdio back to zero.
+*/
+driver_return_code_t
+cdio_reset_stats(CdIo_t *p_cdio)
+{
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  cdio_stats_state_reset(&p_cdio->stats);
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Install or, if callback is NULL, remove the trace callback of
+  p_cdio.
+*/
+driver_return_code_t
+cdio_set_trace_callback(CdIo_t *p_cdio, cdio_trace_callback_t callback,
+                        void *p_user_data)
+{
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  p_cdio->stats.trace_callback = callback;
+  p_cdio->stats.p_trace_data   = callback ? p_user_data : NULL;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Stands in for a driver's run_mmc_cmd in CdIo_t.op so that every MMC
+  command sent through the operation table is counted and traced.
+*/
+driver_return_code_t
+cdio_stats_run_mmc_cmd(void *p_user_data, unsigned int i_timeout_ms,
+                       unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                       cdio_mmc_direction_t e_direction, unsigned int i_buf,
+                       /*in/out*/ void *p_buf)
+{
+  CdIo_t *p_cdio = ((generic_img_private_t *) p_user_data)->cdio;
+  const uint64_t i_start = cdio_stats_now();
+  driver_return_code_t i_ret =
+    p_cdio->driver_run_mmc_cmd(p_user_data, i_timeout_ms, i_cdb, p_cdb,
+                               e_direction, i_buf, p_buf);
+  cdio_stats_record(&p_cdio->stats, cdio_stats_source(p_cdio),
+                    CDIO_STATS_MMC, CDIO_INVALID_LSN, 0, 0,
+                    p_cdb ? p_cdb->field[0] : 0, i_ret, i_start);
+  return i_ret;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,162 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Bookkeeping behind <cdio/stats.h>. This is shared by libcdio,
+   libiso9660 and libudf; everything here is inline so that none of it
+   has to be exported. */
+
+#ifndef CDIO_DRIVER_STATS_PRIVATE_H_
+#define CDIO_DRIVER_STATS_PRIVATE_H_
+
+#if defined(HAVE_CONFIG_H) && !defined(LIBCDIO_CONFIG_H)
+# include "config.h"
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <time.h>
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/util.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  /*! Statistics and trace hook carried by each CdIo_t, iso9660_t and
+    udf_t. */
+  typedef struct {
+    cdio_stats_t          stats;
+    cdio_trace_callback_t trace_callback;
+    void                 *p_trace_data;
+    lsn_t                 i_next_lsn; /**< Where a read continuing the
+                                         previous one would start, or
+                                         CDIO_INVALID_LSN. */
+  } cdio_stats_state_t;
+
+  static CDIO_INLINE void
+  cdio_stats_state_init(cdio_stats_state_t *p_state)
+  {
+    memset(p_state, 0, sizeof(*p_state));
+    p_state->i_next_lsn = CDIO_INVALID_LSN;
+  }
+
+  static CDIO_INLINE void
+  cdio_stats_state_reset(cdio_stats_state_t *p_state)
+  {
+    memset(&p_state->stats, 0, sizeof(p_state->stats));
+    p_state->i_next_lsn = CDIO_INVALID_LSN;
+  }
+
+  /*! Return a monotonic time stamp in nanoseconds. Only differences
+    between two of these mean anything. */
+  static CDIO_INLINE uint64_t
+  cdio_stats_now(void)
+  {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+      return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+#ifdef HAVE_GETTIMEOFDAY
+    {
+      struct timeval tv;
+      if (0 == gettimeofday(&tv, NULL))
+        return (uint64_t) tv.tv_sec * 1000000000 + tv.tv_usec * 1000;
+    }
+#endif
+    return 0;
+  }
+
+  /*!
+    Account for a driver operation which started at i_start (from
+    cdio_stats_now()) and has just finished with status i_status,
+    and pass it on to the trace callback if there is one.
+
+    For reads, i_lsn and i_blocks give the sectors asked for and
+    i_bytes how many bytes came back; i_lsn is CDIO_INVALID_LSN for
+    reads which aren't sector-addressed. i_mmc_opcode is only used for
+    CDIO_STATS_MMC.
+  */
+  static CDIO_INLINE void
+  cdio_stats_record(cdio_stats_state_t *p_state, const char *psz_source,
+                    cdio_stats_op_t e_op, lsn_t i_lsn, uint32_t i_blocks,
+                    uint64_t i_bytes, uint8_t i_mmc_opcode, int i_status,
+                    uint64_t i_start)
+  {
+    cdio_stats_t *p_stats = &p_state->stats;
+    const uint64_t i_nsec = cdio_stats_now() - i_start;
+    const bool b_ok = (i_status >= 0);
+
+    p_stats->op[e_op].i_calls++;
+    p_stats->op[e_op].i_nsec += i_nsec;
+    if (!b_ok) p_stats->op[e_op].i_errors++;
+
+    switch (e_op) {
+    case CDIO_STATS_SEEK:
+      p_stats->i_seeks++;
+      p_state->i_next_lsn = CDIO_INVALID_LSN;
+      break;
+    case CDIO_STATS_MMC:
+      p_stats->i_mmc_cmds++;
+      break;
+    default:
+      p_stats->i_read_calls++;
+      if (CDIO_INVALID_LSN != i_lsn) {
+        if (i_lsn != p_state->i_next_lsn) p_stats->i_seeks++;
+        p_state->i_next_lsn = b_ok ? i_lsn + i_blocks : CDIO_INVALID_LSN;
+      }
+      if (b_ok) {
+        p_stats->i_sectors_read += i_blocks;
+        p_stats->i_bytes_copied += i_bytes;
+      } else
+        i_bytes = 0;
+    }
+
+    if (p_state->trace_callback) {
+      cdio_trace_event_t event;
+      event.e_op         = e_op;
+      event.psz_source   = psz_source;
+      event.i_lsn        = i_lsn;
+      event.i_blocks     = i_blocks;
+      event.i_bytes      = (CDIO_STATS_MMC == e_op) ? 0 : i_bytes;
+      event.i_mmc_opcode = (CDIO_STATS_MMC == e_op) ? i_mmc_opcode : 0;
+      event.i_status     = i_status;
+      event.i_nsec       = i_nsec;
+      p_state->trace_callback(&event, p_state->p_trace_data);
+    }
+  }
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_DRIVER_STATS_PRIVATE_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
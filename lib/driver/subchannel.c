@@ -0,0 +1,662 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** \file subchannel.c
+ *
+ *  \brief Decoding Q sub-channel, and scanning a disc for what it
+ *  holds.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/mmc_hl_cmds.h>
+#include <cdio/subchannel.h>
+
+/* How far the address in a Q frame may be from the sector it was
+   read with. Drives often return the Q of a neighbouring sector. */
+#define SUBQ_SLACK 10
+/* Sectors read by each probe of an index search, and how often a
+   probe without a sound position frame is read again. */
+#define SUBQ_PROBE        4
+#define SUBQ_PROBE_TRIES  3
+/* The usual pregap, where the search for one starts. */
+#define SUBQ_PREGAP     150
+/* Sectors read at the start of a track for its ISRC and the MCN. */
+#define SUBQ_HARVEST    200
+
+uint16_t
+cdio_subq_crc(const uint8_t *p_q)
+{
+  /* CRC-16-CCITT, x^16 + x^12 + x^5 + 1, stored inverted. */
+  uint16_t i_crc = 0;
+  unsigned int i, j;
+
+  for (i = 0; i < 10; i++) {
+    i_crc ^= (uint16_t) p_q[i] << 8;
+    for (j = 0; j < 8; j++)
+      i_crc = (i_crc & 0x8000) ? (i_crc << 1) ^ 0x1021 : i_crc << 1;
+  }
+  return (uint16_t) ~i_crc;
+}
+
+/* Convert BCD byte i_bcd into *pi, or return false if it isn't BCD. */
+static bool
+subq_bcd(uint8_t i_bcd, /*out*/ int *pi)
+{
+  if ((i_bcd >> 4) > 9 || (i_bcd & 0xf) > 9) return false;
+  *pi = (i_bcd >> 4) * 10 + (i_bcd & 0xf);
+  return true;
+}
+
+/* Convert the BCD minute, second and frame at p into a frame count. */
+static bool
+subq_msf(const uint8_t *p, /*out*/ int32_t *pi_frames)
+{
+  int m, s, f;
+
+  if (!subq_bcd(p[0], &m) || !subq_bcd(p[1], &s) || !subq_bcd(p[2], &f)
+      || s >= 60 || f >= CDIO_CD_FRAMES_PER_SEC)
+    return false;
+  *pi_frames = (m * 60 + s) * CDIO_CD_FRAMES_PER_SEC + f;
+  return true;
+}
+
+/* The ISRC character with 6-bit code i_code, or 0 if there is none. */
+static char
+subq_isrc_char(unsigned int i_code)
+{
+  if (i_code <= 9) return '0' + i_code;
+  if (i_code >= 17 && i_code <= 42) return 'A' + (i_code - 17);
+  return 0;
+}
+
+bool
+cdio_subq_decode(const uint8_t *p_q, /*out*/ cdio_subq_t *p_subq)
+{
+  const uint16_t i_crc = (p_q[10] << 8) | p_q[11];
+  unsigned int i;
+
+  if (0 != i_crc && cdio_subq_crc(p_q) != i_crc) return false;
+
+  memset(p_subq, 0, sizeof(cdio_subq_t));
+  p_subq->i_control = p_q[0] >> 4;
+  p_subq->i_adr     = p_q[0] & 0xf;
+  p_subq->i_lsn     = CDIO_INVALID_LSN;
+
+  switch (p_subq->i_adr) {
+  case CDIO_SUBQ_POSITION:
+    {
+      int i_track, i_index;
+      int32_t i_rel, i_abs;
+
+      if (CDIO_SUBQ_LEADOUT == p_q[1])
+        i_track = CDIO_SUBQ_LEADOUT;
+      else if (!subq_bcd(p_q[1], &i_track) || 0 == i_track)
+        return false;
+      if (!subq_bcd(p_q[2], &i_index)
+          || !subq_msf(p_q + 3, &i_rel) || !subq_msf(p_q + 7, &i_abs))
+        return false;
+      p_subq->i_track = i_track;
+      p_subq->i_index = i_index;
+      /* The relative time counts down to index 1 in the pregap. */
+      p_subq->i_rel   = (0 == i_index && CDIO_SUBQ_LEADOUT != i_track)
+        ? -i_rel : i_rel;
+      p_subq->i_lsn   = i_abs - CDIO_PREGAP_SECTORS;
+      return true;
+    }
+
+  case CDIO_SUBQ_MCN:
+    /* 13 BCD digits. */
+    for (i = 0; i < CDIO_MCN_SIZE; i++) {
+      const unsigned int i_digit =
+        (i % 2) ? p_q[1 + i / 2] & 0xf : p_q[1 + i / 2] >> 4;
+      if (i_digit > 9) return false;
+      p_subq->psz_text[i] = '0' + i_digit;
+    }
+    return true;
+
+  case CDIO_SUBQ_ISRC:
+    {
+      /* Five 6-bit characters, then seven BCD digits. */
+      const unsigned int i_codes[5] = {
+        p_q[1] >> 2,
+        ((p_q[1] & 0x3) << 4) | (p_q[2] >> 4),
+        ((p_q[2] & 0xf) << 2) | (p_q[3] >> 6),
+        p_q[3] & 0x3f,
+        p_q[4] >> 2
+      };
+      for (i = 0; i < 5; i++)
+        if (0 == (p_subq->psz_text[i] = subq_isrc_char(i_codes[i])))
+          return false;
+      for (i = 0; i < 7; i++) {
+        const unsigned int i_digit =
+          (i % 2) ? p_q[5 + i / 2] & 0xf : p_q[5 + i / 2] >> 4;
+        if (i_digit > 9) return false;
+        p_subq->psz_text[5 + i] = '0' + i_digit;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+static void
+scan_reset(cdio_subq_scan_t *p_scan)
+{
+  unsigned int i, j;
+
+  memset(p_scan, 0, sizeof(cdio_subq_scan_t));
+  p_scan->i_first_track = CDIO_INVALID_TRACK;
+  p_scan->i_last_track  = CDIO_INVALID_TRACK;
+  for (i = 0; i <= CDIO_CD_MAX_TRACKS; i++)
+    for (j = 0; j <= CDIO_SUBQ_MAX_INDEX; j++)
+      p_scan->track[i].i_index[j] = CDIO_INVALID_LSN;
+}
+
+static void
+scan_saw_track(cdio_subq_scan_t *p_scan, track_t i_track)
+{
+  if (CDIO_INVALID_TRACK == p_scan->i_first_track
+      || i_track < p_scan->i_first_track)
+    p_scan->i_first_track = i_track;
+  if (CDIO_INVALID_TRACK == p_scan->i_last_track
+      || i_track > p_scan->i_last_track)
+    p_scan->i_last_track = i_track;
+}
+
+/* Fill in p_scan, for the tracks in the i_sectors from i_lsn, from
+   what the driver knows without sub-channel. */
+static void
+scan_from_driver(CdIo_t *p_cdio, lsn_t i_lsn, uint32_t i_sectors,
+                 cdio_subq_scan_t *p_scan)
+{
+  const track_t i_first  = cdio_get_first_track_num(p_cdio);
+  const track_t i_tracks = cdio_get_num_tracks(p_cdio);
+  char *psz;
+  track_t i;
+
+  p_scan->b_subchannel = false;
+  if (NULL != (psz = cdio_get_mcn(p_cdio))) {
+    strncpy(p_scan->psz_mcn, psz, CDIO_MCN_SIZE);
+    free(psz);
+  }
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks)
+    return;
+
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    cdio_subq_track_t *p_track = &p_scan->track[i];
+    const lsn_t i_start  = cdio_get_track_lsn(p_cdio, i);
+    const lsn_t i_pregap = cdio_get_track_pregap_lsn(p_cdio, i);
+    const lsn_t i_begin  = (CDIO_INVALID_LSN != i_pregap && i_pregap < i_start)
+      ? i_pregap : i_start;
+    const lsn_t i_last   = cdio_get_track_last_lsn(p_cdio, i);
+    const track_format_t format = cdio_get_track_format(p_cdio, i);
+
+    if (CDIO_INVALID_LSN == i_start || i_last < i_lsn
+        || i_begin >= i_lsn + (lsn_t) i_sectors)
+      continue;
+
+    scan_saw_track(p_scan, i);
+    p_track->i_index[1]   = i_start;
+    p_track->i_last_index = 1;
+    if (i_begin < i_start) p_track->i_index[0] = i_begin;
+
+    if (TRACK_FORMAT_AUDIO != format) p_track->i_control |= 0x4;
+    if (4 == cdio_get_track_channels(p_cdio, i)) p_track->i_control |= 0x8;
+    if (CDIO_TRACK_FLAG_TRUE == cdio_get_track_copy_permit(p_cdio, i))
+      p_track->i_control |= 0x2;
+    if (CDIO_TRACK_FLAG_TRUE == cdio_get_track_preemphasis(p_cdio, i))
+      p_track->i_control |= 0x1;
+
+    if (TRACK_FORMAT_AUDIO == format
+        && NULL != (psz = cdio_get_track_isrc(p_cdio, i))) {
+      strncpy(p_track->psz_isrc, psz, CDIO_ISRC_SIZE);
+      free(psz);
+    }
+  }
+}
+
+/* Take the i_len characters of psz_text for psz_field once they are
+   certain: at once if their frame had a CRC, otherwise once they have
+   been seen twice in a row in psz_pending. */
+static void
+scan_take(char *psz_field, size_t i_len, const char *psz_text, bool b_crc,
+          char *psz_pending)
+{
+  if (*psz_field) return;
+  if (b_crc || 0 == strcmp(psz_pending, psz_text)) {
+    memcpy(psz_field, psz_text, i_len);
+    psz_field[i_len] = '\0';
+  } else {
+    memcpy(psz_pending, psz_text, i_len);
+    psz_pending[i_len] = '\0';
+  }
+}
+
+/* Reads of Q into a scan. */
+typedef struct {
+  CdIo_t           *p_cdio;
+  mmc_read_batch_t *p_batch;
+  cdio_subq_scan_t *p_scan;
+  lsn_t             i_leadout;
+  track_t           i_track;     /* of the last position seen */
+  lsn_t             i_offset;    /* of the Q the drive gives from the
+                                    sector asked for */
+  char              psz_mcn_pending[CDIO_MCN_SIZE + 1];
+  char              psz_isrc_pending[CDIO_ISRC_SIZE + 1];
+} subq_reader_t;
+
+/* Read the Q of i_blocks sectors from i_lsn, taking in the MCN and
+   ISRCs they hold. If b_indices, also record where each index
+   starts. If p_first isn't NULL, set it to the first position frame
+   read that is sound, and return DRIVER_OP_ERROR if there is none. */
+static driver_return_code_t
+subq_read(subq_reader_t *p_rd, lsn_t i_lsn, uint32_t i_blocks,
+          bool b_indices, /*out*/ cdio_subq_t *p_first)
+{
+  cdio_subq_scan_t *p_scan = p_rd->p_scan;
+  driver_return_code_t rc =
+    mmc_read_cd_batch(p_rd->p_cdio, i_lsn, i_blocks, p_rd->p_batch);
+  bool b_first = false;
+  uint32_t i;
+
+  p_scan->i_reads++;
+  if (DRIVER_OP_SUCCESS != rc) return rc;
+  if (!(p_rd->p_batch->i_filled & MMC_READ_PLANE_SUBQ))
+    return DRIVER_OP_UNSUPPORTED;
+  p_scan->i_sectors += i_blocks;
+
+  for (i = 0; i < i_blocks; i++) {
+    const uint8_t *p_q = p_rd->p_batch->p_subq + (size_t) i * MMC_SUBQ_SIZE;
+    const bool b_crc = 0 != (p_q[10] | p_q[11]);
+    cdio_subq_t q;
+
+    if (!cdio_subq_decode(p_q, &q)) {
+      p_scan->i_bad++;
+      continue;
+    }
+    switch (q.i_adr) {
+    case CDIO_SUBQ_POSITION:
+      if (q.i_lsn < i_lsn + (lsn_t) i - SUBQ_SLACK
+          || q.i_lsn > i_lsn + (lsn_t) i + SUBQ_SLACK) {
+        p_scan->i_bad++;
+        break;
+      }
+      if (p_first && !b_first) {
+        *p_first = q;
+        b_first = true;
+        p_rd->i_offset = q.i_lsn - (i_lsn + (lsn_t) i);
+      }
+      if (CDIO_SUBQ_LEADOUT == q.i_track
+          || q.i_track > CDIO_CD_MAX_TRACKS) {
+        p_rd->i_track = CDIO_INVALID_TRACK;
+        break;
+      }
+      if (q.i_track != p_rd->i_track) {
+        p_rd->i_track = q.i_track;
+        p_rd->psz_isrc_pending[0] = '\0';
+      }
+      scan_saw_track(p_scan, q.i_track);
+      p_scan->track[q.i_track].i_control = q.i_control;
+      if (b_indices) {
+        cdio_subq_track_t *p_track = &p_scan->track[q.i_track];
+        if (CDIO_INVALID_LSN == p_track->i_index[q.i_index]
+            || q.i_lsn < p_track->i_index[q.i_index])
+          p_track->i_index[q.i_index] = q.i_lsn;
+        if (q.i_index > p_track->i_last_index)
+          p_track->i_last_index = q.i_index;
+      }
+      break;
+    case CDIO_SUBQ_MCN:
+      scan_take(p_scan->psz_mcn, CDIO_MCN_SIZE, q.psz_text, b_crc,
+                p_rd->psz_mcn_pending);
+      break;
+    case CDIO_SUBQ_ISRC:
+      if (CDIO_INVALID_TRACK != p_rd->i_track)
+        scan_take(p_scan->track[p_rd->i_track].psz_isrc, CDIO_ISRC_SIZE,
+                  q.psz_text, b_crc, p_rd->psz_isrc_pending);
+      break;
+    }
+  }
+  return (p_first && !b_first) ? DRIVER_OP_ERROR : DRIVER_OP_SUCCESS;
+}
+
+/* Start reading Q from p_cdio into p_scan, which is reset. */
+static driver_return_code_t
+subq_reader_init(subq_reader_t *p_rd, CdIo_t *p_cdio,
+                 cdio_subq_scan_t *p_scan, uint32_t i_max_blocks)
+{
+  memset(p_rd, 0, sizeof(subq_reader_t));
+  scan_reset(p_scan);
+  p_rd->p_cdio    = p_cdio;
+  p_rd->p_scan    = p_scan;
+  p_rd->i_track   = CDIO_INVALID_TRACK;
+  p_rd->i_leadout = cdio_get_disc_last_lsn(p_cdio);
+  if (CDIO_INVALID_LSN == p_rd->i_leadout) return DRIVER_OP_ERROR;
+  p_rd->p_batch = mmc_read_batch_new(MMC_READ_PLANE_SUBQ, i_max_blocks);
+  if (!p_rd->p_batch) return DRIVER_OP_ERROR;
+  p_scan->b_subchannel = true;
+  return DRIVER_OP_SUCCESS;
+}
+
+driver_return_code_t
+cdio_subq_scan(CdIo_t *p_cdio, lsn_t i_lsn, uint32_t i_sectors,
+               /*out*/ cdio_subq_scan_t *p_scan)
+{
+  subq_reader_t rd;
+  driver_return_code_t rc;
+  uint32_t i_done = 0;
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_scan) return DRIVER_OP_BAD_POINTER;
+
+  rc = subq_reader_init(&rd, p_cdio, p_scan, CDIO_SUBQ_SCAN_BATCH);
+  if (DRIVER_OP_SUCCESS != rc) return rc;
+  if (0 == i_sectors) {
+    if (rd.i_leadout <= i_lsn) {
+      mmc_read_batch_free(rd.p_batch);
+      return DRIVER_OP_BAD_PARAMETER;
+    }
+    i_sectors = rd.i_leadout - i_lsn;
+  }
+
+  while (i_done < i_sectors) {
+    const uint32_t i_blocks = (i_sectors - i_done < CDIO_SUBQ_SCAN_BATCH)
+      ? i_sectors - i_done : CDIO_SUBQ_SCAN_BATCH;
+
+    rc = subq_read(&rd, i_lsn + i_done, i_blocks, true, NULL);
+    if (0 == i_done && DRIVER_OP_UNSUPPORTED == rc) {
+      mmc_read_batch_free(rd.p_batch);
+      scan_reset(p_scan);
+      scan_from_driver(p_cdio, i_lsn, i_sectors, p_scan);
+      return DRIVER_OP_SUCCESS;
+    }
+    if (DRIVER_OP_SUCCESS != rc) break;
+    i_done += i_blocks;
+  }
+
+  mmc_read_batch_free(rd.p_batch);
+  cdio_debug("Q scan of %u sectors: tracks %u to %u, %u frames rejected",
+             (unsigned int) p_scan->i_sectors,
+             (unsigned int) p_scan->i_first_track,
+             (unsigned int) p_scan->i_last_track,
+             (unsigned int) p_scan->i_bad);
+  return rc;
+}
+
+/* Read the first sound position frame at or just after i_lsn into
+   p_q. Some drives give the Q of a sector a little way off from the
+   one asked for; the read is moved by as much as the last one was
+   off, so the frame is usually that of i_lsn itself. */
+static driver_return_code_t
+subq_probe(subq_reader_t *p_rd, lsn_t i_lsn, /*out*/ cdio_subq_t *p_q)
+{
+  unsigned int i_try;
+  driver_return_code_t rc = DRIVER_OP_ERROR;
+
+  i_lsn -= p_rd->i_offset;
+  if (i_lsn > p_rd->i_leadout - SUBQ_PROBE)
+    i_lsn = p_rd->i_leadout - SUBQ_PROBE;
+  if (i_lsn < 0) i_lsn = 0;
+  /* An ISRC is only put down to the track of a frame read with it. */
+  p_rd->i_track = CDIO_INVALID_TRACK;
+  for (i_try = 0; i_try < SUBQ_PROBE_TRIES; i_try++) {
+    rc = subq_read(p_rd, i_lsn, SUBQ_PROBE, false, p_q);
+    if (DRIVER_OP_ERROR != rc) break;
+  }
+  return rc;
+}
+
+/* Whether position p_q is at or past index i_index of track i_track. */
+static bool
+subq_past(const cdio_subq_t *p_q, track_t i_track, uint8_t i_index)
+{
+  if (CDIO_SUBQ_LEADOUT == p_q->i_track) return true;
+  return p_q->i_track > i_track
+    || (p_q->i_track == i_track && p_q->i_index >= i_index);
+}
+
+/* Find the first sector past index i_index of track i_track, knowing
+   that i_lo isn't and i_hi is, by bisection. Each probe is placed by
+   the address its Q gives, so a drive returning the Q of a nearby
+   sector still gives an exact answer. A sector whose Q is an MCN or
+   an ISRC has no address of its own, and its probe gives the one
+   after it; then the sectors either side are tried, and if none
+   between i_lo and i_hi has an address, the sector is taken to be in
+   the index before, as the player would show it. p_q is set to the
+   frame found at the answer. */
+static driver_return_code_t
+subq_bisect(subq_reader_t *p_rd, lsn_t i_lo, lsn_t i_hi, track_t i_track,
+            uint8_t i_index, /*out*/ lsn_t *pi_lsn, cdio_subq_t *p_q)
+{
+  static const int ai_near[] = { 0, -1, 1 };
+
+  while (i_hi - i_lo > 1) {
+    const lsn_t i_mid = i_lo + (i_hi - i_lo) / 2;
+    cdio_subq_t q;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(ai_near) / sizeof(ai_near[0]); i++) {
+      const lsn_t i_at = i_mid + ai_near[i];
+      driver_return_code_t rc;
+
+      if (i_at <= i_lo || i_at >= i_hi) continue;
+      rc = subq_probe(p_rd, i_at, &q);
+      if (DRIVER_OP_SUCCESS != rc) return rc;
+      if (q.i_lsn > i_lo && q.i_lsn < i_hi) break;
+    }
+    if (i == sizeof(ai_near) / sizeof(ai_near[0])) break;
+
+    if (subq_past(&q, i_track, i_index)) {
+      i_hi = q.i_lsn;
+      *p_q = q;
+    } else
+      i_lo = q.i_lsn;
+  }
+  *pi_lsn = i_hi;
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Give up on index i_index of track i_track after a probe for it
+   failed with rc: a sector whose Q can't be read loses just the index
+   it was to find. Only a driver without sub-channel stops the search. */
+static driver_return_code_t
+subq_drop(driver_return_code_t rc, track_t i_track, uint8_t i_index)
+{
+  if (DRIVER_OP_UNSUPPORTED == rc) return rc;
+  cdio_debug("Q index search: can't find index %u of track %u (%s)",
+             (unsigned int) i_index, (unsigned int) i_track,
+             cdio_driver_errmsg(rc));
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Find where the pregap of track i_track, which starts at i_start,
+   begins, if it has one. i_prev is a sector known to be before it.
+   The search gallops back from i_start to bracket the boundary, then
+   bisects, so a pregap of n sectors takes about 2 log2(n) probes. */
+static driver_return_code_t
+subq_find_pregap(subq_reader_t *p_rd, track_t i_track, lsn_t i_start,
+                 lsn_t i_prev)
+{
+  lsn_t i_lo, i_hi = i_start, i_step = SUBQ_PROBE, i_lsn;
+  cdio_subq_t q;
+  driver_return_code_t rc;
+
+  if (i_start - 1 <= i_prev) return DRIVER_OP_SUCCESS;
+  for (;;) {
+    lsn_t i_at = i_start - i_step;
+
+    if (i_at <= i_prev) {
+      i_lo = i_prev;
+      break;
+    }
+    rc = subq_probe(p_rd, i_at, &q);
+    if (DRIVER_OP_SUCCESS != rc) return subq_drop(rc, i_track, 0);
+    if (q.i_lsn > i_prev && q.i_lsn < i_hi) i_at = q.i_lsn;
+    if (!subq_past(&q, i_track, 0)) {
+      i_lo = i_at;
+      break;
+    }
+    i_hi = i_at;
+    /* Just before the usual pregap next, then ever further back. */
+    i_step = (SUBQ_PROBE == i_step) ? SUBQ_PREGAP + 1 : 2 * i_step;
+  }
+
+  rc = subq_bisect(p_rd, i_lo, i_hi, i_track, 0, &i_lsn, &q);
+  if (DRIVER_OP_SUCCESS != rc) return subq_drop(rc, i_track, 0);
+  if (i_lsn < i_start)
+    p_rd->p_scan->track[i_track].i_index[0] = i_lsn;
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Find where indices 2 and up of track i_track start, between i_start
+   and i_last, its last sector. Only a track whose end is past index 1
+   is searched. */
+static driver_return_code_t
+subq_find_indices(subq_reader_t *p_rd, track_t i_track, lsn_t i_start,
+                  lsn_t i_last)
+{
+  cdio_subq_track_t *p_track = &p_rd->p_scan->track[i_track];
+  cdio_subq_t q_end;
+  driver_return_code_t rc;
+  lsn_t i_lo = i_start, i_hi;
+  unsigned int i_index;
+
+  p_track->i_index[1]   = i_start;
+  p_track->i_last_index = 1;
+  if (i_last <= i_start) return DRIVER_OP_SUCCESS;
+
+  rc = subq_probe(p_rd, (i_last - i_start >= SUBQ_PROBE)
+                  ? i_last - SUBQ_PROBE + 1 : i_start, &q_end);
+  if (DRIVER_OP_SUCCESS != rc) return subq_drop(rc, i_track, 2);
+  if (q_end.i_track != i_track || q_end.i_index <= 1)
+    return DRIVER_OP_SUCCESS;
+  i_hi = (q_end.i_lsn > i_start && q_end.i_lsn <= i_last)
+    ? q_end.i_lsn : i_last;
+
+  for (i_index = 2; i_index <= q_end.i_index; i_index++) {
+    cdio_subq_t q = q_end;
+    lsn_t i_lsn;
+
+    rc = subq_bisect(p_rd, i_lo, i_hi, i_track, i_index, &i_lsn, &q);
+    if (DRIVER_OP_SUCCESS != rc) {
+      rc = subq_drop(rc, i_track, i_index);
+      if (DRIVER_OP_SUCCESS != rc) return rc;
+      continue;
+    }
+    /* Indices may be skipped; the frame found says which this is. */
+    if (q.i_track == i_track && q.i_index > i_index) i_index = q.i_index;
+    p_track->i_index[i_index] = i_lsn;
+    p_track->i_last_index = i_index;
+    i_lo = i_lsn;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+driver_return_code_t
+cdio_subq_find_indices(CdIo_t *p_cdio, /*out*/ cdio_subq_scan_t *p_scan)
+{
+  subq_reader_t rd;
+  driver_return_code_t rc;
+  track_t i_first, i_tracks, i;
+  lsn_t i_start[CDIO_CD_MAX_TRACKS + 2];
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_scan) return DRIVER_OP_BAD_POINTER;
+
+  i_first  = cdio_get_first_track_num(p_cdio);
+  i_tracks = cdio_get_num_tracks(p_cdio);
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || 0 == i_tracks || i_first + i_tracks - 1 > CDIO_CD_MAX_TRACKS)
+    return DRIVER_OP_ERROR;
+
+  rc = subq_reader_init(&rd, p_cdio, p_scan, SUBQ_HARVEST);
+  if (DRIVER_OP_SUCCESS != rc) return rc;
+
+  for (i = 0; i <= i_tracks; i++) {
+    i_start[i] = (i < i_tracks) ? cdio_get_track_lsn(p_cdio, i_first + i)
+                                : rd.i_leadout;
+    if (CDIO_INVALID_LSN == i_start[i] || (i && i_start[i] <= i_start[i - 1])) {
+      mmc_read_batch_free(rd.p_batch);
+      return DRIVER_OP_ERROR;
+    }
+  }
+
+  /* Pregaps first: a track ends where the next one's pregap begins. */
+  for (i = 0; i < i_tracks && DRIVER_OP_SUCCESS == rc; i++)
+    rc = subq_find_pregap(&rd, i_first + i, i_start[i],
+                          i ? i_start[i - 1] : -1);
+
+  for (i = 0; i < i_tracks && DRIVER_OP_SUCCESS == rc; i++) {
+    const track_t i_track = i_first + i;
+    const lsn_t i_next = (i + 1 < i_tracks
+                          && CDIO_INVALID_LSN
+                             != p_scan->track[i_track + 1].i_index[0])
+      ? p_scan->track[i_track + 1].i_index[0] : i_start[i + 1];
+
+    scan_saw_track(p_scan, i_track);
+    rc = subq_find_indices(&rd, i_track, i_start[i], i_next - 1);
+
+    /* MCN and ISRC frames come at least once in every 100 sectors;
+       reading a couple of hundred at the start of a track is sure to
+       catch two of each. */
+    if (DRIVER_OP_SUCCESS == rc
+        && (!p_scan->psz_mcn[0]
+            || (!(p_scan->track[i_track].i_control & 0x4)
+                && !p_scan->track[i_track].psz_isrc[0]))) {
+      const uint32_t i_blocks = (i_next - i_start[i] < SUBQ_HARVEST)
+        ? i_next - i_start[i] : SUBQ_HARVEST;
+      rd.i_track = CDIO_INVALID_TRACK;
+      if (i_blocks > 0)
+        rc = subq_read(&rd, i_start[i], i_blocks, false, NULL);
+    }
+  }
+
+  mmc_read_batch_free(rd.p_batch);
+  if (DRIVER_OP_UNSUPPORTED == rc) {
+    /* The driver has no sub-channel, so it can't have read any. */
+    scan_reset(p_scan);
+    scan_from_driver(p_cdio, 0, rd.i_leadout, p_scan);
+    return DRIVER_OP_SUCCESS;
+  }
+  cdio_debug("Q index search of %u tracks: %u reads, %u sectors",
+             (unsigned int) i_tracks, (unsigned int) p_scan->i_reads,
+             (unsigned int) p_scan->i_sectors);
+  return rc;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -173,6 +173,12 @@ track_t
 cdio_get_track(const CdIo_t *p_cdio, lsn_t lsn)
 {
   if (!p_cdio) return CDIO_INVALID_TRACK;
+
+  if (p_cdio->track_table.b_valid)
+    ((CdIo_t *) p_cdio)->stats.stats.i_cache_hits++;
+  if (cdio_track_table_ready(p_cdio))
+    return cdio_track_table_find((cdio_track_table_t *) &p_cdio->track_table,
+                                 lsn);
   
   {
     track_t i_low_track   = cdio_get_first_track_num(p_cdio);
@@ -199,6 +205,60 @@ cdio_get_track(const CdIo_t *p_cdio, lsn_t lsn)
   }
 }
 
+/*!
+  Fill in the track table of p_cdio from the driver's TOC.
+  @return true if the table could be built.
+*/
+bool
+cdio_track_table_init(CdIo_t *p_cdio)
+{
+  cdio_track_table_t *p_table = &p_cdio->track_table;
+  const track_t i_first_track = cdio_get_first_track_num(p_cdio);
+  const track_t i_last_track  = cdio_get_last_track_num(p_cdio);
+  lsn_t i_next_lsn;
+  track_t i;
+
+  if (CDIO_INVALID_TRACK == i_first_track
+      || CDIO_INVALID_TRACK == i_last_track
+      || 0 == i_first_track || i_last_track > CDIO_CD_MAX_TRACKS
+      || i_first_track > i_last_track)
+    return false;
+
+  i_next_lsn = cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);
+  if (CDIO_INVALID_LSN == i_next_lsn) return false;
+  p_table->leadout_lsn = i_next_lsn;
+
+  /* Go backwards so that the end of a track is the start of the
+     one after it. */
+  for (i = i_last_track; i >= i_first_track; i--) {
+    cdio_track_entry_t *p_entry = &p_table->entry[i];
+    p_entry->start_lsn = cdio_get_track_lsn(p_cdio, i);
+    if (CDIO_INVALID_LSN == p_entry->start_lsn) return false;
+    p_entry->end_lsn   = i_next_lsn - 1;
+    p_entry->format    = p_cdio->op.get_track_format
+      ? p_cdio->op.get_track_format(p_cdio->env, i) : TRACK_FORMAT_ERROR;
+    p_entry->b_green   = p_cdio->op.get_track_green
+      ? p_cdio->op.get_track_green(p_cdio->env, i) : false;
+    i_next_lsn = p_entry->start_lsn;
+  }
+
+  p_table->i_first_track = i_first_track;
+  p_table->i_last_track  = i_last_track;
+  p_table->i_hint        = i_first_track;
+  p_table->b_valid       = true;
+  return true;
+}
+
+/*!
+  Drop the cached track table of p_cdio so that the next lookup
+  reads the TOC again.
+*/
+void
+cdio_track_table_invalidate(CdIo_t *p_cdio)
+{
+  if (p_cdio) p_cdio->track_table.b_valid = false;
+}
+
 /*!
   Return true if we have XA data (green, mode2 form1) or
   XA data (green, mode2 form2). That is track begins:
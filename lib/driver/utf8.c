@@ -39,9 +39,130 @@
 #include <errno.h>
 #endif
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 #include <cdio/utf8.h>
 #include <cdio/logging.h>
 
+/*
+ * Converts the big-endian UCS-2 at src to UTF-8 without going
+ * through iconv: Joliet and UDF names are all UCS-2, and there are
+ * a lot of them. Runs of ASCII are copied four characters at a time.
+ */
+size_t
+cdio_ucs2be_to_utf8(const uint8_t *src, size_t src_len,
+                    cdio_utf8_t *dst, size_t dst_size)
+  {
+  size_t i = 0, j = 0;
+
+  if (dst == NULL || dst_size == 0)
+    return 0;
+  if (src == NULL)
+    src_len = 0;
+  src_len &= ~(size_t) 1;
+
+  while (i < src_len)
+    {
+    uint32_t c;
+    size_t n;
+
+    while (i + 8 <= src_len && j + 4 < dst_size
+           && (src[i] | src[i+2] | src[i+4] | src[i+6]) == 0
+           && ((src[i+1] | src[i+3] | src[i+5] | src[i+7]) & 0x80) == 0
+           && src[i+1] && src[i+3] && src[i+5] && src[i+7])
+      {
+      dst[j]   = (char) src[i+1];
+      dst[j+1] = (char) src[i+3];
+      dst[j+2] = (char) src[i+5];
+      dst[j+3] = (char) src[i+7];
+      i += 8;
+      j += 4;
+      }
+    if (i >= src_len)
+      break;
+
+    c = ((uint32_t) src[i] << 8) | src[i+1];
+    i += 2;
+    if (c == 0)
+      break;
+    if (c >= 0xD800 && c < 0xDC00 && i + 2 <= src_len
+        && src[i] >= 0xDC && src[i] < 0xE0)
+      {
+      /* A UTF-16 surrogate pair */
+      c = 0x10000 + ((c - 0xD800) << 10)
+        + ((((uint32_t) src[i] << 8) | src[i+1]) - 0xDC00);
+      i += 2;
+      }
+    else if (c >= 0xD800 && c < 0xE000)
+      c = 0xFFFD;
+
+    n = (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x10000) ? 3 : 4;
+    if (j + n >= dst_size)
+      break;
+    switch (n)
+      {
+      case 1:
+        dst[j++] = (char) c;
+        break;
+      case 2:
+        dst[j++] = (char) (0xC0 | (c >> 6));
+        dst[j++] = (char) (0x80 | (c & 0x3F));
+        break;
+      case 3:
+        dst[j++] = (char) (0xE0 | (c >> 12));
+        dst[j++] = (char) (0x80 | ((c >> 6) & 0x3F));
+        dst[j++] = (char) (0x80 | (c & 0x3F));
+        break;
+      default:
+        dst[j++] = (char) (0xF0 | (c >> 18));
+        dst[j++] = (char) (0x80 | ((c >> 12) & 0x3F));
+        dst[j++] = (char) (0x80 | ((c >> 6) & 0x3F));
+        dst[j++] = (char) (0x80 | (c & 0x3F));
+        break;
+      }
+    }
+  dst[j] = '\0';
+  return j;
+  }
+
+#ifdef HAVE_JOLIET
+/*
+ * The same, allocating the result. src_len == (size_t)-1 means src
+ * ends with a 0 character.
+ */
+static bool
+ucs2be_to_utf8_alloc(const char *src, size_t src_len, cdio_utf8_t **dst)
+  {
+  size_t dst_size;
+
+  if (src == NULL || dst == NULL)
+    return false;
+  if (src_len == (size_t)-1)
+    for (src_len = 0; src[src_len] || src[src_len+1]; src_len += 2);
+
+  /* Each 2-byte character takes at most 3 bytes; a surrogate pair
+     of 4 bytes takes 4. */
+  dst_size = (src_len / 2) * 3 + 1;
+  *dst = malloc(dst_size);
+  if (*dst == NULL)
+    {
+    cdio_warn("Can't malloc(%lu).", (unsigned long) dst_size);
+    return false;
+    }
+  cdio_ucs2be_to_utf8((const uint8_t *) src, src_len, *dst, dst_size);
+  return true;
+  }
+
+static bool
+charset_is_ucs2be(const char *charset)
+  {
+  return charset != NULL
+    && (strcmp(charset, "UCS-2BE") == 0 || strcmp(charset, "UTF-16BE") == 0);
+  }
+#endif /* HAVE_JOLIET */
+
 /* Windows requires some basic UTF-8 support outside of Joliet */
 #if defined(_WIN32)
 #include <windows.h>
@@ -246,6 +367,136 @@ do_convert(iconv_t cd, const char * src, int src_len,
   return true;
   }
 
+/*
+ * iconv_open() is expensive, so each thread keeps the converters it
+ * used last open, most recently used first.
+ */
+#define CHARSET_CACHE_SIZE 4
+#define CHARSET_NAME_SIZE  32
+
+typedef struct
+  {
+  char    src_charset[CHARSET_NAME_SIZE];
+  char    dst_charset[CHARSET_NAME_SIZE];
+  iconv_t ic;
+  } charset_cache_entry_t;
+
+typedef struct
+  {
+  unsigned int          num_entries;
+  charset_cache_entry_t entries[CHARSET_CACHE_SIZE];
+  } charset_cache_t;
+
+#ifdef HAVE_PTHREAD_H
+static pthread_once_t charset_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  charset_key;
+
+static void
+charset_cache_free(void *arg)
+  {
+  charset_cache_t *cache = arg;
+  unsigned int i;
+
+  for (i = 0; i < cache->num_entries; i++)
+    iconv_close(cache->entries[i].ic);
+  free(cache);
+  }
+
+static void
+charset_key_create(void)
+  {
+  pthread_key_create(&charset_key, charset_cache_free);
+  }
+
+static charset_cache_t *
+charset_cache_get(void)
+  {
+  charset_cache_t *cache;
+
+  pthread_once(&charset_once, charset_key_create);
+  cache = pthread_getspecific(charset_key);
+  if (cache == NULL)
+    {
+    cache = calloc(1, sizeof(*cache));
+    if (cache != NULL && pthread_setspecific(charset_key, cache) != 0)
+      {
+      free(cache);
+      cache = NULL;
+      }
+    }
+  return cache;
+  }
+#else
+static charset_cache_t charset_cache;
+# define charset_cache_get() (&charset_cache)
+#endif
+
+/*
+ * Convert src from src_charset to dst_charset with this thread's
+ * cached converter, opening one if there isn't one yet.
+ */
+static bool
+charset_convert_cached(const char * src, int src_len, char ** dst,
+                       int * dst_len, const char * src_charset,
+                       const char * dst_charset)
+  {
+  charset_cache_t *cache = charset_cache_get();
+  charset_cache_entry_t entry;
+  unsigned int i;
+  bool result;
+
+  if (cache == NULL
+      || strlen(src_charset) >= CHARSET_NAME_SIZE
+      || strlen(dst_charset) >= CHARSET_NAME_SIZE)
+    {
+    /* Too unusual to keep */
+    iconv_t ic = iconv_open(dst_charset, src_charset);
+    if (ic == (iconv_t)-1)
+      {
+      cdio_warn("Can't convert from %s to %s: %s", src_charset,
+                dst_charset, strerror(errno));
+      return false;
+      }
+    result = do_convert(ic, src, src_len, dst, dst_len);
+    iconv_close(ic);
+    return result;
+    }
+
+  for (i = 0; i < cache->num_entries; i++)
+    if (strcmp(cache->entries[i].src_charset, src_charset) == 0
+        && strcmp(cache->entries[i].dst_charset, dst_charset) == 0)
+      break;
+
+  if (i < cache->num_entries)
+    {
+    entry = cache->entries[i];
+    /* Back to the initial shift state after whatever came before */
+    iconv(entry.ic, NULL, NULL, NULL, NULL);
+    }
+  else
+    {
+    entry.ic = iconv_open(dst_charset, src_charset);
+    if (entry.ic == (iconv_t)-1)
+      {
+      cdio_warn("Can't convert from %s to %s: %s", src_charset,
+                dst_charset, strerror(errno));
+      return false;
+      }
+    strcpy(entry.src_charset, src_charset);
+    strcpy(entry.dst_charset, dst_charset);
+    if (cache->num_entries < CHARSET_CACHE_SIZE)
+      cache->num_entries++;
+    else
+      iconv_close(cache->entries[--i].ic);
+    }
+
+  memmove(&cache->entries[1], &cache->entries[0],
+          i * sizeof(charset_cache_entry_t));
+  cache->entries[0] = entry;
+
+  return do_convert(entry.ic, src, src_len, dst, dst_len);
+  }
+
 bool cdio_charset_convert(cdio_charset_coverter_t*cnv,
                           char * src, int src_len,
                           char ** dst, int * dst_len)
@@ -258,12 +509,7 @@ bool cdio_charset_convert(cdio_charset_coverter_t*cnv,
 bool cdio_charset_from_utf8(cdio_utf8_t * src, char ** dst,
                             int * dst_len, const char * dst_charset)
   {
-  iconv_t ic;
-  bool result;
-  ic = iconv_open(dst_charset, "UTF-8");
-  result = do_convert(ic, src, -1, dst, dst_len);
-  iconv_close(ic);
-  return result;
+  return charset_convert_cached(src, -1, dst, dst_len, "UTF-8", dst_charset);
   }
 
 
@@ -272,12 +518,10 @@ bool cdio_charset_from_utf8(cdio_utf8_t * src, char ** dst,
 bool cdio_charset_to_utf8(const char *src, size_t src_len, cdio_utf8_t **dst,
                           const char * src_charset)
   {
-  iconv_t ic;
-  bool result;
-  ic = iconv_open("UTF-8", src_charset);
-  result = do_convert(ic, src, src_len, dst, NULL);
-  iconv_close(ic);
-  return result;
+  if (charset_is_ucs2be(src_charset))
+    return ucs2be_to_utf8_alloc(src, src_len, dst);
+  return charset_convert_cached(src, (int) src_len, dst, NULL, src_charset,
+                                "UTF-8");
   }
 #elif defined(_WIN32)
 
@@ -309,39 +553,12 @@ bool cdio_charset_from_utf8(cdio_utf8_t * src, char ** dst,
   return true;
   }
 
-bool cdio_charset_to_utf8(char *src, size_t src_len, cdio_utf8_t **dst,
+bool cdio_charset_to_utf8(const char *src, size_t src_len, cdio_utf8_t **dst,
                           const char * src_charset)
   {
-  wchar_t* le_src;
-  int i;
-
-  if (src == NULL || dst == NULL || src_charset == NULL || strcmp(src_charset, "UCS-2BE") != 0)
+  if (!charset_is_ucs2be(src_charset))
     return false;
-
-  /* Compute UCS-2 src length */
-  if (src_len == (size_t)-1) {
-    for (src_len = 0; ((uint16_t*)src)[src_len] !=0; src_len++);
-  } else {
-    src_len >>=1;
-  }
-
-  /* Eliminate empty strings */
-  if ((src_len < 1) || ((src[0] == 0) && (src[1] == 0))) {
-    *dst = NULL;
-    return false;
-  }
-
-  /* Perform byte reversal */
-  le_src = (wchar_t*)malloc(2*src_len+2);
-  for (i=0; i<src_len; i++) {
-    ((char*)le_src)[2*i] = src[2*i+1];
-    ((char*)le_src)[2*i+1] = src[2*i];
-  }
-  le_src[src_len] = 0;
-  *dst = cdio_wchar_to_utf8(le_src);
-  free(le_src);
-
-  return (*dst != NULL);
+  return ucs2be_to_utf8_alloc(src, src_len, dst);
 }
 #endif /* HAVE_ICONV */
 
@@ -89,6 +89,8 @@ struct _iso9660_s {
 			       filesystem inside that it may be
 			       different.
 			     */
+  char *psz_source;         /* Path the image was opened with. */
+  cdio_stats_state_t stats; /* I/O counters and trace hook. */
 };
 
 static long int iso9660_seek_read_framesize (const iso9660_t *p_iso, 
@@ -172,9 +174,11 @@ iso9660_open_ext_private (const char *psz_path,
 
   if (!p_iso) return NULL;
   
+  cdio_stats_state_init(&p_iso->stats);
   p_iso->stream = cdio_stdio_new( psz_path );
   if (NULL == p_iso->stream) 
     goto error;
+  p_iso->psz_source = strdup(psz_path);
 
   p_iso->i_framesize = ISO_BLOCKSIZE;
 
@@ -196,6 +200,7 @@ iso9660_open_ext_private (const char *psz_path,
 
  error:
   if (p_iso && p_iso->stream) cdio_stdio_destroy(p_iso->stream);
+  if (p_iso) free(p_iso->psz_source);
   free(p_iso);
   
   return NULL;
@@ -256,11 +261,48 @@ iso9660_close (iso9660_t *p_iso)
 {
   if (NULL != p_iso) {
     cdio_stdio_destroy(p_iso->stream);
+    free(p_iso->psz_source);
     free(p_iso);
   }
   return true;
 }
 
+/*!
+  Copy the I/O statistics of p_iso into p_stats.
+*/
+driver_return_code_t
+iso9660_get_stats (const iso9660_t *p_iso, /*out*/ cdio_stats_t *p_stats)
+{
+  if (!p_iso) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  *p_stats = p_iso->stats.stats;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Set all of the I/O statistics of p_iso back to zero.
+*/
+driver_return_code_t
+iso9660_reset_stats (iso9660_t *p_iso)
+{
+  if (!p_iso) return DRIVER_OP_UNINIT;
+  cdio_stats_state_reset(&p_iso->stats);
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Install or, if callback is NULL, remove the trace callback of p_iso.
+*/
+driver_return_code_t
+iso9660_set_trace_callback (iso9660_t *p_iso, cdio_trace_callback_t callback,
+			    void *p_user_data)
+{
+  if (!p_iso) return DRIVER_OP_UNINIT;
+  p_iso->stats.trace_callback = callback;
+  p_iso->stats.p_trace_data   = callback ? p_user_data : NULL;
+  return DRIVER_OP_SUCCESS;
+}
+
 static bool
 check_pvd (const iso9660_pvd_t *p_pvd, cdio_log_level_t log_level) 
 {
@@ -686,14 +728,25 @@ iso9660_seek_read_framesize (const iso9660_t *p_iso, void *ptr,
 {
   long int ret;
   int64_t i_byte_offset;
+  uint64_t i_start;
   
   if (!p_iso) return 0;
-  i_byte_offset = (start * p_iso->i_framesize) + p_iso->i_fuzzy_offset 
-    + p_iso->i_datastart;
+  i_byte_offset = ((int64_t) start * p_iso->i_framesize)
+    + p_iso->i_fuzzy_offset + p_iso->i_datastart;
 
+  i_start = cdio_stats_now();
   ret = cdio_stream_seek (p_iso->stream, i_byte_offset, SEEK_SET);
-  if (ret!=0) return 0;
-  return cdio_stream_read (p_iso->stream, ptr, i_framesize, size);
+  if (ret==0)
+    ret = cdio_stream_read (p_iso->stream, ptr, i_framesize, size);
+  else
+    ret = 0;
+  /* A short read is as good as a failed one to our callers. */
+  cdio_stats_record(&((iso9660_t *) p_iso)->stats, p_iso->psz_source,
+		    CDIO_STATS_READ, start, size, ret, 0,
+		    (ret == size * i_framesize)
+		    ? DRIVER_OP_SUCCESS : DRIVER_OP_ERROR,
+		    i_start);
+  return ret;
 }
 
 /*!
@@ -706,6 +759,47 @@ iso9660_iso_seek_read (const iso9660_t *p_iso, void *ptr, lsn_t start,
   return iso9660_seek_read_framesize(p_iso, ptr, start, size, ISO_BLOCKSIZE);
 }
 
+/*!
+  Read i_blocks blocks of the file p_stat, starting i_block blocks
+  into it, with one read per extent spanned. Size read is returned.
+*/
+long int
+iso9660_iso_seek_read_file (const iso9660_t *p_iso,
+			    const iso9660_stat_t *p_stat, void *ptr,
+			    uint64_t i_block, long int i_blocks)
+{
+  uint8_t *p_buf = ptr;
+  long int i_read = 0;
+  unsigned int i;
+
+  if (!p_iso || !p_stat || !ptr) return 0;
+
+  for (i = 0; i < p_stat->extents && i_blocks > 0; i++) {
+    const uint64_t i_extent_blocks =
+      _cdio_len2blocks(p_stat->extent_size[i], ISO_BLOCKSIZE);
+    long int i_now, i_ret;
+
+    if (i_block >= i_extent_blocks) {
+      i_block -= i_extent_blocks;
+      continue;
+    }
+    i_now = (i_extent_blocks - i_block < (uint64_t) i_blocks)
+      ? (long int) (i_extent_blocks - i_block) : i_blocks;
+
+    i_ret = iso9660_iso_seek_read(p_iso, p_buf,
+				  p_stat->extent_lsn[i] + (lsn_t) i_block,
+				  i_now);
+    if (i_ret > 0) {
+      i_read += i_ret;
+      p_buf  += i_ret;
+    }
+    if (i_ret != i_now * ISO_BLOCKSIZE) break;
+    i_blocks -= i_now;
+    i_block   = 0;
+  }
+  return i_read;
+}
+
 
 
 static iso9660_stat_t *
@@ -723,6 +817,11 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir, bool_3way_t b_xa,
 
   /* .. string in statbuf is one longer than in p_iso9660_dir's listing '\1' */
   stat_len      = sizeof(iso9660_stat_t)+i_fname+2;
+#ifdef HAVE_JOLIET
+  /* A UCS-2 character takes up to 3 bytes of UTF-8. */
+  if (i_joliet_level)
+    stat_len    = sizeof(iso9660_stat_t)+(i_fname/2)*3+2;
+#endif
 
   p_stat          = calloc(1, stat_len);
   if (!p_stat)
@@ -735,6 +834,10 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir, bool_3way_t b_xa,
   p_stat->lsn     = from_733 (p_iso9660_dir->extent);
   p_stat->size    = from_733 (p_iso9660_dir->size);
   p_stat->secsize = _cdio_len2blocks (p_stat->size, ISO_BLOCKSIZE);
+  p_stat->total_size     = p_stat->size;
+  p_stat->extents        = 1;
+  p_stat->extent_lsn[0]  = p_stat->lsn;
+  p_stat->extent_size[0] = p_stat->size;
   p_stat->rr.b3_rock = dunno; /*FIXME should do based on mask */
   p_stat->b_xa    = false; 
 
@@ -749,7 +852,7 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir, bool_3way_t b_xa,
 #endif
     
     if (i_rr_fname > 0) {
-      if (i_rr_fname > i_fname) {
+      if (sizeof(iso9660_stat_t)+i_rr_fname+2 > stat_len) {
 	/* realloc gives valgrind errors */
 	iso9660_stat_t *p_stat_new = 
 	  calloc(1, sizeof(iso9660_stat_t)+i_rr_fname+2);
@@ -770,17 +873,9 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir, bool_3way_t b_xa,
 	strncpy (p_stat->filename, "..", sizeof(".."));
 #ifdef HAVE_JOLIET
       else if (i_joliet_level) {
-	int i_inlen = i_fname;
-	cdio_utf8_t *p_psz_out = NULL;
-	if (cdio_charset_to_utf8(&p_iso9660_dir->filename.str[1], i_inlen,
-                             &p_psz_out, "UCS-2BE")) {
-          strncpy(p_stat->filename, p_psz_out, i_fname);
-          free(p_psz_out);
-        }
-        else {
-          free(p_stat);
-          return NULL;
-        }
+	cdio_ucs2be_to_utf8((const uint8_t *) &p_iso9660_dir->filename.str[1],
+			    i_fname, p_stat->filename,
+			    stat_len - sizeof(iso9660_stat_t));
       }
 #endif /*HAVE_JOLIET*/
       else {
@@ -841,6 +936,61 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir, bool_3way_t b_xa,
     
 }
 
+/*
+   A file bigger than 4 GiB has a directory record for each of its
+   extents, all with the same name and all but the last flagged
+   ISO_MULTIEXTENT. Add the extents of the records following the one
+   at *p_offset in p_dirbuf that belong to the same file to p_stat,
+   which was made from that record, leave *p_offset at the file's
+   last record and return it. If the file has more extents than
+   ISO_MAX_MULTIEXTENT, *pp_stat is freed and set to NULL.
+*/
+static iso9660_dir_t *
+_iso9660_stat_add_extents (iso9660_stat_t **pp_stat, uint8_t *p_dirbuf,
+			   unsigned int *p_offset, unsigned int i_dirsize)
+{
+  iso9660_dir_t *p_iso9660_dir = (void *) &p_dirbuf[*p_offset];
+  iso9660_stat_t *p_stat = *pp_stat;
+
+  while (p_iso9660_dir->file_flags & ISO_MULTIEXTENT) {
+    unsigned int i_next = *p_offset + iso9660_get_dir_len(p_iso9660_dir);
+    iso9660_dir_t *p_next;
+
+    /* Records don't cross blocks; the rest of a block may be padding. */
+    while (i_next < i_dirsize && !p_dirbuf[i_next])
+      i_next++;
+    if (i_next >= i_dirsize) {
+      cdio_warn("last extent of a multi-extent file is missing");
+      break;
+    }
+
+    p_next = (void *) &p_dirbuf[i_next];
+    if (from_711(p_next->filename.len) != from_711(p_iso9660_dir->filename.len)
+	|| memcmp(&p_next->filename.str[1], &p_iso9660_dir->filename.str[1],
+		  from_711(p_iso9660_dir->filename.len))) {
+      cdio_warn("last extent of a multi-extent file is missing");
+      break;
+    }
+
+    if (p_stat && p_stat->extents < ISO_MAX_MULTIEXTENT) {
+      p_stat->extent_lsn[p_stat->extents]  = from_733 (p_next->extent);
+      p_stat->extent_size[p_stat->extents] = from_733 (p_next->size);
+      p_stat->total_size += from_733 (p_next->size);
+      p_stat->extents++;
+    } else if (p_stat) {
+      cdio_warn("%s has more than %d extents; skipping it",
+		p_stat->filename, ISO_MAX_MULTIEXTENT);
+      free(p_stat->rr.psz_symlink);
+      free(p_stat);
+      p_stat = *pp_stat = NULL;
+    }
+
+    *p_offset     = i_next;
+    p_iso9660_dir = p_next;
+  }
+  return p_iso9660_dir;
+}
+
 /*!
   Return the directory name stored in the iso9660_dir_t
 
@@ -987,6 +1137,13 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
       
       p_iso9660_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, dunno, 
 					p_env->i_joliet_level);
+      p_iso9660_dir = _iso9660_stat_add_extents (&p_iso9660_stat, _dirbuf,
+						 &offset,
+						 _root->secsize * ISO_BLOCKSIZE);
+      if (!p_iso9660_stat) {
+	offset += iso9660_get_dir_len(p_iso9660_dir);
+	continue;
+      }
 
       cmp = strcmp(splitpath[0], p_iso9660_stat->filename);
 
@@ -1086,6 +1243,12 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
       
       p_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, p_iso->b_xa, 
 					p_iso->i_joliet_level);
+      p_iso9660_dir = _iso9660_stat_add_extents (&p_stat, _dirbuf, &offset,
+						 _root->secsize * ISO_BLOCKSIZE);
+      if (!p_stat) {
+	offset += iso9660_get_dir_len(p_iso9660_dir);
+	continue;
+      }
 
       cmp = strcmp(splitpath[0], p_stat->filename);
 
@@ -1292,7 +1455,11 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[], bool b_mode2)
 
 	p_iso9660_stat = _iso9660_dir_to_statbuf(p_iso9660_dir, dunno,
 						 p_env->i_joliet_level);
-	_cdio_list_append (retval, p_iso9660_stat);
+	p_iso9660_dir = _iso9660_stat_add_extents(&p_iso9660_stat, _dirbuf,
+						  &offset,
+						  p_stat->secsize * ISO_BLOCKSIZE);
+	if (p_iso9660_stat)
+	  _cdio_list_append (retval, p_iso9660_stat);
 
 	offset += iso9660_get_dir_len(p_iso9660_dir);
       }
@@ -1359,6 +1526,9 @@ iso9660_ifs_readdir (iso9660_t *p_iso, const char psz_path[])
 
 	p_iso9660_stat = _iso9660_dir_to_statbuf(p_iso9660_dir, p_iso->b_xa,
 						 p_iso->i_joliet_level);
+	p_iso9660_dir = _iso9660_stat_add_extents(&p_iso9660_stat, _dirbuf,
+						  &offset,
+						  p_stat->secsize * ISO_BLOCKSIZE);
 
 	if (p_iso9660_stat) 
 	  _cdio_list_append (retval, p_iso9660_stat);
@@ -0,0 +1,1557 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file iso9660_write.c
+ *
+ *  \brief Building ISO 9660 images, with Joliet and Rock Ridge
+ *  extensions, from a tree of files.
+ *
+ *  The tree is only a list of names and where their contents come
+ *  from until the image is written. Writing first lays out the whole
+ *  image: names, directory and path table sizes, and an extent for
+ *  everything. The image is then written front to back in one pass:
+ *  volume descriptors, path tables and directories, which are built
+ *  in memory one at a time, and then each file's contents, copied
+ *  straight from the file.
+ */
+
+#if defined(HAVE_CONFIG_H) && !defined(__CDIO_CONFIG_H__)
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDBOOL_H
+# include <stdbool.h>
+#endif
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+# include <errno.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_DIRENT_H
+# include <dirent.h>
+#endif
+#include <time.h>
+
+#include <cdio/bytesex.h>
+#include <cdio/iso9660.h>
+#include <cdio/logging.h>
+#include <cdio/rock.h>
+#include <cdio/util.h>
+
+/* Private headers */
+#include "iso9660_private.h"
+#include "cdio_assert.h"
+#include "_cdio_stdio.h"
+
+#ifndef HAVE_LSTAT
+# define lstat stat
+#endif
+
+/* No node; the root's parent. */
+#define NODE_NONE          0xffffffffU
+
+/* Path table entries refer to their parent by a 16-bit number. */
+#define WRITER_MAX_DIRS    0xffff
+
+/* The longest ISO 9660 identifier we make: a level 2 name, which is
+   at most 30 characters plus the dot, and at most 8 of them in the
+   extension. */
+#define ISO_NAME_MAX       31
+#define ISO_EXT_MAX        8
+
+/* The longest Joliet identifier we make, in UCS-2 characters, leaving
+   room for a ";1" version. */
+#define JOLIET_NAME_MAX    62
+#define JOLIET_EXT_MAX     16
+
+/* A Rock Ridge name longer than this goes in more than one NM entry. */
+#define ROCK_NM_MAX        250
+
+/* How much of a file is copied at a time. */
+#define WRITER_COPY_SIZE   (1024 * 1024)
+
+/* Sizes of the Rock Ridge entries we write. */
+#define ROCK_PX_LEN        36
+#define ROCK_TF_LEN        12
+
+#define ROCK_ER_ID   "RRIP_1991A"
+#define ROCK_ER_DES  "THE ROCK RIDGE INTERCHANGE PROTOCOL PROVIDES SUPPORT " \
+  "FOR POSIX FILE SYSTEM SEMANTICS"
+#define ROCK_ER_SRC  "PLEASE CONTACT DISC PUBLISHER FOR SPECIFICATION " \
+  "SOURCE.  SEE PUBLISHER IDENTIFIER IN PRIMARY VOLUME DESCRIPTOR FOR " \
+  "CONTACT INFORMATION."
+
+/* A file or directory in the image. Nodes refer to each other by
+   their index in iso9660_writer_t.p_nodes. */
+typedef struct {
+  char     *psz_name;      /* name in the tree, UTF-8 */
+  char     *psz_source;    /* where a file's contents come from */
+  char     *psz_iso;       /* ISO 9660 identifier, without ";1" */
+  uint16_t *p_joliet;      /* Joliet identifier, without ";1" */
+  uint8_t   i_joliet_len;  /* ... in characters */
+  bool      b_dir;
+  uint32_t  i_parent;
+  uint32_t  i_child;       /* first entry of a directory */
+  uint32_t  i_next;        /* next entry in the same directory */
+  uint32_t  i_jchild;      /* the same, in Joliet order */
+  uint32_t  i_jnext;
+  uint32_t  i_size;        /* bytes; a directory's ISO 9660 extent */
+  uint32_t  i_extent;
+  uint32_t  i_jsize;       /* a directory's Joliet extent */
+  uint32_t  i_jextent;
+  uint32_t  i_subdirs;
+  uint32_t  i_ce_blocks;   /* a directory's Rock Ridge continuation
+                              area, which follows its records */
+  uint16_t  i_dirnum;      /* a directory's number in the path table */
+  uint16_t  i_jdirnum;     /* ... and in the Joliet one */
+  uint32_t  i_mode;
+  uint32_t  i_uid;
+  uint32_t  i_gid;
+  time_t    i_mtime;
+} writer_node_t;
+
+struct iso9660_writer_s {
+  char          *psz_volume_id;
+  char          *psz_publisher_id;
+  char          *psz_preparer_id;
+  char          *psz_application_id;
+  bool           b_joliet;
+  bool           b_rock;
+  time_t         i_time;       /* when the writer was made */
+
+  writer_node_t *p_nodes;      /* p_nodes[0] is the root */
+  uint32_t       i_nodes;
+  uint32_t       i_nodes_max;
+  uint32_t       i_dirs;
+
+  /* (parent, name) -> node */
+  uint32_t      *p_hash;
+  uint32_t       i_hash_size;
+
+  /* Set by writer_layout(). */
+  uint32_t      *p_dirs;       /* directories in path table order */
+  uint32_t      *p_jdirs;      /* ... and in Joliet path table order */
+  uint32_t       i_pt_size;
+  uint32_t       i_jpt_size;
+  uint32_t       i_pt_l;
+  uint32_t       i_pt_m;
+  uint32_t       i_jpt_l;
+  uint32_t       i_jpt_m;
+  uint32_t       i_volume_size;
+
+  /* The continuation area of the directory being built: where it is,
+     the bytes handed out so far, and while writing, its contents. */
+  uint32_t       i_ce_extent;
+  uint32_t       i_ce_used;
+  uint8_t       *p_ce;
+};
+
+/*!
+  Return the character c is written as in an ISO 9660 identifier.
+*/
+static char
+writer_dchar(char c)
+{
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 'A';
+  return iso9660_is_dchar(c) ? c : '_';
+}
+
+/*!
+  Copy at most i_max characters of the i_len bytes at p_src to psz_dst
+  as d-characters, one '_' for each character that isn't one.
+  @return the number of characters copied.
+*/
+static size_t
+writer_dchars(char *psz_dst, const char *p_src, size_t i_len, size_t i_max)
+{
+  size_t i, n = 0;
+
+  for (i = 0; i < i_len && n < i_max; i++) {
+    /* Skip the rest of a UTF-8 sequence. */
+    if (0x80 == ((uint8_t) p_src[i] & 0xc0))
+      continue;
+    psz_dst[n++] = writer_dchar(p_src[i]);
+  }
+  psz_dst[n] = '\0';
+  return n;
+}
+
+/*!
+  Return the ISO 9660 identifier for psz_name: upper case
+  d-characters, with psz_suffix added to the name to tell it apart
+  from others. A file's identifier always has a dot, a directory's
+  never does. Caller must free the result.
+*/
+static char *
+writer_iso_name(const char *psz_name, bool b_dir, const char *psz_suffix)
+{
+  const char *p_dot = b_dir ? NULL : strrchr(psz_name, '.');
+  const size_t i_suffix = strlen(psz_suffix);
+  char ext[ISO_EXT_MAX + 1];
+  char name[ISO_NAME_MAX + 1];
+  size_t i_ext = 0, i_base;
+
+  /* A leading dot, as in ".profile", is part of the name. */
+  if (p_dot == psz_name)
+    p_dot = NULL;
+  if (p_dot)
+    i_ext = writer_dchars(ext, p_dot + 1, strlen(p_dot + 1), ISO_EXT_MAX);
+
+  i_base = writer_dchars(name, psz_name,
+                         p_dot ? (size_t) (p_dot - psz_name)
+                         : strlen(psz_name),
+                         ISO_NAME_MAX - i_suffix - (b_dir ? 0 : i_ext + 1));
+  strcpy(name + i_base, psz_suffix);
+  if (!b_dir) {
+    strcat(name, ".");
+    strcat(name, p_dot ? ext : "");
+  }
+  return strdup(name);
+}
+
+/*!
+  Convert the UTF-8 name psz_name to UCS-2 in p_out, which has room
+  for 255 characters. Characters outside UCS-2, bad UTF-8, and
+  characters Joliet doesn't allow become '_'.
+  @return the number of characters.
+*/
+static unsigned int
+writer_ucs2(const char *psz_name, uint16_t *p_out)
+{
+  const uint8_t *p = (const uint8_t *) psz_name;
+  unsigned int n = 0;
+
+  while (*p && n < 255) {
+    uint32_t c = *p++;
+    unsigned int i_more = 0;
+
+    if (c >= 0xf0)      { c &= 0x07; i_more = 3; }
+    else if (c >= 0xe0) { c &= 0x0f; i_more = 2; }
+    else if (c >= 0xc0) { c &= 0x1f; i_more = 1; }
+    else if (c >= 0x80) c = '_';
+    for (; i_more > 0 && 0x80 == (*p & 0xc0); i_more--)
+      c = (c << 6) | (*p++ & 0x3f);
+    if (i_more > 0 || c > 0xffff || (c >= 0xd800 && c <= 0xdfff))
+      c = '_';
+
+    switch (c) {
+    case '*': case '/': case ':': case ';': case '?': case '\\':
+      c = '_';
+      break;
+    default:
+      if (c < 0x20) c = '_';
+    }
+    p_out[n++] = (uint16_t) c;
+  }
+  return n;
+}
+
+/*!
+  Set p_node's Joliet identifier: psz_name in UCS-2, with psz_suffix
+  added to tell it apart from others. A name that is too long keeps
+  its extension.
+*/
+static bool
+writer_joliet_name(writer_node_t *p_node, const char *psz_suffix)
+{
+  uint16_t name[256];
+  const unsigned int i_len = writer_ucs2(p_node->psz_name, name);
+  const unsigned int i_suffix = strlen(psz_suffix);
+  unsigned int i_dot = i_len, i_ext = 0, i_base, i;
+  uint16_t *p_out;
+
+  if (!p_node->b_dir) {
+    for (i = i_len; i > 1; i--)
+      if ('.' == name[i - 1]) {
+        i_dot = i - 1;
+        break;
+      }
+    if (i_len - i_dot > JOLIET_EXT_MAX + 1)
+      i_dot = i_len;
+    i_ext = i_len - i_dot;
+  }
+  i_base = i_dot;
+  if (i_base + i_suffix + i_ext > JOLIET_NAME_MAX)
+    i_base = JOLIET_NAME_MAX - i_suffix - i_ext;
+
+  p_out = malloc((i_base + i_suffix + i_ext) * sizeof(uint16_t) + 1);
+  if (!p_out) return false;
+  memcpy(p_out, name, i_base * sizeof(uint16_t));
+  for (i = 0; i < i_suffix; i++)
+    p_out[i_base + i] = (uint8_t) psz_suffix[i];
+  memcpy(p_out + i_base + i_suffix, name + i_dot, i_ext * sizeof(uint16_t));
+
+  free(p_node->p_joliet);
+  p_node->p_joliet = p_out;
+  p_node->i_joliet_len = (uint8_t) (i_base + i_suffix + i_ext);
+  return true;
+}
+
+static uint32_t
+writer_hash(uint32_t i_parent, const char *psz_name)
+{
+  uint32_t h = 2166136261U ^ i_parent;
+
+  for (; *psz_name; psz_name++) {
+    h ^= (uint8_t) *psz_name;
+    h *= 16777619U;
+  }
+  return h;
+}
+
+/*!
+  Return the node called psz_name in directory i_parent, or NODE_NONE.
+*/
+static uint32_t
+writer_lookup(const iso9660_writer_t *p, uint32_t i_parent,
+              const char *psz_name)
+{
+  const uint32_t i_mask = p->i_hash_size - 1;
+  uint32_t i = writer_hash(i_parent, psz_name) & i_mask;
+
+  for (; NODE_NONE != p->p_hash[i]; i = (i + 1) & i_mask) {
+    const writer_node_t *p_node = &p->p_nodes[p->p_hash[i]];
+    if (p_node->i_parent == i_parent && 0 == strcmp(p_node->psz_name, psz_name))
+      return p->p_hash[i];
+  }
+  return NODE_NONE;
+}
+
+static void
+writer_hash_insert(iso9660_writer_t *p, uint32_t i_node)
+{
+  const writer_node_t *p_node = &p->p_nodes[i_node];
+  const uint32_t i_mask = p->i_hash_size - 1;
+  uint32_t i = writer_hash(p_node->i_parent, p_node->psz_name) & i_mask;
+
+  while (NODE_NONE != p->p_hash[i])
+    i = (i + 1) & i_mask;
+  p->p_hash[i] = i_node;
+}
+
+/*!
+  Make sure there is room for one more node.
+*/
+static bool
+writer_grow(iso9660_writer_t *p)
+{
+  if (p->i_nodes == p->i_nodes_max) {
+    const uint32_t i_max = p->i_nodes_max ? 2 * p->i_nodes_max : 1024;
+    writer_node_t *p_nodes = realloc(p->p_nodes, i_max * sizeof(*p_nodes));
+    if (!p_nodes) return false;
+    p->p_nodes = p_nodes;
+    p->i_nodes_max = i_max;
+  }
+
+  /* Keep the hash table at most half full. */
+  if (2 * (p->i_nodes + 1) > p->i_hash_size) {
+    const uint32_t i_size = p->i_hash_size ? 2 * p->i_hash_size : 2048;
+    uint32_t *p_hash = malloc(i_size * sizeof(uint32_t));
+    uint32_t i;
+
+    if (!p_hash) return false;
+    free(p->p_hash);
+    p->p_hash = p_hash;
+    p->i_hash_size = i_size;
+    memset(p_hash, 0xff, i_size * sizeof(uint32_t));
+    for (i = 1; i < p->i_nodes; i++)
+      writer_hash_insert(p, i);
+  }
+  return true;
+}
+
+/*!
+  Add an entry called psz_name to directory i_parent.
+  @return the new node, or NODE_NONE if we ran out of memory.
+*/
+static uint32_t
+writer_node_new(iso9660_writer_t *p, uint32_t i_parent, const char *psz_name,
+                size_t i_name_len, bool b_dir)
+{
+  writer_node_t *p_node;
+  uint32_t i_node;
+
+  if (!writer_grow(p)) {
+    cdio_warn("out of memory adding %s", psz_name);
+    return NODE_NONE;
+  }
+
+  i_node = p->i_nodes;
+  p_node = &p->p_nodes[i_node];
+  memset(p_node, 0, sizeof(*p_node));
+  p_node->psz_name = malloc(i_name_len + 1);
+  if (!p_node->psz_name) return NODE_NONE;
+  memcpy(p_node->psz_name, psz_name, i_name_len);
+  p_node->psz_name[i_name_len] = '\0';
+  p_node->b_dir    = b_dir;
+  p_node->i_parent = i_parent;
+  p_node->i_child  = p_node->i_jchild = NODE_NONE;
+  p_node->i_mode   = b_dir ? ISO_ROCK_ISDIR | 0555 : ISO_ROCK_ISREG | 0444;
+  p_node->i_mtime  = p->i_time;
+
+  p_node->psz_iso = writer_iso_name(p_node->psz_name, b_dir, "");
+  if (!p_node->psz_iso
+      || (p->b_joliet && !writer_joliet_name(p_node, ""))) {
+    free(p_node->psz_iso);
+    free(p_node->psz_name);
+    return NODE_NONE;
+  }
+
+  if (NODE_NONE != i_parent) {
+    p_node->i_next = p->p_nodes[i_parent].i_child;
+    p->p_nodes[i_parent].i_child = i_node;
+    p->i_nodes++;
+    writer_hash_insert(p, i_node);
+  } else
+    p->i_nodes++;
+  if (b_dir) p->i_dirs++;
+  return i_node;
+}
+
+/*!
+  Find the node for psz_path, making any directories on the way that
+  aren't there yet, and the node itself if b_create.
+  @return the node, or NODE_NONE if psz_path is bad, names a file
+  where we need a directory, or we ran out of memory.
+*/
+static uint32_t
+writer_path(iso9660_writer_t *p, const char psz_path[], bool b_dir,
+            bool b_create)
+{
+  const char *psz = psz_path;
+  uint32_t i_node = 0;
+
+  while (*psz) {
+    const char *psz_end = strchr(psz, '/');
+    const size_t i_len = psz_end ? (size_t) (psz_end - psz) : strlen(psz);
+    char name[MAX_ISOPATHNAME + 1];
+    bool b_last;
+    uint32_t i_child;
+
+    if (0 == i_len || (1 == i_len && '.' == psz[0])) {
+      psz += i_len + (psz_end ? 1 : 0);
+      continue;
+    }
+    if ((2 == i_len && 0 == strncmp(psz, "..", 2))
+        || i_len > MAX_ISOPATHNAME) {
+      cdio_warn("bad path %s", psz_path);
+      return NODE_NONE;
+    }
+    memcpy(name, psz, i_len);
+    name[i_len] = '\0';
+    psz += i_len;
+    while ('/' == *psz) psz++;
+    b_last = ('\0' == *psz);
+
+    i_child = writer_lookup(p, i_node, name);
+    if (NODE_NONE == i_child) {
+      if (b_last && !b_create) return NODE_NONE;
+      i_child = writer_node_new(p, i_node, name, i_len, b_last ? b_dir : true);
+      if (NODE_NONE == i_child) return NODE_NONE;
+    } else if (!p->p_nodes[i_child].b_dir && (!b_last || b_dir)) {
+      cdio_warn("%s: %s is a file, not a directory", psz_path, name);
+      return NODE_NONE;
+    } else if (b_last && !b_dir && p->p_nodes[i_child].b_dir) {
+      cdio_warn("%s is a directory, not a file", psz_path);
+      return NODE_NONE;
+    }
+    i_node = i_child;
+  }
+  return i_node;
+}
+
+/*!
+  Copy the attributes in p_stat to p_node.
+*/
+static void
+writer_set_stat(writer_node_t *p_node, const struct stat *p_stat)
+{
+  p_node->i_mode  = (uint32_t) p_stat->st_mode;
+  p_node->i_uid   = (uint32_t) p_stat->st_uid;
+  p_node->i_gid   = (uint32_t) p_stat->st_gid;
+  p_node->i_mtime = p_stat->st_mtime;
+}
+
+/*!
+  Add the file psz_source, described by p_stat, at psz_path.
+*/
+static bool
+writer_add_file(iso9660_writer_t *p, const char psz_path[],
+                const char psz_source[], const struct stat *p_stat)
+{
+  uint32_t i_node;
+  char *psz_copy;
+
+  if ((uint64_t) p_stat->st_size > 0xffffffffU) {
+    cdio_warn("%s is too big: an ISO 9660 file is under 4 GiB", psz_source);
+    return false;
+  }
+
+  psz_copy = strdup(psz_source);
+  i_node = writer_path(p, psz_path, false, true);
+  if (!psz_copy || NODE_NONE == i_node) {
+    free(psz_copy);
+    return false;
+  }
+  free(p->p_nodes[i_node].psz_source);
+  p->p_nodes[i_node].psz_source = psz_copy;
+  p->p_nodes[i_node].i_size = (uint32_t) p_stat->st_size;
+  writer_set_stat(&p->p_nodes[i_node], p_stat);
+  return true;
+}
+
+/* ------------------------------------------------------------------- */
+/* Laying out the image */
+
+static int
+writer_cmp_iso(const void *p1, const void *p2)
+{
+  const writer_node_t *p_a = *(const writer_node_t * const *) p1;
+  const writer_node_t *p_b = *(const writer_node_t * const *) p2;
+  return strcmp(p_a->psz_iso, p_b->psz_iso);
+}
+
+static int
+writer_cmp_joliet(const void *p1, const void *p2)
+{
+  const writer_node_t *p_a = *(const writer_node_t * const *) p1;
+  const writer_node_t *p_b = *(const writer_node_t * const *) p2;
+  const unsigned int i_len = p_a->i_joliet_len < p_b->i_joliet_len
+    ? p_a->i_joliet_len : p_b->i_joliet_len;
+  unsigned int i;
+
+  for (i = 0; i < i_len; i++)
+    if (p_a->p_joliet[i] != p_b->p_joliet[i])
+      return p_a->p_joliet[i] < p_b->p_joliet[i] ? -1 : 1;
+  return (int) p_a->i_joliet_len - (int) p_b->i_joliet_len;
+}
+
+/*!
+  Sort directory i_dir's entries by their ISO 9660 identifiers, or
+  their Joliet ones if b_joliet, renaming any that come out the same,
+  and relink them in that order. pp_sort has room for all the nodes.
+*/
+static bool
+writer_sort_dir(iso9660_writer_t *p, uint32_t i_dir, bool b_joliet,
+                writer_node_t **pp_sort)
+{
+  writer_node_t *p_dir = &p->p_nodes[i_dir];
+  uint32_t i_count = 0, i, c;
+  unsigned int i_renamed = 0;
+  bool b_again;
+
+  for (c = p_dir->i_child; NODE_NONE != c; c = p->p_nodes[c].i_next)
+    pp_sort[i_count++] = &p->p_nodes[c];
+
+  do {
+    b_again = false;
+    qsort(pp_sort, i_count, sizeof(writer_node_t *),
+          b_joliet ? writer_cmp_joliet : writer_cmp_iso);
+    for (i = 1; i < i_count; i++) {
+      writer_node_t *p_node = pp_sort[i];
+      char suffix[16];
+
+      if (0 != (b_joliet ? writer_cmp_joliet : writer_cmp_iso)
+          (&pp_sort[i - 1], &pp_sort[i]))
+        continue;
+
+      snprintf(suffix, sizeof(suffix), b_joliet ? "~%u" : "_%u",
+               ++i_renamed);
+      if (b_joliet) {
+        if (!writer_joliet_name(p_node, suffix)) return false;
+      } else {
+        char *psz_iso = writer_iso_name(p_node->psz_name, p_node->b_dir,
+                                        suffix);
+        if (!psz_iso) return false;
+        free(p_node->psz_iso);
+        p_node->psz_iso = psz_iso;
+      }
+      b_again = true;
+    }
+  } while (b_again);
+
+  if (b_joliet) {
+    p_dir->i_jchild = NODE_NONE;
+    for (i = i_count; i > 0; i--) {
+      pp_sort[i - 1]->i_jnext = p_dir->i_jchild;
+      p_dir->i_jchild = (uint32_t) (pp_sort[i - 1] - p->p_nodes);
+    }
+  } else {
+    p_dir->i_child = NODE_NONE;
+    for (i = i_count; i > 0; i--) {
+      pp_sort[i - 1]->i_next = p_dir->i_child;
+      p_dir->i_child = (uint32_t) (pp_sort[i - 1] - p->p_nodes);
+    }
+  }
+  return true;
+}
+
+/*!
+  Sort every directory, and list the directories in p_dirs (or
+  p_jdirs) in path table order: by depth, then by parent, then by
+  name, which is breadth first with each directory's entries sorted.
+*/
+static bool
+writer_order_dirs(iso9660_writer_t *p, bool b_joliet, uint32_t *p_dirs)
+{
+  writer_node_t **pp_sort = malloc(p->i_nodes * sizeof(writer_node_t *));
+  uint32_t i_dirs = 0, i;
+
+  if (!pp_sort) return false;
+  p_dirs[i_dirs++] = 0;
+  p->p_nodes[0].i_dirnum = p->p_nodes[0].i_jdirnum = 1;
+  for (i = 0; i < i_dirs; i++) {
+    const uint32_t i_dir = p_dirs[i];
+    uint32_t c;
+
+    if (!writer_sort_dir(p, i_dir, b_joliet, pp_sort)) {
+      free(pp_sort);
+      return false;
+    }
+    p->p_nodes[i_dir].i_subdirs = 0;
+    for (c = b_joliet ? p->p_nodes[i_dir].i_jchild : p->p_nodes[i_dir].i_child;
+         NODE_NONE != c;
+         c = b_joliet ? p->p_nodes[c].i_jnext : p->p_nodes[c].i_next)
+      if (p->p_nodes[c].b_dir) {
+        p_dirs[i_dirs++] = c;
+        if (b_joliet)
+          p->p_nodes[c].i_jdirnum = (uint16_t) i_dirs;
+        else
+          p->p_nodes[c].i_dirnum = (uint16_t) i_dirs;
+        p->p_nodes[i_dir].i_subdirs++;
+      }
+  }
+  free(pp_sort);
+  cdio_assert(i_dirs == p->i_dirs);
+  return true;
+}
+
+/*!
+  Hand out i_len bytes of the continuation area of the directory being
+  built, not crossing a block boundary.
+  @return the offset of the bytes in the area.
+*/
+static uint32_t
+writer_ce_alloc(iso9660_writer_t *p, unsigned int i_len)
+{
+  p->i_ce_used = _cdio_ofs_add(p->i_ce_used, i_len, ISO_BLOCKSIZE);
+  return p->i_ce_used - i_len;
+}
+
+/*!
+  Append a SUSP entry with signature psz_sig and i_len bytes of data
+  p_data to p_su at *pi_pos.
+*/
+static void
+susp_add(uint8_t *p_su, unsigned int *pi_pos, const char psz_sig[],
+         const void *p_data, unsigned int i_len)
+{
+  uint8_t *p_entry = p_su + *pi_pos;
+
+  p_entry[0] = (uint8_t) psz_sig[0];
+  p_entry[1] = (uint8_t) psz_sig[1];
+  p_entry[2] = (uint8_t) (i_len + 4);
+  p_entry[3] = 1;
+  memcpy(p_entry + 4, p_data, i_len);
+  *pi_pos += i_len + 4;
+}
+
+static void
+susp_add_733(uint8_t *p_buf, uint32_t i_value)
+{
+  const uint64_t i_733 = to_733(i_value);
+  memcpy(p_buf, &i_733, sizeof(i_733));
+}
+
+/*!
+  Add NM entries for psz_name to p_su at *pi_pos, as many as it takes.
+*/
+static void
+rock_add_nm(uint8_t *p_su, unsigned int *pi_pos, const char *psz_name)
+{
+  size_t i_left = strlen(psz_name);
+  uint8_t nm[1 + ROCK_NM_MAX];
+
+  do {
+    const size_t i_now = i_left > ROCK_NM_MAX ? ROCK_NM_MAX : i_left;
+
+    nm[0] = i_now < i_left ? ISO_ROCK_NM_CONTINUE : 0;
+    memcpy(nm + 1, psz_name, i_now);
+    susp_add(p_su, pi_pos, "NM", nm, (unsigned int) (1 + i_now));
+    psz_name += i_now;
+    i_left -= i_now;
+  } while (i_left > 0);
+}
+
+/*!
+  Build the Rock Ridge entries of a directory record in p_su: the
+  attributes of p_node, and its name psz_name unless that is NULL.
+  b_root says this is the root's "." record, which starts the SUSP
+  area of the whole image. Whatever doesn't fit in the i_room bytes
+  left in the record goes in the continuation area.
+  @return the size of the entries.
+*/
+static unsigned int
+writer_rock_ridge(iso9660_writer_t *p, const writer_node_t *p_node,
+                  const char *psz_name, bool b_root, unsigned int i_room,
+                  /*out*/ uint8_t *p_su)
+{
+  const size_t i_name = psz_name ? strlen(psz_name) : 0;
+  uint8_t px[4 * 8];
+  uint8_t tf[1 + 7];
+  unsigned int n = 0;
+  bool b_inline;
+
+  if (!p->b_rock) return 0;
+
+  susp_add_733(px + 0,  p_node->i_mode);
+  susp_add_733(px + 8,  p_node->b_dir ? 2 + p_node->i_subdirs : 1);
+  susp_add_733(px + 16, p_node->i_uid);
+  susp_add_733(px + 24, p_node->i_gid);
+  tf[0] = ISO_ROCK_TF_MODIFY;
+  {
+    struct tm temp_tm;
+    gmtime_r(&p_node->i_mtime, &temp_tm);
+    iso9660_set_dtime(&temp_tm, (iso9660_dtime_t *) (tf + 1));
+  }
+
+  b_inline = !b_root
+    && ROCK_PX_LEN + ROCK_TF_LEN + (i_name ? 5 + i_name : 0) <= i_room
+    && i_name <= ROCK_NM_MAX;
+
+  if (b_root) {
+    const uint8_t sp[3] = { 0xbe, 0xef, 0 };
+    susp_add(p_su, &n, "SP", sp, sizeof(sp));
+  }
+  if (b_inline && i_name)
+    rock_add_nm(p_su, &n, psz_name);
+  susp_add(p_su, &n, "PX", px, sizeof(px));
+  susp_add(p_su, &n, "TF", tf, sizeof(tf));
+
+  if (!b_inline) {
+    uint8_t ce_area[ISO_BLOCKSIZE];
+    uint8_t ce[3 * 8];
+    unsigned int i_ce = 0;
+    uint32_t i_offset;
+
+    if (b_root) {
+      uint8_t er[4 + sizeof(ROCK_ER_ID) + sizeof(ROCK_ER_DES)
+                 + sizeof(ROCK_ER_SRC)];
+      er[0] = sizeof(ROCK_ER_ID) - 1;
+      er[1] = sizeof(ROCK_ER_DES) - 1;
+      er[2] = sizeof(ROCK_ER_SRC) - 1;
+      er[3] = 1;
+      memcpy(er + 4, ROCK_ER_ID ROCK_ER_DES ROCK_ER_SRC,
+             er[0] + er[1] + er[2]);
+      susp_add(ce_area, &i_ce, "ER", er, 4 + er[0] + er[1] + er[2]);
+    }
+    if (i_name)
+      rock_add_nm(ce_area, &i_ce, psz_name);
+
+    i_offset = writer_ce_alloc(p, i_ce);
+    if (p->p_ce)
+      memcpy(p->p_ce + i_offset, ce_area, i_ce);
+    susp_add_733(ce + 0,  p->i_ce_extent + i_offset / ISO_BLOCKSIZE);
+    susp_add_733(ce + 8,  i_offset % ISO_BLOCKSIZE);
+    susp_add_733(ce + 16, i_ce);
+    susp_add(p_su, &n, "CE", ce, sizeof(ce));
+  }
+  return n;
+}
+
+/*!
+  Put a directory record at *pi_pos in p_buf, moving it to the next
+  block if it would cross into it, and advance *pi_pos past it. With
+  p_buf NULL, just advance *pi_pos.
+*/
+static void
+writer_record(uint8_t *p_buf, uint32_t *pi_pos,
+              const uint8_t *p_id, unsigned int i_id_len,
+              uint32_t i_extent, uint32_t i_size, uint8_t i_flags,
+              const uint8_t *p_su, unsigned int i_su_len, time_t i_time)
+{
+  unsigned int i_length = _cdio_ceil2block(sizeof(iso9660_dir_t) + i_id_len,
+                                           2);
+  const unsigned int i_su_offset = i_length;
+
+  i_length = _cdio_ceil2block(i_length + i_su_len, 2);
+  *pi_pos = _cdio_ofs_add(*pi_pos, i_length, ISO_BLOCKSIZE) - i_length;
+
+  if (p_buf) {
+    iso9660_dir_t *p_idr = (iso9660_dir_t *) (p_buf + *pi_pos);
+    struct tm temp_tm;
+
+    memset(p_idr, 0, i_length);
+    p_idr->length = to_711(i_length);
+    p_idr->extent = to_733(i_extent);
+    p_idr->size   = to_733(i_size);
+    gmtime_r(&i_time, &temp_tm);
+    iso9660_set_dtime(&temp_tm, &(p_idr->recording_time));
+    p_idr->file_flags = to_711(i_flags);
+    p_idr->volume_sequence_number = to_723(1);
+    p_idr->filename.len = to_711(i_id_len);
+    memcpy(&p_idr->filename.str[1], p_id, i_id_len);
+    memcpy(p_buf + *pi_pos + i_su_offset, p_su, i_su_len);
+  }
+  *pi_pos += i_length;
+}
+
+/*!
+  Build the ISO 9660 directory i_dir in p_buf, or with p_buf NULL,
+  work out how big it is.
+  @return its size in bytes, a whole number of blocks.
+*/
+static uint32_t
+writer_iso_dir(iso9660_writer_t *p, uint32_t i_dir, uint8_t *p_buf)
+{
+  const writer_node_t *p_dir = &p->p_nodes[i_dir];
+  const writer_node_t *p_parent =
+    &p->p_nodes[NODE_NONE == p_dir->i_parent ? i_dir : p_dir->i_parent];
+  const uint8_t self = 0, parent = 1;
+  uint8_t su[255];
+  unsigned int i_su;
+  uint32_t i_pos = 0, c;
+
+  i_su = writer_rock_ridge(p, p_dir, NULL, 0 == i_dir, 254 - 34, su);
+  writer_record(p_buf, &i_pos, &self, 1, p_dir->i_extent, p_dir->i_size,
+                ISO_DIRECTORY, su, i_su, p_dir->i_mtime);
+  i_su = writer_rock_ridge(p, p_parent, NULL, false, 254 - 34, su);
+  writer_record(p_buf, &i_pos, &parent, 1, p_parent->i_extent,
+                p_parent->i_size, ISO_DIRECTORY, su, i_su,
+                p_parent->i_mtime);
+
+  for (c = p_dir->i_child; NODE_NONE != c; c = p->p_nodes[c].i_next) {
+    const writer_node_t *p_node = &p->p_nodes[c];
+    char id[ISO_NAME_MAX + 3];
+    unsigned int i_id;
+
+    strcpy(id, p_node->psz_iso);
+    if (!p_node->b_dir) strcat(id, ";1");
+    i_id = strlen(id);
+    i_su = writer_rock_ridge(p, p_node, p_node->psz_name, false,
+                             254 - _cdio_ceil2block(sizeof(iso9660_dir_t)
+                                                    + i_id, 2),
+                             su);
+    writer_record(p_buf, &i_pos, (const uint8_t *) id, i_id,
+                  p_node->i_extent, p_node->i_size,
+                  p_node->b_dir ? ISO_DIRECTORY : ISO_FILE, su, i_su,
+                  p_node->i_mtime);
+  }
+  return _cdio_ceil2block(i_pos, ISO_BLOCKSIZE);
+}
+
+/*!
+  Build the Joliet directory i_dir in p_buf, or with p_buf NULL,
+  work out how big it is.
+  @return its size in bytes, a whole number of blocks.
+*/
+static uint32_t
+writer_joliet_dir(iso9660_writer_t *p, uint32_t i_dir, uint8_t *p_buf)
+{
+  const writer_node_t *p_dir = &p->p_nodes[i_dir];
+  const writer_node_t *p_parent =
+    &p->p_nodes[NODE_NONE == p_dir->i_parent ? i_dir : p_dir->i_parent];
+  const uint8_t self = 0, parent = 1;
+  uint32_t i_pos = 0, c;
+
+  writer_record(p_buf, &i_pos, &self, 1, p_dir->i_jextent, p_dir->i_jsize,
+                ISO_DIRECTORY, NULL, 0, p_dir->i_mtime);
+  writer_record(p_buf, &i_pos, &parent, 1, p_parent->i_jextent,
+                p_parent->i_jsize, ISO_DIRECTORY, NULL, 0,
+                p_parent->i_mtime);
+
+  for (c = p_dir->i_jchild; NODE_NONE != c; c = p->p_nodes[c].i_jnext) {
+    const writer_node_t *p_node = &p->p_nodes[c];
+    uint8_t id[2 * (JOLIET_NAME_MAX + 2)];
+    unsigned int i, i_id = 0;
+
+    for (i = 0; i < p_node->i_joliet_len; i++) {
+      id[i_id++] = (uint8_t) (p_node->p_joliet[i] >> 8);
+      id[i_id++] = (uint8_t) p_node->p_joliet[i];
+    }
+    if (!p_node->b_dir) {
+      id[i_id++] = 0; id[i_id++] = ';';
+      id[i_id++] = 0; id[i_id++] = '1';
+    }
+    writer_record(p_buf, &i_pos, id, i_id,
+                  p_node->b_dir ? p_node->i_jextent : p_node->i_extent,
+                  p_node->b_dir ? p_node->i_jsize : p_node->i_size,
+                  p_node->b_dir ? ISO_DIRECTORY : ISO_FILE, NULL, 0,
+                  p_node->i_mtime);
+  }
+  return _cdio_ceil2block(i_pos, ISO_BLOCKSIZE);
+}
+
+/*!
+  Return the size of the path table listing p_dirs.
+*/
+static uint32_t
+writer_pathtable_size(const iso9660_writer_t *p, const uint32_t *p_dirs,
+                      bool b_joliet)
+{
+  uint32_t i_size = 0, i;
+
+  for (i = 0; i < p->i_dirs; i++) {
+    const writer_node_t *p_dir = &p->p_nodes[p_dirs[i]];
+    const unsigned int i_name = 0 == i ? 1
+      : b_joliet ? 2 * p_dir->i_joliet_len : strlen(p_dir->psz_iso);
+    i_size += sizeof(iso_path_table_t) + i_name + (i_name & 1);
+  }
+  return i_size;
+}
+
+/*!
+  Work out where everything in the image goes.
+*/
+static bool
+writer_layout(iso9660_writer_t *p)
+{
+  uint32_t i_lsn, i, c;
+
+  if (p->i_dirs > WRITER_MAX_DIRS) {
+    cdio_warn("too many directories for an ISO 9660 path table: %u",
+              (unsigned int) p->i_dirs);
+    return false;
+  }
+
+  free(p->p_dirs);
+  free(p->p_jdirs);
+  p->p_jdirs = NULL;
+  p->p_dirs = malloc(p->i_dirs * sizeof(uint32_t));
+  if (!p->p_dirs || !writer_order_dirs(p, false, p->p_dirs))
+    return false;
+  if (p->b_joliet) {
+    p->p_jdirs = malloc(p->i_dirs * sizeof(uint32_t));
+    if (!p->p_jdirs || !writer_order_dirs(p, true, p->p_jdirs))
+      return false;
+  }
+
+  i_lsn = ISO_PVD_SECTOR + 2 + (p->b_joliet ? 1 : 0);
+
+  p->i_pt_size = writer_pathtable_size(p, p->p_dirs, false);
+  p->i_pt_l = i_lsn;
+  i_lsn += _cdio_len2blocks(p->i_pt_size, ISO_BLOCKSIZE);
+  p->i_pt_m = i_lsn;
+  i_lsn += _cdio_len2blocks(p->i_pt_size, ISO_BLOCKSIZE);
+  if (p->b_joliet) {
+    p->i_jpt_size = writer_pathtable_size(p, p->p_jdirs, true);
+    p->i_jpt_l = i_lsn;
+    i_lsn += _cdio_len2blocks(p->i_jpt_size, ISO_BLOCKSIZE);
+    p->i_jpt_m = i_lsn;
+    i_lsn += _cdio_len2blocks(p->i_jpt_size, ISO_BLOCKSIZE);
+  }
+
+  for (i = 0; i < p->i_dirs; i++) {
+    writer_node_t *p_dir = &p->p_nodes[p->p_dirs[i]];
+    p->i_ce_used = 0;
+    p_dir->i_extent = i_lsn;
+    p_dir->i_size   = writer_iso_dir(p, p->p_dirs[i], NULL);
+    p_dir->i_ce_blocks = _cdio_len2blocks(p->i_ce_used, ISO_BLOCKSIZE);
+    i_lsn += p_dir->i_size / ISO_BLOCKSIZE + p_dir->i_ce_blocks;
+  }
+  if (p->b_joliet)
+    for (i = 0; i < p->i_dirs; i++) {
+      writer_node_t *p_dir = &p->p_nodes[p->p_jdirs[i]];
+      p_dir->i_jextent = i_lsn;
+      p_dir->i_jsize   = writer_joliet_dir(p, p->p_jdirs[i], NULL);
+      i_lsn += p_dir->i_jsize / ISO_BLOCKSIZE;
+    }
+  /* File contents, in the order the directories list them. */
+  for (i = 0; i < p->i_dirs; i++)
+    for (c = p->p_nodes[p->p_dirs[i]].i_child; NODE_NONE != c;
+         c = p->p_nodes[c].i_next) {
+      writer_node_t *p_node = &p->p_nodes[c];
+      if (p_node->b_dir) continue;
+      if ((uint64_t) i_lsn + _cdio_len2blocks(p_node->i_size, ISO_BLOCKSIZE)
+          > 0xffffffffU) {
+        cdio_warn("image too big");
+        return false;
+      }
+      p_node->i_extent = i_lsn;
+      i_lsn += _cdio_len2blocks(p_node->i_size, ISO_BLOCKSIZE);
+    }
+
+  p->i_volume_size = i_lsn;
+  return true;
+}
+
+/* ------------------------------------------------------------------- */
+/* Writing the image */
+
+typedef struct {
+  FILE       *p_out;
+  const char *psz_image;
+  uint64_t    i_written;
+  bool        b_error;
+} writer_out_t;
+
+static void
+writer_put(writer_out_t *p_out, const void *p_buf, size_t i_len)
+{
+  if (p_out->b_error || 0 == i_len) return;
+  if (fwrite(p_buf, 1, i_len, p_out->p_out) != i_len) {
+    cdio_warn("error writing %s: %s", p_out->psz_image, strerror(errno));
+    p_out->b_error = true;
+  }
+  p_out->i_written += i_len;
+}
+
+/*!
+  Write zeros up to the start of block i_lsn.
+*/
+static void
+writer_pad(writer_out_t *p_out, uint32_t i_lsn)
+{
+  static const uint8_t zero[ISO_BLOCKSIZE];
+  const uint64_t i_end = (uint64_t) i_lsn * ISO_BLOCKSIZE;
+
+  cdio_assert(p_out->i_written <= i_end);
+  while (p_out->i_written < i_end) {
+    const uint64_t i_left = i_end - p_out->i_written;
+    writer_put(p_out, zero, i_left < ISO_BLOCKSIZE ? i_left : ISO_BLOCKSIZE);
+  }
+}
+
+/*!
+  Fill the identifier field p_field of i_len bytes with psz_id in
+  UCS-2, padded with spaces, as in a Joliet volume descriptor.
+*/
+static void
+writer_ucs2_field(char *p_field, const char *psz_id, size_t i_len)
+{
+  uint16_t name[256];
+  const unsigned int i_name = writer_ucs2(psz_id, name);
+  size_t i;
+
+  for (i = 0; i + 1 < i_len; i += 2) {
+    const uint16_t c = i / 2 < i_name ? name[i / 2] : ' ';
+    p_field[i]     = (char) (c >> 8);
+    p_field[i + 1] = (char) c;
+  }
+  if (i < i_len) p_field[i] = 0;
+}
+
+/*!
+  Write the volume descriptors.
+*/
+static void
+writer_put_vds(iso9660_writer_t *p, writer_out_t *p_out)
+{
+  uint8_t pvd[ISO_BLOCKSIZE];
+  uint8_t root[34];
+  uint32_t i_pos = 0;
+  const uint8_t self = 0;
+  const writer_node_t *p_root = &p->p_nodes[0];
+
+  writer_record(root, &i_pos, &self, 1, p_root->i_extent, p_root->i_size,
+                ISO_DIRECTORY, NULL, 0, p_root->i_mtime);
+  iso9660_set_pvd(pvd, p->psz_volume_id, p->psz_publisher_id,
+                  p->psz_preparer_id, p->psz_application_id,
+                  p->i_volume_size, root, p->i_pt_l, p->i_pt_m,
+                  p->i_pt_size, &p->i_time);
+  /* This is a plain Mode 1 image, not a CD-XA one, so it carries
+     neither the XA marker nor the CD-XA system identifier. */
+  memset(pvd + ISO_XA_MARKER_OFFSET, 0, sizeof(ISO_XA_MARKER_STRING));
+  iso9660_strncpy_pad(((iso9660_pvd_t *) pvd)->system_id, "",
+                      ISO_MAX_SYSTEM_ID, ISO9660_ACHARS);
+  writer_put(p_out, pvd, sizeof(pvd));
+
+  if (p->b_joliet) {
+    iso9660_svd_t *p_svd = (iso9660_svd_t *) pvd;
+
+    /* The same, with UCS-2 identifiers and the Joliet tree. */
+    i_pos = 0;
+    writer_record(root, &i_pos, &self, 1, p_root->i_jextent, p_root->i_jsize,
+                  ISO_DIRECTORY, NULL, 0, p_root->i_mtime);
+    memcpy(&p_svd->root_directory_record, root,
+           sizeof(p_svd->root_directory_record));
+    p_svd->root_directory_filename = '\0';
+    p_svd->root_directory_record.length =
+      sizeof(p_svd->root_directory_record) + 1;
+
+    p_svd->type = to_711(ISO_VD_SUPPLEMENTARY);
+    memset(p_svd->escape_sequences, 0, sizeof(p_svd->escape_sequences));
+    memcpy(p_svd->escape_sequences, "%/E", 3); /* UCS-2 Level 3 */
+    p_svd->path_table_size   = to_733(p->i_jpt_size);
+    p_svd->type_l_path_table = to_731(p->i_jpt_l);
+    p_svd->type_m_path_table = to_732(p->i_jpt_m);
+
+    writer_ucs2_field(p_svd->system_id, "", sizeof(p_svd->system_id));
+    writer_ucs2_field(p_svd->volume_id, p->psz_volume_id,
+                      sizeof(p_svd->volume_id));
+    writer_ucs2_field(p_svd->volume_set_id, "",
+                      sizeof(p_svd->volume_set_id));
+    writer_ucs2_field(p_svd->publisher_id, p->psz_publisher_id,
+                      sizeof(p_svd->publisher_id));
+    writer_ucs2_field(p_svd->preparer_id, p->psz_preparer_id,
+                      sizeof(p_svd->preparer_id));
+    writer_ucs2_field(p_svd->application_id, p->psz_application_id,
+                      sizeof(p_svd->application_id));
+    writer_ucs2_field(p_svd->copyright_file_id, "",
+                      sizeof(p_svd->copyright_file_id));
+    writer_ucs2_field(p_svd->abstract_file_id, "",
+                      sizeof(p_svd->abstract_file_id));
+    writer_ucs2_field(p_svd->bibliographic_file_id, "",
+                      sizeof(p_svd->bibliographic_file_id));
+    writer_put(p_out, pvd, sizeof(pvd));
+  }
+
+  iso9660_set_evd(pvd);
+  writer_put(p_out, pvd, sizeof(pvd));
+}
+
+/*!
+  Write the L and M path tables listing p_dirs.
+*/
+static bool
+writer_put_pathtables(iso9660_writer_t *p, writer_out_t *p_out,
+                      const uint32_t *p_dirs, bool b_joliet,
+                      uint32_t i_size, uint32_t i_l, uint32_t i_m)
+{
+  uint8_t *p_l = calloc(2, i_size);
+  uint8_t *p_m;
+  uint32_t i, i_pos = 0;
+
+  if (!p_l) {
+    cdio_warn("out of memory for a %u-byte path table", (unsigned int) i_size);
+    return false;
+  }
+  p_m = p_l + i_size;
+
+  for (i = 0; i < p->i_dirs; i++) {
+    const writer_node_t *p_dir = &p->p_nodes[p_dirs[i]];
+    iso_path_table_t *p_lpt = (iso_path_table_t *) (p_l + i_pos);
+    iso_path_table_t *p_mpt = (iso_path_table_t *) (p_m + i_pos);
+    const writer_node_t *p_parent =
+      &p->p_nodes[0 == i ? 0 : p_dir->i_parent];
+    const uint16_t i_parent = b_joliet ? p_parent->i_jdirnum
+      : p_parent->i_dirnum;
+    const uint32_t i_extent = b_joliet ? p_dir->i_jextent : p_dir->i_extent;
+    unsigned int i_name;
+
+    if (0 == i) {
+      i_name = 1;
+      p_lpt->name[0] = p_mpt->name[0] = '\0';
+    } else if (b_joliet) {
+      unsigned int j;
+      i_name = 2 * p_dir->i_joliet_len;
+      for (j = 0; j < p_dir->i_joliet_len; j++) {
+        p_lpt->name[2 * j]     = (char) (p_dir->p_joliet[j] >> 8);
+        p_lpt->name[2 * j + 1] = (char) p_dir->p_joliet[j];
+      }
+      memcpy(p_mpt->name, p_lpt->name, i_name);
+    } else {
+      i_name = strlen(p_dir->psz_iso);
+      memcpy(p_lpt->name, p_dir->psz_iso, i_name);
+      memcpy(p_mpt->name, p_dir->psz_iso, i_name);
+    }
+    p_lpt->name_len = p_mpt->name_len = to_711(i_name);
+    p_lpt->extent = to_731(i_extent);
+    p_mpt->extent = to_732(i_extent);
+    p_lpt->parent = to_721(i_parent);
+    p_mpt->parent = to_722(i_parent);
+    i_pos += sizeof(iso_path_table_t) + i_name + (i_name & 1);
+  }
+  cdio_assert(i_pos == i_size);
+
+  writer_pad(p_out, i_l);
+  writer_put(p_out, p_l, i_size);
+  writer_pad(p_out, i_m);
+  writer_put(p_out, p_m, i_size);
+  free(p_l);
+  return !p_out->b_error;
+}
+
+/*!
+  Write the directories listed in p_dirs, ISO 9660 ones or Joliet ones,
+  each followed by its continuation area.
+*/
+static bool
+writer_put_dirs(iso9660_writer_t *p, writer_out_t *p_out,
+                const uint32_t *p_dirs, bool b_joliet)
+{
+  uint8_t *p_buf = NULL;
+  uint32_t i_buf = 0, i;
+
+  for (i = 0; i < p->i_dirs && !p_out->b_error; i++) {
+    const writer_node_t *p_dir = &p->p_nodes[p_dirs[i]];
+    const uint32_t i_size = b_joliet ? p_dir->i_jsize : p_dir->i_size;
+    const uint32_t i_ce = b_joliet ? 0 : p_dir->i_ce_blocks * ISO_BLOCKSIZE;
+    uint32_t i_built;
+
+    if (i_size + i_ce > i_buf) {
+      uint8_t *p_new = realloc(p_buf, i_size + i_ce);
+      if (!p_new) {
+        cdio_warn("out of memory for a %u-byte directory",
+                  (unsigned int) i_size);
+        free(p_buf);
+        return false;
+      }
+      p_buf = p_new;
+      i_buf = i_size + i_ce;
+    }
+    memset(p_buf, 0, i_size + i_ce);
+    if (b_joliet)
+      i_built = writer_joliet_dir(p, p_dirs[i], p_buf);
+    else {
+      p->i_ce_extent = p_dir->i_extent + i_size / ISO_BLOCKSIZE;
+      p->i_ce_used = 0;
+      p->p_ce = p_buf + i_size;
+      i_built = writer_iso_dir(p, p_dirs[i], p_buf);
+      p->p_ce = NULL;
+      cdio_assert(_cdio_ceil2block(p->i_ce_used, ISO_BLOCKSIZE) == i_ce);
+    }
+    cdio_assert(i_built == i_size);
+
+    writer_pad(p_out, b_joliet ? p_dir->i_jextent : p_dir->i_extent);
+    writer_put(p_out, p_buf, i_size + i_ce);
+  }
+  free(p_buf);
+  return !p_out->b_error;
+}
+
+/*!
+  Copy the contents of p_node's file to the image. A file that has
+  changed size since it was added is cut off or padded with zeros to
+  the size the image has room for.
+*/
+static bool
+writer_put_file(writer_out_t *p_out, const writer_node_t *p_node,
+                uint8_t *p_buf)
+{
+  FILE *p_in = CDIO_FOPEN(p_node->psz_source, "rb");
+  uint32_t i_left = p_node->i_size;
+  bool b_short = false;
+
+  if (!p_in) {
+    cdio_warn("can't open %s: %s", p_node->psz_source, strerror(errno));
+    return false;
+  }
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_SEQUENTIAL)
+  posix_fadvise(fileno(p_in), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  while (i_left > 0 && !p_out->b_error) {
+    const size_t i_want = i_left < WRITER_COPY_SIZE
+      ? i_left : WRITER_COPY_SIZE;
+    size_t i_got = b_short ? 0 : fread(p_buf, 1, i_want, p_in);
+
+    if (i_got < i_want) {
+      if (ferror(p_in)) {
+        cdio_warn("error reading %s: %s", p_node->psz_source,
+                  strerror(errno));
+        fclose(p_in);
+        return false;
+      }
+      if (!b_short)
+        cdio_warn("%s got shorter while writing it", p_node->psz_source);
+      b_short = true;
+      memset(p_buf + i_got, 0, i_want - i_got);
+    }
+    writer_put(p_out, p_buf, i_want);
+    i_left -= (uint32_t) i_want;
+  }
+  if (!b_short && EOF != getc(p_in))
+    cdio_warn("%s got longer while writing it", p_node->psz_source);
+  fclose(p_in);
+  return !p_out->b_error;
+}
+
+/* ------------------------------------------------------------------- */
+/* Public routines */
+
+/*!
+  Start an image with volume ID psz_volume_id, and the extensions in
+  u_extensions: any Joliet level and ISO_EXTENSION_ROCK_RIDGE.
+*/
+iso9660_writer_t *
+iso9660_writer_new(const char psz_volume_id[],
+                   iso_extension_mask_t u_extensions)
+{
+  iso9660_writer_t *p = calloc(1, sizeof(iso9660_writer_t));
+  char volume_id[ISO_MAX_VOLUME_ID + 1];
+
+  if (!p) return NULL;
+
+  writer_dchars(volume_id, psz_volume_id ? psz_volume_id : "",
+                psz_volume_id ? strlen(psz_volume_id) : 0, ISO_MAX_VOLUME_ID);
+  p->psz_volume_id = strdup(volume_id);
+  p->b_joliet = 0 != (u_extensions & ISO_EXTENSION_JOLIET);
+  p->b_rock   = 0 != (u_extensions & ISO_EXTENSION_ROCK_RIDGE);
+  p->i_time   = time(NULL);
+  iso9660_writer_set_ids(p, "", "", "");
+
+  if (!p->psz_volume_id || !p->psz_application_id
+      || NODE_NONE == writer_node_new(p, NODE_NONE, "", 0, true)) {
+    iso9660_writer_free(p);
+    return NULL;
+  }
+  return p;
+}
+
+/*!
+  Set the publisher, data preparer and application IDs of the image.
+  NULL leaves an ID as it was.
+*/
+void
+iso9660_writer_set_ids(iso9660_writer_t *p, const char psz_publisher_id[],
+                       const char psz_preparer_id[],
+                       const char psz_application_id[])
+{
+  const char *ids[3];
+  char **pp_ids[3];
+  unsigned int i;
+
+  if (!p) return;
+  ids[0] = psz_publisher_id;   pp_ids[0] = &p->psz_publisher_id;
+  ids[1] = psz_preparer_id;    pp_ids[1] = &p->psz_preparer_id;
+  ids[2] = psz_application_id; pp_ids[2] = &p->psz_application_id;
+
+  for (i = 0; i < 3; i++) {
+    char *psz_id;
+    size_t j;
+
+    if (!ids[i]) continue;
+    psz_id = strdup(ids[i]);
+    if (!psz_id) continue;
+    /* The ISO 9660 volume descriptor takes upper case a-characters. */
+    for (j = 0; psz_id[j]; j++) {
+      if (psz_id[j] >= 'a' && psz_id[j] <= 'z')
+        psz_id[j] = psz_id[j] - 'a' + 'A';
+      else if (!iso9660_is_achar(psz_id[j]))
+        psz_id[j] = '_';
+    }
+    if (j > ISO_MAX_PUBLISHER_ID) psz_id[ISO_MAX_PUBLISHER_ID] = '\0';
+    free(*pp_ids[i]);
+    *pp_ids[i] = psz_id;
+  }
+}
+
+/*!
+  Add the directory psz_path, along with any directories above it
+  that aren't there yet.
+*/
+bool
+iso9660_writer_add_dir(iso9660_writer_t *p, const char psz_path[])
+{
+  if (!p || !psz_path) return false;
+  return NODE_NONE != writer_path(p, psz_path, true, true);
+}
+
+/*!
+  Add psz_path with the contents and attributes of the file
+  psz_source.
+*/
+bool
+iso9660_writer_add_file(iso9660_writer_t *p, const char psz_path[],
+                        const char psz_source[])
+{
+  struct stat statbuf;
+
+  if (!p || !psz_path || !psz_source) return false;
+  if (0 != stat(psz_source, &statbuf)) {
+    cdio_warn("can't stat %s: %s", psz_source, strerror(errno));
+    return false;
+  }
+  if (!S_ISREG(statbuf.st_mode)) {
+    cdio_warn("%s is not a regular file", psz_source);
+    return false;
+  }
+  return writer_add_file(p, psz_path, psz_source, &statbuf);
+}
+
+/*!
+  Add the directory psz_source_dir and everything under it at
+  psz_path.
+*/
+bool
+iso9660_writer_add_tree(iso9660_writer_t *p, const char psz_path[],
+                        const char psz_source_dir[])
+{
+#ifdef HAVE_DIRENT_H
+  struct stat statbuf;
+  struct dirent *p_entry;
+  DIR *p_dir;
+  uint32_t i_node;
+  bool b_ok = true;
+
+  if (!p || !psz_path || !psz_source_dir) return false;
+  if (0 != stat(psz_source_dir, &statbuf)) {
+    cdio_warn("can't stat %s: %s", psz_source_dir, strerror(errno));
+    return false;
+  }
+  i_node = writer_path(p, psz_path, true, true);
+  if (NODE_NONE == i_node) return false;
+  writer_set_stat(&p->p_nodes[i_node], &statbuf);
+
+  p_dir = opendir(psz_source_dir);
+  if (!p_dir) {
+    cdio_warn("can't open directory %s: %s", psz_source_dir,
+              strerror(errno));
+    return false;
+  }
+
+  while (b_ok && NULL != (p_entry = readdir(p_dir))) {
+    const char *psz_name = p_entry->d_name;
+    const size_t i_path = strlen(psz_path), i_dir = strlen(psz_source_dir),
+      i_name = strlen(psz_name);
+    char *psz_image_path, *psz_source;
+
+    if (0 == strcmp(psz_name, ".") || 0 == strcmp(psz_name, ".."))
+      continue;
+
+    psz_image_path = malloc(i_path + i_name + 2);
+    psz_source = malloc(i_dir + i_name + 2);
+    if (!psz_image_path || !psz_source) {
+      free(psz_image_path);
+      free(psz_source);
+      b_ok = false;
+      break;
+    }
+    snprintf(psz_image_path, i_path + i_name + 2, "%s/%s", psz_path,
+             psz_name);
+    snprintf(psz_source, i_dir + i_name + 2, "%s/%s", psz_source_dir,
+             psz_name);
+
+    if (0 != lstat(psz_source, &statbuf)) {
+      cdio_warn("can't stat %s: %s", psz_source, strerror(errno));
+      b_ok = false;
+    } else if (S_ISDIR(statbuf.st_mode))
+      b_ok = iso9660_writer_add_tree(p, psz_image_path, psz_source);
+    else if (S_ISREG(statbuf.st_mode))
+      b_ok = writer_add_file(p, psz_image_path, psz_source, &statbuf);
+    else
+      cdio_info("skipping %s: not a regular file or directory", psz_source);
+
+    free(psz_image_path);
+    free(psz_source);
+  }
+  closedir(p_dir);
+  return b_ok;
+#else
+  cdio_warn("can't read directory %s: no directory reading support",
+            psz_source_dir);
+  return false;
+#endif
+}
+
+/*!
+  Lay out and write the image to psz_image.
+*/
+bool
+iso9660_writer_write(iso9660_writer_t *p, const char psz_image[])
+{
+  writer_out_t out;
+  uint8_t *p_buf = NULL;
+  uint32_t i, c;
+  bool b_ok;
+
+  if (!p || !psz_image) return false;
+  if (!writer_layout(p)) return false;
+
+  out.psz_image = psz_image;
+  out.i_written = 0;
+  out.b_error   = false;
+  out.p_out = CDIO_FOPEN(psz_image, "wb");
+  if (!out.p_out) {
+    cdio_warn("can't create %s: %s", psz_image, strerror(errno));
+    return false;
+  }
+
+  p_buf = malloc(WRITER_COPY_SIZE);
+  b_ok = (NULL != p_buf);
+  if (!b_ok)
+    cdio_warn("out of memory writing %s", psz_image);
+
+  if (b_ok) {
+    writer_pad(&out, ISO_PVD_SECTOR);
+    writer_put_vds(p, &out);
+    b_ok = writer_put_pathtables(p, &out, p->p_dirs, false, p->i_pt_size,
+                                 p->i_pt_l, p->i_pt_m)
+      && (!p->b_joliet
+          || writer_put_pathtables(p, &out, p->p_jdirs, true, p->i_jpt_size,
+                                   p->i_jpt_l, p->i_jpt_m))
+      && writer_put_dirs(p, &out, p->p_dirs, false)
+      && (!p->b_joliet || writer_put_dirs(p, &out, p->p_jdirs, true));
+  }
+
+  for (i = 0; b_ok && i < p->i_dirs; i++)
+    for (c = p->p_nodes[p->p_dirs[i]].i_child; b_ok && NODE_NONE != c;
+         c = p->p_nodes[c].i_next) {
+      const writer_node_t *p_node = &p->p_nodes[c];
+      if (p_node->b_dir || 0 == p_node->i_size) continue;
+      writer_pad(&out, p_node->i_extent);
+      b_ok = writer_put_file(&out, p_node, p_buf);
+    }
+  if (b_ok)
+    writer_pad(&out, p->i_volume_size);
+
+  free(p_buf);
+  if (0 != fclose(out.p_out) && b_ok) {
+    cdio_warn("error writing %s: %s", psz_image, strerror(errno));
+    b_ok = false;
+  }
+  return b_ok && !out.b_error;
+}
+
+/*!
+  Free the writer p and everything added to it.
+*/
+void
+iso9660_writer_free(iso9660_writer_t *p)
+{
+  uint32_t i;
+
+  if (!p) return;
+  for (i = 0; i < p->i_nodes; i++) {
+    free(p->p_nodes[i].psz_name);
+    free(p->p_nodes[i].psz_source);
+    free(p->p_nodes[i].psz_iso);
+    free(p->p_nodes[i].p_joliet);
+  }
+  free(p->p_nodes);
+  free(p->p_hash);
+  free(p->p_dirs);
+  free(p->p_jdirs);
+  free(p->psz_volume_id);
+  free(p->psz_publisher_id);
+  free(p->psz_preparer_id);
+  free(p->psz_application_id);
+  free(p);
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
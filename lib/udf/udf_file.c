@@ -20,6 +20,7 @@
    say opensolaris. */
 #include "udf_private.h"
 #include <cdio/bytesex.h>
+#include <cdio/util.h>
 #include "udf_fs.h"
 
 #ifdef HAVE_STRING_H
@@ -32,7 +33,6 @@
 
 /* Useful defines */
 
-#define MIN(a, b) (a<b) ? (a) : (b)
 #define CEILING(x, y) ((x+(y-1))/y)
 
 #define	GETICB(offset)	\
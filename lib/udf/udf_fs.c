@@ -70,6 +70,7 @@ const char VSD_STD_ID_NSR03[] = {'N', 'S', 'R', '0', '3'};
 const char VSD_STD_ID_TEA01[] = {'T', 'E', 'A', '0', '1'};
 
 #include <cdio/bytesex.h>
+#include <cdio/utf8.h>
 #include "udf_private.h"
 #include "udf_fs.h"
 #include "cdio_assert.h"
@@ -199,9 +200,8 @@ udf_get_lba(const udf_file_entry_t *p_udf_fe,
 #define udf_PATH_DELIMITERS "/\\"
 
 /* Searches p_udf_dirent a directory entry called psz_token.
-   Note p_udf_dirent is continuously updated. If the entry is
-   not found p_udf_dirent is useless and thus the caller should
-   not use it afterwards.
+   Note p_udf_dirent is continuously updated and is consumed: either it
+   is returned positioned at the entry found, or it has been freed.
 */
 static 
 udf_dirent_t *
@@ -217,16 +217,13 @@ udf_ff_traverse(udf_dirent_t *p_udf_dirent, char *psz_token)
 	udf_dirent_t * p_udf_dirent2 = udf_opendir(p_udf_dirent);
 	
 	if (p_udf_dirent2) {
-	  udf_dirent_t * p_udf_dirent3 = 
-	    udf_ff_traverse(p_udf_dirent2, next_tok);
-
-	  /* if p_udf_dirent3 is null p_udf_dirent2 is free'd. */
-	  return p_udf_dirent3;
+	  udf_dirent_free(p_udf_dirent);
+	  return udf_ff_traverse(p_udf_dirent2, next_tok);
 	}
       }
     }
   }
-  free(p_udf_dirent->psz_name);
+  /* udf_readdir() has freed p_udf_dirent on reaching the end. */
   return NULL;
 }
 
@@ -256,8 +253,8 @@ udf_fopen(udf_dirent_t *p_udf_root, const char *psz_name)
 	udf_new_dirent(&p_udf_root->fe, p_udf_root->p_udf,
 		       p_udf_root->psz_name, p_udf_root->b_dir, 
 		       p_udf_root->b_parent);
-      p_udf_file = udf_ff_traverse(p_udf_dirent, psz_token);
-      udf_dirent_free(p_udf_dirent);
+      if (p_udf_dirent)
+	p_udf_file = udf_ff_traverse(p_udf_dirent, psz_token);
     }
     else if ( 0 == strncmp("/", psz_name, sizeof("/")) ) {
       return udf_new_dirent(&p_udf_root->fe, p_udf_root->p_udf,
@@ -268,8 +265,8 @@ udf_fopen(udf_dirent_t *p_udf_root, const char *psz_name)
   return p_udf_file;
 }
 
-/* Convert unicode16 to 8-bit char by dripping MSB. 
-   Wonder if iconv can be used here
+/* Convert unicode16 to 8-bit char by dripping MSB. File names are
+   converted to UTF-8 with cdio_ucs2be_to_utf8() instead.
 */
 static int 
 unicode16_decode( const uint8_t *data, int i_len, char *target ) 
@@ -322,6 +319,8 @@ udf_read_sectors (const udf_t *p_udf, void *ptr, lsn_t i_start,
   long i_read;
   off_t i_byte_offset;
   
+  uint64_t i_clock;
+
   if (!p_udf) return 0;
   /* Without the cast, i_start * UDF_BLOCKSIZE may be evaluated as 32 bit */
   i_byte_offset = ((off_t)i_start) * UDF_BLOCKSIZE;
@@ -332,16 +331,26 @@ udf_read_sectors (const udf_t *p_udf, void *ptr, lsn_t i_start,
     return DRIVER_OP_BAD_PARAMETER;
   }
 
+  i_clock = cdio_stats_now();
   if (p_udf->b_stream) {
+    i_read = 0;
     ret = cdio_stream_seek (p_udf->stream, i_byte_offset, SEEK_SET);
-    if (DRIVER_OP_SUCCESS != ret) return ret;
-    i_read = cdio_stream_read (p_udf->stream, ptr, UDF_BLOCKSIZE, i_blocks);
-    if (i_read) return DRIVER_OP_SUCCESS;
-    return DRIVER_OP_ERROR;
+    if (DRIVER_OP_SUCCESS == ret) {
+      /* cdio_stream_read() returns the bytes read, which may be short
+	 at the end of the image. */
+      i_read = cdio_stream_read (p_udf->stream, ptr, UDF_BLOCKSIZE, i_blocks);
+      ret = i_read > 0 ? DRIVER_OP_SUCCESS : DRIVER_OP_ERROR;
+      if (i_read < 0) i_read = 0;
+    }
   } else {
-    return cdio_read_data_sectors(p_udf->cdio, ptr, i_start, UDF_BLOCKSIZE,
-				  i_blocks);
+    ret = cdio_read_data_sectors(p_udf->cdio, ptr, i_start, UDF_BLOCKSIZE,
+				 i_blocks);
+    i_read = (DRIVER_OP_SUCCESS == ret) ? i_blocks * UDF_BLOCKSIZE : 0;
   }
+  cdio_stats_record(&((udf_t *) p_udf)->stats, p_udf->psz_source,
+		    CDIO_STATS_READ, i_start, i_read / UDF_BLOCKSIZE,
+		    (uint64_t) i_read, 0, ret, i_clock);
+  return ret;
 }
 
 /*!
@@ -361,6 +370,9 @@ udf_open (const char *psz_path)
   /* Sanity check */
   cdio_assert(sizeof(udf_file_entry_t) == UDF_BLOCKSIZE);
 
+  cdio_stats_state_init(&p_udf->stats);
+  p_udf->psz_source = strdup(psz_path);
+
   p_udf->cdio = cdio_open(psz_path, DRIVER_UNKNOWN);
   if (!p_udf->cdio) {
     /* Not a CD-ROM drive or CD Image. Maybe it's a UDF file not
@@ -420,6 +432,7 @@ udf_open (const char *psz_path)
 
  error:
   cdio_stdio_destroy(p_udf->stream);
+  free(p_udf->psz_source);
   free(p_udf);
   return NULL;
 }
@@ -588,10 +601,47 @@ udf_close (udf_t *p_udf)
 
   /* Get rid of root directory if allocated. */
 
+  free(p_udf->psz_source);
   free_and_null(p_udf);
   return true;
 }
 
+/*!
+  Copy the I/O statistics of p_udf into p_stats.
+*/
+driver_return_code_t
+udf_get_stats (const udf_t *p_udf, /*out*/ cdio_stats_t *p_stats)
+{
+  if (!p_udf) return DRIVER_OP_UNINIT;
+  if (!p_stats) return DRIVER_OP_BAD_POINTER;
+  *p_stats = p_udf->stats.stats;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Set all of the I/O statistics of p_udf back to zero.
+*/
+driver_return_code_t
+udf_reset_stats (udf_t *p_udf)
+{
+  if (!p_udf) return DRIVER_OP_UNINIT;
+  cdio_stats_state_reset(&p_udf->stats);
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Install or, if callback is NULL, remove the trace callback of p_udf.
+*/
+driver_return_code_t
+udf_set_trace_callback (udf_t *p_udf, cdio_trace_callback_t callback,
+			void *p_user_data)
+{
+  if (!p_udf) return DRIVER_OP_UNINIT;
+  p_udf->stats.trace_callback = callback;
+  p_udf->stats.p_trace_data   = callback ? p_user_data : NULL;
+  return DRIVER_OP_SUCCESS;
+}
+
 udf_dirent_t * 
 udf_opendir(const udf_dirent_t *p_udf_dirent)
 {
@@ -679,13 +729,20 @@ udf_readdir(udf_dirent_t *p_udf_dirent)
 		return NULL;
 	}
 
-	if (strlen(p_udf_dirent->psz_name) < i_len) 
+	const uint8_t *p_file_id = p_udf_dirent->fid->u.imp_use.data
+	  + p_udf_dirent->fid->u.i_imp_use;
+
+	/* Room for i_len - 1 bytes of unicode16 as UTF-8, at up to 3
+	   bytes a character. */
+	if (strlen(p_udf_dirent->psz_name) < 2 * i_len)
 	  p_udf_dirent->psz_name = (char *)
-	    realloc(p_udf_dirent->psz_name, sizeof(char)*i_len+1);
+	    realloc(p_udf_dirent->psz_name, sizeof(char)*2*i_len+1);
 	
-	unicode16_decode(p_udf_dirent->fid->u.imp_use.data 
-			 + p_udf_dirent->fid->u.i_imp_use, 
-			 i_len, p_udf_dirent->psz_name);
+	if (i_len > 0 && 16 == p_file_id[0])
+	  cdio_ucs2be_to_utf8(p_file_id + 1, i_len - 1,
+			      p_udf_dirent->psz_name, 2 * i_len + 1);
+	else
+	  unicode16_decode(p_file_id, i_len, p_udf_dirent->psz_name);
       }
       return p_udf_dirent;
     }
@@ -31,6 +31,7 @@
 #include <cdio/ecma_167.h>
 #include <cdio/udf.h>
 #include "_cdio_stdio.h"
+#include "stats_private.h"
 
 /* Implementation of opaque types */
 
@@ -45,6 +46,8 @@ struct udf_s {
   uint32_t              i_part_start; /* start of Partition Descriptor */
   uint32_t              lvd_lba;      /* sector of Logical Volume Descriptor */
   uint32_t              fsd_offset;   /* lba of fileset descriptor */
+  char                  *psz_source;  /* Path the UDF was opened with */
+  cdio_stats_state_t    stats;        /* I/O counters and trace hook */
 };
 
 #endif /* CDIO_UDF_UDF_PRIVATE_H_ */
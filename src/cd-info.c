@@ -98,6 +98,7 @@ static struct opts_s
   int            no_rock_ridge;
   int            print_iso9660;
   int            list_drives;
+  unsigned int   checksums;   /* cdio_checksum_kind_t values to compute */
   source_image_t source_image;
 } opts;
      
@@ -119,6 +120,8 @@ enum {
   OP_CDDB_NOCACHE,
   OP_CDDB_TIMEOUT,
 
+  OP_CHECKSUMS,
+
   OP_USAGE,
 
   /* These are the remaining configuration options */
@@ -126,6 +129,31 @@ enum {
   
 };
 
+/* Parse the --checksums list, like "md5,crc32"; all of them when
+   there is none. Return 0 if some name isn't known. */
+static unsigned int
+parse_checksums(const char *psz_list)
+{
+  unsigned int i_kinds = 0;
+
+  if (NULL == psz_list) return CDIO_CHECKSUM_ALL;
+
+  while (*psz_list) {
+    const size_t i_len = strcspn(psz_list, ",");
+    unsigned int i_kind;
+    for (i_kind = 1; i_kind <= CDIO_CHECKSUM_ALL; i_kind <<= 1) {
+      const char *psz_name = cdio_checksum_kind2str(i_kind);
+      if (strlen(psz_name) == i_len && 0 == strncmp(psz_name, psz_list, i_len))
+        break;
+    }
+    if (i_kind > CDIO_CHECKSUM_ALL) return 0;
+    i_kinds |= i_kind;
+    psz_list += i_len;
+    if (',' == *psz_list) psz_list++;
+  }
+  return i_kinds;
+}
+
 /* Parse source options. */
 static void
 parse_source(int opt)
@@ -231,6 +259,9 @@ parse_options (int argc, char *argv[])
     "                                  device\n"
     "  --iso9660                       print directory contents of any ISO-9660\n"
     "                                  filesystems\n"
+    "  --checksums[=LIST]              read every track and show its checksums;\n"
+    "                                  LIST is a comma-separated list of crc32,\n"
+    "                                  md5, sha256 and accuraterip (default all)\n"
     "  -C, --cdrom-device[=DEVICE]     set CD-ROM device as source\n"
     "  -l, --list-drives               Give a list of CD-drives\n"
     "  --no-header                     Don't display header and copyright (for\n"
@@ -256,6 +287,7 @@ parse_options (int argc, char *argv[])
     "        [--no-disc-mode] [--dvd] [-v|--no-vcd] [-I|--no-ioctl]\n"
     "        [-b|--bin-file FILE] [-c|--cue-file FILE] [-N|--nrg-file FILE]\n"
     "        [-t|--toc-file FILE] [-i|--input FILE] [--iso9660]\n"
+    "        [--checksums[=LIST]]\n"
     "        [-C|--cdrom-device DEVICE] [-l|--list-drives] [--no-header]\n"
     "        [--no-joliet] [--no-rock-ridge] [--no-xa] [-q|--quiet] [-V|--version]\n"
     "        [-?|--help] [--usage]\n";
@@ -285,6 +317,7 @@ parse_options (int argc, char *argv[])
     {"toc-file", optional_argument, NULL, 't' },
     {"input", optional_argument, NULL, 'i' },
     {"iso9660", no_argument, &opts.print_iso9660, 1 },
+    {"checksums", optional_argument, NULL, OP_CHECKSUMS },
     {"cdrom-device", optional_argument, NULL, 'C' },
     {"list-drives", no_argument, NULL, 'l' },
     {"no-header", no_argument, &opts.no_header, 1 }, 
@@ -331,6 +364,15 @@ parse_options (int argc, char *argv[])
     case 'q': opts.silent = 1; break;
     case 'V': opts.version_only = 1; break;
 
+    case OP_CHECKSUMS:
+      opts.checksums = parse_checksums(optarg);
+      if (0 == opts.checksums) {
+        report(stderr, "%s: unknown checksum in `%s'\n", program_name, optarg);
+        free(program_name);
+        exit (EXIT_FAILURE);
+      }
+      break;
+
     case '?':
       fprintf(stdout, helpText, program_name);
       free(program_name);
@@ -414,6 +456,58 @@ _cddb_log_handler (cddb_log_level_t level, const char message[])
 }
 #endif
 
+static void
+print_checksum_report(const cdio_checksum_report_t *p_sum)
+{
+  unsigned int i;
+
+  if (p_sum->i_track)
+    printf("%3d: %06lu %6lu %-5s", (int) p_sum->i_track,
+           (long unsigned int) p_sum->i_lsn,
+           (long unsigned int) p_sum->i_sectors,
+           p_sum->b_audio ? "audio" : "data");
+  else
+    printf("disc %06lu %6lu      ", (long unsigned int) p_sum->i_lsn,
+           (long unsigned int) p_sum->i_sectors);
+
+  if (p_sum->i_kinds & CDIO_CHECKSUM_CRC32)
+    printf(" crc32 %08x", p_sum->crc32);
+  if (p_sum->i_kinds & CDIO_CHECKSUM_MD5) {
+    printf(" md5 ");
+    for (i = 0; i < CDIO_MD5_DIGEST_SIZE; i++)
+      printf("%02x", p_sum->md5[i]);
+  }
+  if (p_sum->i_kinds & CDIO_CHECKSUM_SHA256) {
+    printf(" sha256 ");
+    for (i = 0; i < CDIO_SHA256_DIGEST_SIZE; i++)
+      printf("%02x", p_sum->sha256[i]);
+  }
+  if (p_sum->i_kinds & CDIO_CHECKSUM_ACCURATERIP)
+    printf(" ar %08x %08x", p_sum->accuraterip_v1, p_sum->accuraterip_v2);
+  if (DRIVER_OP_SUCCESS != p_sum->i_status)
+    printf(" (%s)", cdio_driver_errmsg(p_sum->i_status));
+  printf("\n");
+}
+
+/* Read every track and print the i_kinds checksums of each, and of
+   the whole disc. */
+static void
+print_checksums(CdIo_t *p_cdio, unsigned int i_kinds)
+{
+  cdio_disc_checksum_t *p_sums = calloc(1, sizeof(cdio_disc_checksum_t));
+  track_t i;
+
+  if (!p_sums) return;
+  report(stdout, STRONG "Checksums\n" NORMAL);
+  printf("  #: LSN    Blocks Type\n");
+  cdio_checksum_disc(p_cdio, i_kinds, p_sums);
+  for (i = 0; i < p_sums->i_tracks; i++)
+    print_checksum_report(&p_sums->track[i]);
+  if (p_sums->i_tracks)
+    print_checksum_report(&p_sums->disc);
+  free(p_sums);
+}
+
 static void 
 print_cdtext_track_info(cdtext_t *p_cdtext, track_t i_track, const char *psz_msg) {
 
@@ -810,6 +904,7 @@ init(void)
   opts.debug_level   = 0;
   opts.no_tracks     = 0;
   opts.print_iso9660 = 0;
+  opts.checksums     = 0;
 #ifdef HAVE_CDDB
   opts.no_cddb       = 0;
   cddb_opts.port     = 8880;
@@ -1215,6 +1310,14 @@ main(int argc, char *argv[])
     }
   }
 
+  if (opts.checksums) {
+    if (b_playing_audio)
+      report(stdout, "Checksums omitted because audio is currently "
+             "playing.\n");
+    else
+      print_checksums(p_cdio, opts.checksums);
+  }
+
   if (!opts.no_analysis) {
     if (b_playing_audio) {
       /* Running a CD Analysis would mess up audio playback.*/
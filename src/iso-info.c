@@ -264,7 +264,8 @@ print_iso9660_recurse (iso9660_t *p_iso, const char psz_path[])
                        psz_iso_name, translated_name);
       } else 
         if ( strcmp (psz_iso_name, ".") && strcmp (psz_iso_name, ".."))
-          printf("%9u %s%s\n", (unsigned int) p_statbuf->size, psz_path, 
+          printf("%9llu %s%s\n",
+                 (long long unsigned int) p_statbuf->total_size, psz_path,
                  yep == p_statbuf->rr.b3_rock 
                  ? psz_iso_name : translated_name);
       if (p_statbuf->rr.i_symlink) {
@@ -36,6 +36,9 @@
 #ifdef HAVE_ERRNO_H
 #include <errno.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
@@ -47,6 +50,9 @@
 
 #define CEILING(x, y) ((x+(y-1))/y)
 
+/* Blocks of an ISO 9660 file copied at a time. */
+#define ISO_READ_BLOCKS 256
+
 /* Used by `main' to communicate with `parse_opt'. And global options
  */
 static struct arguments
@@ -208,10 +214,9 @@ init(void)
 }
 
 static int read_iso_file(const char *iso_name, const char *src,
-                         FILE *outfd, size_t *bytes_written)
+                         FILE *outfd, off_t *bytes_written)
 {
   iso9660_stat_t *statbuf;
-  int i;
   iso9660_t *iso;
 
   iso = iso9660_open (iso_name);
@@ -238,39 +243,57 @@ static int read_iso_file(const char *iso_name, const char *src,
     }
 
 
-  /* Copy the blocks from the ISO-9660 filesystem to the local filesystem. */
-  for (i = 0; i < statbuf->size; i += ISO_BLOCKSIZE)
-    {
-      char buf[ISO_BLOCKSIZE];
+  /* Copy the blocks from the ISO-9660 filesystem to the local
+     filesystem, following every extent of a multi-extent file. */
+  {
+    const uint64_t i_blocks = CEILING(statbuf->total_size, ISO_BLOCKSIZE);
+    char *buf = malloc(ISO_READ_BLOCKS * ISO_BLOCKSIZE);
+    uint64_t i;
 
-      memset (buf, 0, ISO_BLOCKSIZE);
-      
-      if ( ISO_BLOCKSIZE != iso9660_iso_seek_read (iso, buf, statbuf->lsn 
-                                                   + (i / ISO_BLOCKSIZE),
-                                                   1) )
+    if (!buf) {
+      perror ("malloc()");
+      return 4;
+    }
+
+    for (i = 0; i < i_blocks; i += ISO_READ_BLOCKS)
       {
-        report(stderr, "Error reading ISO 9660 file at lsn %lu\n",
-               (long unsigned int) statbuf->lsn + (i / ISO_BLOCKSIZE));
-        if (!opts.ignore) return 4;
+        const long int i_now = (i_blocks - i < ISO_READ_BLOCKS)
+          ? (long int) (i_blocks - i) : ISO_READ_BLOCKS;
+
+        memset (buf, 0, i_now * ISO_BLOCKSIZE);
+
+        if ( i_now * ISO_BLOCKSIZE
+             != iso9660_iso_seek_read_file (iso, statbuf, buf, i, i_now) )
+          {
+            report(stderr, "Error reading ISO 9660 file at block %lu\n",
+                   (long unsigned int) i);
+            if (!opts.ignore) {
+              free (buf);
+              return 4;
+            }
+          }
+
+        fwrite (buf, ISO_BLOCKSIZE, i_now, outfd);
+
+        if (ferror (outfd))
+          {
+            perror ("fwrite()");
+            free (buf);
+            return 5;
+          }
       }
-      
-      
-      fwrite (buf, ISO_BLOCKSIZE, 1, outfd);
-      
-      if (ferror (outfd))
-        {
-          perror ("fwrite()");
-          return 5;
-        }
-    }
+    free (buf);
+  }
   iso9660_close(iso);
 
-  *bytes_written = statbuf->size;
+  *bytes_written = statbuf->total_size;
+  free(statbuf->rr.psz_symlink);
+  free(statbuf);
   return 0;
 }
 
 static int read_udf_file(const char *iso_name, const char *src,
-                         FILE *outfd, size_t *bytes_written)
+                         FILE *outfd, off_t *bytes_written)
 {
   udf_t *p_udf;
 
@@ -332,7 +355,7 @@ main(int argc, char *argv[])
 {
   FILE *outfd;
   int ret;
-  size_t bytes_written;
+  off_t bytes_written;
   
   init();
 
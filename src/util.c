@@ -482,15 +482,15 @@ print_fs_attrs(iso9660_stat_t *p_statbuf, bool b_rock, bool b_xa,
 
 #ifdef HAVE_ROCK
   if (yep == p_statbuf->rr.b3_rock && b_rock) {
-    report ( stdout, "  %s %3d %d %d [LSN %6lu] %9u",
+    report ( stdout, "  %s %3d %d %d [LSN %6lu] %9llu",
 	     iso9660_get_rock_attr_str (p_statbuf->rr.st_mode),
 	     p_statbuf->rr.st_nlinks,
 	     p_statbuf->rr.st_uid,
 	     p_statbuf->rr.st_gid,
 	     (long unsigned int) p_statbuf->lsn,
 	     S_ISLNK(p_statbuf->rr.st_mode) 
-	     ? strlen(p_statbuf->rr.psz_symlink)
-	     : (unsigned int) p_statbuf->size );
+	     ? (long long unsigned int) strlen(p_statbuf->rr.psz_symlink)
+	     : (long long unsigned int) p_statbuf->total_size );
 
   } else 
 #endif
@@ -507,12 +507,13 @@ print_fs_attrs(iso9660_stat_t *p_statbuf, bool b_rock, bool b_xa,
 	       (unsigned int) p_statbuf->secsize * M2F2_SECTOR_SIZE,
 	       (unsigned int) p_statbuf->size );
     } else 
-      report (stdout, "%9u", (unsigned int) p_statbuf->size);
+      report (stdout, "%9llu",
+	      (long long unsigned int) p_statbuf->total_size);
   } else {
-    report ( stdout,"  %c [LSN %6lu] %9u", 
+    report ( stdout,"  %c [LSN %6lu] %9llu",
 	     (p_statbuf->type == _STAT_DIR) ? 'd' : '-',
 	     (long unsigned int) p_statbuf->lsn,
-	     (unsigned int) p_statbuf->size );
+	     (long long unsigned int) p_statbuf->total_size );
   }
 
   if (yep == p_statbuf->rr.b3_rock && b_rock) {
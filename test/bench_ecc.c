@@ -0,0 +1,265 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark for the EDC/ECC engine of <cdio/ecc.h>.
+
+   A buffer of raw sectors is built in memory for each of Mode 1,
+   Mode 2 Form 1 and Mode 2 Form 2, and then
+
+     cdio_edc             over the bytes each sector's EDC covers
+     cdio_sectors_verify  over the whole buffer in one call
+     cdio_sector_repair   on intact sectors (the verify-only path)
+     cdio_sector_repair   on sectors with a few bytes damaged
+     cdio_sector_encode   to build each sector again
+
+   are timed.  Results go to stdout as comma-separated values, one
+   line per (mode, operation), with throughput in GB/s (10^9 bytes of
+   raw sectors per second) so that it can be set against the rate of
+   a drive or a disk.
+
+   This is not run as part of "make check"; use "make bench".
+*/
+#include "portable.h"
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#include <time.h>
+
+#include <cdio/cdio.h>
+#include <cdio/sector.h>
+#include <cdio/ecc.h>
+
+#define BENCH_DEFAULT_SECTORS  8192
+#define BENCH_DEFAULT_REPEAT   5
+
+typedef enum {
+  OP_EDC,         /* cdio_edc */
+  OP_VERIFY,      /* cdio_sectors_verify */
+  OP_REPAIR_OK,   /* cdio_sector_repair, nothing to repair */
+  OP_REPAIR_BAD,  /* cdio_sector_repair, damaged sectors */
+  OP_ENCODE,      /* cdio_sector_encode */
+} bench_op_t;
+
+static const char *op_name[] = {
+  "edc", "verify", "repair_intact", "repair_damaged", "encode"
+};
+
+static const struct {
+  cdio_raw_mode_t e_mode;
+  const char     *psz_name;
+  size_t          i_data;     /* user data bytes */
+  size_t          i_edc_from; /* first byte the EDC covers */
+  size_t          i_edc_len;  /* bytes it covers */
+} modes[] = {
+  { CDIO_RAW_MODE1,       "mode1",    CDIO_CD_FRAMESIZE,       0,  2064 },
+  { CDIO_RAW_MODE2_FORM1, "mode2f1",  CDIO_CD_FRAMESIZE,       16, 2056 },
+  { CDIO_RAW_MODE2_FORM2, "mode2f2",  CDIO_CD_M2F2_DATA_SIZE,  16, 2332 },
+};
+
+static unsigned int i_sectors = BENCH_DEFAULT_SECTORS;
+static unsigned int i_repeat  = BENCH_DEFAULT_REPEAT;
+
+/* Monotonic time in seconds. */
+static double
+now_sec(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#elif defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1e6;
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Build i_sectors raw sectors of mode m into p_raw, with user data
+   that is a simple function of the LSN. */
+static void
+make_sectors(uint8_t *p_raw, unsigned int m)
+{
+  uint8_t data[CDIO_CD_M2F2_DATA_SIZE];
+  unsigned int i, j;
+
+  for (i = 0; i < i_sectors; i++) {
+    for (j = 0; j < modes[m].i_data; j++)
+      data[j] = (uint8_t) (i * 7 + j);
+    cdio_sector_encode(p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW, i,
+                       modes[m].e_mode, NULL, data);
+  }
+}
+
+/* Damage a few bytes of each sector, few enough that P and Q can put
+   them right. */
+static void
+damage_sectors(uint8_t *p_raw)
+{
+  unsigned int i;
+  for (i = 0; i < i_sectors; i++) {
+    uint8_t *p = p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW;
+    p[100 + i % 1000] ^= 0x55;
+    p[1500]           ^= 0x01;
+  }
+}
+
+/* Time one operation over the buffer and print a line of results.
+   Return the number of sectors which didn't come out as expected. */
+static unsigned int
+bench_one(unsigned int m, bench_op_t op, uint8_t *p_raw,
+          const uint8_t *p_good)
+{
+  const size_t i_bytes = (size_t) i_sectors * CDIO_CD_FRAMESIZE_RAW;
+  uint8_t data[CDIO_CD_M2F2_DATA_SIZE];
+  double t_total = 0, t0;
+  unsigned int i, r, i_errors = 0;
+  volatile uint32_t i_sink = 0;
+
+  memset(data, 0x5a, sizeof(data));
+  for (r = 0; r < i_repeat; r++) {
+    if (OP_REPAIR_BAD == op) {
+      memcpy(p_raw, p_good, i_bytes);
+      damage_sectors(p_raw);
+    }
+    t0 = now_sec();
+    switch (op) {
+    case OP_EDC:
+      for (i = 0; i < i_sectors; i++)
+        i_sink += cdio_edc(p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW
+                           + modes[m].i_edc_from, modes[m].i_edc_len);
+      break;
+    case OP_VERIFY:
+      i_errors += cdio_sectors_verify(p_raw, i_sectors, NULL);
+      break;
+    case OP_REPAIR_OK:
+      for (i = 0; i < i_sectors; i++)
+        if (CDIO_SECTOR_OK !=
+            cdio_sector_repair(p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW))
+          i_errors++;
+      break;
+    case OP_REPAIR_BAD:
+      for (i = 0; i < i_sectors; i++) {
+        const cdio_sector_status_t e_status =
+          cdio_sector_repair(p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW);
+        /* Form 2 has no parity to repair from. */
+        if ((CDIO_RAW_MODE2_FORM2 == modes[m].e_mode)
+            ? CDIO_SECTOR_BAD != e_status
+            : CDIO_SECTOR_CORRECTED != e_status)
+          i_errors++;
+      }
+      break;
+    case OP_ENCODE:
+    default:
+      for (i = 0; i < i_sectors; i++)
+        cdio_sector_encode(p_raw + (size_t) i * CDIO_CD_FRAMESIZE_RAW, i,
+                           modes[m].e_mode, NULL, data);
+      break;
+    }
+    t_total += now_sec() - t0;
+  }
+
+  /* Leave the buffer as it was for the next operation. */
+  memcpy(p_raw, p_good, i_bytes);
+
+  printf("%s,%s,%u,%u,%u,%.6f,%.3f,%.3f\n",
+         modes[m].psz_name, op_name[op], i_sectors, i_repeat, i_errors,
+         t_total,
+         t_total > 0 ? (double) i_bytes * i_repeat / t_total / 1e9 : 0.0,
+         t_total * 1e6 / ((double) i_sectors * i_repeat));
+  return i_errors;
+}
+
+static void
+usage(const char *psz_prog)
+{
+  fprintf(stderr,
+          "Usage: %s [--sectors N] [--repeat N]\n"
+          "  --sectors N   raw sectors per buffer (default %u)\n"
+          "  --repeat N    passes over each buffer (default %u)\n",
+          psz_prog, BENCH_DEFAULT_SECTORS, BENCH_DEFAULT_REPEAT);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  unsigned int i_errors = 0;
+  unsigned int m;
+  bench_op_t op;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--sectors") && i + 1 < argc)
+      i_sectors = atoi(argv[++i]);
+    else if (0 == strcmp(argv[i], "--repeat") && i + 1 < argc)
+      i_repeat = atoi(argv[++i]);
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (0 == i_sectors || 0 == i_repeat) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  printf("mode,operation,sectors,repeat,errors,seconds,gb_per_s,"
+         "usec_per_sector\n");
+
+  for (m = 0; m < sizeof(modes)/sizeof(modes[0]); m++) {
+    uint8_t *p_raw  = malloc((size_t) i_sectors * CDIO_CD_FRAMESIZE_RAW);
+    uint8_t *p_good = malloc((size_t) i_sectors * CDIO_CD_FRAMESIZE_RAW);
+    if (!p_raw || !p_good) {
+      fprintf(stderr, "bench_ecc: out of memory\n");
+      free(p_raw);
+      free(p_good);
+      return 2;
+    }
+    make_sectors(p_good, m);
+    memcpy(p_raw, p_good, (size_t) i_sectors * CDIO_CD_FRAMESIZE_RAW);
+    for (op = OP_EDC; op <= OP_ENCODE; op++)
+      i_errors += bench_one(m, op, p_raw, p_good);
+    free(p_raw);
+    free(p_good);
+  }
+
+  if (i_errors)
+    fprintf(stderr, "bench_ecc: %u sectors didn't check out\n", i_errors);
+  return i_errors ? 3 : 0;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,1136 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark for filesystem traversal in libiso9660 and libudf.
+
+   A directory tree with configurable fan-out, depth, files per
+   directory and name length is laid out twice: once as an ISO 9660
+   image carrying Rock Ridge names in the primary tree plus a Joliet
+   tree, and once as a UDF image.  Then
+
+     iso9660_ifs_readdir, iso9660_ifs_stat and iso9660_ifs_find_lsn
+
+   are timed over the primary (Rock Ridge) and Joliet trees, and
+
+     udf_readdir and udf_fopen
+
+   over the UDF tree.  Each line of CSV output gives, for one
+   filesystem and operation, the call count, latency summary, a
+   latency histogram, allocations per call and bytes read from the
+   image per call.
+
+   Histogram buckets are powers of two in microseconds: the first
+   counts calls under 1us, the next 1-2us, then 2-4us and so on; the
+   last bucket catches everything slower.
+
+   Allocation counts need glibc, where malloc() and friends can be
+   interposed; bytes read come from /proc/self/io and so need Linux.
+   When either is unavailable the column reads "-".
+
+   This is not run as part of "make check"; use "make bench".
+*/
+#include "portable.h"
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#include <time.h>
+#include <ctype.h>
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/bytesex.h>
+#include <cdio/util.h>
+#include <cdio/ds.h>
+#include <cdio/iso9660.h>
+#include <cdio/udf.h>
+
+#define BENCH_DEFAULT_FANOUT    4
+#define BENCH_DEFAULT_DEPTH     3
+#define BENCH_DEFAULT_FILES     16
+#define BENCH_DEFAULT_NAMELEN   12
+#define BENCH_DEFAULT_FILESIZE  2048
+#define BENCH_DEFAULT_REPEAT    3
+#define BENCH_DEFAULT_SAMPLES   64
+
+#define BENCH_MAX_NAMELEN       64 /* Joliet's limit; kept for all trees */
+#define BENCH_MAX_ISONAME       30 /* primary-tree names, before ";1" */
+#define BENCH_HIST_BUCKETS      20
+
+/* Sector layout of the UDF image. */
+#define UDF_AVDP_LSN            256
+#define UDF_MVDS_LSN            257
+#define UDF_MVDS_LEN            16
+#define UDF_PART_START          (UDF_MVDS_LSN + UDF_MVDS_LEN)
+
+/* Rock Ridge system-use entry sizes. */
+#define RR_SP_LEN               7
+#define RR_PX_LEN               36
+#define RR_NM_LEN(n)            (5 + (n))
+
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_COUNT)
+/* Count every allocation made by the process, the library included.
+   glibc lets a program replace malloc() as long as the real one is
+   still reachable, which it is under these names. */
+#define BENCH_COUNT_ALLOCS 1
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static unsigned long i_alloc_count = 0;
+
+void *
+malloc(size_t n)
+{
+  i_alloc_count++;
+  return __libc_malloc(n);
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+  i_alloc_count++;
+  return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *p, size_t n)
+{
+  i_alloc_count++;
+  return __libc_realloc(p, n);
+}
+#else
+static unsigned long i_alloc_count = 0;
+#endif
+
+/* One file or directory in the synthetic tree. Nodes are kept in
+   breadth-first order, so a directory's children are contiguous and
+   the directories appear in path-table order. */
+typedef struct {
+  char         psz_name[BENCH_MAX_NAMELEN+1];
+  char        *psz_path;
+  bool         b_dir;
+  unsigned int i_depth;
+  unsigned int i_parent;
+  unsigned int i_first_child;
+  unsigned int i_children;
+  unsigned int i_dirno;         /* path table number, directories only */
+
+  /* ISO 9660: for files the data extent (shared by both trees); for
+     directories the primary and Joliet directory extents. */
+  uint32_t     i_lsn, i_size;
+  uint32_t     i_joliet_lsn, i_joliet_size;
+
+  /* UDF, partition-relative. */
+  uint32_t     i_udf_fe, i_udf_data, i_udf_size;
+} bench_node_t;
+
+/* Accumulated results for one filesystem/operation pair. */
+typedef struct {
+  const char   *psz_fs;
+  const char   *psz_op;
+  unsigned long i_calls;
+  unsigned long i_errors;
+  unsigned long i_allocs;
+  long long     i_bytes;        /* -1 if unknown */
+  double        t_total;
+  double       *a_usec;
+  unsigned long i_max_samples;
+  unsigned long a_hist[BENCH_HIST_BUCKETS];
+} bench_stat_t;
+
+static unsigned int i_fanout   = BENCH_DEFAULT_FANOUT;
+static unsigned int i_depth    = BENCH_DEFAULT_DEPTH;
+static unsigned int i_files    = BENCH_DEFAULT_FILES;
+static unsigned int i_namelen  = BENCH_DEFAULT_NAMELEN;
+static unsigned int i_filesize = BENCH_DEFAULT_FILESIZE;
+static unsigned int i_repeat   = BENCH_DEFAULT_REPEAT;
+static unsigned int i_samples  = BENCH_DEFAULT_SAMPLES;
+
+static bench_node_t *a_node = NULL;
+static unsigned int  i_nodes = 0, i_dirs = 0;
+
+/* Time in microseconds from some fixed point. */
+static double
+now_usec(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e6 + (double) ts.tv_nsec / 1e3;
+#elif defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec * 1e6 + (double) tv.tv_usec;
+#else
+  return (double) clock() * 1e6 / CLOCKS_PER_SEC;
+#endif
+}
+
+/* Bytes this process has read through read(2) and friends, or -1. */
+static long long
+bytes_read_so_far(void)
+{
+#ifdef __linux__
+  FILE *fp = fopen("/proc/self/io", "r");
+  char line[80];
+  long long i_rchar = -1;
+  if (!fp) return -1;
+  while (fgets(line, sizeof(line), fp))
+    if (1 == sscanf(line, "rchar: %lld", &i_rchar))
+      break;
+  fclose(fp);
+  return i_rchar;
+#else
+  return -1;
+#endif
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+  const double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/*========================================================================
+  Results
+ *======================================================================*/
+
+static void
+stat_init(bench_stat_t *p_stat, const char *psz_fs, const char *psz_op,
+          unsigned long i_max_samples)
+{
+  memset(p_stat, 0, sizeof(*p_stat));
+  p_stat->psz_fs = psz_fs;
+  p_stat->psz_op = psz_op;
+  p_stat->i_max_samples = i_max_samples;
+  p_stat->a_usec = calloc(i_max_samples ? i_max_samples : 1, sizeof(double));
+  p_stat->i_bytes = bytes_read_so_far();
+}
+
+static void
+stat_add(bench_stat_t *p_stat, double usec, unsigned long i_allocs, bool b_ok)
+{
+  unsigned int b = 0;
+  double limit = 1.0;
+
+  while (b < BENCH_HIST_BUCKETS - 1 && usec >= limit) {
+    b++;
+    limit *= 2;
+  }
+  p_stat->a_hist[b]++;
+  if (p_stat->i_calls < p_stat->i_max_samples)
+    p_stat->a_usec[p_stat->i_calls] = usec;
+  p_stat->i_calls++;
+  p_stat->t_total += usec;
+  p_stat->i_allocs += i_allocs;
+  if (!b_ok) p_stat->i_errors++;
+}
+
+static void
+stat_print(bench_stat_t *p_stat)
+{
+  const long long i_end = bytes_read_so_far();
+  const unsigned long n = p_stat->i_calls < p_stat->i_max_samples
+    ? p_stat->i_calls : p_stat->i_max_samples;
+  unsigned int b;
+
+  if (0 == n) {
+    free(p_stat->a_usec);
+    return;
+  }
+  qsort(p_stat->a_usec, n, sizeof(double), cmp_double);
+
+  printf("%s,%s,%lu,%lu,%.3f,%.3f,%.3f,%.3f,", p_stat->psz_fs,
+         p_stat->psz_op, p_stat->i_calls, p_stat->i_errors,
+         p_stat->t_total / p_stat->i_calls, p_stat->a_usec[n / 2],
+         p_stat->a_usec[(n * 99) / 100], p_stat->a_usec[n - 1]);
+#ifdef BENCH_COUNT_ALLOCS
+  printf("%.2f,", (double) p_stat->i_allocs / p_stat->i_calls);
+#else
+  printf("-,");
+#endif
+  if (p_stat->i_bytes >= 0 && i_end >= 0)
+    printf("%.0f,", (double) (i_end - p_stat->i_bytes) / p_stat->i_calls);
+  else
+    printf("-,");
+  for (b = 0; b < BENCH_HIST_BUCKETS; b++)
+    printf("%s%lu", b ? ":" : "", p_stat->a_hist[b]);
+  printf("\n");
+  free(p_stat->a_usec);
+}
+
+/*========================================================================
+  The tree
+ *======================================================================*/
+
+static void
+add_node(unsigned int i_parent, bool b_dir)
+{
+  bench_node_t *p_node = &a_node[i_nodes];
+  const bench_node_t *p_parent = &a_node[i_parent];
+  size_t len;
+
+  snprintf(p_node->psz_name, sizeof(p_node->psz_name), "%c%05u",
+           b_dir ? 'd' : 'f', i_nodes);
+  for (len = strlen(p_node->psz_name); len < i_namelen; len++)
+    p_node->psz_name[len] = 'a' + (len % 26);
+  p_node->psz_name[len] = '\0';
+
+  len = strlen(p_parent->psz_path) + strlen(p_node->psz_name) + 2;
+  p_node->psz_path = calloc(1, len);
+  snprintf(p_node->psz_path, len, "%s/%s",
+           0 == i_parent ? "" : p_parent->psz_path, p_node->psz_name);
+
+  p_node->b_dir    = b_dir;
+  p_node->i_depth  = p_parent->i_depth + 1;
+  p_node->i_parent = i_parent;
+  if (b_dir) p_node->i_dirno = ++i_dirs;
+  i_nodes++;
+}
+
+static bool
+build_tree(void)
+{
+  unsigned int i, j, i_max_dirs = 0, i_level = 1, i_max;
+
+  for (i = 0; i <= i_depth; i++) {
+    i_max_dirs += i_level;
+    i_level *= i_fanout;
+  }
+  i_max = i_max_dirs * (1 + i_files);
+  a_node = calloc(i_max, sizeof(bench_node_t));
+  if (!a_node) return false;
+
+  /* The root. */
+  a_node[0].psz_path = strdup("/");
+  a_node[0].b_dir    = true;
+  a_node[0].i_dirno  = i_dirs = 1;
+  i_nodes = 1;
+
+  for (i = 0; i < i_nodes; i++) {
+    if (!a_node[i].b_dir) continue;
+    a_node[i].i_first_child = i_nodes;
+    if (a_node[i].i_depth < i_depth)
+      for (j = 0; j < i_fanout; j++) add_node(i, true);
+    for (j = 0; j < i_files; j++) add_node(i, false);
+    a_node[i].i_children = i_nodes - a_node[i].i_first_child;
+  }
+  return true;
+}
+
+static void
+free_tree(void)
+{
+  unsigned int i;
+  for (i = 0; i < i_nodes; i++) free(a_node[i].psz_path);
+  free(a_node);
+}
+
+/*========================================================================
+  ISO 9660 image: Rock Ridge in the primary tree, plus Joliet
+ *======================================================================*/
+
+static void
+put_733(uint8_t *p, uint32_t i)
+{
+  p[0] = i;       p[1] = i >> 8;  p[2] = i >> 16; p[3] = i >> 24;
+  p[4] = i >> 24; p[5] = i >> 16; p[6] = i >> 8;  p[7] = i;
+}
+
+/* Primary-tree name: upper case, at most BENCH_MAX_ISONAME
+   characters, ";1" on files. */
+static void
+iso_name(const bench_node_t *p_node, char *psz_out)
+{
+  unsigned int i;
+  for (i = 0; p_node->psz_name[i] && i < BENCH_MAX_ISONAME; i++)
+    psz_out[i] = toupper((unsigned char) p_node->psz_name[i]);
+  psz_out[i] = '\0';
+  if (!p_node->b_dir) strcat(psz_out, ";1");
+}
+
+/* Fill in Rock Ridge system use data for a node; returns its length. */
+static unsigned int
+rr_su(uint8_t *p, const bench_node_t *p_node, bool b_sp, bool b_nm)
+{
+  unsigned int i_len = 0;
+
+  if (b_sp) {
+    const uint8_t sp[RR_SP_LEN] = { 'S', 'P', RR_SP_LEN, 1, 0xbe, 0xef, 0 };
+    memcpy(p, sp, RR_SP_LEN);
+    i_len += RR_SP_LEN;
+  }
+
+  p[i_len] = 'P'; p[i_len+1] = 'X'; p[i_len+2] = RR_PX_LEN; p[i_len+3] = 1;
+  put_733(p + i_len + 4,  p_node->b_dir ? 040555 : 0100444);
+  put_733(p + i_len + 12, p_node->b_dir ? 2 : 1);
+  put_733(p + i_len + 20, 0);
+  put_733(p + i_len + 28, 0);
+  i_len += RR_PX_LEN;
+
+  if (b_nm) {
+    const size_t n = strlen(p_node->psz_name);
+    p[i_len] = 'N'; p[i_len+1] = 'M'; p[i_len+2] = RR_NM_LEN(n);
+    p[i_len+3] = 1; p[i_len+4] = 0;
+    memcpy(p + i_len + 5, p_node->psz_name, n);
+    i_len += RR_NM_LEN(n);
+  }
+  return i_len;
+}
+
+/* Size of a directory extent holding '.', '..' and the children,
+   where record sizes are as given. Records never cross a sector and
+   iso9660_dir_add_entry_su() wants some slack at the end. */
+static uint32_t
+iso_dir_size(const bench_node_t *p_dir, bool b_joliet)
+{
+  unsigned int i, ofs = 0;
+  const unsigned int i_dot =
+    iso9660_dir_calc_record_size(1, b_joliet ? 0 : RR_SP_LEN + RR_PX_LEN);
+
+  ofs = _cdio_ofs_add(ofs, i_dot, ISO_BLOCKSIZE);
+  ofs = _cdio_ofs_add(ofs, i_dot, ISO_BLOCKSIZE);
+  for (i = 0; i < p_dir->i_children; i++) {
+    const bench_node_t *p_child = &a_node[p_dir->i_first_child + i];
+    unsigned int i_rec;
+    if (b_joliet) {
+      i_rec = iso9660_dir_calc_record_size(2 * strlen(p_child->psz_name), 0);
+    } else {
+      char psz_iso[BENCH_MAX_ISONAME + 3];
+      iso_name(p_child, psz_iso);
+      i_rec = iso9660_dir_calc_record_size(strlen(psz_iso),
+                RR_PX_LEN + RR_NM_LEN(strlen(p_child->psz_name)));
+    }
+    ofs = _cdio_ofs_add(ofs, i_rec, ISO_BLOCKSIZE);
+  }
+  return _cdio_ceil2block(ofs + 1, ISO_BLOCKSIZE);
+}
+
+/* Name as written in a path table or Joliet directory record. */
+static unsigned int
+encode_name(const bench_node_t *p_node, bool b_joliet, uint8_t *p_out)
+{
+  unsigned int i, n = strlen(p_node->psz_name);
+  if (0 == p_node->i_depth) {
+    p_out[0] = 0;
+    return 1;
+  }
+  if (!b_joliet) {
+    char psz_iso[BENCH_MAX_ISONAME + 3];
+    iso_name(p_node, psz_iso);
+    memcpy(p_out, psz_iso, strlen(psz_iso));
+    return strlen(psz_iso);
+  }
+  for (i = 0; i < n; i++) {
+    p_out[2*i]   = 0;
+    p_out[2*i+1] = p_node->psz_name[i];
+  }
+  return 2 * n;
+}
+
+static uint32_t
+path_table_size(bool b_joliet)
+{
+  uint8_t name[2 * BENCH_MAX_NAMELEN];
+  uint32_t i, i_size = 0;
+  for (i = 0; i < i_nodes; i++) {
+    if (!a_node[i].b_dir) continue;
+    i_size += 8 + encode_name(&a_node[i], b_joliet, name);
+    if (i_size % 2) i_size++;
+  }
+  return i_size;
+}
+
+static void
+write_path_table(uint8_t *p, bool b_joliet, bool b_msb)
+{
+  unsigned int i, ofs = 0;
+  for (i = 0; i < i_nodes; i++) {
+    const bench_node_t *p_node = &a_node[i];
+    uint32_t i_lsn;
+    uint16_t i_parent;
+    unsigned int n;
+    if (!p_node->b_dir) continue;
+    n = encode_name(p_node, b_joliet, p + ofs + 8);
+    i_lsn    = b_joliet ? p_node->i_joliet_lsn : p_node->i_lsn;
+    i_parent = a_node[p_node->i_parent].i_dirno;
+    p[ofs] = n;
+    p[ofs + 1] = 0;
+    if (b_msb) {
+      i_lsn = uint32_to_be(i_lsn);
+      i_parent = uint16_to_be(i_parent);
+    } else {
+      i_lsn = uint32_to_le(i_lsn);
+      i_parent = uint16_to_le(i_parent);
+    }
+    memcpy(p + ofs + 2, &i_lsn, 4);
+    memcpy(p + ofs + 6, &i_parent, 2);
+    ofs += 8 + n;
+    if (ofs % 2) ofs++;
+  }
+}
+
+/* iso9660_dir_add_entry_su() works on NUL-terminated names, so Joliet
+   records are put together here. */
+static void
+joliet_add_record(uint8_t *p_dir, unsigned int *p_ofs, const uint8_t *name,
+                  unsigned int i_name, uint32_t i_lsn, uint32_t i_size,
+                  bool b_dir, const struct tm *p_tm)
+{
+  const unsigned int i_rec = iso9660_dir_calc_record_size(i_name, 0);
+  iso9660_dir_t *p_rec;
+
+  *p_ofs = _cdio_ofs_add(*p_ofs, i_rec, ISO_BLOCKSIZE) - i_rec;
+  p_rec = (iso9660_dir_t *) (p_dir + *p_ofs);
+  p_rec->length = to_711(i_rec);
+  p_rec->extent = to_733(i_lsn);
+  p_rec->size   = to_733(i_size);
+  iso9660_set_dtime(p_tm, &p_rec->recording_time);
+  p_rec->file_flags = b_dir ? ISO_DIRECTORY : ISO_FILE;
+  p_rec->volume_sequence_number = to_723(1);
+  p_rec->filename.len = to_711(i_name);
+  memcpy(&p_rec->filename.str[1], name, i_name);
+  *p_ofs += i_rec;
+}
+
+static bool
+write_iso(const char *psz_path)
+{
+  const time_t now = time(NULL);
+  struct tm tm;
+  uint32_t i_pt, i_jpt, i_lsn, i_total, i;
+  uint32_t i_ptl, i_ptm, i_jptl, i_jptm;
+  uint8_t *p_image, su[2 * (RR_SP_LEN + RR_PX_LEN) + RR_NM_LEN(256)];
+  FILE *fp;
+
+  gmtime_r(&now, &tm);
+
+  /* Layout: descriptors, path tables, directories, then file data. */
+  i_pt  = path_table_size(false);
+  i_jpt = path_table_size(true);
+  i_lsn = ISO_PVD_SECTOR + 3;
+  i_ptl  = i_lsn; i_lsn += _cdio_len2blocks(i_pt, ISO_BLOCKSIZE);
+  i_ptm  = i_lsn; i_lsn += _cdio_len2blocks(i_pt, ISO_BLOCKSIZE);
+  i_jptl = i_lsn; i_lsn += _cdio_len2blocks(i_jpt, ISO_BLOCKSIZE);
+  i_jptm = i_lsn; i_lsn += _cdio_len2blocks(i_jpt, ISO_BLOCKSIZE);
+  for (i = 0; i < i_nodes; i++) {
+    if (!a_node[i].b_dir) continue;
+    a_node[i].i_size = iso_dir_size(&a_node[i], false);
+    a_node[i].i_lsn  = i_lsn;
+    i_lsn += a_node[i].i_size / ISO_BLOCKSIZE;
+  }
+  for (i = 0; i < i_nodes; i++) {
+    if (!a_node[i].b_dir) continue;
+    a_node[i].i_joliet_size = iso_dir_size(&a_node[i], true);
+    a_node[i].i_joliet_lsn  = i_lsn;
+    i_lsn += a_node[i].i_joliet_size / ISO_BLOCKSIZE;
+  }
+  for (i = 0; i < i_nodes; i++) {
+    if (a_node[i].b_dir) continue;
+    a_node[i].i_size = i_filesize;
+    a_node[i].i_lsn  = i_lsn;
+    i_lsn += i_filesize ? _cdio_len2blocks(i_filesize, ISO_BLOCKSIZE) : 1;
+  }
+  i_total = i_lsn;
+
+  p_image = calloc(i_total, ISO_BLOCKSIZE);
+  if (!p_image) return false;
+#define SECTOR(lsn) (p_image + (size_t) (lsn) * ISO_BLOCKSIZE)
+
+  /* Primary directories, through the library's mastering routines. */
+  for (i = 0; i < i_nodes; i++) {
+    const bench_node_t *p_node = &a_node[i];
+    const bench_node_t *p_parent = &a_node[p_node->i_parent];
+    unsigned int c, i_self, i_up;
+    if (!p_node->b_dir) continue;
+    i_self = rr_su(su, p_node, 0 == i, false);
+    i_up   = rr_su(su + i_self, p_parent, false, false);
+    iso9660_dir_init_new_su(SECTOR(p_node->i_lsn), p_node->i_lsn,
+                            p_node->i_size, su, i_self,
+                            p_parent->i_lsn, p_parent->i_size,
+                            su + i_self, i_up, &now);
+    for (c = 0; c < p_node->i_children; c++) {
+      const bench_node_t *p_child = &a_node[p_node->i_first_child + c];
+      char psz_iso[BENCH_MAX_ISONAME + 3];
+      iso_name(p_child, psz_iso);
+      iso9660_dir_add_entry_su(SECTOR(p_node->i_lsn), psz_iso,
+                               p_child->i_lsn, p_child->i_size,
+                               p_child->b_dir ? ISO_DIRECTORY : ISO_FILE,
+                               su, rr_su(su, p_child, false, true), &now);
+    }
+  }
+
+  /* Joliet directories. */
+  for (i = 0; i < i_nodes; i++) {
+    const bench_node_t *p_node = &a_node[i];
+    const bench_node_t *p_parent = &a_node[p_node->i_parent];
+    uint8_t name[2 * BENCH_MAX_NAMELEN];
+    unsigned int c, ofs = 0;
+    if (!p_node->b_dir) continue;
+    name[0] = 0;
+    joliet_add_record(SECTOR(p_node->i_joliet_lsn), &ofs, name, 1,
+                      p_node->i_joliet_lsn, p_node->i_joliet_size, true, &tm);
+    name[0] = 1;
+    joliet_add_record(SECTOR(p_node->i_joliet_lsn), &ofs, name, 1,
+                      p_parent->i_joliet_lsn, p_parent->i_joliet_size,
+                      true, &tm);
+    for (c = 0; c < p_node->i_children; c++) {
+      const bench_node_t *p_child = &a_node[p_node->i_first_child + c];
+      const unsigned int n = encode_name(p_child, true, name);
+      joliet_add_record(SECTOR(p_node->i_joliet_lsn), &ofs, name, n,
+                        p_child->b_dir ? p_child->i_joliet_lsn
+                                       : p_child->i_lsn,
+                        p_child->b_dir ? p_child->i_joliet_size
+                                       : p_child->i_size,
+                        p_child->b_dir, &tm);
+    }
+  }
+
+  /* Volume descriptors. The Joliet SVD starts out as a copy of the
+     PVD and has its root, path tables and escape sequence replaced. */
+  iso9660_set_pvd(SECTOR(ISO_PVD_SECTOR), "BENCH_FS", "", "", "BENCH_FS",
+                  i_total, SECTOR(a_node[0].i_lsn), i_ptl, i_ptm, i_pt, &now);
+  /* The records carry Rock Ridge, not XA, system use data. */
+  memset(SECTOR(ISO_PVD_SECTOR) + ISO_XA_MARKER_OFFSET, 0,
+         strlen(ISO_XA_MARKER_STRING));
+  {
+    iso9660_svd_t *p_svd = (iso9660_svd_t *) SECTOR(ISO_PVD_SECTOR + 1);
+    memcpy(p_svd, SECTOR(ISO_PVD_SECTOR), ISO_BLOCKSIZE);
+    p_svd->type = to_711(ISO_VD_SUPPLEMENTARY);
+    memcpy(p_svd->escape_sequences, "%/E", 3);
+    p_svd->path_table_size   = to_733(i_jpt);
+    p_svd->type_l_path_table = to_731(i_jptl);
+    p_svd->type_m_path_table = to_732(i_jptm);
+    memcpy(&p_svd->root_directory_record, SECTOR(a_node[0].i_joliet_lsn),
+           sizeof(p_svd->root_directory_record));
+    p_svd->root_directory_record.length =
+      sizeof(p_svd->root_directory_record) + 1;
+  }
+  iso9660_set_evd(SECTOR(ISO_PVD_SECTOR + 2));
+
+  write_path_table(SECTOR(i_ptl),  false, false);
+  write_path_table(SECTOR(i_ptm),  false, true);
+  write_path_table(SECTOR(i_jptl), true,  false);
+  write_path_table(SECTOR(i_jptm), true,  true);
+
+  for (i = 0; i < i_nodes; i++)
+    if (!a_node[i].b_dir && i_filesize)
+      memset(SECTOR(a_node[i].i_lsn), 'a' + (i % 26), i_filesize);
+#undef SECTOR
+
+  fp = fopen(psz_path, "wb");
+  if (!fp) {
+    free(p_image);
+    return false;
+  }
+  fwrite(p_image, ISO_BLOCKSIZE, i_total, fp);
+  fclose(fp);
+  free(p_image);
+  fprintf(stderr, "bench_fs: %s: %u sectors\n", psz_path, i_total);
+  return true;
+}
+
+/*========================================================================
+  UDF image
+ *======================================================================*/
+
+/* CRC-ITU-T, as ECMA-167 7.2.6 uses for descriptor tags. */
+static uint16_t
+udf_crc(const uint8_t *p, unsigned int i_len)
+{
+  uint16_t crc = 0;
+  unsigned int i, b;
+  for (i = 0; i < i_len; i++) {
+    crc ^= (uint16_t) p[i] << 8;
+    for (b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+/* Fill in a descriptor tag once the rest of the descriptor, i_len
+   bytes in all, is in place. */
+static void
+udf_set_tag(udf_tag_t *p_tag, uint16_t i_id, uint32_t i_loc, unsigned int i_len)
+{
+  uint8_t *p = (uint8_t *) p_tag;
+  uint8_t cksum = 0;
+  unsigned int i;
+
+  p_tag->id           = uint16_to_le(i_id);
+  p_tag->desc_version = uint16_to_le(2);
+  p_tag->i_serial     = uint16_to_le(1);
+  p_tag->loc          = uint32_to_le(i_loc);
+  p_tag->desc_CRC_len = uint16_to_le(i_len - sizeof(udf_tag_t));
+  p_tag->desc_CRC     = uint16_to_le(udf_crc(p + sizeof(udf_tag_t),
+                                             i_len - sizeof(udf_tag_t)));
+  p_tag->cksum = 0;
+  for (i = 0; i < sizeof(udf_tag_t); i++)
+    if (4 != i) cksum += p[i];
+  p_tag->cksum = cksum;
+}
+
+/* CS0 d-string of the given field size. */
+static void
+udf_set_dstring(char *p, unsigned int i_size, const char *psz)
+{
+  const unsigned int n = strlen(psz);
+  memset(p, 0, i_size);
+  p[0] = 8;
+  memcpy(p + 1, psz, n);
+  p[i_size - 1] = n + 1;
+}
+
+static void
+udf_set_regid(udf_regid_t *p_regid, const char *psz)
+{
+  memset(p_regid, 0, sizeof(*p_regid));
+  memcpy(p_regid->id, psz, strlen(psz));
+}
+
+static unsigned int
+udf_fid_len(unsigned int i_name)
+{
+  const unsigned int i_file_id = i_name ? i_name + 1 : 0;
+  return 4 * ((sizeof(udf_fileid_desc_t) + i_file_id + 3) / 4);
+}
+
+static bool
+write_udf(const char *psz_path)
+{
+  uint32_t i, b = 1, i_total, i_part_len;
+  uint8_t *p_image;
+  FILE *fp;
+
+  /* Layout, partition-relative: the FSD at block 0, then each node's
+     file entry followed by its data. */
+  for (i = 0; i < i_nodes; i++) {
+    bench_node_t *p_node = &a_node[i];
+    a_node[i].i_udf_fe = b++;
+    if (p_node->b_dir) {
+      unsigned int c;
+      p_node->i_udf_size = udf_fid_len(0);
+      for (c = 0; c < p_node->i_children; c++)
+        p_node->i_udf_size +=
+          udf_fid_len(strlen(a_node[p_node->i_first_child + c].psz_name));
+    } else
+      p_node->i_udf_size = i_filesize;
+    p_node->i_udf_data = b;
+    b += p_node->i_udf_size ? _cdio_len2blocks(p_node->i_udf_size,
+                                               UDF_BLOCKSIZE) : 1;
+  }
+  i_part_len = b;
+  i_total = UDF_PART_START + i_part_len + 1;
+
+  p_image = calloc(i_total, UDF_BLOCKSIZE);
+  if (!p_image) return false;
+#define SECTOR(lsn) (p_image + (size_t) (lsn) * UDF_BLOCKSIZE)
+#define PBLOCK(lba) SECTOR(UDF_PART_START + (lba))
+
+  /* Volume recognition sequence. */
+  {
+    const char *vsd[] = { "BEA01", "NSR02", "TEA01" };
+    for (i = 0; i < 3; i++) {
+      uint8_t *p = SECTOR(16 + i);
+      memcpy(p + 1, vsd[i], VSD_STD_ID_SIZE);
+      p[6] = 1;
+    }
+  }
+
+  /* Anchors, at 256 and at the last sector. */
+  for (i = 0; i < 2; i++) {
+    const uint32_t i_lsn = i ? i_total - 1 : UDF_AVDP_LSN;
+    anchor_vol_desc_ptr_t *p_avdp = (anchor_vol_desc_ptr_t *) SECTOR(i_lsn);
+    p_avdp->main_vol_desc_seq_ext.len =
+      uint32_to_le(UDF_MVDS_LEN * UDF_BLOCKSIZE);
+    p_avdp->main_vol_desc_seq_ext.loc = uint32_to_le(UDF_MVDS_LSN);
+    udf_set_tag(&p_avdp->tag, TAGID_ANCHOR, i_lsn, 512);
+  }
+
+  /* Main volume descriptor sequence. */
+  {
+    udf_pvd_t *p_pvd = (udf_pvd_t *) SECTOR(UDF_MVDS_LSN);
+    partition_desc_t *p_pd = (partition_desc_t *) SECTOR(UDF_MVDS_LSN + 1);
+    logical_vol_desc_t *p_lvd = (logical_vol_desc_t *) SECTOR(UDF_MVDS_LSN + 2);
+    uint8_t *p_map = p_lvd->partition_maps;
+
+    p_pvd->vol_desc_seq_num = uint32_to_le(1);
+    udf_set_dstring(p_pvd->vol_ident, UDF_VOLID_SIZE, "BENCH_FS");
+    p_pvd->vol_seq_num         = uint16_to_le(1);
+    p_pvd->max_vol_seqnum      = uint16_to_le(1);
+    p_pvd->interchange_lvl     = uint16_to_le(2);
+    p_pvd->max_interchange_lvl = uint16_to_le(2);
+    p_pvd->charset_list        = uint32_to_le(1);
+    p_pvd->max_charset_list    = uint32_to_le(1);
+    udf_set_dstring(p_pvd->volset_id, UDF_VOLSET_ID_SIZE, "BENCH_FS");
+    udf_set_regid(&p_pvd->imp_ident, "*libcdio");
+    udf_set_tag(&p_pvd->tag, TAGID_PRI_VOL, UDF_MVDS_LSN, 512);
+
+    p_pd->vol_desc_seq_num = uint32_to_le(2);
+    p_pd->flags       = uint16_to_le(PD_PARTITION_FLAGS_ALLOC);
+    p_pd->number      = uint16_to_le(0);
+    udf_set_regid(&p_pd->contents, PD_PARTITION_CONTENTS_NSR02);
+    p_pd->access_type = uint32_to_le(PD_ACCESS_TYPE_READ_ONLY);
+    p_pd->start_loc   = uint32_to_le(UDF_PART_START);
+    p_pd->part_len    = uint32_to_le(i_part_len);
+    udf_set_tag(&p_pd->tag, TAGID_PARTITION, UDF_MVDS_LSN + 1, 512);
+
+    p_lvd->seq_num = uint32_to_le(3);
+    udf_set_dstring(p_lvd->logvol_id, 128, "BENCH_FS");
+    p_lvd->logical_blocksize = uint32_to_le(UDF_BLOCKSIZE);
+    udf_set_regid(&p_lvd->domain_id, "*OSTA UDF Compliant");
+    p_lvd->lvd_use.fsd_loc.len = uint32_to_le(UDF_BLOCKSIZE);
+    p_lvd->lvd_use.fsd_loc.loc.lba = uint32_to_le(0);
+    p_lvd->maptable_len     = uint32_to_le(6);
+    p_lvd->i_partition_maps = uint32_to_le(1);
+    p_map[0] = 1;                       /* type 1 map */
+    p_map[1] = 6;                       /* its length */
+    p_map[2] = 1; p_map[3] = 0;         /* volume sequence number */
+    p_map[4] = 0; p_map[5] = 0;         /* partition number */
+    udf_set_tag(&p_lvd->tag, TAGID_LOGVOL, UDF_MVDS_LSN + 2,
+                sizeof(logical_vol_desc_t) + 6);
+
+    udf_set_tag((udf_tag_t *) SECTOR(UDF_MVDS_LSN + 3), TAGID_TERM,
+                UDF_MVDS_LSN + 3, 512);
+  }
+
+  /* File set descriptor. */
+  {
+    udf_fsd_t *p_fsd = (udf_fsd_t *) PBLOCK(0);
+    p_fsd->interchange_lvl    = uint16_to_le(3);
+    p_fsd->maxInterchange_lvl = uint16_to_le(3);
+    p_fsd->charset_list       = uint32_to_le(1);
+    p_fsd->max_charset_list   = uint32_to_le(1);
+    udf_set_dstring(p_fsd->logical_vol_id, 128, "BENCH_FS");
+    udf_set_dstring(p_fsd->fileSet_id, 32, "BENCH_FS");
+    p_fsd->root_icb.len = uint32_to_le(UDF_BLOCKSIZE);
+    p_fsd->root_icb.loc.lba = uint32_to_le(a_node[0].i_udf_fe);
+    udf_set_regid(&p_fsd->domain_id, "*OSTA UDF Compliant");
+    udf_set_tag(&p_fsd->tag, TAGID_FSD, 0, 512);
+  }
+
+  /* File entries, directory contents and file data. */
+  for (i = 0; i < i_nodes; i++) {
+    const bench_node_t *p_node = &a_node[i];
+    udf_file_entry_t *p_fe = (udf_file_entry_t *) PBLOCK(p_node->i_udf_fe);
+    udf_short_ad_t *p_ad = (udf_short_ad_t *) p_fe->u.alloc_descs;
+
+    p_fe->icb_tag.strat_type      = uint16_to_le(ICBTAG_STRATEGY_TYPE_4);
+    p_fe->icb_tag.max_num_entries = uint16_to_le(1);
+    p_fe->icb_tag.file_type = p_node->b_dir
+      ? ICBTAG_FILE_TYPE_DIRECTORY : ICBTAG_FILE_TYPE_REGULAR;
+    p_fe->icb_tag.flags = uint16_to_le(ICBTAG_FLAG_AD_SHORT);
+    p_fe->permissions = uint32_to_le(FE_PERM_U_READ | FE_PERM_G_READ
+                                     | FE_PERM_O_READ
+                                     | (p_node->b_dir
+                                        ? FE_PERM_U_EXEC | FE_PERM_G_EXEC
+                                          | FE_PERM_O_EXEC : 0));
+    p_fe->link_count = uint16_to_le(1);
+    p_fe->info_len = uint64_to_le(p_node->i_udf_size);
+    p_fe->logblks_recorded =
+      uint64_to_le(_cdio_len2blocks(p_node->i_udf_size, UDF_BLOCKSIZE));
+    p_fe->unique_ID = uint64_to_le(i + 16);
+    p_fe->i_extended_attr = 0;
+    p_fe->i_alloc_descs = uint32_to_le(sizeof(udf_short_ad_t));
+    p_ad->len = uint32_to_le(p_node->i_udf_size);
+    p_ad->pos = uint32_to_le(p_node->i_udf_data);
+    udf_set_tag(&p_fe->tag, TAGID_FILE_ENTRY, p_node->i_udf_fe,
+                UDF_FENTRY_SIZE + sizeof(udf_short_ad_t));
+
+    if (p_node->b_dir) {
+      uint8_t *p_dir = PBLOCK(p_node->i_udf_data);
+      unsigned int c, ofs = 0;
+      for (c = 0; c <= p_node->i_children; c++) {
+        /* c == 0 is the parent entry. */
+        const bench_node_t *p_target = c
+          ? &a_node[p_node->i_first_child + c - 1]
+          : &a_node[p_node->i_parent];
+        const unsigned int n = c ? strlen(p_target->psz_name) : 0;
+        udf_fileid_desc_t *p_fid = (udf_fileid_desc_t *) (p_dir + ofs);
+
+        p_fid->file_version_num = uint16_to_le(1);
+        p_fid->file_characteristics = c
+          ? (p_target->b_dir ? UDF_FILE_DIRECTORY : 0)
+          : UDF_FILE_DIRECTORY | UDF_FILE_PARENT;
+        p_fid->i_file_id = n ? n + 1 : 0;
+        p_fid->icb.len = uint32_to_le(UDF_BLOCKSIZE);
+        p_fid->icb.loc.lba = uint32_to_le(p_target->i_udf_fe);
+        p_fid->u.i_imp_use = 0;
+        if (n) {
+          p_fid->u.file_id.data[0] = 8;
+          memcpy(p_fid->u.file_id.data + 1, p_target->psz_name, n);
+        }
+        udf_set_tag(&p_fid->tag, TAGID_FID,
+                    p_node->i_udf_data + ofs / UDF_BLOCKSIZE, udf_fid_len(n));
+        ofs += udf_fid_len(n);
+      }
+    } else if (i_filesize)
+      memset(PBLOCK(p_node->i_udf_data), 'a' + (i % 26), i_filesize);
+  }
+#undef PBLOCK
+#undef SECTOR
+
+  fp = fopen(psz_path, "wb");
+  if (!fp) {
+    free(p_image);
+    return false;
+  }
+  fwrite(p_image, UDF_BLOCKSIZE, i_total, fp);
+  fclose(fp);
+  free(p_image);
+  fprintf(stderr, "bench_fs: %s: %u sectors\n", psz_path, i_total);
+  return true;
+}
+
+/*========================================================================
+  Benchmarks
+ *======================================================================*/
+
+#define TIMED_CALL(p_stat, call, ok_expr)                               \
+  {                                                                     \
+    const unsigned long i_allocs0 = i_alloc_count;                      \
+    const double t0 = now_usec();                                       \
+    call;                                                               \
+    {                                                                   \
+      const double t1 = now_usec();                                     \
+      stat_add(p_stat, t1 - t0, i_alloc_count - i_allocs0, (ok_expr));  \
+    }                                                                   \
+  }
+
+static unsigned int
+bench_iso(const char *psz_image, const char *psz_fs,
+          iso_extension_mask_t mask)
+{
+  iso9660_t *p_iso = iso9660_open_ext(psz_image, mask);
+  const unsigned int i_files_total = i_nodes - i_dirs;
+  const unsigned int i_step = (i_files_total > i_samples && i_samples)
+    ? i_files_total / i_samples : 1;
+  unsigned int i, r, i_errors = 0;
+  bench_stat_t stat;
+
+  if (!p_iso) {
+    fprintf(stderr, "bench_fs: can't open %s as ISO 9660\n", psz_image);
+    return 1;
+  }
+
+  stat_init(&stat, psz_fs, "iso9660_ifs_readdir", i_dirs * i_repeat);
+  for (r = 0; r < i_repeat; r++)
+    for (i = 0; i < i_nodes; i++) {
+      CdioList_t *p_list;
+      if (!a_node[i].b_dir) continue;
+      TIMED_CALL(&stat, p_list = iso9660_ifs_readdir(p_iso,
+                                                     a_node[i].psz_path),
+                 p_list && _cdio_list_length(p_list)
+                 == a_node[i].i_children + 2);
+      if (p_list) _cdio_list_free(p_list, true);
+    }
+  i_errors += stat.i_errors;
+  stat_print(&stat);
+
+  stat_init(&stat, psz_fs, "iso9660_ifs_stat", (i_nodes - 1) * i_repeat);
+  for (r = 0; r < i_repeat; r++)
+    for (i = 1; i < i_nodes; i++) {
+      iso9660_stat_t *p_stat;
+      TIMED_CALL(&stat, p_stat = iso9660_ifs_stat(p_iso, a_node[i].psz_path),
+                 p_stat && p_stat->lsn == (a_node[i].b_dir && mask
+                                           ? a_node[i].i_joliet_lsn
+                                           : a_node[i].i_lsn));
+      free(p_stat);
+    }
+  i_errors += stat.i_errors;
+  stat_print(&stat);
+
+  stat_init(&stat, psz_fs, "iso9660_ifs_find_lsn",
+            (i_files_total / i_step + 1) * i_repeat);
+  for (r = 0; r < i_repeat; r++)
+    for (i = 1; i < i_nodes; i++) {
+      iso9660_stat_t *p_stat;
+      if (a_node[i].b_dir || (i % i_step)) continue;
+      TIMED_CALL(&stat, p_stat = iso9660_ifs_find_lsn(p_iso, a_node[i].i_lsn),
+                 p_stat && p_stat->lsn == a_node[i].i_lsn);
+      free(p_stat);
+    }
+  i_errors += stat.i_errors;
+  stat_print(&stat);
+
+  iso9660_close(p_iso);
+  return i_errors;
+}
+
+static unsigned int
+bench_udf(const char *psz_image)
+{
+  udf_t *p_udf = udf_open(psz_image);
+  udf_dirent_t *p_root;
+  unsigned int i, r, i_errors = 0;
+  bench_stat_t stat;
+
+  if (!p_udf) {
+    fprintf(stderr, "bench_fs: can't open %s as UDF\n", psz_image);
+    return 1;
+  }
+  p_root = udf_get_root(p_udf, true, 0);
+  if (!p_root) {
+    fprintf(stderr, "bench_fs: can't find the UDF root in %s\n", psz_image);
+    udf_close(p_udf);
+    return 1;
+  }
+
+  /* Every entry of every directory, the parent entry included, and
+     the final call that reports the end. */
+  stat_init(&stat, "udf", "udf_readdir", (i_nodes + 2 * i_dirs) * i_repeat);
+  for (r = 0; r < i_repeat; r++)
+    for (i = 0; i < i_nodes; i++) {
+      udf_dirent_t *p_dir, *p_entry;
+      unsigned int i_seen = 0;
+      if (!a_node[i].b_dir) continue;
+      if (0 == i)
+        p_dir = udf_fopen(p_root, "/");
+      else {
+        udf_dirent_t *p_found = udf_fopen(p_root, a_node[i].psz_path);
+        p_dir = p_found ? udf_opendir(p_found) : NULL;
+        udf_dirent_free(p_found);
+      }
+      if (!p_dir) {
+        stat.i_errors++;
+        continue;
+      }
+      do {
+        TIMED_CALL(&stat, p_entry = udf_readdir(p_dir), true);
+        if (p_entry) i_seen++;
+      } while (p_entry);
+      if (i_seen != a_node[i].i_children + 1)
+        stat.i_errors++;
+    }
+  i_errors += stat.i_errors;
+  stat_print(&stat);
+
+  stat_init(&stat, "udf", "udf_fopen", (i_nodes - 1) * i_repeat);
+  for (r = 0; r < i_repeat; r++)
+    for (i = 1; i < i_nodes; i++) {
+      udf_dirent_t *p_file;
+      TIMED_CALL(&stat, p_file = udf_fopen(p_root, a_node[i].psz_path),
+                 NULL != p_file);
+      udf_dirent_free(p_file);
+    }
+  i_errors += stat.i_errors;
+  stat_print(&stat);
+
+  udf_dirent_free(p_root);
+  udf_close(p_udf);
+  return i_errors;
+}
+
+static void
+usage(const char *psz_prog)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --fanout N    subdirectories per directory (default %u)\n"
+          "  --depth N     directory levels below the root (default %u)\n"
+          "  --files N     files per directory (default %u)\n"
+          "  --namelen N   name length, 6 to %u (default %u)\n"
+          "  --filesize N  bytes per file (default %u)\n"
+          "  --repeat N    passes over the tree (default %u)\n"
+          "  --samples N   files looked up with iso9660_ifs_find_lsn "
+          "(default %u)\n"
+          "  --dir DIR     scratch directory for images (default .)\n",
+          psz_prog, BENCH_DEFAULT_FANOUT, BENCH_DEFAULT_DEPTH,
+          BENCH_DEFAULT_FILES, BENCH_MAX_NAMELEN, BENCH_DEFAULT_NAMELEN,
+          BENCH_DEFAULT_FILESIZE, BENCH_DEFAULT_REPEAT,
+          BENCH_DEFAULT_SAMPLES);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  const char *psz_dir = ".";
+  char psz_iso[1024], psz_udf[1024];
+  unsigned int i_errors = 0;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    unsigned int *p_opt = NULL;
+    if (0 == strcmp(argv[i], "--fanout"))        p_opt = &i_fanout;
+    else if (0 == strcmp(argv[i], "--depth"))    p_opt = &i_depth;
+    else if (0 == strcmp(argv[i], "--files"))    p_opt = &i_files;
+    else if (0 == strcmp(argv[i], "--namelen"))  p_opt = &i_namelen;
+    else if (0 == strcmp(argv[i], "--filesize")) p_opt = &i_filesize;
+    else if (0 == strcmp(argv[i], "--repeat"))   p_opt = &i_repeat;
+    else if (0 == strcmp(argv[i], "--samples"))  p_opt = &i_samples;
+    else if (0 == strcmp(argv[i], "--dir") && i + 1 < argc) {
+      psz_dir = argv[++i];
+      continue;
+    }
+    if (!p_opt || i + 1 >= argc) {
+      usage(argv[0]);
+      return 1;
+    }
+    *p_opt = atoi(argv[++i]);
+  }
+  if (i_namelen < 6 || i_namelen > BENCH_MAX_NAMELEN || 0 == i_repeat) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  cdio_loglevel_default = CDIO_LOG_WARN;
+
+  if (!build_tree()) return 2;
+  fprintf(stderr, "bench_fs: %u directories, %u files\n",
+          i_dirs, i_nodes - i_dirs);
+
+  snprintf(psz_iso, sizeof(psz_iso), "%s/bench-fs.iso", psz_dir);
+  snprintf(psz_udf, sizeof(psz_udf), "%s/bench-fs.udf", psz_dir);
+  if (!write_iso(psz_iso) || !write_udf(psz_udf)) {
+    fprintf(stderr, "bench_fs: can't write images in %s\n", psz_dir);
+    free_tree();
+    return 2;
+  }
+
+  printf("fs,operation,calls,errors,usec_avg,usec_p50,usec_p99,usec_max,"
+         "allocs_per_op,bytes_read_per_op,histogram\n");
+  i_errors += bench_iso(psz_iso, "iso9660-rr", ISO_EXTENSION_NONE);
+  i_errors += bench_iso(psz_iso, "iso9660-joliet", ISO_EXTENSION_ALL);
+  i_errors += bench_udf(psz_udf);
+
+  free_tree();
+  if (i_errors)
+    fprintf(stderr, "bench_fs: %u calls failed\n", i_errors);
+  return i_errors ? 3 : 0;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
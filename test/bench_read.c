@@ -0,0 +1,507 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Microbenchmark for the image-driver read paths.
+
+   Synthetic BIN/CUE, cdrdao TOC, NRG and plain ISO 9660 images are
+   written to a scratch directory, and then each of the read routines
+   (audio, mode 1, mode 2 and plain data) is timed for several batch
+   sizes.  Results go to stdout as comma-separated values, one line per
+   (driver, mode, operation, batch) combination, so that two runs can
+   be compared mechanically.
+
+   This is not run as part of "make check"; use "make bench".
+*/
+#include "portable.h"
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#include <time.h>
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/iso9660.h>
+#include <cdio/sector.h>
+#include <cdio/bytesex.h>
+
+#define BENCH_DEFAULT_SECTORS  4096
+#define BENCH_DEFAULT_REPEAT   3
+#define BENCH_MAX_BATCHES      16
+
+typedef enum {
+  BENCH_AUDIO,
+  BENCH_MODE1,
+  BENCH_MODE2,
+} bench_mode_t;
+
+typedef enum {
+  OP_AUDIO,       /* cdio_read_audio_sectors */
+  OP_MODE1,       /* cdio_read_mode1_sectors, 2048-byte blocks */
+  OP_MODE2,       /* cdio_read_mode2_sectors, 2336-byte blocks */
+  OP_DATA,        /* cdio_read_data_sectors, 2048-byte blocks */
+  OP_ISO,         /* iso9660_iso_seek_read */
+} bench_op_t;
+
+static const char *mode_name[] = { "audio", "mode1", "mode2" };
+static const char *op_name[]   = {
+  "read_audio", "read_mode1", "read_mode2", "read_data", "iso_seek_read"
+};
+
+static unsigned int i_sectors = BENCH_DEFAULT_SECTORS;
+static unsigned int i_repeat  = BENCH_DEFAULT_REPEAT;
+static unsigned int ai_batch[BENCH_MAX_BATCHES] = { 1, 16, 64, 256 };
+static unsigned int i_batches = 4;
+
+/* Monotonic time in microseconds. */
+static double
+now_usec(void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec * 1e6 + (double) ts.tv_nsec / 1e3;
+#elif defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec * 1e6 + (double) tv.tv_usec;
+#else
+  return (double) clock() * 1e6 / CLOCKS_PER_SEC;
+#endif
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+  const double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* Fill in a raw 2352-byte sector for lsn in the given mode. The
+   payload is a simple function of lsn so reads are never all-zero. */
+static void
+make_raw_sector(uint8_t *p_buf, lsn_t lsn, bench_mode_t mode)
+{
+  unsigned int i;
+  msf_t msf;
+
+  for (i = 0; i < CDIO_CD_FRAMESIZE_RAW; i++)
+    p_buf[i] = (uint8_t) (lsn + i);
+
+  if (BENCH_AUDIO == mode) return;
+
+  cdio_lsn_to_msf(lsn, &msf);
+  memcpy(p_buf, CDIO_SECTOR_SYNC_HEADER, CDIO_CD_SYNC_SIZE);
+  p_buf[12] = msf.m;
+  p_buf[13] = msf.s;
+  p_buf[14] = msf.f;
+  p_buf[15] = (BENCH_MODE1 == mode) ? 1 : 2;
+  if (BENCH_MODE2 == mode) {
+    /* Form 1 data subheader, given twice. */
+    static const uint8_t subheader[CDIO_CD_SUBHEADER_SIZE] =
+      { 0, 0, 0x08, 0, 0, 0, 0x08, 0 };
+    memcpy(p_buf + 16, subheader, sizeof(subheader));
+  }
+}
+
+static FILE *
+open_out(const char *psz_dir, const char *psz_name, char *psz_path,
+         size_t i_path)
+{
+  FILE *fp;
+  snprintf(psz_path, i_path, "%s/%s", psz_dir, psz_name);
+  fp = fopen(psz_path, "wb");
+  if (!fp)
+    fprintf(stderr, "bench_read: can't create %s\n", psz_path);
+  return fp;
+}
+
+/* Write a single-track BIN/CUE pair and a cdrdao TOC file that refers
+   to the same BIN file. */
+static bool
+make_bincue_and_toc(const char *psz_dir, bench_mode_t mode)
+{
+  static const char *cue_mode[] = { "AUDIO", "MODE1/2352", "MODE2/2352" };
+  static const char *toc_disc[] = { "CD_DA", "CD_ROM", "CD_ROM_XA" };
+  static const char *toc_mode[] = { "AUDIO", "MODE1_RAW", "MODE2_RAW" };
+  char psz_name[40], psz_bin[1024], psz_path[1024];
+  uint8_t buf[CDIO_CD_FRAMESIZE_RAW];
+  msf_t msf;
+  lsn_t lsn;
+  FILE *fp;
+
+  snprintf(psz_name, sizeof(psz_name), "bench-%s.bin", mode_name[mode]);
+  if (!(fp = open_out(psz_dir, psz_name, psz_bin, sizeof(psz_bin))))
+    return false;
+  for (lsn = 0; lsn < (lsn_t) i_sectors; lsn++) {
+    make_raw_sector(buf, lsn, mode);
+    fwrite(buf, sizeof(buf), 1, fp);
+  }
+  fclose(fp);
+
+  snprintf(psz_name, sizeof(psz_name), "bench-%s.cue", mode_name[mode]);
+  if (!(fp = open_out(psz_dir, psz_name, psz_path, sizeof(psz_path))))
+    return false;
+  /* The CUE FILE is relative to the CUE file; the cdrdao one is not. */
+  fprintf(fp, "FILE \"bench-%s.bin\" BINARY\n", mode_name[mode]);
+  fprintf(fp, "  TRACK 01 %s\n", cue_mode[mode]);
+  fprintf(fp, "    INDEX 01 00:00:00\n");
+  fclose(fp);
+
+  snprintf(psz_name, sizeof(psz_name), "bench-%s.toc", mode_name[mode]);
+  if (!(fp = open_out(psz_dir, psz_name, psz_path, sizeof(psz_path))))
+    return false;
+  cdio_lba_to_msf(i_sectors, &msf);
+  fprintf(fp, "%s\n\nTRACK %s\n", toc_disc[mode], toc_mode[mode]);
+  fprintf(fp, "FILE \"%s\" 00:00:00 %02x:%02x:%02x\n", psz_bin,
+          msf.m, msf.s, msf.f);
+  fclose(fp);
+  return true;
+}
+
+static void
+put_be32(uint8_t *p, uint32_t i)
+{
+  p[0] = i >> 24; p[1] = i >> 16; p[2] = i >> 8; p[3] = i;
+}
+
+/* Write a single-track Nero 5.0 (ETNF) image. */
+static bool
+make_nrg(const char *psz_dir, bench_mode_t mode)
+{
+  static const uint32_t etnf_type[] = { 7, 0, 3 };
+  static const unsigned int blocksize[] = {
+    CDIO_CD_FRAMESIZE_RAW, CDIO_CD_FRAMESIZE, M2RAW_SECTOR_SIZE
+  };
+  static const unsigned int skip[] = {
+    0, CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+    CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE
+  };
+  char psz_name[40], psz_path[1024];
+  uint8_t buf[CDIO_CD_FRAMESIZE_RAW];
+  uint8_t footer[8 + 20 + 8 + 12];
+  const uint32_t i_data = i_sectors * blocksize[mode];
+  lsn_t lsn;
+  FILE *fp;
+
+  snprintf(psz_name, sizeof(psz_name), "bench-%s.nrg", mode_name[mode]);
+  if (!(fp = open_out(psz_dir, psz_name, psz_path, sizeof(psz_path))))
+    return false;
+  for (lsn = 0; lsn < (lsn_t) i_sectors; lsn++) {
+    make_raw_sector(buf, lsn, mode);
+    fwrite(buf + skip[mode], blocksize[mode], 1, fp);
+  }
+
+  memset(footer, 0, sizeof(footer));
+  memcpy(footer, "ETNF", 4);
+  put_be32(footer + 4, 20);
+  put_be32(footer + 8, 0);                 /* start byte offset */
+  put_be32(footer + 12, i_data);           /* length in bytes */
+  put_be32(footer + 16, etnf_type[mode]);
+  put_be32(footer + 20, 0);                /* start lsn */
+  memcpy(footer + 28, "END!", 4);
+  memcpy(footer + 36 + 4, "NERO", 4);
+  put_be32(footer + 36 + 8, i_data);       /* chunk start */
+  fwrite(footer, sizeof(footer), 1, fp);
+  fclose(fp);
+  return true;
+}
+
+/* Write a plain ISO 9660 image: a primary volume descriptor, a
+   terminator, an empty root directory and i_sectors of filler. */
+static bool
+make_iso(const char *psz_dir)
+{
+  char psz_path[1024];
+  uint8_t buf[ISO_BLOCKSIZE];
+  uint8_t root[ISO_BLOCKSIZE];
+  uint8_t pt[ISO_BLOCKSIZE];
+  uint8_t pt_m[ISO_BLOCKSIZE];
+  const time_t now = time(NULL);
+  const uint32_t root_lsn = 20, iso_size = 20 + i_sectors;
+  lsn_t lsn;
+  FILE *fp;
+
+  if (!(fp = open_out(psz_dir, "bench.iso", psz_path, sizeof(psz_path))))
+    return false;
+
+  iso9660_dir_init_new(root, root_lsn, ISO_BLOCKSIZE, root_lsn,
+                       ISO_BLOCKSIZE, &now);
+  iso9660_pathtable_init(pt);
+  iso9660_pathtable_l_add_entry(pt, "", root_lsn, 1);
+  iso9660_pathtable_init(pt_m);
+  iso9660_pathtable_m_add_entry(pt_m, "", root_lsn, 1);
+
+  for (lsn = 0; lsn < (lsn_t) iso_size; lsn++) {
+    if (ISO_PVD_SECTOR == lsn)
+      iso9660_set_pvd(buf, "BENCH", "", "", "BENCH_READ", iso_size,
+                      root, 18, 19, iso9660_pathtable_get_size(pt), &now);
+    else if (ISO_EVD_SECTOR == lsn)
+      iso9660_set_evd(buf);
+    else if (18 == lsn)
+      memcpy(buf, pt, sizeof(buf));
+    else if (19 == lsn)
+      memcpy(buf, pt_m, sizeof(buf));
+    else if ((lsn_t) root_lsn == lsn)
+      memcpy(buf, root, sizeof(buf));
+    else {
+      uint8_t raw[CDIO_CD_FRAMESIZE_RAW];
+      make_raw_sector(raw, lsn, BENCH_AUDIO);
+      memcpy(buf, raw, sizeof(buf));
+    }
+    fwrite(buf, sizeof(buf), 1, fp);
+  }
+  fclose(fp);
+  return true;
+}
+
+/* Time one operation over the whole image at the given batch size
+   and print a line of results. Returns the number of failed calls. */
+static unsigned int
+bench_one(const char *psz_driver, bench_mode_t mode, bench_op_t op,
+          CdIo_t *p_cdio, iso9660_t *p_iso, lsn_t i_first,
+          unsigned int i_batch)
+{
+  const unsigned int i_calls_per_pass = i_sectors / i_batch;
+  const unsigned int i_calls = i_calls_per_pass * i_repeat;
+  unsigned int i_blocksize;
+  double *a_usec, t_total = 0;
+  unsigned int i, r, i_errors = 0, n = 0;
+  uint8_t *p_buf;
+
+  switch (op) {
+  case OP_AUDIO: i_blocksize = CDIO_CD_FRAMESIZE_RAW; break;
+  case OP_MODE2: i_blocksize = M2RAW_SECTOR_SIZE; break;
+  default:       i_blocksize = ISO_BLOCKSIZE; break;
+  }
+
+  if (0 == i_calls) return 0;
+  p_buf  = calloc(i_batch, i_blocksize);
+  a_usec = calloc(i_calls, sizeof(double));
+  if (!p_buf || !a_usec) {
+    free(p_buf);
+    free(a_usec);
+    return 1;
+  }
+
+  for (r = 0; r < i_repeat; r++) {
+    for (i = 0; i < i_calls_per_pass; i++) {
+      const lsn_t lsn = i_first + i * i_batch;
+      bool b_ok;
+      double t0 = now_usec(), t1;
+      switch (op) {
+      case OP_AUDIO:
+        b_ok = DRIVER_OP_SUCCESS ==
+          cdio_read_audio_sectors(p_cdio, p_buf, lsn, i_batch);
+        break;
+      case OP_MODE1:
+        b_ok = DRIVER_OP_SUCCESS ==
+          cdio_read_mode1_sectors(p_cdio, p_buf, lsn, false, i_batch);
+        break;
+      case OP_MODE2:
+        b_ok = DRIVER_OP_SUCCESS ==
+          cdio_read_mode2_sectors(p_cdio, p_buf, lsn, true, i_batch);
+        break;
+      case OP_DATA:
+        b_ok = DRIVER_OP_SUCCESS ==
+          cdio_read_data_sectors(p_cdio, p_buf, lsn, ISO_BLOCKSIZE, i_batch);
+        break;
+      case OP_ISO:
+      default:
+        b_ok = (long int) i_batch * ISO_BLOCKSIZE ==
+          iso9660_iso_seek_read(p_iso, p_buf, lsn, i_batch);
+        break;
+      }
+      t1 = now_usec();
+      if (!b_ok) i_errors++;
+      a_usec[n++] = t1 - t0;
+      t_total += t1 - t0;
+    }
+  }
+
+  qsort(a_usec, n, sizeof(double), cmp_double);
+  {
+    const double secs = t_total / 1e6;
+    const double mib  = (double) n * i_batch * i_blocksize / (1024.0 * 1024.0);
+    printf("%s,%s,%s,%u,%u,%u,%u,%.6f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+           psz_driver, mode_name[mode], op_name[op], i_batch,
+           n * i_batch, n, i_errors, secs,
+           secs > 0 ? mib / secs : 0.0,
+           t_total / n, a_usec[n / 2], a_usec[(n * 99) / 100],
+           a_usec[n - 1]);
+  }
+
+  free(p_buf);
+  free(a_usec);
+  return i_errors;
+}
+
+/* Run every applicable operation against one image. */
+static unsigned int
+bench_image(const char *psz_path, driver_id_t driver_id,
+            const char *psz_driver, bench_mode_t mode)
+{
+  CdIo_t *p_cdio = cdio_open(psz_path, driver_id);
+  unsigned int b, i_errors = 0;
+  lsn_t i_first;
+
+  if (!p_cdio) {
+    fprintf(stderr, "bench_read: %s can't open %s\n", psz_driver, psz_path);
+    return 1;
+  }
+  i_first = cdio_get_track_lsn(p_cdio, cdio_get_first_track_num(p_cdio));
+
+  for (b = 0; b < i_batches; b++) {
+    switch (mode) {
+    case BENCH_AUDIO:
+      i_errors += bench_one(psz_driver, mode, OP_AUDIO, p_cdio, NULL,
+                            i_first, ai_batch[b]);
+      break;
+    case BENCH_MODE1:
+      i_errors += bench_one(psz_driver, mode, OP_MODE1, p_cdio, NULL,
+                            i_first, ai_batch[b]);
+      i_errors += bench_one(psz_driver, mode, OP_DATA, p_cdio, NULL,
+                            i_first, ai_batch[b]);
+      break;
+    case BENCH_MODE2:
+      i_errors += bench_one(psz_driver, mode, OP_MODE2, p_cdio, NULL,
+                            i_first, ai_batch[b]);
+      i_errors += bench_one(psz_driver, mode, OP_DATA, p_cdio, NULL,
+                            i_first, ai_batch[b]);
+      break;
+    }
+  }
+  cdio_destroy(p_cdio);
+  return i_errors;
+}
+
+static void
+usage(const char *psz_prog)
+{
+  fprintf(stderr,
+          "Usage: %s [--sectors N] [--repeat N] [--batch N[,N...]] "
+          "[--dir DIR]\n"
+          "  --sectors N   sectors per synthetic image (default %u)\n"
+          "  --repeat N    passes over each image (default %u)\n"
+          "  --batch LIST  comma-separated sectors per call "
+          "(default 1,16,64,256)\n"
+          "  --dir DIR     scratch directory for images (default .)\n",
+          psz_prog, BENCH_DEFAULT_SECTORS, BENCH_DEFAULT_REPEAT);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  const char *psz_dir = ".";
+  char psz_path[1024];
+  unsigned int i_errors = 0;
+  int i;
+  bench_mode_t mode;
+
+  for (i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--sectors") && i + 1 < argc)
+      i_sectors = atoi(argv[++i]);
+    else if (0 == strcmp(argv[i], "--repeat") && i + 1 < argc)
+      i_repeat = atoi(argv[++i]);
+    else if (0 == strcmp(argv[i], "--dir") && i + 1 < argc)
+      psz_dir = argv[++i];
+    else if (0 == strcmp(argv[i], "--batch") && i + 1 < argc) {
+      const char *p = argv[++i];
+      i_batches = 0;
+      while (*p && i_batches < BENCH_MAX_BATCHES) {
+        char *psz_end;
+        const unsigned long l = strtoul(p, &psz_end, 10);
+        if (psz_end == p || 0 == l) break;
+        ai_batch[i_batches++] = l;
+        p = ('\0' == *psz_end) ? psz_end : psz_end + 1;
+      }
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (0 == i_sectors || 0 == i_repeat || 0 == i_batches) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  cdio_loglevel_default = CDIO_LOG_WARN;
+
+  printf("driver,mode,operation,batch,sectors,calls,errors,seconds,"
+         "mib_per_s,usec_avg,usec_p50,usec_p99,usec_max\n");
+
+  for (mode = BENCH_AUDIO; mode <= BENCH_MODE2; mode++) {
+    if (!make_bincue_and_toc(psz_dir, mode) || !make_nrg(psz_dir, mode))
+      return 2;
+
+    snprintf(psz_path, sizeof(psz_path), "%s/bench-%s.cue", psz_dir,
+             mode_name[mode]);
+    i_errors += bench_image(psz_path, DRIVER_BINCUE, "bincue", mode);
+
+    snprintf(psz_path, sizeof(psz_path), "%s/bench-%s.toc", psz_dir,
+             mode_name[mode]);
+    i_errors += bench_image(psz_path, DRIVER_CDRDAO, "cdrdao", mode);
+
+    snprintf(psz_path, sizeof(psz_path), "%s/bench-%s.nrg", psz_dir,
+             mode_name[mode]);
+    i_errors += bench_image(psz_path, DRIVER_NRG, "nrg", mode);
+  }
+
+  if (!make_iso(psz_dir))
+    return 2;
+  snprintf(psz_path, sizeof(psz_path), "%s/bench.iso", psz_dir);
+  {
+    iso9660_t *p_iso = iso9660_open(psz_path);
+    unsigned int b;
+    if (!p_iso) {
+      fprintf(stderr, "bench_read: can't open %s\n", psz_path);
+      i_errors++;
+    } else {
+      for (b = 0; b < i_batches; b++)
+        i_errors += bench_one("iso9660", BENCH_MODE1, OP_ISO, NULL, p_iso,
+                              20, ai_batch[b]);
+      iso9660_close(p_iso);
+    }
+  }
+
+  if (i_errors)
+    fprintf(stderr, "bench_read: %u read calls failed\n", i_errors);
+  return i_errors ? 3 : 0;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,6 @@
+REM INDEX without a position
+
+FILE "cdda.bin" BINARY
+
+TRACK 01 AUDIO
+    INDEX 01
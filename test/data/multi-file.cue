@@ -0,0 +1,9 @@
+REM Two tracks in two files. The pregap of track 2 is at the end of
+REM the first file.
+FILE "cdda.bin" BINARY
+  TRACK 01 AUDIO
+    INDEX 01 00:00:00
+  TRACK 02 AUDIO
+    INDEX 00 00:03:00
+FILE "p1.bin" BINARY
+    INDEX 01 00:00:00
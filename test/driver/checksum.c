@@ -0,0 +1,183 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/checksum.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+static const uint8_t md5_abc[CDIO_MD5_DIGEST_SIZE] = {
+  0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+  0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72
+};
+static const uint8_t sha256_abc[CDIO_SHA256_DIGEST_SIZE] = {
+  0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+/* AccurateRip v1 and v2 of the two tracks of multi-file.cue, from an
+   independent implementation of the algorithm. */
+static const uint32_t ar_v1[2] = { 0x2ed9af4e, 0xb009b770 };
+static const uint32_t ar_v2[2] = { 0x3c6eb129, 0xbdc0400c };
+
+/* The digests agree with their published test vectors. */
+static int
+test_vectors(void)
+{
+  uint8_t bytes[256];
+  uint8_t digest[CDIO_SHA256_DIGEST_SIZE];
+  cdio_md5_t md5;
+  cdio_sha256_t sha;
+  unsigned int i;
+
+  cdio_md5_init(&md5);
+  cdio_md5_update(&md5, "abc", 3);
+  cdio_md5_final(&md5, digest);
+  if (0xcbf43926 != cdio_crc32(0, "123456789", 9)
+      || 0 != memcmp(digest, md5_abc, sizeof(md5_abc))) {
+    printf("CRC-32 or MD5 of a test vector is wrong\n");
+    return 1;
+  }
+  /* Long enough for the folding CRC, also from an odd start. */
+  for (i=0; i<sizeof(bytes); i++)
+    bytes[i] = (uint8_t) i;
+  if (0x29058c73 != cdio_crc32(0, bytes, sizeof(bytes))
+      || 0x569b49a3 != cdio_crc32(0, bytes + 1, 199)
+      || 0x29058c73 != cdio_crc32(cdio_crc32(0, bytes, 67),
+                                  bytes + 67, sizeof(bytes) - 67)) {
+    printf("CRC-32 of 256 bytes is wrong\n");
+    return 2;
+  }
+  cdio_sha256_init(&sha);
+  cdio_sha256_update(&sha, "abc", 3);
+  cdio_sha256_final(&sha, digest);
+  if (0 != memcmp(digest, sha256_abc, sizeof(sha256_abc))) {
+    printf("SHA-256 of a test vector is wrong\n");
+    return 3;
+  }
+  return 0;
+}
+
+/* The checksum engine agrees with digests of sector-by-sector
+   reads. */
+static int
+test_disc(CdIo_t *p_cdio)
+{
+  uint8_t buf[CDIO_CD_FRAMESIZE_RAW];
+  uint8_t digest[CDIO_MD5_DIGEST_SIZE];
+  cdio_disc_checksum_t *p_sums = calloc(1, sizeof(*p_sums));
+  cdio_md5_t md5, disc_md5;
+  uint32_t disc_crc = 0;
+  track_t i_track;
+  int ret = 0;
+
+  if (!p_sums
+      || DRIVER_OP_SUCCESS != cdio_checksum_disc(p_cdio, CDIO_CHECKSUM_ALL,
+                                                 p_sums)
+      || 2 != p_sums->i_tracks || 604 != p_sums->disc.i_sectors) {
+    printf("cdio_checksum_disc() of multi-file.cue failed\n");
+    free(p_sums);
+    return 10;
+  }
+
+  cdio_md5_init(&disc_md5);
+  for (i_track = 0; i_track < 2; i_track++) {
+    const cdio_checksum_report_t *p_sum = &p_sums->track[i_track];
+    cdio_accuraterip_t ar;
+    uint32_t crc = 0, v1, v2;
+    lsn_t i_lsn;
+    cdio_md5_init(&md5);
+    cdio_accuraterip_init(&ar, p_sum->i_sectors, 0 == i_track,
+                          1 == i_track);
+    for (i_lsn = p_sum->i_lsn;
+         i_lsn < p_sum->i_lsn + (lsn_t) p_sum->i_sectors; i_lsn++) {
+      cdio_read_audio_sector(p_cdio, buf, i_lsn);
+      crc = cdio_crc32(crc, buf, CDIO_CD_FRAMESIZE_RAW);
+      disc_crc = cdio_crc32(disc_crc, buf, CDIO_CD_FRAMESIZE_RAW);
+      cdio_md5_update(&md5, buf, CDIO_CD_FRAMESIZE_RAW);
+      cdio_md5_update(&disc_md5, buf, CDIO_CD_FRAMESIZE_RAW);
+      cdio_accuraterip_update(&ar, buf, CDIO_CD_FRAMESIZE_RAW);
+    }
+    cdio_md5_final(&md5, digest);
+    cdio_accuraterip_final(&ar, &v1, &v2);
+    if (crc != p_sum->crc32 || 0 != memcmp(digest, p_sum->md5, 16)
+        || v1 != ar_v1[i_track] || v2 != ar_v2[i_track]
+        || v1 != p_sum->accuraterip_v1 || v2 != p_sum->accuraterip_v2) {
+      printf("Checksums of track %d are wrong\n", i_track + 1);
+      ret = 11;
+    }
+  }
+  cdio_md5_final(&disc_md5, digest);
+  if (disc_crc != p_sums->disc.crc32
+      || 0 != memcmp(digest, p_sums->disc.md5, 16)) {
+    printf("Checksums of the whole disc are wrong\n");
+    ret = 12;
+  }
+  free(p_sums);
+  return ret;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  char psz_cuefile[500];
+  CdIo_t *p_cdio;
+  int ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  ret = test_vectors();
+  if (ret) return ret;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR,
+           "multi-file.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (!p_cdio) {
+    printf("Can't open multi-file.cue\n");
+    return 20;
+  }
+  ret = test_disc(p_cdio);
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
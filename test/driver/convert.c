@@ -0,0 +1,188 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/convert.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+/* Sectors in an image big enough to be split among threads. */
+#define BIG_SECTORS 4200
+
+/* Encoding the user data of a Mode 1 image again gives back the raw
+   image. */
+static int
+test_round_trip(void)
+{
+  uint8_t raw[CDIO_CD_FRAMESIZE_RAW], copy[CDIO_CD_FRAMESIZE_RAW];
+  uint8_t data[CDIO_CD_FRAMESIZE];
+  char psz_path[500];
+  FILE *p_iso, *p_bin;
+  unsigned int i;
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  snprintf(psz_path, sizeof(psz_path), "%s/%s", DATA_DIR, "isofs-m1.cue");
+  p_cdio = cdio_open (psz_path, DRIVER_BINCUE);
+  if (!p_cdio) {
+    printf("Can't open isofs-m1.cue\n");
+    return 1;
+  }
+  p_iso = fopen("iso2bin.iso", "wb");
+  for (i=0; p_iso && i<302; i++) {
+    cdio_read_data_sectors(p_cdio, data, i, CDIO_CD_FRAMESIZE, 1);
+    fwrite(data, CDIO_CD_FRAMESIZE, 1, p_iso);
+  }
+  cdio_destroy(p_cdio);
+
+  if (!p_iso || 0 != fclose(p_iso)
+      || DRIVER_OP_SUCCESS !=
+         cdio_convert_iso_to_bin("iso2bin.iso", "iso2bin.bin",
+                                 "iso2bin.cue", CDIO_RAW_MODE1, 2)) {
+    printf("cdio_convert_iso_to_bin() failed\n");
+    ret = 2;
+  } else {
+    snprintf(psz_path, sizeof(psz_path), "%s/%s", DATA_DIR, "isofs-m1.bin");
+    p_bin = fopen(psz_path, "rb");
+    p_iso = fopen("iso2bin.bin", "rb");
+    for (i=0; p_bin && p_iso && i<302; i++) {
+      if (1 != fread(raw, sizeof(raw), 1, p_bin)
+          || 1 != fread(copy, sizeof(copy), 1, p_iso)
+          || 0 != memcmp(raw, copy, sizeof(raw)))
+        break;
+    }
+    if (302 != i) {
+      printf("Sector %u of the converted image differs\n", i);
+      ret = 3;
+    }
+    if (p_bin) fclose(p_bin);
+    if (p_iso) fclose(p_iso);
+  }
+  unlink("iso2bin.iso");
+  unlink("iso2bin.bin");
+  unlink("iso2bin.cue");
+  return ret;
+}
+
+/* An image big enough to be split among threads converts to the same
+   raw image whatever the number of threads, and every sector of it
+   holds its 2048 bytes of data and checks out. */
+static int
+test_threads(void)
+{
+  const unsigned int ai_threads[3] = { 1, 4, 0 };
+  const char *ppsz_bin[3] = { "big1.bin", "big4.bin", "big0.bin" };
+  const size_t i_bin_size = (size_t) BIG_SECTORS * CDIO_CD_FRAMESIZE_RAW;
+  uint8_t *p_bin[3] = { NULL, NULL, NULL };
+  uint8_t data[CDIO_CD_FRAMESIZE];
+  FILE *p_iso = fopen("big.iso", "wb");
+  unsigned int i, j;
+  int ret = 0;
+
+  for (i=0; p_iso && i<BIG_SECTORS; i++) {
+    for (j=0; j<sizeof(data); j++)
+      data[j] = (uint8_t) (i * 31 + j);
+    fwrite(data, sizeof(data), 1, p_iso);
+  }
+  if (!p_iso || 0 != fclose(p_iso)) {
+    printf("Can't write big.iso\n");
+    unlink("big.iso");
+    return 10;
+  }
+
+  for (j=0; j<3; j++) {
+    FILE *p_in;
+    p_bin[j] = malloc(i_bin_size);
+    if (!p_bin[j]
+        || DRIVER_OP_SUCCESS !=
+           cdio_convert_iso_to_bin("big.iso", ppsz_bin[j], NULL,
+                                   CDIO_RAW_MODE1, ai_threads[j])
+        || !(p_in = fopen(ppsz_bin[j], "rb"))) {
+      printf("Converting big.iso with %u threads failed\n", ai_threads[j]);
+      ret = 11;
+      break;
+    }
+    if (1 != fread(p_bin[j], i_bin_size, 1, p_in)
+        || EOF != fgetc(p_in)
+        || (j > 0 && 0 != memcmp(p_bin[0], p_bin[j], i_bin_size))) {
+      printf("Converting big.iso with %u threads gave another image\n",
+             ai_threads[j]);
+      ret = 12;
+    }
+    fclose(p_in);
+  }
+
+  for (i=0; p_bin[0] && 11 != ret && i<BIG_SECTORS; i++) {
+    const uint8_t *p_sector = p_bin[0] + (size_t) i * CDIO_CD_FRAMESIZE_RAW;
+    for (j=0; j<sizeof(data); j++)
+      data[j] = (uint8_t) (i * 31 + j);
+    if (CDIO_SECTOR_OK != cdio_sector_verify(p_sector)
+        || 0 != memcmp(p_sector + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+                       data, sizeof(data))) {
+      printf("Sector %u of the converted big.iso is wrong\n", i);
+      ret = 13;
+      break;
+    }
+  }
+
+  for (j=0; j<3; j++) {
+    free(p_bin[j]);
+    unlink(ppsz_bin[j]);
+  }
+  unlink("big.iso");
+  return ret;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  ret = test_round_trip();
+  if (ret) return ret;
+  return test_threads();
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
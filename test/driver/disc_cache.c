@@ -0,0 +1,175 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/disc_cache.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+#define CACHE_DIR "disc-cache"
+
+/* Make the MCN in the cache file of a disc run on past its field.
+   Return false if it can't be found. */
+static bool
+corrupt_mcn(const cdio_disc_key_t *p_key)
+{
+  char psz_path[100];
+  uint8_t data[4096];
+  size_t i_len = 0, i;
+  FILE *fp;
+
+  snprintf(psz_path, sizeof(psz_path), CACHE_DIR "/%08x-%08x-%08x",
+           (unsigned int) p_key->i_discid,
+           (unsigned int) p_key->i_leadout,
+           (unsigned int) p_key->i_toc_crc);
+  if ((fp = fopen(psz_path, "rb"))) {
+    i_len = fread(data, 1, sizeof(data), fp);
+    fclose(fp);
+  }
+  for (i = 0; i + 16 <= i_len; i++)
+    if (0 == memcmp(data + i, "0000010271955", 14)) {
+      memset(data + i, '9', 16);
+      break;
+    }
+  if (i + 16 > i_len || !(fp = fopen(psz_path, "wb")))
+    return false;
+  fwrite(data, 1, i_len, fp);
+  fclose(fp);
+  return true;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  char psz_cuefile[500];
+  cdio_disc_cache_t *p_cache;
+  cdio_disc_info_t *p_info = NULL, *p_again = NULL;
+  cdio_disc_key_t key_cdda, key_iso;
+  cdio_iso_analysis_t analysis, cached_analysis;
+  cdio_fs_anal_t fs;
+  CdIo_t *p_cdda, *p_iso;
+  bool b_cached = true, b_again = false;
+  int ret = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "cdda.cue");
+  p_cdda = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR,
+           "isofs-m1.cue");
+  p_iso = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  p_cache = cdio_disc_cache_open(CACHE_DIR);
+  if (p_cache) p_info = cdio_disc_cache_get(p_cache, p_cdda, &b_cached);
+  if (!p_cdda || !p_iso || !p_info
+      || !cdio_disc_cache_key(p_cdda, &key_cdda)
+      || !cdio_disc_cache_key(p_iso, &key_iso)) {
+    printf("Can't set up the disc cache\n");
+    ret = 1;
+  } else if (b_cached || 1 != cdio_disc_info_get_num_tracks(p_info)
+             || !cdio_disc_info_get_mcn(p_info)
+             || 0 != strcmp("0000010271955", cdio_disc_info_get_mcn(p_info))
+             || NULL != cdio_disc_info_get_isrc(p_info, 1)
+             || CDIO_FS_AUDIO != cdio_disc_info_get_fs(p_info, 1, NULL)
+             || 302 != cdio_disc_info_get_track_lsn(p_info,
+                                                    CDIO_CDROM_LEADOUT_TRACK)
+             || key_cdda.i_toc_crc == key_iso.i_toc_crc
+             || p_info != cdio_disc_cache_get(p_cache, p_cdda, &b_again)
+             || !b_again) {
+    /* A disc is read once, then found in the cache... */
+    printf("cdio_disc_cache_get() got the wrong entry for cdda.cue\n");
+    ret = 2;
+  } else {
+    /* ...even by a cache opened afresh. */
+    cdio_disc_cache_close(p_cache);
+    p_cache = cdio_disc_cache_open(CACHE_DIR);
+    p_info  = p_cache ? cdio_disc_cache_get(p_cache, p_cdda, &b_cached)
+                      : NULL;
+    if (!p_info || !b_cached || !cdio_disc_info_get_mcn(p_info)
+        || 0 != strcmp("0000010271955", cdio_disc_info_get_mcn(p_info))) {
+      printf("cdda.cue wasn't found in the disc cache\n");
+      ret = 3;
+    } else {
+      fs = cdio_guess_cd_type(p_iso, 0, 1, &analysis);
+      p_again = cdio_disc_cache_get(p_cache, p_iso, &b_cached);
+      if (!p_again || b_cached
+          || fs != cdio_disc_info_get_fs(p_again, 1, &cached_analysis)
+          || 0 != strcmp(analysis.iso_label, cached_analysis.iso_label)
+          || analysis.isofs_size != cached_analysis.isofs_size
+          || TRACK_FORMAT_DATA != cdio_disc_info_get_track_format(p_again,
+                                                                  1)) {
+        printf("cdio_disc_cache_get() got the wrong entry for "
+               "isofs-m1.cue\n");
+        ret = 4;
+      }
+    }
+  }
+
+  if (!ret) {
+    /* A cache file whose MCN runs on past its field is read afresh
+       from the disc. */
+    bool b_corrupted;
+    cdio_disc_cache_close(p_cache);
+    b_corrupted = corrupt_mcn(&key_cdda);
+    p_cache = cdio_disc_cache_open(CACHE_DIR);
+    p_info  = p_cache ? cdio_disc_cache_get(p_cache, p_cdda, &b_cached)
+                      : NULL;
+    if (!b_corrupted || !p_info || b_cached
+        || !cdio_disc_info_get_mcn(p_info)
+        || 0 != strcmp("0000010271955", cdio_disc_info_get_mcn(p_info))) {
+      printf("cdio_disc_cache_get() took a cache file with a bad MCN\n");
+      ret = 5;
+    }
+  }
+
+  if (p_cache
+      && (!cdio_disc_cache_remove(p_cache, &key_cdda)
+          || !cdio_disc_cache_remove(p_cache, &key_iso)
+          || cdio_disc_cache_remove(p_cache, &key_iso))) {
+    printf("cdio_disc_cache_remove() failed\n");
+    ret = 6;
+  }
+  cdio_disc_cache_close(p_cache);
+  rmdir(CACHE_DIR);
+  cdio_destroy(p_iso);
+  cdio_destroy(p_cdda);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
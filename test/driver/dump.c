@@ -0,0 +1,138 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/dump.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+/* A dumped disc opens again as a CUE sheet... */
+static int
+test_cue(CdIo_t *p_cdio, cdio_dump_options_t *p_opts)
+{
+  uint8_t raw[CDIO_CD_FRAMESIZE_RAW], copy[CDIO_CD_FRAMESIZE_RAW];
+  cdio_dump_stats_t stats;
+  CdIo_t *p_dump = NULL;
+  char *psz_mcn = NULL;
+  int ret = 0;
+
+  if (DRIVER_OP_SUCCESS != cdio_dump_disc(p_cdio, "dump.bin", "dump.cue",
+                                          p_opts, &stats)
+      || 302 != stats.i_sectors || 0 != stats.i_bad_sectors
+      || !(p_dump = cdio_open ("dump.cue", DRIVER_BINCUE))
+      || 2 != cdio_get_num_tracks(p_dump)
+      || 225 != cdio_get_track_lsn(p_dump, 2)
+      || 150 != cdio_get_track_pregap_lsn(p_dump, 2)
+      || CDIO_TRACK_FLAG_TRUE != cdio_get_track_copy_permit(p_dump, 2)
+      || !(psz_mcn = cdio_get_mcn(p_dump))
+      || 0 != strcmp("0000010271955", psz_mcn)
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sector(p_cdio, raw, 200)
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sector(p_dump, copy, 200)
+      || 0 != memcmp(raw, copy, sizeof(raw))) {
+    printf("cdio_dump_disc() of p1.cue to a CUE sheet failed\n");
+    ret = 1;
+  }
+  free(psz_mcn);
+  cdio_destroy(p_dump);
+  return ret;
+}
+
+/* ...and as a TOC file, with the same tracks and sectors, whatever
+   the size of the batches it is read in. */
+static int
+test_toc(CdIo_t *p_cdio, cdio_dump_options_t *p_opts)
+{
+  uint8_t raw[CDIO_CD_FRAMESIZE_RAW], copy[CDIO_CD_FRAMESIZE_RAW];
+  cdio_dump_stats_t stats;
+  CdIo_t *p_dump = NULL;
+  char *psz_mcn = NULL;
+  int ret = 0;
+
+  p_opts->e_format = CDIO_DUMP_TOC;
+  p_opts->i_batch  = 7;
+  if (DRIVER_OP_SUCCESS != cdio_dump_disc(p_cdio, "dump.bin", "dump.toc",
+                                          p_opts, &stats)
+      || 302 != stats.i_sectors || 44 != stats.i_reads
+      || !(p_dump = cdio_open ("dump.toc", DRIVER_CDRDAO))
+      || 2 != cdio_get_num_tracks(p_dump)
+      || 225 != cdio_get_track_lsn(p_dump, 2)
+      || !(psz_mcn = cdio_get_mcn(p_dump))
+      || 0 != strcmp("0000010271955", psz_mcn)
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sector(p_cdio, raw, 200)
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sector(p_dump, copy, 200)
+      || 0 != memcmp(raw, copy, sizeof(raw))) {
+    printf("cdio_dump_disc() of p1.cue to a TOC file failed\n");
+    ret = 2;
+  }
+  free(psz_mcn);
+  cdio_destroy(p_dump);
+  return ret;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  char psz_cuefile[500];
+  cdio_dump_options_t opts;
+  CdIo_t *p_cdio;
+  int ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "p1.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (!p_cdio) {
+    printf("Can't open p1.cue\n");
+    return 10;
+  }
+  memset(&opts, 0, sizeof(opts));
+  ret = test_cue(p_cdio, &opts);
+  if (!ret) ret = test_toc(p_cdio, &opts);
+  cdio_destroy(p_cdio);
+  unlink("dump.bin");
+  unlink("dump.cue");
+  unlink("dump.toc");
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
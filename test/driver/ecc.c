@@ -0,0 +1,99 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/ecc.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+int
+main(int argc, const char *argv[])
+{
+  uint8_t raw[CDIO_CD_FRAMESIZE_RAW], damaged[CDIO_CD_FRAMESIZE_RAW];
+  uint8_t data[CDIO_CD_FRAMESIZE];
+  char psz_cuefile[500];
+  unsigned int i;
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR,
+           "isofs-m1.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (!p_cdio) {
+    printf("Can't open isofs-m1.cue\n");
+    return 1;
+  }
+
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_cdio, "ecc", "verify")
+      || 0 != strcmp("verify", cdio_get_arg(p_cdio, "ecc"))
+      || DRIVER_OP_SUCCESS == cdio_set_arg(p_cdio, "ecc", "maybe")) {
+    printf("The \"ecc\" arg isn't handled\n");
+    ret = 2;
+  }
+
+  /* Every raw sector of a Mode 1 image checks out. */
+  for (i=0; i<302; i++) {
+    if (DRIVER_OP_SUCCESS != cdio_read_audio_sector(p_cdio, raw, i)
+        || CDIO_SECTOR_OK != cdio_sector_verify(raw)
+        || DRIVER_OP_SUCCESS != cdio_read_mode1_sector(p_cdio, data, i,
+                                                       false)) {
+      printf("Sector %u of isofs-m1.bin doesn't verify\n", i);
+      ret = 3;
+      break;
+    }
+  }
+
+  /* A damaged one is put right from its parity. */
+  cdio_read_audio_sector(p_cdio, raw, 16);
+  memcpy(damaged, raw, sizeof(raw));
+  damaged[100]  ^= 0x55;
+  damaged[1000] ^= 0xff;
+  damaged[2200] ^= 0x01;
+  if (CDIO_SECTOR_BAD != cdio_sector_verify(damaged)
+      || CDIO_SECTOR_CORRECTED != cdio_sector_repair(damaged)
+      || 0 != memcmp(damaged, raw, sizeof(raw))) {
+    printf("A damaged sector wasn't repaired\n");
+    ret = 4;
+  }
+
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,873 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit tests of the parts of lib/driver that work a drive, run
+   against a made-up one: a driver whose reads come back the way a
+   real drive's can, but in a way the test knows in advance.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/dump.h>
+#include <cdio/logging.h>
+#include <cdio/mmc.h>
+#include <cdio/mmc_hl_cmds.h>
+#include <cdio/read_ctl.h>
+#include <cdio/rip.h>
+#include <cdio/subchannel.h>
+#include "cdio_private.h"
+
+/* The made-up disc: FAKE_LEADOUT sectors, one audio track unless the
+   test lays out more. */
+#define FAKE_LEADOUT 400
+#define FAKE_TRACKS  3
+#define SAMPLES      CDIO_CD_SAMPLES_PER_SECTOR
+
+typedef struct {
+  generic_img_private_t gen;   /* must come first */
+  const int   *pi_shifts;      /* samples each read is off by, in turn */
+  unsigned int i_shifts;
+  unsigned int i_reads;        /* audio reads so far */
+  track_t      i_tracks;
+  lsn_t        ai_track_start[FAKE_TRACKS];
+  track_format_t ai_track_format[FAKE_TRACKS];
+  bool         b_mmc;          /* whether READ CD works */
+  unsigned int i_mmc_reads;    /* READ CDs so far */
+  unsigned int ai_c2_left[FAKE_LEADOUT]; /* reads of each sector still
+                                            to come with C2 errors */
+  const lsn_t *pi_indices;     /* where indices 2 and up start */
+  unsigned int i_indices;
+  lsn_t        i_mcn_at;       /* sectors whose Q is an MCN or an ISRC */
+  lsn_t        i_isrc_at;
+  lsn_t        i_bad_q_from;   /* sectors whose Q has a bad CRC */
+  lsn_t        i_bad_q_to;
+  unsigned int ai_fail_left[FAKE_LEADOUT]; /* READ CDs of each sector
+                                              still to fail */
+  bool         ab_fail_typed[FAKE_LEADOUT]; /* whether a sector fails
+                                               unless read as any type */
+  unsigned int i_wrong_type;   /* sectors read as the wrong type */
+  unsigned int i_any_type;     /* sectors of audio and mode 1 tracks
+                                  read as any type */
+} fake_env_t;
+
+/* The track sector i_lsn is in, counted from 0. */
+static unsigned int
+fake_track(const fake_env_t *p_env, lsn_t i_lsn)
+{
+  unsigned int i = 0;
+  while (i + 1 < p_env->i_tracks && p_env->ai_track_start[i + 1] <= i_lsn)
+    i++;
+  return i;
+}
+
+/* Sample i of the disc: no two nearby ones are alike, so that where
+   a read really starts can only be found one way. */
+static uint32_t
+fake_sample(int64_t i)
+{
+  uint32_t x;
+  if (i < 0 || i >= (int64_t) FAKE_LEADOUT * SAMPLES) return 0;
+  x  = (uint32_t) i * 2654435761u;
+  x ^= x >> 13;
+  x *= 0x5bd1e995u;
+  x ^= x >> 15;
+  return x;
+}
+
+/* Read audio, off by the next of the shifts the test set, the way a
+   drive without accurate stream reads is. */
+static int
+fake_read_audio_sectors(void *p_user_data, void *p_buf, lsn_t i_lsn,
+                        unsigned int i_blocks)
+{
+  fake_env_t *p_env = p_user_data;
+  const int i_shift = p_env->i_shifts
+    ? p_env->pi_shifts[p_env->i_reads % p_env->i_shifts] : 0;
+  uint32_t *p_samples = p_buf;
+  unsigned int i;
+
+  p_env->i_reads++;
+  for (i = 0; i < i_blocks * SAMPLES; i++)
+    p_samples[i] = fake_sample((int64_t) i_lsn * SAMPLES + i + i_shift);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Byte i_byte of the main channel of sector i_lsn: the samples of
+   fake_sample(), little-endian. */
+static uint8_t
+fake_byte(lsn_t i_lsn, unsigned int i_byte)
+{
+  return (uint8_t) (fake_sample((int64_t) i_lsn * SAMPLES + i_byte / 4)
+                    >> (8 * (i_byte % 4)));
+}
+
+/* Mode 2 sectors, cut out of the main channel of fake_byte(): the
+   2336 bytes after the header for form 2, the 2048 after the subheader
+   for form 1. */
+static int
+fake_read_mode2_sectors(void *p_user_data, void *p_buf, lsn_t i_lsn,
+                        bool b_form2, unsigned int i_blocks)
+{
+  const unsigned int i_from = b_form2
+    ? CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE : CDIO_CD_XA_SYNC_HEADER;
+  const unsigned int i_size = b_form2 ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE;
+  uint8_t *p = p_buf;
+  unsigned int i, k;
+
+  for (i = 0; i < i_blocks; i++)
+    for (k = 0; k < i_size; k++)
+      *p++ = fake_byte(i_lsn + (lsn_t) i, i_from + k);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* C2 bits the drive flags in sector i_lsn while it reads it badly,
+   i_left more times: more on some reads than on others. */
+#define FAKE_C2_BITS(i_lsn, i_left) (1 + (i_lsn) % 13 + (i_left) % 4)
+
+static void
+fake_c2(lsn_t i_lsn, unsigned int i_bits, /*out*/ uint8_t *p_c2)
+{
+  unsigned int i;
+  memset(p_c2, 0, MMC_C2_SIZE);
+  for (i = 0; i < i_bits; i++) {
+    const unsigned int i_bit = (i * 181 + i_lsn) % (MMC_C2_SIZE * 8);
+    p_c2[i_bit / 8] |= 0x80 >> (i_bit % 8);
+  }
+}
+
+static uint8_t
+fake_bcd(unsigned int i)
+{
+  return (uint8_t) (((i / 10) << 4) | (i % 10));
+}
+
+/* The Q of sector i_lsn: its position in its track, in the index the
+   test set, unless the test put an MCN or an ISRC there instead. */
+static void
+fake_q(const fake_env_t *p_env, lsn_t i_lsn, /*out*/ uint8_t *p_q)
+{
+  static const uint8_t mcn[10] = { 0x02, 0x00, 0x00, 0x01, 0x02, 0x71,
+                                   0x95, 0x50, 0x00, 0x00 };
+  static const uint8_t isrc[10] = { 0x03, 0x96, 0x38, 0x93, 0x04, 0x76,
+                                    0x07, 0x83, 0x90, 0x00 };
+  const lba_t i_lba = i_lsn + CDIO_PREGAP_SECTORS;
+  const unsigned int i_track = fake_track(p_env, i_lsn);
+  const lsn_t i_rel = i_lsn - p_env->ai_track_start[i_track];
+  uint16_t i_crc;
+
+  if (i_lsn == p_env->i_mcn_at)
+    memcpy(p_q, mcn, sizeof(mcn));
+  else if (i_lsn == p_env->i_isrc_at)
+    memcpy(p_q, isrc, sizeof(isrc));
+  else {
+    unsigned int i_index = 1, i;
+    for (i = 0; i < p_env->i_indices; i++)
+      if (p_env->pi_indices[i] <= i_lsn) i_index = i + 2;
+    p_q[0] = (TRACK_FORMAT_AUDIO == p_env->ai_track_format[i_track])
+      ? 0x01 : 0x41;
+    p_q[1] = fake_bcd(i_track + 1);
+    p_q[2] = fake_bcd(i_index);
+    p_q[3] = fake_bcd(i_rel / (60 * 75));
+    p_q[4] = fake_bcd(i_rel / 75 % 60);
+    p_q[5] = fake_bcd(i_rel % 75);
+    p_q[6] = 0;
+    p_q[7] = fake_bcd(i_lba / (60 * 75));
+    p_q[8] = fake_bcd(i_lba / 75 % 60);
+    p_q[9] = fake_bcd(i_lba % 75);
+  }
+  i_crc = cdio_subq_crc(p_q);
+  if (i_lsn >= p_env->i_bad_q_from && i_lsn < p_env->i_bad_q_to)
+    i_crc ^= 0x5a5a;
+  p_q[10] = i_crc >> 8;
+  p_q[11] = i_crc & 0xff;
+}
+
+/* Raw P-W byte i_byte of sector i_lsn: P set, Q from fake_q(), and
+   R-W bits that are something else again. */
+static uint8_t
+fake_pw(const fake_env_t *p_env, lsn_t i_lsn, unsigned int i_byte)
+{
+  uint8_t q[MMC_SUBQ_SIZE];
+  fake_q(p_env, i_lsn, q);
+  return (uint8_t) (0x80 | (((q[i_byte / 8] >> (7 - i_byte % 8)) & 1) << 6)
+                    | ((i_lsn + i_byte * 5) & 0x3f));
+}
+
+/* Whether a drive reads a sector of track format e_format when asked
+   for READ CD sector type i_type. */
+static bool
+fake_type_ok(track_format_t e_format, int i_type)
+{
+  switch (i_type) {
+  case CDIO_MMC_READ_TYPE_ANY:   return true;
+  case CDIO_MMC_READ_TYPE_CDDA:  return TRACK_FORMAT_AUDIO == e_format;
+  case CDIO_MMC_READ_TYPE_MODE1: return TRACK_FORMAT_DATA == e_format;
+  default:                       return TRACK_FORMAT_XA == e_format;
+  }
+}
+
+/* READ CD, the one MMC command the made-up drive knows: each sector
+   as the CDB asks for it, with C2 errors as long as the test said
+   the sector would be read badly. A read of the main channel fails
+   where the test said it would, or where it asks for the wrong type
+   of sector. */
+static driver_return_code_t
+fake_run_mmc_cmd(void *p_user_data, unsigned int i_timeout_ms,
+                 unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                 cdio_mmc_direction_t e_direction, unsigned int i_buf,
+                 /*in/out*/ void *p_buf)
+{
+  fake_env_t *p_env = p_user_data;
+  const uint8_t *f = p_cdb->field;
+  const lsn_t i_lsn = (lsn_t) (((uint32_t) f[2] << 24) | (f[3] << 16)
+                               | (f[4] << 8) | f[5]);
+  const uint32_t i_blocks = (f[6] << 16) | (f[7] << 8) | f[8];
+  const bool b_main = 0 != (f[9] & 0x10);
+  const bool b_c2 = 1 == ((f[9] >> 1) & 3);
+  const uint8_t i_sub = f[10] & 7;
+  unsigned int i_size = 0;
+  uint8_t *p = p_buf;
+  uint32_t i;
+
+  if (!p_env->b_mmc) return DRIVER_OP_UNSUPPORTED;
+  if (CDIO_MMC_GPCMD_READ_CD != f[0] || SCSI_MMC_DATA_READ != e_direction)
+    return DRIVER_OP_UNSUPPORTED;
+  if (b_main) i_size += CDIO_CD_FRAMESIZE_RAW;
+  if (b_c2) i_size += MMC_C2_SIZE;
+  if (1 == i_sub) i_size += CDIO_CD_FRAMESIZE_SUB;
+  if (2 == i_sub) i_size += 16;
+  if (i_size * i_blocks != i_buf) return DRIVER_OP_BAD_PARAMETER;
+  if (i_lsn < 0 || i_lsn + (int64_t) i_blocks > FAKE_LEADOUT)
+    return DRIVER_OP_ERROR;
+
+  p_env->i_mmc_reads++;
+  if (b_main) {
+    const int i_type = (f[1] >> 2) & 7;
+    bool b_fail = false;
+
+    for (i = 0; i < i_blocks; i++) {
+      const lsn_t j = i_lsn + (lsn_t) i;
+      const track_format_t e_format =
+        p_env->ai_track_format[fake_track(p_env, j)];
+      if (!fake_type_ok(e_format, i_type)) {
+        p_env->i_wrong_type++;
+        b_fail = true;
+      }
+      if (CDIO_MMC_READ_TYPE_ANY == i_type && TRACK_FORMAT_XA != e_format)
+        p_env->i_any_type++;
+      if (p_env->ai_fail_left[j]) {
+        p_env->ai_fail_left[j]--;
+        b_fail = true;
+      }
+      if (p_env->ab_fail_typed[j] && CDIO_MMC_READ_TYPE_ANY != i_type)
+        b_fail = true;
+    }
+    if (b_fail) return DRIVER_OP_ERROR;
+  }
+  for (i = 0; i < i_blocks; i++) {
+    const lsn_t j = i_lsn + (lsn_t) i;
+    unsigned int k;
+
+    if (b_main) {
+      for (k = 0; k < CDIO_CD_FRAMESIZE_RAW; k++)
+        *p++ = fake_byte(j, k);
+    }
+    if (b_c2) {
+      fake_c2(j, p_env->ai_c2_left[j]
+              ? FAKE_C2_BITS(j, p_env->ai_c2_left[j]) : 0, p);
+      p += MMC_C2_SIZE;
+    }
+    if (1 == i_sub) {
+      for (k = 0; k < CDIO_CD_FRAMESIZE_SUB; k++)
+        *p++ = fake_pw(p_env, j, k);
+    } else if (2 == i_sub) {
+      memset(p, 0, 16);
+      fake_q(p_env, j, p);
+      p += 16;
+    }
+    if (p_env->ai_c2_left[j]) p_env->ai_c2_left[j]--;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+static lba_t
+fake_get_track_lba(void *p_user_data, track_t i_track)
+{
+  const fake_env_t *p_env = p_user_data;
+  if (i_track >= 1 && i_track <= p_env->i_tracks)
+    return p_env->ai_track_start[i_track - 1] + CDIO_PREGAP_SECTORS;
+  if (p_env->i_tracks + 1 == i_track || CDIO_CDROM_LEADOUT_TRACK == i_track)
+    return FAKE_LEADOUT + CDIO_PREGAP_SECTORS;
+  return CDIO_INVALID_LBA;
+}
+
+static lsn_t
+fake_get_disc_last_lsn(void *p_user_data)
+{
+  return FAKE_LEADOUT;
+}
+
+static track_t
+fake_get_first_track_num(void *p_user_data)
+{
+  return 1;
+}
+
+static track_t
+fake_get_num_tracks(void *p_user_data)
+{
+  const fake_env_t *p_env = p_user_data;
+  return p_env->i_tracks;
+}
+
+static track_format_t
+fake_get_track_format(void *p_user_data, track_t i_track)
+{
+  const fake_env_t *p_env = p_user_data;
+  return (i_track >= 1 && i_track <= p_env->i_tracks)
+    ? p_env->ai_track_format[i_track - 1] : TRACK_FORMAT_ERROR;
+}
+
+static CdIo_t *
+fake_open(fake_env_t **pp_env)
+{
+  fake_env_t *p_env = calloc(1, sizeof(fake_env_t));
+  cdio_funcs_t funcs;
+
+  if (!p_env) return NULL;
+  memset(&funcs, 0, sizeof(funcs));
+  funcs.free                = free;
+  funcs.get_disc_last_lsn   = fake_get_disc_last_lsn;
+  funcs.get_first_track_num = fake_get_first_track_num;
+  funcs.get_num_tracks      = fake_get_num_tracks;
+  funcs.get_track_format    = fake_get_track_format;
+  funcs.get_track_lba       = fake_get_track_lba;
+  funcs.read_audio_sectors  = fake_read_audio_sectors;
+  funcs.read_mode2_sectors  = fake_read_mode2_sectors;
+  funcs.run_mmc_cmd         = fake_run_mmc_cmd;
+  p_env->i_tracks  = 1;
+  p_env->ai_track_format[0] = TRACK_FORMAT_AUDIO;
+  p_env->i_mcn_at  = CDIO_INVALID_LSN;
+  p_env->i_isrc_at = CDIO_INVALID_LSN;
+  *pp_env = p_env;
+  return cdio_new(&p_env->gen, &funcs);
+}
+
+/* Audio extraction callback: append the PCM to a buffer, counting
+   the calls, slowly enough that the reader gets ahead. */
+typedef struct {
+  uint8_t     *p_pcm;
+  size_t       i_size;
+  size_t       i_used;
+  unsigned int i_empty;   /* calls with nothing in them */
+} rip_buffer_t;
+
+static driver_return_code_t
+rip_to_buffer(const uint8_t *p_pcm, size_t i_bytes, void *p_user_data)
+{
+  rip_buffer_t *p_buf = p_user_data;
+  if (0 == i_bytes) p_buf->i_empty++;
+  if (p_buf->i_used + i_bytes > p_buf->i_size) return DRIVER_OP_ERROR;
+  memcpy(p_buf->p_pcm + p_buf->i_used, p_pcm, i_bytes);
+  p_buf->i_used += i_bytes;
+#ifdef HAVE_USLEEP
+  usleep(2000);
+#endif
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Extract from a drive whose reads land up to 100 samples either side
+   of where they were asked for: what comes out should be the disc as
+   it is, and the shifts should be in the statistics. The range is a
+   whole number of batches, so the last one fills its slot in the ring
+   exactly. */
+static int
+test_rip_jitter(void)
+{
+  static const int ai_shifts[] = { 0, 37, -23, 100, -100, 5, 0, -64 };
+  const lsn_t i_lsn = 10;
+  const uint32_t i_sectors = 12 * 20;
+  cdio_rip_options_t opts;
+  cdio_rip_stats_t stats;
+  rip_buffer_t buf;
+  fake_env_t *p_env;
+  CdIo_t *p_cdio = fake_open(&p_env);
+  const uint32_t *p_samples;
+  int i_ret = 0;
+  uint32_t i;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.i_batch = 20;
+  memset(&buf, 0, sizeof(buf));
+  buf.i_size = (size_t) i_sectors * CDIO_CD_FRAMESIZE_RAW;
+  buf.p_pcm  = malloc(buf.i_size);
+  if (!p_cdio || !buf.p_pcm) {
+    printf("Can't set up the made-up drive\n");
+    free(buf.p_pcm);
+    cdio_destroy(p_cdio);
+    return 10;
+  }
+  p_env->pi_shifts = ai_shifts;
+  p_env->i_shifts  = sizeof(ai_shifts) / sizeof(ai_shifts[0]);
+
+  if (DRIVER_OP_SUCCESS != cdio_rip_audio(p_cdio, i_lsn, i_sectors, &opts,
+                                          rip_to_buffer, &buf, &stats)
+      || buf.i_size != buf.i_used) {
+    printf("cdio_rip_audio() failed on a jittery drive: %lu bytes of %lu\n",
+           (unsigned long) buf.i_used, (unsigned long) buf.i_size);
+    i_ret = 11;
+  } else if (buf.i_empty) {
+    printf("cdio_rip_audio() made %u empty callbacks\n", buf.i_empty);
+    i_ret = 12;
+  }
+
+  p_samples = (const uint32_t *) buf.p_pcm;
+  for (i = 0; !i_ret && i < i_sectors * SAMPLES; i++)
+    if (fake_sample((int64_t) i_lsn * SAMPLES + i) != p_samples[i]) {
+      printf("cdio_rip_audio() gave the wrong sample %lu\n",
+             (unsigned long) i);
+      i_ret = 13;
+    }
+
+  if (!i_ret && (0 == stats.i_shifted || 100 != stats.i_max_shift
+                 || 0 != stats.i_unverified || i_sectors != stats.i_sectors)) {
+    printf("cdio_rip_audio() statistics are off: %u shifted, "
+           "largest %u, %u unverified\n", (unsigned int) stats.i_shifted,
+           (unsigned int) stats.i_max_shift,
+           (unsigned int) stats.i_unverified);
+    i_ret = 14;
+  }
+
+  free(buf.p_pcm);
+  cdio_destroy(p_cdio);
+  return i_ret;
+}
+
+/* Read a run of sectors, some of them badly, through every plane a
+   batch can have; then read the bad ones again until all but one come
+   back clean. That one reads worse each time, so its first copy should
+   be the one kept. */
+static int
+test_mmc_batch(void)
+{
+  const lsn_t i_lsn = 16;
+  const uint32_t i_blocks = 32;
+  fake_env_t *p_env;
+  CdIo_t *p_cdio = fake_open(&p_env);
+  mmc_read_batch_t *p_batch =
+    mmc_read_batch_new(MMC_READ_PLANE_DATA|MMC_READ_PLANE_C2
+                       |MMC_READ_PLANE_SUBQ|MMC_READ_PLANE_SUBPW, i_blocks);
+  mmc_read_batch_t *p_qbatch = mmc_read_batch_new(MMC_READ_PLANE_SUBQ, 8);
+  uint8_t c2[MMC_C2_SIZE], q[MMC_SUBQ_SIZE];
+  int i_ret = 0;
+  uint32_t i;
+  unsigned int k;
+
+  if (!p_cdio || !p_batch || !p_qbatch) {
+    printf("Can't set up the made-up drive\n");
+    i_ret = 20;
+    goto out;
+  }
+  p_env->b_mmc = true;
+  p_env->ai_c2_left[20] = 1;
+  p_env->ai_c2_left[21] = 1;
+  p_env->ai_c2_left[22] = 2;
+  p_env->ai_c2_left[25] = 100;
+
+  if (DRIVER_OP_SUCCESS !=
+      mmc_read_cd_batch(p_cdio, i_lsn, i_blocks, p_batch)
+      || p_batch->i_blocks != i_blocks
+      || p_batch->i_filled != p_batch->i_planes) {
+    printf("mmc_read_cd_batch() failed\n");
+    i_ret = 21;
+    goto out;
+  }
+
+  if (4 != p_batch->i_bad) {
+    printf("mmc_read_cd_batch() found %u bad sectors, not 4\n",
+           (unsigned int) p_batch->i_bad);
+    i_ret = 22;
+  }
+  for (i = 0; !i_ret && i < i_blocks; i++) {
+    const lsn_t j = i_lsn + (lsn_t) i;
+    const unsigned int i_bits =
+      (20 == j || 21 == j) ? FAKE_C2_BITS(j, 1)
+      : (22 == j) ? FAKE_C2_BITS(j, 2)
+      : (25 == j) ? FAKE_C2_BITS(j, 100) : 0;
+    fake_c2(j, i_bits, c2);
+    if (i_bits != p_batch->p_c2_errors[i]
+        || memcmp(c2, p_batch->p_c2 + i * MMC_C2_SIZE, MMC_C2_SIZE)) {
+      printf("mmc_read_cd_batch() C2 of sector %d: %u bits, not %u\n",
+             (int) j, (unsigned int) p_batch->p_c2_errors[i], i_bits);
+      i_ret = 22;
+    }
+  }
+
+  for (i = 0; !i_ret && i < i_blocks; i++) {
+    const lsn_t j = i_lsn + (lsn_t) i;
+    for (k = 0; !i_ret && k < CDIO_CD_FRAMESIZE_RAW; k++)
+      if (fake_byte(j, k) != p_batch->p_data[i * CDIO_CD_FRAMESIZE_RAW + k])
+        i_ret = 23;
+    for (k = 0; !i_ret && k < CDIO_CD_FRAMESIZE_SUB; k++)
+      if (fake_pw(p_env, j, k)
+          != p_batch->p_subpw[i * CDIO_CD_FRAMESIZE_SUB + k])
+        i_ret = 23;
+    if (i_ret)
+      printf("mmc_read_cd_batch() split sector %d up wrong\n", (int) j);
+    fake_q(p_env, j, q);
+    if (!i_ret && memcmp(q, p_batch->p_subq + i * MMC_SUBQ_SIZE,
+                         MMC_SUBQ_SIZE)) {
+      printf("mmc_read_cd_batch() took the wrong Q out of the P-W of "
+             "sector %d\n", (int) j);
+      i_ret = 24;
+    }
+  }
+  if (i_ret) goto out;
+
+  /* Three of the bad sectors read clean within two more tries; the
+     runs 20-22 and 25 are read the first time, 22 and 25 the second. */
+  p_env->i_mmc_reads = 0;
+  if (DRIVER_OP_SUCCESS != mmc_read_cd_batch_retry(p_cdio, p_batch, 2)
+      || 1 != p_batch->i_bad || 0 == p_batch->p_c2_errors[25 - i_lsn]
+      || p_batch->p_c2_errors[20 - i_lsn] || p_batch->p_c2_errors[21 - i_lsn]
+      || p_batch->p_c2_errors[22 - i_lsn] || 4 != p_env->i_mmc_reads) {
+    printf("mmc_read_cd_batch_retry() left %u bad sectors after %u reads\n",
+           (unsigned int) p_batch->i_bad, p_env->i_mmc_reads);
+    i_ret = 25;
+    goto out;
+  }
+  fake_c2(22, 0, c2);
+  for (k = 0; !i_ret && k < CDIO_CD_FRAMESIZE_RAW; k++)
+    if (fake_byte(22, k)
+        != p_batch->p_data[(22 - i_lsn) * CDIO_CD_FRAMESIZE_RAW + k])
+      i_ret = 25;
+  if (i_ret || memcmp(c2, p_batch->p_c2 + (22 - i_lsn) * MMC_C2_SIZE,
+                      MMC_C2_SIZE)) {
+    printf("mmc_read_cd_batch_retry() kept the bad copy of sector 22\n");
+    i_ret = 25;
+    goto out;
+  }
+  fake_c2(25, FAKE_C2_BITS(25, 100), c2);
+  if (FAKE_C2_BITS(25, 100) != p_batch->p_c2_errors[25 - i_lsn]
+      || memcmp(c2, p_batch->p_c2 + (25 - i_lsn) * MMC_C2_SIZE,
+                MMC_C2_SIZE)) {
+    printf("mmc_read_cd_batch_retry() kept a worse copy of sector 25\n");
+    i_ret = 25;
+    goto out;
+  }
+
+  /* Q alone comes formatted, without the main channel. */
+  if (DRIVER_OP_SUCCESS != mmc_read_cd_batch(p_cdio, 100, 8, p_qbatch)
+      || MMC_READ_PLANE_SUBQ != p_qbatch->i_filled) {
+    printf("mmc_read_cd_batch() failed for Q alone\n");
+    i_ret = 26;
+    goto out;
+  }
+  for (i = 0; !i_ret && i < 8; i++) {
+    fake_q(p_env, 100 + i, q);
+    if (memcmp(q, p_qbatch->p_subq + i * MMC_SUBQ_SIZE, MMC_SUBQ_SIZE)) {
+      printf("mmc_read_cd_batch() gave the wrong Q for sector %d\n",
+             (int) (100 + i));
+      i_ret = 26;
+    }
+  }
+
+ out:
+  mmc_read_batch_free(p_qbatch);
+  mmc_read_batch_free(p_batch);
+  cdio_destroy(p_cdio);
+  return i_ret;
+}
+
+/* Read mode 2 form 2 sectors through a read controller in short
+   transfers: each should land where a plain read puts it, 2336 bytes
+   on from the last. */
+static int
+test_read_ctl_m2f2(void)
+{
+  const lsn_t i_lsn = 30;
+  const uint32_t i_blocks = 50;
+  cdio_read_ctl_options_t opts;
+  cdio_read_ctl_stats_t stats;
+  cdio_read_ctl_t *p_ctl = NULL;
+  fake_env_t *p_env;
+  CdIo_t *p_cdio = fake_open(&p_env);
+  uint8_t *p_direct = malloc((size_t) i_blocks * M2RAW_SECTOR_SIZE);
+  uint8_t *p_buf = calloc(i_blocks, M2RAW_SECTOR_SIZE);
+  int i_ret = 0;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.i_max_blocks = 8;
+  if (p_cdio) p_ctl = cdio_read_ctl_new(p_cdio, &opts);
+  if (!p_ctl || !p_direct || !p_buf
+      || DRIVER_OP_SUCCESS != cdio_read_sectors(p_cdio, p_direct, i_lsn,
+                                                CDIO_READ_MODE_M2F2,
+                                                i_blocks)) {
+    printf("Can't set up the read controller\n");
+    i_ret = 30;
+  } else if (DRIVER_OP_SUCCESS != cdio_read_ctl_read(p_ctl, p_buf, i_lsn,
+                                                     CDIO_READ_MODE_M2F2,
+                                                     i_blocks)
+             || memcmp(p_direct, p_buf,
+                       (size_t) i_blocks * M2RAW_SECTOR_SIZE)) {
+    printf("cdio_read_ctl_read() put mode 2 form 2 sectors in the wrong "
+           "place\n");
+    i_ret = 31;
+  } else if (DRIVER_OP_SUCCESS != cdio_read_ctl_get_stats(p_ctl, &stats)
+             || i_blocks != stats.i_sectors || stats.i_reads < 2) {
+    printf("cdio_read_ctl_read() read %lu sectors in %lu transfers\n",
+           (unsigned long) stats.i_sectors, (unsigned long) stats.i_reads);
+    i_ret = 32;
+  }
+
+  cdio_read_ctl_free(p_ctl);
+  free(p_buf);
+  free(p_direct);
+  cdio_destroy(p_cdio);
+  return i_ret;
+}
+
+/* Find the indices of a track where the sector before index 2 has an
+   MCN for its Q and the one before index 3 an ISRC, and where no Q can
+   be read for a while around index 4: the first two should come out
+   exactly, and the last be left out. */
+static int
+test_subq_indices(void)
+{
+  static const lsn_t ai_indices[] = { 101, 151, 301 };
+  cdio_subq_scan_t *p_scan = malloc(sizeof(cdio_subq_scan_t));
+  fake_env_t *p_env;
+  CdIo_t *p_cdio = fake_open(&p_env);
+  const cdio_subq_track_t *p_track;
+  int i_ret = 0;
+
+  if (!p_cdio || !p_scan) {
+    printf("Can't set up the made-up drive\n");
+    i_ret = 40;
+    goto out;
+  }
+  p_env->b_mmc        = true;
+  p_env->pi_indices   = ai_indices;
+  p_env->i_indices    = sizeof(ai_indices) / sizeof(ai_indices[0]);
+  p_env->i_mcn_at     = ai_indices[0] - 1;
+  p_env->i_isrc_at    = ai_indices[1] - 1;
+  p_env->i_bad_q_from = ai_indices[2] - 40;
+  p_env->i_bad_q_to   = ai_indices[2] + 40;
+
+  if (DRIVER_OP_SUCCESS != cdio_subq_find_indices(p_cdio, p_scan)
+      || !p_scan->b_subchannel) {
+    printf("cdio_subq_find_indices() gave up on the disc\n");
+    i_ret = 41;
+    goto out;
+  }
+  p_track = &p_scan->track[1];
+  if (0 != p_track->i_index[1] || ai_indices[0] != p_track->i_index[2]
+      || ai_indices[1] != p_track->i_index[3]) {
+    printf("cdio_subq_find_indices() put indices 2 and 3 at %ld and %ld, "
+           "not %ld and %ld\n", (long int) p_track->i_index[2],
+           (long int) p_track->i_index[3], (long int) ai_indices[0],
+           (long int) ai_indices[1]);
+    i_ret = 42;
+  } else if (CDIO_INVALID_LSN != p_track->i_index[4]
+             || 3 != p_track->i_last_index) {
+    printf("cdio_subq_find_indices() put index 4, which can't be read, "
+           "at %ld\n", (long int) p_track->i_index[4]);
+    i_ret = 43;
+  } else if (0 != strcmp("0000010271955", p_scan->psz_mcn)
+             || 0 != strcmp("USRC17607839", p_track->psz_isrc)) {
+    printf("cdio_subq_find_indices() got MCN \"%s\" and ISRC \"%s\"\n",
+           p_scan->psz_mcn, p_track->psz_isrc);
+    i_ret = 44;
+  }
+
+ out:
+  free(p_scan);
+  cdio_destroy(p_cdio);
+  return i_ret;
+}
+
+/* Sectors the dump test reads badly: one that reads on its third
+   try, one that only reads as any type of sector, and one that never
+   reads. */
+#define DUMP_SLOW  20
+#define DUMP_TYPED 170
+#define DUMP_BAD   320
+
+static void
+dump_set_faults(fake_env_t *p_env)
+{
+  p_env->ai_fail_left[DUMP_SLOW]  = 2;
+  p_env->ab_fail_typed[DUMP_TYPED] = true;
+  p_env->ai_fail_left[DUMP_BAD]   = 1000;
+  p_env->i_wrong_type = 0;
+  p_env->i_any_type   = 0;
+}
+
+/* Dump a disc of an audio, a mode 1 and a mode 2 track, each of which
+   takes its own kind of READ CD, with a few sectors that can't be read
+   at once: each should be read again on its own, the last time as any
+   type, and the one that never reads should stop the dump unless it
+   may be skipped, and then be zeros in the image. */
+static int
+test_dump(void)
+{
+  static const char psz_bin[] = "fake_drive.bin";
+  static const char psz_cue[] = "fake_drive.cue";
+  const uint32_t i_batch = 16;
+  cdio_dump_options_t opts;
+  cdio_dump_stats_t stats;
+  fake_env_t *p_env;
+  CdIo_t *p_cdio = fake_open(&p_env);
+  uint8_t sector[CDIO_CD_FRAMESIZE_RAW];
+  char line[100];
+  bool b_mode2 = false;
+  FILE *fp;
+  int i_ret = 0;
+  lsn_t i;
+  unsigned int k;
+
+  if (!p_cdio) {
+    printf("Can't set up the made-up drive\n");
+    return 50;
+  }
+  p_env->b_mmc    = true;
+  p_env->i_tracks = 3;
+  p_env->ai_track_start[1]  = 150;
+  p_env->ai_track_start[2]  = 300;
+  p_env->ai_track_format[1] = TRACK_FORMAT_DATA;
+  p_env->ai_track_format[2] = TRACK_FORMAT_XA;
+
+  memset(&opts, 0, sizeof(opts));
+  opts.i_batch = i_batch;
+  dump_set_faults(p_env);
+  if (DRIVER_OP_ERROR != cdio_dump_disc(p_cdio, psz_bin, psz_cue, &opts,
+                                        &stats)
+      || 0 != stats.i_bad_sectors) {
+    printf("cdio_dump_disc() got past a sector that can't be read\n");
+    i_ret = 51;
+    goto out;
+  }
+
+  opts.b_skip_bad = true;
+  dump_set_faults(p_env);
+  if (DRIVER_OP_SUCCESS != cdio_dump_disc(p_cdio, psz_bin, psz_cue, &opts,
+                                          &stats)
+      || FAKE_LEADOUT != stats.i_sectors || 1 != stats.i_bad_sectors) {
+    printf("cdio_dump_disc() failed, or dumped %u sectors with %u bad\n",
+           (unsigned int) stats.i_sectors,
+           (unsigned int) stats.i_bad_sectors);
+    i_ret = 52;
+    goto out;
+  }
+  /* The whole batch of each sector read badly is read again sector by
+     sector: every other sector once, DUMP_SLOW twice, DUMP_TYPED until
+     its last try, and DUMP_BAD on every try. Only the last try at
+     DUMP_TYPED should need any type of sector outside the mode 2
+     track. */
+  if (p_env->i_wrong_type || 1 != p_env->i_any_type
+      || (i_batch - 1) * 3 + 2 + 2 * CDIO_DUMP_TRIES != stats.i_rereads) {
+    printf("cdio_dump_disc() read %u sectors as the wrong type and %u as "
+           "any type, and read %u again\n", p_env->i_wrong_type,
+           p_env->i_any_type, (unsigned int) stats.i_rereads);
+    i_ret = 53;
+    goto out;
+  }
+
+  if (!(fp = fopen(psz_bin, "rb"))) {
+    printf("cdio_dump_disc() wrote no image\n");
+    i_ret = 54;
+    goto out;
+  }
+  for (i = 0; !i_ret && i < FAKE_LEADOUT; i++) {
+    if (1 != fread(sector, sizeof(sector), 1, fp))
+      i_ret = 54;
+    for (k = 0; !i_ret && k < CDIO_CD_FRAMESIZE_RAW; k++)
+      if (sector[k] != (DUMP_BAD == i ? 0 : fake_byte(i, k)))
+        i_ret = 54;
+    if (i_ret)
+      printf("cdio_dump_disc() wrote sector %ld wrong\n", (long int) i);
+  }
+  fclose(fp);
+
+  if (!i_ret && (fp = fopen(psz_cue, "r"))) {
+    while (fgets(line, sizeof(line), fp))
+      if (0 == strcmp("  TRACK 03 MODE2/2352\n", line)) b_mode2 = true;
+    fclose(fp);
+  }
+  if (!i_ret && !b_mode2) {
+    printf("cdio_dump_disc() wrote no mode 2 track in the CUE sheet\n");
+    i_ret = 55;
+  }
+
+ out:
+  remove(psz_bin);
+  remove(psz_cue);
+  cdio_destroy(p_cdio);
+  return i_ret;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int i_ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  i_ret = test_rip_jitter();
+  if (i_ret) return i_ret;
+
+  i_ret = test_mmc_batch();
+  if (i_ret) return i_ret;
+
+  i_ret = test_read_ctl_m2f2();
+  if (i_ret) return i_ret;
+
+  i_ret = test_subq_indices();
+  if (i_ret) return i_ret;
+
+  i_ret = test_dump();
+  if (i_ret) return i_ret;
+
+  return 0;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
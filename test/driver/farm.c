@@ -0,0 +1,209 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/farm.c, and for opening images on
+   several threads at once, which the farm does.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+#ifdef HAVE_PTHREAD_H
+#define NUM_PARSE_THREADS 4
+
+/* Open each of a list of CUE sheets over and over, counting the
+   times one doesn't come out as it did in the main thread. */
+typedef struct {
+  const char *ppsz_cue[2];
+  track_t     ai_tracks[2];
+  lsn_t       ai_last_lsn[2];
+  unsigned int i_wrong;
+} parse_job_t;
+
+static void *
+parse_cues(void *p_user_data)
+{
+  parse_job_t *p_job = p_user_data;
+  unsigned int i, j;
+  for (i=0; i<50; i++)
+    for (j=0; j<2; j++) {
+      CdIo_t *p_cdio = cdio_open(p_job->ppsz_cue[j], DRIVER_BINCUE);
+      if (!p_cdio
+          || cdio_get_num_tracks(p_cdio) != p_job->ai_tracks[j]
+          || cdio_get_track_last_lsn(p_cdio, p_job->ai_tracks[j])
+             != p_job->ai_last_lsn[j])
+        p_job->i_wrong++;
+      cdio_destroy(p_cdio);
+    }
+  return NULL;
+}
+
+/* Drive farm job: read the first ten sectors of the first track. */
+static driver_return_code_t
+read_first_sectors(CdIo_t *p_cdio, const char *psz_drive, void *p_user_data)
+{
+  uint8_t buf[10 * CDIO_CD_FRAMESIZE_RAW];
+  const lsn_t i_lsn = cdio_get_track_lsn(p_cdio, 1);
+
+  *(const char **) p_user_data = psz_drive;
+  if (TRACK_FORMAT_AUDIO == cdio_get_track_format(p_cdio, 1))
+    return cdio_read_audio_sectors(p_cdio, buf, i_lsn, 10);
+  return cdio_read_data_sectors(p_cdio, buf, i_lsn, CDIO_CD_FRAMESIZE, 10);
+}
+
+/* CUE sheets can be parsed on several threads at once. */
+static int
+test_parse_threads(void)
+{
+  char psz_cdda[500], psz_multi[500];
+  pthread_t thread_ids[NUM_PARSE_THREADS];
+  parse_job_t jobs[NUM_PARSE_THREADS];
+  parse_job_t expected;
+  unsigned int j;
+  int ret = 0;
+
+  snprintf(psz_cdda, sizeof(psz_cdda), "%s/%s", DATA_DIR, "cdda.cue");
+  snprintf(psz_multi, sizeof(psz_multi), "%s/%s", DATA_DIR,
+           "multi-file.cue");
+  expected.ppsz_cue[0] = psz_cdda;
+  expected.ppsz_cue[1] = psz_multi;
+  expected.i_wrong = 0;
+  for (j=0; j<2; j++) {
+    CdIo_t *p_cdio = cdio_open(expected.ppsz_cue[j], DRIVER_BINCUE);
+    expected.ai_tracks[j] = p_cdio ? cdio_get_num_tracks(p_cdio) : 0;
+    expected.ai_last_lsn[j] = p_cdio
+      ? cdio_get_track_last_lsn(p_cdio, expected.ai_tracks[j])
+      : CDIO_INVALID_LSN;
+    cdio_destroy(p_cdio);
+  }
+  if (0 == expected.ai_tracks[0] || 0 == expected.ai_tracks[1]) {
+    printf("Can't open cdda.cue or multi-file.cue\n");
+    return 1;
+  }
+
+  for (j=0; j<NUM_PARSE_THREADS; j++) {
+    jobs[j] = expected;
+    pthread_create(&thread_ids[j], NULL, parse_cues, &jobs[j]);
+  }
+  for (j=0; j<NUM_PARSE_THREADS; j++) {
+    pthread_join(thread_ids[j], NULL);
+    if (0 != jobs[j].i_wrong) {
+      printf("%u CUE sheets parsed wrongly on thread %u\n",
+             jobs[j].i_wrong, j);
+      ret = 2;
+    }
+  }
+  return ret;
+}
+
+/* A farm of two images runs one job on each, and no more. */
+static int
+test_farm(void)
+{
+  char psz_cdda[500], psz_iso[500];
+  char *ppsz_drives[3];
+  const char *psz_ran[3] = { NULL, NULL, NULL };
+  cdio_farm_stats_t stats;
+  cdio_farm_t *p_farm;
+  int ret = 0;
+
+  snprintf(psz_cdda, sizeof(psz_cdda), "%s/%s", DATA_DIR, "cdda.cue");
+  snprintf(psz_iso, sizeof(psz_iso), "%s/%s", DATA_DIR, "isofs-m1.cue");
+  ppsz_drives[0] = psz_cdda;
+  ppsz_drives[1] = psz_iso;
+  ppsz_drives[2] = NULL;
+  p_farm = cdio_farm_new(ppsz_drives, DRIVER_BINCUE, 10, false);
+  if (!p_farm || 2 != cdio_farm_num_drives(p_farm)
+      || 0 != strcmp(psz_iso, cdio_farm_get_drive(p_farm, 1))) {
+    printf("cdio_farm_new() failed\n");
+    cdio_farm_destroy(p_farm);
+    return 10;
+  }
+
+  cdio_farm_submit(p_farm, read_first_sectors, &psz_ran[0], psz_cdda);
+  cdio_farm_submit(p_farm, read_first_sectors, &psz_ran[1], NULL);
+  if (!cdio_farm_wait(p_farm, 5000)
+      || !psz_ran[0] || 0 != strcmp(psz_cdda, psz_ran[0])
+      || !psz_ran[1] || 0 != strcmp(psz_iso, psz_ran[1])) {
+    printf("Drive farm jobs didn't run where they should\n");
+    ret = 11;
+  } else if (DRIVER_OP_SUCCESS != cdio_farm_get_stats(p_farm, &stats)
+             || 2 != stats.i_drives || 2 != stats.i_loaded
+             || 2 != stats.i_jobs_done || 0 != stats.i_jobs_failed
+             || 10 * (CDIO_CD_FRAMESIZE_RAW + CDIO_CD_FRAMESIZE)
+                != stats.i_bytes) {
+    printf("Drive farm stats are wrong: %u jobs, %llu bytes\n",
+           (unsigned int) stats.i_jobs_done,
+           (unsigned long long) stats.i_bytes);
+    ret = 12;
+  } else {
+    /* Both discs have had their job. */
+    cdio_farm_submit(p_farm, read_first_sectors, &psz_ran[2], NULL);
+    if (cdio_farm_wait(p_farm, 100) || psz_ran[2]
+        || DRIVER_OP_SUCCESS != cdio_farm_get_drive_stats(p_farm, 0,
+                                                          &stats)
+        || 1 != stats.i_queued || 1 != stats.i_jobs_done
+        || 10 * CDIO_CD_FRAMESIZE_RAW != stats.i_bytes) {
+      printf("A drive farm job ran on a used disc\n");
+      ret = 13;
+    }
+  }
+  cdio_farm_destroy(p_farm);
+  return ret;
+}
+#endif /* HAVE_PTHREAD_H */
+
+int
+main(int argc, const char *argv[])
+{
+#ifdef HAVE_PTHREAD_H
+  int ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  ret = test_parse_threads();
+  if (ret) return ret;
+  return test_farm();
+#else
+  printf("No threads; skipping.\n");
+  return 77;
+#endif
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -35,8 +35,190 @@
 #include <string.h>
 #endif
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#include <dirent.h>
+
 #include "helper.h"
 
+#ifdef HAVE_LINUX_CDROM
+/* The scratch tree the drive registry is pointed at. */
+static char psz_root[] = "gnu_linux.XXXXXX";
+static char psz_sys_block[64];
+static char psz_dev[64];
+
+/* Make psz_sys_block/psz_name, of SCSI type i_type. */
+static void
+make_sys_block(const char *psz_name, int i_type)
+{
+  char psz_path[128];
+  FILE *p_file;
+
+  snprintf(psz_path, sizeof(psz_path), "%s/%s", psz_sys_block, psz_name);
+  mkdir(psz_path, 0755);
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device", psz_sys_block,
+           psz_name);
+  mkdir(psz_path, 0755);
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device/type", psz_sys_block,
+           psz_name);
+  p_file = fopen(psz_path, "w");
+  if (p_file) {
+    fprintf(p_file, "%d\n", i_type);
+    fclose(p_file);
+  }
+}
+
+static void
+remove_sys_block(const char *psz_name)
+{
+  char psz_path[128];
+
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device/type", psz_sys_block,
+           psz_name);
+  unlink(psz_path);
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device", psz_sys_block,
+           psz_name);
+  rmdir(psz_path);
+  snprintf(psz_path, sizeof(psz_path), "%s/%s", psz_sys_block, psz_name);
+  rmdir(psz_path);
+}
+
+/* Create or remove the node psz_dev/psz_name. */
+static void
+touch_dev(const char *psz_name, bool b_create)
+{
+  char psz_path[128];
+  FILE *p_file;
+
+  snprintf(psz_path, sizeof(psz_path), "%s/%s", psz_dev, psz_name);
+  if (!b_create)
+    unlink(psz_path);
+  else if ((p_file = fopen(psz_path, "w")))
+    fclose(p_file);
+}
+
+/* Number of descriptors open in this process. */
+static int
+count_fds(void)
+{
+  DIR *p_dir = opendir("/proc/self/fd");
+  int i_fds = 0;
+
+  if (!p_dir)
+    return -1;
+  while (readdir(p_dir))
+    i_fds++;
+  closedir(p_dir);
+  return i_fds;
+}
+
+/* Is the registry's list of names exactly psz_expected, the names
+   separated by spaces? */
+static bool
+registry_is(const char *psz_expected)
+{
+  char **ppsz_names = cdio_linux_registry_get_names();
+  char psz_got[128] = "";
+  unsigned int i;
+  bool b_ok;
+
+  if (!ppsz_names) {
+    printf("The drive registry can't read %s\n", psz_sys_block);
+    return false;
+  }
+  for (i = 0; ppsz_names[i]; i++) {
+    if (i) strncat(psz_got, " ", sizeof(psz_got) - strlen(psz_got) - 1);
+    strncat(psz_got, ppsz_names[i], sizeof(psz_got) - strlen(psz_got) - 1);
+  }
+  cdio_free_device_list(ppsz_names);
+  b_ok = (0 == strcmp(psz_got, psz_expected));
+  if (!b_ok)
+    printf("The drive registry lists \"%s\", not \"%s\"\n", psz_got,
+           psz_expected);
+  return b_ok;
+}
+
+/* Run the drive registry over a made-up sysfs and /dev: it should
+   list only CD drives, in order, follow what is added to and removed
+   from /dev, and give back its descriptor when it is reset. */
+static int
+test_registry(void)
+{
+  const int i_fds = count_fds();
+  char psz_path[64];
+  int i_ret = 0;
+
+  if (!mkdtemp(psz_root)) {
+    printf("Can't make a scratch directory\n");
+    return 10;
+  }
+  snprintf(psz_path, sizeof(psz_path), "%s/sys", psz_root);
+  mkdir(psz_path, 0755);
+  snprintf(psz_sys_block, sizeof(psz_sys_block), "%s/sys/block", psz_root);
+  mkdir(psz_sys_block, 0755);
+  snprintf(psz_dev, sizeof(psz_dev), "%s/dev", psz_root);
+  mkdir(psz_dev, 0755);
+
+  make_sys_block("sr10", 5); /* TYPE_ROM */
+  make_sys_block("sr2", 4);  /* TYPE_WORM */
+  make_sys_block("sda", 0);  /* TYPE_DISK */
+  touch_dev("sr10", true);
+  touch_dev("sr2", true);
+  touch_dev("sda", true);
+
+  cdio_linux_registry_set_roots(psz_sys_block, psz_dev);
+  if (!registry_is("sr2 sr10"))
+    i_ret = 11;
+
+  /* A drive appears. */
+  make_sys_block("sr0", 5);
+  touch_dev("sr0", true);
+  if (!i_ret && !registry_is("sr0 sr2 sr10"))
+    i_ret = 12;
+
+#ifdef HAVE_SYS_INOTIFY_H
+  /* A drive goes from /dev: it is dropped without sysfs being read
+     again, so a drive only in sysfs doesn't show up yet. */
+  touch_dev("sr2", false);
+  make_sys_block("sr3", 5);
+  if (!i_ret && !registry_is("sr0 sr10"))
+    i_ret = 13;
+
+  /* Resetting the registry reads sysfs again. */
+  cdio_linux_registry_set_roots(psz_sys_block, psz_dev);
+  if (!i_ret && !registry_is("sr0 sr2 sr3 sr10"))
+    i_ret = 14;
+  remove_sys_block("sr3");
+#endif
+
+  cdio_linux_registry_set_roots(NULL, NULL);
+  if (!i_ret && i_fds >= 0 && count_fds() != i_fds) {
+    printf("The drive registry left %d descriptors open\n",
+           count_fds() - i_fds);
+    i_ret = 15;
+  }
+
+  touch_dev("sr0", false);
+  touch_dev("sr2", false);
+  touch_dev("sr10", false);
+  touch_dev("sda", false);
+  remove_sys_block("sr0");
+  remove_sys_block("sr2");
+  remove_sys_block("sr10");
+  remove_sys_block("sda");
+  rmdir(psz_dev);
+  rmdir(psz_sys_block);
+  snprintf(psz_path, sizeof(psz_path), "%s/sys", psz_root);
+  rmdir(psz_path);
+  rmdir(psz_root);
+  return i_ret;
+}
+#endif /* HAVE_LINUX_CDROM */
+
 int
 main(int argc, const char *argv[])
 {
@@ -45,6 +227,13 @@ main(int argc, const char *argv[])
   
   cdio_log_set_handler(log_handler);
   cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_INFO;
+
+#ifdef HAVE_LINUX_CDROM
+  {
+    const int i_ret = test_registry();
+    if (i_ret) return i_ret;
+  }
+#endif
   /* snprintf(psz_nrgfile, sizeof(psz_nrgfile)-1,
              "%s/%s", TEST_DIR, cue_file[i]);
   */
@@ -0,0 +1,202 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for lib/driver/logging.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <cdio/logging.h>
+
+#define NUM_THREADS  4
+#define NUM_MESSAGES 2000
+
+static unsigned int i_received = 0;
+static unsigned int i_out_of_order = 0;
+static int last_seen[NUM_THREADS];
+
+/* Count messages; each one is "<thread> <sequence number>". */
+static void
+count_handler(cdio_log_level_t level, const char message[])
+{
+  int i_thread, i_seq;
+  i_received++;
+  if (2 == sscanf(message, "%d %d", &i_thread, &i_seq)
+      && i_thread >= 0 && i_thread < NUM_THREADS) {
+    if (i_seq <= last_seen[i_thread]) i_out_of_order++;
+    last_seen[i_thread] = i_seq;
+  }
+}
+
+#ifdef HAVE_PTHREAD_H
+static volatile unsigned long i_delivered = 0;
+static volatile int b_stop_logging = 0;
+
+/* Count messages from several threads at once. */
+static void
+atomic_count_handler(cdio_log_level_t level, const char message[])
+{
+  __sync_fetch_and_add(&i_delivered, 1);
+}
+
+/* Log until told to stop; return how many messages were sent. */
+static void *
+log_until_stopped(void *p_sent)
+{
+  unsigned long *pi_sent = p_sent;
+  while (!b_stop_logging) {
+    cdio_info("%lu", *pi_sent);
+    (*pi_sent)++;
+  }
+  return NULL;
+}
+#endif
+
+static void *
+log_some(void *p_thread)
+{
+  int i_thread = *(int *) p_thread;
+  int i;
+  for (i=0; i<NUM_MESSAGES; i++)
+    cdio_info("%d %d", i_thread, i);
+  return NULL;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int i;
+  int threads[NUM_THREADS];
+  unsigned long i_dropped;
+  cdio_log_handler_t old_handler;
+
+  /* A handler other than the default one sees messages below
+     cdio_loglevel_default. */
+  cdio_loglevel_default = CDIO_LOG_WARN;
+  old_handler = cdio_log_set_handler(count_handler);
+  cdio_debug("0 0");
+  if (1 != i_received) {
+    fprintf(stderr, "Custom log handler got %u messages; expected 1\n",
+            i_received);
+    exit(1);
+  }
+  cdio_log_set_handler(old_handler);
+
+  /* Several threads log through the asynchronous sink into a small
+     buffer. Every message is either delivered, in order, or counted
+     as dropped. */
+  i_received = 0;
+  i_out_of_order = 0;
+  for (i=0; i<NUM_THREADS; i++) {
+    threads[i] = i;
+    last_seen[i] = -1;
+  }
+  if (!cdio_log_async_start(count_handler, 64)) {
+    printf("Asynchronous logging is not available; skipping.\n");
+    exit(77);
+  }
+  if (cdio_log_async_start(count_handler, 64)) {
+    fprintf(stderr, "Asynchronous logging started twice\n");
+    exit(2);
+  }
+
+#ifdef HAVE_PTHREAD_H
+  {
+    pthread_t thread_ids[NUM_THREADS];
+    for (i=0; i<NUM_THREADS; i++)
+      pthread_create(&thread_ids[i], NULL, log_some, &threads[i]);
+    for (i=0; i<NUM_THREADS; i++)
+      pthread_join(thread_ids[i], NULL);
+  }
+#else
+  for (i=0; i<NUM_THREADS; i++)
+    log_some(&threads[i]);
+#endif
+  cdio_log_async_stop();
+  i_dropped = cdio_log_async_dropped();
+
+  if (i_received + i_dropped != NUM_THREADS * NUM_MESSAGES) {
+    fprintf(stderr, "%u messages delivered and %lu dropped; expected %u\n",
+            i_received, i_dropped, NUM_THREADS * NUM_MESSAGES);
+    exit(3);
+  }
+  if (0 != i_out_of_order) {
+    fprintf(stderr, "%u messages delivered out of order\n", i_out_of_order);
+    exit(4);
+  }
+
+  /* The handler from before cdio_log_async_start() is back. */
+  if (cdio_log_set_handler(NULL) != old_handler) {
+    fprintf(stderr, "Log handler was not restored\n");
+    exit(5);
+  }
+
+#ifdef HAVE_PTHREAD_H
+  {
+    /* Start and stop the sink over and over while other threads keep
+       logging, so that some of them are caught between picking up the
+       handler and entering it. Every message must still arrive or be
+       counted as dropped. */
+    pthread_t thread_ids[NUM_THREADS];
+    unsigned long ai_sent[NUM_THREADS];
+    unsigned long i_sent = 0;
+
+    i_dropped = 0;
+    cdio_log_set_handler(atomic_count_handler);
+    for (i=0; i<NUM_THREADS; i++) {
+      ai_sent[i] = 0;
+      pthread_create(&thread_ids[i], NULL, log_until_stopped, &ai_sent[i]);
+    }
+    for (i=0; i<200; i++) {
+      if (!cdio_log_async_start(NULL, 16)) {
+        fprintf(stderr, "Asynchronous logging failed to restart\n");
+        exit(6);
+      }
+      cdio_log_async_stop();
+      i_dropped += cdio_log_async_dropped();
+    }
+    b_stop_logging = 1;
+    for (i=0; i<NUM_THREADS; i++) {
+      pthread_join(thread_ids[i], NULL);
+      i_sent += ai_sent[i];
+    }
+    cdio_log_set_handler(old_handler);
+    if (i_delivered + i_dropped != i_sent) {
+      fprintf(stderr, "%lu messages delivered and %lu dropped; expected %lu\n",
+              i_delivered, i_dropped, i_sent);
+      exit(7);
+    }
+  }
+#endif
+  return 0;
+}
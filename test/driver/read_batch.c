@@ -0,0 +1,83 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for mmc_read_cd_batch() of lib/driver/mmc/mmc_hl_cmds.c
+   on an image, which has no MMC to ask for subchannels or C2 errors.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/mmc_hl_cmds.h>
+
+int
+main(int argc, const char *argv[])
+{
+  uint8_t direct[20 * CDIO_CD_FRAMESIZE_RAW];
+  char psz_cuefile[500];
+  mmc_read_batch_t *p_batch;
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "cdda.cue");
+  p_cdio  = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  p_batch = mmc_read_batch_new(MMC_READ_PLANE_DATA|MMC_READ_PLANE_C2, 20);
+  if (!p_cdio || !p_batch
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sectors(p_cdio, direct,
+                                                      100, 20)) {
+    printf("Can't set up the batch read\n");
+    ret = 1;
+  } else if (DRIVER_OP_SUCCESS != mmc_read_cd_batch(p_cdio, 100, 20, p_batch)
+             || 20 != p_batch->i_blocks
+             || MMC_READ_PLANE_DATA != p_batch->i_filled
+             || 0 != p_batch->i_bad
+             || 0 != memcmp(direct, p_batch->p_data, sizeof(direct))) {
+    /* Without MMC a batch read fills in just the main channel. */
+    printf("mmc_read_cd_batch() failed\n");
+    ret = 2;
+  } else if (DRIVER_OP_SUCCESS != mmc_read_cd_batch_retry(p_cdio, p_batch, 3)
+             || DRIVER_OP_BAD_PARAMETER
+                != mmc_read_cd_batch(p_cdio, 100, 21, p_batch)) {
+    printf("mmc_read_cd_batch_retry() or its bounds failed\n");
+    ret = 3;
+  }
+  mmc_read_batch_free(p_batch);
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,98 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/read_ctl.c on an image. An image can't
+   have its speed set, so only reading and its statistics are checked.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+#define NUM_BLOCKS 300
+
+int
+main(int argc, const char *argv[])
+{
+  uint8_t *p_direct  = malloc(NUM_BLOCKS * CDIO_CD_FRAMESIZE_RAW);
+  uint8_t *p_ctl_buf = malloc(NUM_BLOCKS * CDIO_CD_FRAMESIZE_RAW);
+  char psz_cuefile[500];
+  cdio_read_ctl_t *p_ctl = NULL;
+  cdio_read_ctl_stats_t stats;
+  cdio_read_region_t region;
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "cdda.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (p_cdio) p_ctl = cdio_read_ctl_new(p_cdio, NULL);
+  if (!p_ctl || !p_direct || !p_ctl_buf
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sectors(p_cdio, p_direct,
+                                                      0, NUM_BLOCKS)) {
+    printf("Can't set up the read controller\n");
+    ret = 1;
+  } else if (DRIVER_OP_SUCCESS != cdio_read_ctl_read(p_ctl, p_ctl_buf, 0,
+                                                     CDIO_READ_MODE_AUDIO,
+                                                     NUM_BLOCKS)
+             || 0 != memcmp(p_direct, p_ctl_buf,
+                            NUM_BLOCKS * CDIO_CD_FRAMESIZE_RAW)) {
+    /* A read controller reads what a plain read does. */
+    printf("cdio_read_ctl_read() failed\n");
+    ret = 2;
+  } else if (DRIVER_OP_SUCCESS != cdio_read_ctl_get_stats(p_ctl, &stats)
+             || NUM_BLOCKS != stats.i_sectors || 0 != stats.i_errors
+             || 0 != stats.i_bad_sectors || 0 != stats.i_speed
+             || CDIO_READ_CTL_MAX_BLOCKS != stats.i_blocks
+             || DRIVER_OP_SUCCESS != cdio_read_ctl_get_region(p_ctl, 100,
+                                                              &region)
+             || 0 != region.i_lsn || NUM_BLOCKS != region.i_sectors
+             || 0 != region.i_errors) {
+    printf("cdio_read_ctl_get_stats() got %lu sectors, %lu errors\n",
+           (unsigned long) stats.i_sectors, (unsigned long) stats.i_errors);
+    ret = 3;
+  }
+  cdio_read_ctl_free(p_ctl);
+  free(p_ctl_buf);
+  free(p_direct);
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
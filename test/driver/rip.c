@@ -0,0 +1,113 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/rip.c on an image. Extraction from a
+   drive that jitters is tested in fake_drive.c.
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+/* Audio extraction callback: append the PCM to a buffer of
+   cdda.bin's size, stopping once it is full. */
+typedef struct {
+  uint8_t *p_pcm;
+  size_t   i_size;
+  size_t   i_used;
+} rip_buffer_t;
+
+static driver_return_code_t
+rip_to_buffer(const uint8_t *p_pcm, size_t i_bytes, void *p_user_data)
+{
+  rip_buffer_t *p_buf = p_user_data;
+  if (p_buf->i_used + i_bytes > p_buf->i_size) return DRIVER_OP_ERROR;
+  memcpy(p_buf->p_pcm + p_buf->i_used, p_pcm, i_bytes);
+  p_buf->i_used += i_bytes;
+  return DRIVER_OP_SUCCESS;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  char psz_cuefile[500];
+  rip_buffer_t buf;
+  cdio_rip_stats_t stats;
+  uint8_t *p_direct;
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "cdda.cue");
+  p_cdio     = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  buf.i_size = 302 * CDIO_CD_FRAMESIZE_RAW;
+  buf.i_used = 0;
+  buf.p_pcm  = malloc(buf.i_size);
+  p_direct   = malloc(buf.i_size);
+  if (!p_cdio || !buf.p_pcm || !p_direct
+      || DRIVER_OP_SUCCESS != cdio_read_audio_sectors(p_cdio, p_direct,
+                                                      0, 302)) {
+    printf("Can't read cdda.cue\n");
+    ret = 1;
+  } else if (DRIVER_OP_SUCCESS != cdio_rip_track(p_cdio, 1, NULL,
+                                                 rip_to_buffer, &buf, &stats)
+             || buf.i_size != buf.i_used
+             || 0 != memcmp(p_direct, buf.p_pcm, buf.i_size)
+             || 302 != stats.i_sectors || 0 != stats.i_rereads
+             || 0 != stats.i_shifted || 0 != stats.i_unverified) {
+    /* Extracting a track gives what reading it does. */
+    printf("cdio_rip_track() failed: %lu bytes, %u rereads\n",
+           (unsigned long) buf.i_used, (unsigned int) stats.i_rereads);
+    ret = 2;
+  } else {
+    /* The callback can stop it. */
+    buf.i_used = buf.i_size - CDIO_CD_FRAMESIZE_RAW;
+    if (DRIVER_OP_ERROR != cdio_rip_audio(p_cdio, 0, 100, NULL,
+                                          rip_to_buffer, &buf, NULL)) {
+      printf("cdio_rip_audio() didn't stop when asked\n");
+      ret = 3;
+    }
+  }
+  free(p_direct);
+  free(buf.p_pcm);
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,146 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Regression test for lib/driver/subchannel.c
+*/
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+
+/* Q frames decode, and fail when damaged. */
+static int
+test_decode(void)
+{
+  uint8_t position[12] = { 0x01, 0x02, 0x00, 0x00, 0x00, 0x02,
+                           0x00, 0x00, 0x15, 0x25, 0x9a, 0x1f };
+  const uint8_t isrc[12] = { 0x03, 0x96, 0x38, 0x93, 0x04, 0x76,
+                             0x07, 0x83, 0x90, 0x25, 0x6d, 0x5b };
+  cdio_subq_t q;
+
+  if (!cdio_subq_decode(position, &q) || CDIO_SUBQ_POSITION != q.i_adr
+      || 2 != q.i_track || 0 != q.i_index || -2 != q.i_rel
+      || 1000 != q.i_lsn) {
+    printf("A position Q frame was misread\n");
+    return 1;
+  }
+  if (!cdio_subq_decode(isrc, &q) || CDIO_SUBQ_ISRC != q.i_adr
+      || 0 != strcmp("USRC17607839", q.psz_text)) {
+    printf("An ISRC Q frame was misread\n");
+    return 2;
+  }
+  position[8] ^= 0x01;
+  if (cdio_subq_decode(position, &q)) {
+    printf("A damaged Q frame was taken\n");
+    return 3;
+  }
+  return 0;
+}
+
+/* An image is scanned from what the driver knows. */
+static int
+test_scan(cdio_subq_scan_t *p_scan)
+{
+  char psz_cuefile[500];
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "cdda.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (!p_cdio
+      || DRIVER_OP_SUCCESS != cdio_subq_scan(p_cdio, 0, 0, p_scan)
+      || p_scan->b_subchannel
+      || 0 != strcmp("0000010271955", p_scan->psz_mcn)
+      || 1 != p_scan->i_first_track || 1 != p_scan->i_last_track
+      || 0 != p_scan->track[1].i_index[1]
+      || CDIO_INVALID_LSN != p_scan->track[1].i_index[0]
+      || 0 != p_scan->track[1].psz_isrc[0]) {
+    printf("cdio_subq_scan() of cdda.cue failed\n");
+    ret = 10;
+  }
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+/* Without subchannels an image's indices come from its CUE sheet. */
+static int
+test_find_indices(cdio_subq_scan_t *p_scan)
+{
+  char psz_cuefile[500];
+  CdIo_t *p_cdio;
+  int ret = 0;
+
+  snprintf(psz_cuefile, sizeof(psz_cuefile), "%s/%s", DATA_DIR, "p1.cue");
+  p_cdio = cdio_open (psz_cuefile, DRIVER_BINCUE);
+  if (!p_cdio
+      || DRIVER_OP_SUCCESS != cdio_subq_find_indices(p_cdio, p_scan)
+      || 1 != p_scan->i_first_track || 2 != p_scan->i_last_track
+      || 0 != p_scan->track[1].i_index[0]
+      || 75 != p_scan->track[1].i_index[1]
+      || 150 != p_scan->track[2].i_index[0]
+      || 225 != p_scan->track[2].i_index[1]) {
+    printf("cdio_subq_find_indices() of p1.cue failed\n");
+    ret = 11;
+  }
+  cdio_destroy(p_cdio);
+  return ret;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  cdio_subq_scan_t *p_scan;
+  int ret;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_WARN;
+
+  ret = test_decode();
+  if (ret) return ret;
+
+  p_scan = malloc(sizeof(cdio_subq_scan_t));
+  if (!p_scan) {
+    printf("Can't allocate a scan\n");
+    return 20;
+  }
+  ret = test_scan(p_scan);
+  if (!ret) ret = test_find_indices(p_scan);
+  free(p_scan);
+  return ret;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -31,6 +31,25 @@
 #endif
 
 #include <cdio/version.h>
+#include <cdio/utf8.h>
+
+/* Convert the i_src bytes of UCS-2BE at src into a buffer of
+   i_dst_size bytes and check that psz_utf8 comes out. */
+static int
+check_ucs2be(const char src[], size_t i_src, size_t i_dst_size,
+             const char psz_utf8[])
+{
+    char buf[64];
+    size_t i_len = cdio_ucs2be_to_utf8((const uint8_t *) src, i_src,
+                                       buf, i_dst_size);
+
+    if (i_len != strlen(psz_utf8) || 0 != strcmp(buf, psz_utf8)) {
+	fprintf(stderr, "cdio_ucs2be_to_utf8 gave '%s' instead of '%s'\n",
+		buf, psz_utf8);
+	return 1;
+    }
+    return 0;
+}
 
 int
 main(int argc, const char *argv[])
@@ -46,6 +65,38 @@ main(int argc, const char *argv[])
 		libcdio_version_num, LIBCDIO_VERSION_NUM);
 	exit(2);
     }
+
+    /* ASCII, 2- and 3-byte characters, a surrogate pair and a lone
+       surrogate. */
+    {
+	static const char hello[] = "\0H\0e\0l\0l\0o\0,\0 \0w\0o\0r\0l\0d";
+	static const char mixed[] =
+	    "\0a\0\xe9\x65\xe5\xd8\x3d\xde\x00\xdc\x00\0z";
+	static const char utf8_mixed[] =
+	    "a\xc3\xa9\xe6\x97\xa5\xf0\x9f\x98\x80\xef\xbf\xbdz";
+
+	if (check_ucs2be(hello, sizeof(hello) - 1, 64, "Hello, world")
+	    /* Stops at a 0 character, and at what fits */
+	    || check_ucs2be(hello, sizeof(hello), 64, "Hello, world")
+	    || check_ucs2be("\0a\0\0\0b", 6, 64, "a")
+	    || check_ucs2be(hello, sizeof(hello) - 1, 6, "Hello")
+	    || check_ucs2be(mixed, sizeof(mixed) - 1, 64, utf8_mixed)
+	    || check_ucs2be(mixed, sizeof(mixed) - 1, 6, "a\xc3\xa9"))
+	    exit(3);
+
+#ifdef HAVE_JOLIET
+	{
+	    cdio_utf8_t *psz_utf8 = NULL;
+	    if (!cdio_charset_to_utf8(mixed, sizeof(mixed) - 1, &psz_utf8,
+				      "UCS-2BE")
+		|| 0 != strcmp(psz_utf8, utf8_mixed)) {
+		fprintf(stderr, "cdio_charset_to_utf8 failed on UCS-2BE\n");
+		exit(4);
+	    }
+	    free(psz_utf8);
+	}
+#endif
+    }
     exit(0);
 }
 
@@ -114,6 +114,258 @@ time_compare(struct tm *p_tm1, struct tm *p_tm2)
   return okay;
 }
 
+/* Build an image with iso9660_writer_new() and the extensions
+   u_extensions, then read it back through iso9660_ifs. It holds a
+   small file, read back as psz_path, an empty directory, a file three
+   directories deep and one spanning several blocks; psz_version is
+   what the names of the last two end in on the disc. */
+static int
+test_writer(iso_extension_mask_t u_extensions, const char psz_path[],
+            const char psz_version[])
+{
+  static const char psz_text[] = "Hello, ISO 9660\n";
+  const char psz_src[] = "testiso9660.src";
+  const char psz_big[] = "testiso9660.big";
+  const char psz_img[] = "testiso9660.iso";
+  const unsigned int i_big = 3 * ISO_BLOCKSIZE + 100;
+  iso9660_writer_t *p_writer;
+  iso9660_t *p_iso;
+  iso9660_stat_t *p_stat;
+  iso9660_pvd_t pvd;
+  CdioList_t *p_entlist;
+  char psz_name[64];
+  char buf[4 * ISO_BLOCKSIZE];
+  char *psz_system_id;
+  unsigned int i;
+  int i_ret = 0;
+  FILE *p_file = fopen(psz_src, "w");
+
+  if (!p_file || EOF == fputs(psz_text, p_file) || 0 != fclose(p_file)) {
+    printf("Can't write %s\n", psz_src);
+    return 49;
+  }
+  for (i = 0; i < i_big; i++)
+    buf[i] = (char) (i % 251);
+  p_file = fopen(psz_big, "wb");
+  if (!p_file || 1 != fwrite(buf, i_big, 1, p_file) || 0 != fclose(p_file)) {
+    printf("Can't write %s\n", psz_big);
+    remove(psz_src);
+    return 49;
+  }
+
+  p_writer = iso9660_writer_new("testiso9660", u_extensions);
+  if (!p_writer
+      || !iso9660_writer_add_dir(p_writer, "empty")
+      || !iso9660_writer_add_file(p_writer, "dir/Hello World.txt", psz_src)
+      || !iso9660_writer_add_file(p_writer, "a/b/c/deep.txt", psz_src)
+      || !iso9660_writer_add_dir(p_writer, "a/b/other")
+      || !iso9660_writer_add_file(p_writer, "a/big.bin", psz_big)
+      || !iso9660_writer_write(p_writer, psz_img)) {
+    printf("Failed to build %s with iso9660_writer\n", psz_img);
+    iso9660_writer_free(p_writer);
+    remove(psz_src);
+    remove(psz_big);
+    return 50;
+  }
+  iso9660_writer_free(p_writer);
+
+  p_iso = iso9660_open_ext(psz_img, u_extensions);
+  if (!p_iso) {
+    printf("Can't open the image iso9660_writer built\n");
+    i_ret = 51;
+  } else {
+    p_stat = iso9660_ifs_stat_translate(p_iso, psz_path);
+    if (!p_stat || _STAT_FILE != p_stat->type
+        || sizeof(psz_text) - 1 != p_stat->size) {
+      printf("%s is missing from the image iso9660_writer built\n", psz_path);
+      i_ret = 52;
+    } else if (ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, buf,
+                                                      p_stat->lsn, 1)
+               || 0 != memcmp(buf, psz_text, p_stat->size)) {
+      printf("%s has the wrong contents in the image iso9660_writer "
+             "built\n", psz_path);
+      i_ret = 53;
+    }
+    if (p_stat)
+      free(p_stat->rr.psz_symlink);
+    free(p_stat);
+
+    /* A file some directories down. */
+    snprintf(psz_name, sizeof(psz_name), "/a/b/c/deep.txt%s", psz_version);
+    p_stat = i_ret ? NULL : iso9660_ifs_stat_translate(p_iso, psz_name);
+    if (!i_ret && (!p_stat || _STAT_FILE != p_stat->type
+                   || sizeof(psz_text) - 1 != p_stat->size
+                   || ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, buf,
+                                                             p_stat->lsn, 1)
+                   || 0 != memcmp(buf, psz_text, p_stat->size))) {
+      printf("%s is wrong in the image iso9660_writer built\n", psz_name);
+      i_ret = 59;
+    }
+    if (p_stat)
+      free(p_stat->rr.psz_symlink);
+    free(p_stat);
+
+    /* ".", "..", "c" and "other". */
+    p_entlist = i_ret ? NULL : iso9660_ifs_readdir(p_iso, "/a/b");
+    if (!i_ret && (!p_entlist || 4 != _cdio_list_length(p_entlist))) {
+      printf("/a/b doesn't list 4 entries in the image iso9660_writer "
+             "built\n");
+      i_ret = 60;
+    }
+    if (p_entlist)
+      _cdio_list_free(p_entlist, true);
+
+    /* A file of several blocks. */
+    snprintf(psz_name, sizeof(psz_name), "/a/big.bin%s", psz_version);
+    p_stat = i_ret ? NULL : iso9660_ifs_stat_translate(p_iso, psz_name);
+    if (!i_ret && (!p_stat || _STAT_FILE != p_stat->type
+                   || i_big != p_stat->size
+                   || 4 * ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, buf,
+                                                                 p_stat->lsn,
+                                                                 4))) {
+      printf("%s is wrong in the image iso9660_writer built\n", psz_name);
+      i_ret = 61;
+    }
+    for (i = 0; !i_ret && i < i_big; i++)
+      if ((char) (i % 251) != buf[i]) {
+        printf("%s differs at byte %u in the image iso9660_writer built\n",
+               psz_name, i);
+        i_ret = 61;
+      }
+    if (p_stat)
+      free(p_stat->rr.psz_symlink);
+    free(p_stat);
+
+    /* "CD-RTOS CD-BRIDGE" is for CD-XA only. */
+    if (!i_ret && iso9660_ifs_read_pvd(p_iso, &pvd)) {
+      psz_system_id = iso9660_get_system_id(&pvd);
+      if (!psz_system_id || 0 != strlen(psz_system_id)) {
+        printf("The image iso9660_writer built has system id \"%s\"\n",
+               psz_system_id ? psz_system_id : "(null)");
+        i_ret = 62;
+      }
+      free(psz_system_id);
+    }
+    iso9660_close(p_iso);
+  }
+
+  remove(psz_img);
+  remove(psz_src);
+  remove(psz_big);
+  return i_ret;
+}
+
+/* Build an image whose file BIG is recorded as two extents, the
+   second one before the first on the disc, then check that it is
+   stat'ed and read as one file, and a file MANY with one extent more
+   than ISO_MAX_MULTIEXTENT, which can't be stat'ed. Block n of the
+   image is filled with the byte n. */
+static int
+test_multiextent(void)
+{
+  const char psz_img[] = "testiso9660.iso";
+  const time_t now = time(NULL);
+  const lsn_t i_root = 20, i_first = 22, i_second = 21;
+  const uint32_t i_iso_size = 25;
+  uint8_t root[ISO_BLOCKSIZE];
+  uint8_t pt[ISO_BLOCKSIZE];
+  uint8_t buf[4 * ISO_BLOCKSIZE];
+  iso9660_t *p_iso;
+  iso9660_stat_t *p_stat;
+  CdioList_t *p_entlist;
+  int i_ret = 0;
+  unsigned int i;
+  lsn_t lsn;
+  FILE *p_file = fopen(psz_img, "wb");
+
+  if (!p_file) {
+    printf("Can't write %s\n", psz_img);
+    return 54;
+  }
+
+  iso9660_dir_init_new(root, i_root, ISO_BLOCKSIZE, i_root, ISO_BLOCKSIZE,
+                       &now);
+  iso9660_dir_add_entry_su(root, "BIG.;1", i_first, 3 * ISO_BLOCKSIZE,
+                           ISO_MULTIEXTENT, NULL, 0, &now);
+  iso9660_dir_add_entry_su(root, "BIG.;1", i_second, 100, ISO_FILE,
+                           NULL, 0, &now);
+  iso9660_dir_add_entry_su(root, "SMALL.;1", i_second, 100, ISO_FILE,
+                           NULL, 0, &now);
+  for (i = 0; i <= ISO_MAX_MULTIEXTENT; i++)
+    iso9660_dir_add_entry_su(root, "MANY.;1", i_second, ISO_BLOCKSIZE,
+                             i < ISO_MAX_MULTIEXTENT ? ISO_MULTIEXTENT
+                             : ISO_FILE, NULL, 0, &now);
+  iso9660_pathtable_init(pt);
+  iso9660_pathtable_l_add_entry(pt, "", i_root, 1);
+
+  for (lsn = 0; lsn < (lsn_t) i_iso_size; lsn++) {
+    if (ISO_PVD_SECTOR == lsn)
+      iso9660_set_pvd(buf, "TESTISO9660", "", "", "TESTISO9660", i_iso_size,
+                      root, 18, 19, iso9660_pathtable_get_size(pt), &now);
+    else if (ISO_EVD_SECTOR == lsn)
+      iso9660_set_evd(buf);
+    else if (18 == lsn || 19 == lsn)
+      memcpy(buf, pt, ISO_BLOCKSIZE);
+    else if (i_root == lsn)
+      memcpy(buf, root, ISO_BLOCKSIZE);
+    else
+      memset(buf, lsn, ISO_BLOCKSIZE);
+    fwrite(buf, ISO_BLOCKSIZE, 1, p_file);
+  }
+  fclose(p_file);
+
+  p_iso = iso9660_open(psz_img);
+  if (!p_iso) {
+    printf("Can't open the multi-extent image\n");
+    remove(psz_img);
+    return 55;
+  }
+
+  p_stat = iso9660_ifs_stat(p_iso, "/BIG.;1");
+  if (!p_stat || 2 != p_stat->extents
+      || 3 * ISO_BLOCKSIZE + 100 != p_stat->total_size
+      || i_first != p_stat->extent_lsn[0]
+      || i_second != p_stat->extent_lsn[1]) {
+    printf("The extents of a multi-extent file weren't put together\n");
+    i_ret = 56;
+  } else if (4 * ISO_BLOCKSIZE
+             != iso9660_iso_seek_read_file(p_iso, p_stat, buf, 0, 4)
+             || i_first != buf[0] || i_first + 2 != buf[2 * ISO_BLOCKSIZE]
+             || i_second != buf[3 * ISO_BLOCKSIZE]
+             || ISO_BLOCKSIZE
+             != iso9660_iso_seek_read_file(p_iso, p_stat, buf, 3, 4)
+             || i_second != buf[0]) {
+    printf("A multi-extent file wasn't read across its extents\n");
+    i_ret = 57;
+  }
+  if (p_stat)
+    free(p_stat->rr.psz_symlink);
+  free(p_stat);
+
+  /* More extents than can be kept track of. */
+  p_stat = iso9660_ifs_stat(p_iso, "/MANY.;1");
+  if (!i_ret && p_stat) {
+    printf("A file with too many extents was stat'ed\n");
+    i_ret = 63;
+  }
+  if (p_stat)
+    free(p_stat->rr.psz_symlink);
+  free(p_stat);
+
+  /* ".", "..", BIG and SMALL, but not MANY */
+  p_entlist = iso9660_ifs_readdir(p_iso, "/");
+  if (!i_ret && (!p_entlist || 4 != _cdio_list_length(p_entlist))) {
+    printf("A multi-extent file was listed more than once\n");
+    i_ret = 58;
+  }
+  if (p_entlist)
+    _cdio_list_free(p_entlist, true);
+
+  iso9660_close(p_iso);
+  remove(psz_img);
+  return i_ret;
+}
+
 int
 main (int argc, const char *argv[])
 {
@@ -302,5 +554,27 @@ main (int argc, const char *argv[])
 #endif
   }
 
+  /*********************************************
+   * Test iso9660_writer
+   *********************************************/
+
+  i_bad = test_writer(ISO_EXTENSION_NONE, "/dir/hello_world.txt", "");
+  if (i_bad) return i_bad;
+#ifdef HAVE_JOLIET
+  i_bad = test_writer(ISO_EXTENSION_JOLIET, "/dir/Hello World.txt;1", ";1");
+  if (i_bad) return i_bad;
+#endif
+#ifdef HAVE_ROCK
+  i_bad = test_writer(ISO_EXTENSION_ROCK_RIDGE, "/dir/Hello World.txt", "");
+  if (i_bad) return i_bad;
+#endif
+
+  /*********************************************
+   * Test multi-extent files
+   *********************************************/
+
+  i_bad = test_multiextent();
+  if (i_bad) return i_bad;
+
   return 0;
 }